@@ -120,17 +120,35 @@ typedef enum {
  * ion      : use ion device under Android/Linux, MppBuffer will encapsulte ion file handle
  * ext_dma  : the DMABUF(DMA buffers) come from the application
  * drm      : use the drm device interface for memory management
+ * memfd    : use memfd or file on hugetlbfs / tmpfs, the fd can be passed to
+ *            other process and imported on plain Linux host
  */
 typedef enum {
     MPP_BUFFER_TYPE_NORMAL,
     MPP_BUFFER_TYPE_ION,
     MPP_BUFFER_TYPE_EXT_DMA,
     MPP_BUFFER_TYPE_DRM,
+    MPP_BUFFER_TYPE_MEMFD,
     MPP_BUFFER_TYPE_BUTT,
 } MppBufferType;
 
 #define MPP_BUFFER_TYPE_MASK            0x0000FFFF
 
+/*
+ * memory page policy of buffer group, see mpp_buffer_group_placement_config
+ *
+ * default  : allocator default page
+ * thp      : transparent huge page by madvise
+ * hugetlb  : explicit huge page from the hugetlb pool, fall back to default
+ *            page when the pool is exhausted
+ */
+typedef enum {
+    MPP_BUFFER_PAGE_DEFAULT,
+    MPP_BUFFER_PAGE_THP,
+    MPP_BUFFER_PAGE_HUGETLB,
+    MPP_BUFFER_PAGE_BUTT,
+} MppBufferPage;
+
 /*
  * MPP_BUFFER_FLAGS cooperate with MppBufferType
  * 16 high bits of MppBufferType are used in flags
@@ -169,6 +187,12 @@ typedef enum {
  * hnd  - ion handle in user space
  * fd   - ion buffer file handle for map / unmap
  *
+ * MPP_BUFFER_TYPE_MEMFD
+ *
+ * ptr  - virtual address of the shared mapping, ignored on import
+ * hnd  - internal mapping length
+ * fd   - memfd or unlinked file handle, duplicated on import
+ *
  */
 typedef struct MppBufferInfo_t {
     MppBufferType   type;
@@ -309,6 +333,73 @@ MppBufferType mpp_buffer_group_type(MppBufferGroup group);
  */
 MPP_RET mpp_buffer_group_limit_config(MppBufferGroup group, size_t size, RK_S32 count);
 
+/*
+ * keep_undersized : 0 - free unused buffer smaller than request on reuse miss
+ *                   1 - keep unused buffer smaller than request for later request
+ *                       it is only freed when the group reaches count limit
+ */
+MPP_RET mpp_buffer_group_reuse_config(MppBufferGroup group, RK_U32 keep_undersized);
+
+/*
+ * unused buffer reuse statistic
+ * hit   : request served by unused buffer
+ * miss  : request without fit unused buffer
+ * evict : unused buffer freed for request
+ */
+MPP_RET mpp_buffer_group_reuse_stats(MppBufferGroup group, RK_U32 *hit,
+                                     RK_U32 *miss, RK_U32 *evict);
+
+/*
+ * page      : MppBufferPage policy of the buffer memory
+ * numa_node : -1 - no binding, other - bind buffer memory to the numa node
+ *
+ * Only normal and memfd allocator support placement. It applies to buffers
+ * allocated after the config. Default can be set by env mpp_buffer_page and
+ * mpp_buffer_numa_node for all internal groups.
+ */
+MPP_RET mpp_buffer_group_placement_config(MppBufferGroup group, MppBufferPage page,
+                                          RK_S32 numa_node);
+
+/*
+ * size  : size of each buffer
+ * count : buffer count to be kept in the unused list of the group
+ *
+ * Only for internal group. Unused buffers which are not smaller than size
+ * are counted in, so calling it again with the same size allocates nothing.
+ * Later mpp_buffer_get with size not larger than size reuses these buffers.
+ */
+MPP_RET mpp_buffer_group_prealloc(MppBufferGroup group, size_t size, RK_S32 count);
+
+/*
+ * Shared buffer pool for the internal groups of multiple sessions
+ *
+ * Attached groups allocate buffers from the pool and the total size of all
+ * the buffers is capped by the pool limit. A group keeps its unused buffers
+ * up to its reserve size. Above the reserve the buffer goes back to the pool
+ * on the last mpp_buffer_put and is lent to the next group which can not find
+ * an unused buffer of its own. Idle buffers in pool are freed when a new
+ * allocation would exceed the limit. The reserve of the other groups is kept
+ * out of the limit, so a group can always allocate up to its reserve.
+ *
+ * limit   : 0 - no limit, other - max total buffer size of the pool
+ * reserve : buffer size kept by the group and never lent to other groups
+ *
+ * The group must be empty on attach and detach. Attach with NULL pool for
+ * detach. The pool is released after put and the last group detached.
+ */
+MPP_RET mpp_buffer_pool_get(MppBufferPool *pool, MppBufferType type, size_t limit);
+MPP_RET mpp_buffer_pool_put(MppBufferPool pool);
+MPP_RET mpp_buffer_group_attach_pool(MppBufferGroup group, MppBufferPool pool,
+                                     size_t reserve);
+
+/*
+ * usage : total size of the buffers in groups and in pool
+ * idle  : size of the buffers in pool waiting to be lent
+ * peak  : max usage ever reached
+ */
+MPP_RET mpp_buffer_pool_stats(MppBufferPool pool, size_t *usage, size_t *idle,
+                              size_t *peak);
+
 #ifdef __cplusplus
 }
 #endif
@@ -19,6 +19,24 @@
 
 #include "mpp_meta.h"
 
+/*
+ * Input packet reference mode (MPP_SET_INPUT_PACKET_REF)
+ *
+ * put_packet takes the payload of the packet without copy and mpp calls the
+ * release callback with the data and size of the packet once the payload is
+ * consumed. The callback may be called on mpp internal thread or in reset.
+ * Caller must keep the payload valid until then and should have
+ * 256 readable bytes after the payload end for the parser bit reading.
+ * Packet with MppBuffer is referenced by the buffer and is not released by
+ * the callback.
+ */
+typedef void (*MppPacketReleaseCb)(void *ctx, void *data, size_t size);
+
+typedef struct MppPacketRefCfg_t {
+    MppPacketReleaseCb  release;    /* NULL for copy mode */
+    void                *ctx;
+} MppPacketRefCfg;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
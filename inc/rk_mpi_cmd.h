@@ -17,6 +17,8 @@
 #ifndef __RK_MPI_CMD_H__
 #define __RK_MPI_CMD_H__
 
+#include "rk_type.h"
+
 /*
  * Command id bit usage is defined as follows:
  * bit 20 - 23  - module id
@@ -47,6 +49,8 @@
 
 typedef enum {
     MPP_OSAL_CMD_BASE                   = CMD_MODULE_OSAL,
+    MPP_OSAL_DUMP_MEM_STAT,             /* parameter type NULL, need env mpp_mem_debug */
+    MPP_OSAL_DUMP_TRACE,                /* parameter type const char * json file path */
     MPP_OSAL_CMD_END,
 
     MPP_CMD_BASE                        = CMD_MODULE_MPP,
@@ -63,6 +67,14 @@ typedef enum {
      */
     MPP_SET_INPUT_TIMEOUT,              /* parameter type RK_S64 */
     MPP_SET_OUTPUT_TIMEOUT,             /* parameter type RK_S64 */
+    /*
+     * decoder input packet / output frame count allowed in mpp queue
+     * should be set before mpp_init, default 4
+     */
+    MPP_SET_INPUT_QUEUE_DEPTH,          /* parameter type RK_U32 */
+    MPP_SET_OUTPUT_QUEUE_DEPTH,         /* parameter type RK_U32 */
+    MPP_SET_INPUT_PACKET_REF,           /* parameter type MppPacketRefCfg * */
+    MPP_GET_STATS,                      /* parameter type MppStats * */
     MPP_CMD_END,
 
     MPP_CODEC_CMD_BASE                  = CMD_MODULE_CODEC,
@@ -83,6 +95,9 @@ typedef enum {
     MPP_DEC_SET_DISABLE_ERROR,          /* When set it will disable sw/hw error (H.264 / H.265) */
     MPP_DEC_SET_IMMEDIATE_OUT,
     MPP_DEC_SET_ENABLE_DEINTERLACE,     /* MPP enable deinterlace by default. Vpuapi can disable it */
+    MPP_DEC_SET_PRE_ALLOC_BUFF,         /* allocate frame buffers before decoding, param MppDecPreAlloc */
+    MPP_DEC_SET_PARSER_BATCH_DEPTH,     /* Need to setup before init, tasks parsed ahead of hardware in fast mode */
+    MPP_DEC_SET_SKIP_MODE,              /* drop pictures in parser, param MppDecSkipMode (H.264 / H.265 / MPEG2 / MPEG4) */
     MPP_DEC_CMD_END,
 
     MPP_ENC_CMD_BASE                    = CMD_MODULE_CODEC | CMD_CTX_ID_ENC,
@@ -164,6 +179,80 @@ typedef enum {
     MPI_CMD_BUTT,
 } MpiCmd;
 
+/*
+ * Runtime statistic returned by MPP_GET_STATS
+ *
+ * Stage timing is in microsecond. The percentile is the upper bound of the
+ * log-linear histogram bucket holding it which is within 1/8 of the exact
+ * value. Stage with zero count has not been run yet.
+ */
+#define MPP_STATS_STAGE_MAX             16
+
+typedef struct MppStageStat_t {
+    char                name[16];
+    RK_S64              count;
+    RK_S64              avg;
+    RK_S64              p50;
+    RK_S64              p90;
+    RK_S64              p99;
+    RK_S64              max;
+} MppStageStat;
+
+typedef struct MppStats_t {
+    RK_U32              packet_put;
+    RK_U32              packet_get;
+    RK_U32              frame_put;
+    RK_U32              frame_get;
+
+    /*
+     * decoder parameter set cache: a resent parameter set identical to the
+     * one in use is a hit and is not parsed again
+     */
+    RK_U32              ps_cache_hit;
+    RK_U32              ps_cache_miss;
+
+    RK_S32              stage_count;
+    MppStageStat        stages[MPP_STATS_STAGE_MAX];
+} MppStats;
+
+/*
+ * Decoder frame buffer pre-allocation for MPP_DEC_SET_PRE_ALLOC_BUFF
+ *
+ * width / height : max picture size of the stream
+ * format         : MppFrameFormat of the output frame
+ * count          : max dpb size plus the frames held by display
+ *
+ * Buffers are allocated in the frame buffer group with the hal alignment of
+ * the decoder. Later info change with smaller or equal size reuses them.
+ * It should be called after mpp_init and after MPP_DEC_SET_EXT_BUF_GROUP when
+ * external group is used. Do not clear the group on info change then.
+ */
+typedef struct MppDecPreAlloc_t {
+    RK_S32              width;
+    RK_S32              height;
+    RK_S32              format;
+    RK_S32              count;
+} MppDecPreAlloc;
+
+/*
+ * Decoder picture skip mode for MPP_DEC_SET_SKIP_MODE
+ *
+ * Skipped pictures are dropped by parser before any buffer slot and hal
+ * work so no frame is output for them. It is for fast forward and thumbnail.
+ *
+ * MPP_DEC_SKIP_NON_REF : drop pictures never used as reference
+ *                        H.264 nal_ref_idc 0, H.265 sub-layer non-reference
+ *                        and RASL pictures, MPEG2 B picture, MPEG4 B-VOP
+ * MPP_DEC_SKIP_NON_KEY : decode random access pictures only
+ *                        H.264 IDR, H.265 IRAP, MPEG2 I picture, MPEG4 I-VOP
+ */
+typedef enum MppDecSkipMode_e {
+    MPP_DEC_SKIP_NONE,
+    MPP_DEC_SKIP_NON_REF,
+    MPP_DEC_SKIP_NON_KEY,
+    MPP_DEC_SKIP_BUTT,
+} MppDecSkipMode;
+
 #include "rk_venc_cmd.h"
 #include "rk_venc_cfg.h"
 #include "rk_venc_ref.h"
@@ -130,6 +130,7 @@ typedef void* MppPacket;
 
 typedef void* MppBuffer;
 typedef void* MppBufferGroup;
+typedef void* MppBufferPool;
 
 typedef void* MppTask;
 typedef void* MppMeta;
@@ -94,6 +94,12 @@
         else { goto __BITREAD_ERR; }\
     } while (0)
 
+/*
+ * The reader keeps up to 64 bits of the stream in a cache which is refilled
+ * 8 bytes at a time. The data_, bytes_left_, curr_byte_ and
+ * num_remaining_bits_in_curr_byte_ fields are updated after each call as if
+ * the stream was read byte by byte so parsers can still access them directly.
+ */
 typedef struct bitread_ctx_t {
     // Pointer to the next unread (not in curr_byte_) byte in the stream.
     RK_U8 *data_;
@@ -106,6 +112,7 @@ typedef struct bitread_ctx_t {
     RK_S32 num_remaining_bits_in_curr_byte_;
     // Used in emulation prevention three byte detection (see spec).
     // Initially set to 0xffff to accept all initial two-byte sequences.
+    // Holds the last two bytes loaded into the cache.
     RK_S64 prev_two_bytes_;
     // Number of emulation presentation bytes (0x000003) we met.
     RK_S64 emulation_prevention_bytes_;
@@ -116,6 +123,16 @@ typedef struct bitread_ctx_t {
     // ctx
     MPP_RET   ret;
     RK_S32    need_prevention_detection;
+    // Unread bits are the lowest cache_bits_ bits of cache_.
+    RK_U64 cache_;
+    RK_S32 cache_bits_;
+    // Next stream byte to be loaded into the cache and bytes left after it.
+    RK_U8 *cache_ptr_;
+    RK_U32 cache_left_;
+    // Bit i set when the i-th last loaded byte followed a skipped 0x03.
+    RK_U32 cache_epb_;
+    // Emulation prevention bytes skipped by the cache loader.
+    RK_S64 cache_epb_cnt_;
 } BitReadCtx_t;
 
 
@@ -112,6 +112,7 @@ extern "C" {
  * setup         - called by parser when slot information changed
  * is_changed    - called by mpp to detect whether info change flow is needed
  * ready         - called by mpp when info changed is done
+ * calc_size     - buffer size of frame info with the hal alignment of slots
  *
  * typical info change flow:
  *
@@ -129,6 +130,7 @@ MPP_RET mpp_buf_slot_setup(MppBufSlots slots, RK_S32 count);
 RK_U32  mpp_buf_slot_is_changed(MppBufSlots slots);
 MPP_RET mpp_buf_slot_ready(MppBufSlots slots);
 size_t  mpp_buf_slot_get_size(MppBufSlots slots);
+size_t  mpp_buf_slot_calc_size(MppBufSlots slots, MppFrame frame);
 /*
  * called by parser
  *
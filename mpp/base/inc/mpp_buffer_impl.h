@@ -18,6 +18,7 @@
 #define __MPP_BUFFER_IMPL_H__
 
 #include "mpp_list.h"
+#include "mpp_thread.h"
 #include "mpp_common.h"
 #include "mpp_allocator.h"
 
@@ -36,8 +37,20 @@
 #define MPP_BUF_FUNCTION_LEAVE_OK()     mpp_buf_dbg_f(MPP_BUF_DBG_FUNCTION, "success\n")
 #define MPP_BUF_FUNCTION_LEAVE_FAIL()   mpp_buf_dbg_f(MPP_BUF_DBG_FUNCTION, "failed\n")
 
+/*
+ * unused buffer size class bucket
+ * bucket 0 for size below 8K, bucket n for size in [4K << n, 8K << n)
+ * the last bucket holds all the larger buffer
+ */
+#define MPP_BUF_BUCKET_SHIFT            12
+#define MPP_BUF_BUCKET_COUNT            16
+
+#define MPP_BUF_GROUP_LOCK(p)           pthread_mutex_lock(&(p)->buf_lock)
+#define MPP_BUF_GROUP_UNLOCK(p)         pthread_mutex_unlock(&(p)->buf_lock)
+
 typedef struct MppBufferImpl_t          MppBufferImpl;
 typedef struct MppBufferGroupImpl_t     MppBufferGroupImpl;
+typedef struct MppBufferPoolImpl_t      MppBufferPoolImpl;
 typedef void (*MppBufCallback)(void *, void *);
 
 // use index instead of pointer to avoid invalid pointer
@@ -60,6 +73,10 @@ struct MppBufferImpl_t {
     // used flag is for used/unused list detection
     RK_U32              used;
     RK_U32              internal;
+    /*
+     * ref_count is changed by atomic operation. Only the change between zero
+     * and non-zero needs the group lock for used / unused list update.
+     */
     RK_S32              ref_count;
     struct list_head    list_status;
 };
@@ -70,6 +87,8 @@ struct MppBufferGroupImpl_t {
     RK_U32              group_id;
     MppBufferMode       mode;
     MppBufferType       type;
+    // lock for buffer list and status record of this group only
+    pthread_mutex_t     buf_lock;
     // used in limit mode only
     size_t              limit_size;
     RK_S32              limit_count;
@@ -90,6 +109,27 @@ struct MppBufferGroupImpl_t {
 
     // buffer force clear mode flag
     RK_U32              clear_on_exit;
+    // keep unused buffer smaller than request instead of free it
+    RK_U32              keep_undersized;
+    // unused buffer reuse record
+    RK_U32              hit_count;
+    RK_U32              miss_count;
+    RK_U32              evict_count;
+    // memory placement of buffer allocated by the group
+    MppBufferPage       page;
+    RK_S32              numa_node;
+    /*
+     * shared pool the group allocates from, the allocator of the group is
+     * replaced by the pool allocator and the own one is restored on detach
+     * pool_usage is protected by the pool lock
+     */
+    MppBufferPoolImpl   *pool;
+    size_t              pool_reserve;
+    size_t              pool_usage;
+    MppAllocator        own_allocator;
+    MppAllocatorApi     *own_alloc_api;
+    // link to list_members in MppBufferPoolImpl
+    struct list_head    list_member;
     // is_orphan: 0 - normal group 1 - orphan group
     RK_U32              is_orphan;
 
@@ -104,7 +144,37 @@ struct MppBufferGroupImpl_t {
 
     // link to list_status in MppBufferImpl
     struct list_head    list_used;
-    struct list_head    list_unused;
+    // unused buffer in size class bucket
+    struct list_head    list_unused[MPP_BUF_BUCKET_COUNT];
+};
+
+/*
+ * Lock order is group buf_lock then pool lock. Idle buffer in pool is not
+ * in any group and its group_id is invalid until it is lent to a group.
+ */
+struct MppBufferPoolImpl_t {
+    MppBufferType       type;
+    pthread_mutex_t     lock;
+    // put by user, release when no group attached
+    RK_U32              is_orphan;
+    // status record
+    size_t              limit;
+    size_t              usage;
+    size_t              idle;
+    size_t              peak;
+    size_t              reserved;
+    // some group failed on limit and waits for buffer return
+    RK_U32              waiting;
+
+    MppAllocator        allocator;
+    MppAllocatorApi     *alloc_api;
+
+    // link to the other MppBufferPoolImpl
+    struct list_head    list_pool;
+    // link to list_member in MppBufferGroupImpl
+    struct list_head    list_members;
+    // link to list_status in MppBufferImpl
+    struct list_head    list_idle;
 };
 
 #ifdef __cplusplus
@@ -122,8 +192,9 @@ extern RK_U32 mpp_buffer_debug;
  *                            It required map to access. This is an optimization
  *                            for reducing virtual memory usage.
  *
- *  mpp_buffer_get_unused   : get unused buffer with size. it will first search
- *                            the unused list. if failed it will create on from
+ *  mpp_buffer_get_unused   : get unused buffer with size. it will search the
+ *                            size class bucket of unused buffer for the best
+ *                            fit one. if failed caller will create one from
  *                            group allocator.
  *
  *  mpp_buffer_ref_inc      : increase buffer's reference counter. if it is unused
@@ -151,7 +222,13 @@ MPP_RET mpp_buffer_group_deinit(MppBufferGroupImpl *p);
 MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p);
 MPP_RET mpp_buffer_group_set_callback(MppBufferGroupImpl *p,
                                       MppBufCallback callback, void *arg);
+
+MPP_RET mpp_buffer_pool_init(MppBufferPoolImpl **pool, MppBufferType type, size_t limit);
+MPP_RET mpp_buffer_pool_deinit(MppBufferPoolImpl *pool);
+MPP_RET mpp_buffer_group_set_pool(MppBufferGroupImpl *p, MppBufferPoolImpl *pool,
+                                  size_t reserve);
 // mpp_buffer_group helper function
+void mpp_buffer_group_env_placement(MppBufferGroupImpl *p);
 void mpp_buffer_group_dump(MppBufferGroupImpl *p);
 void mpp_buffer_service_dump();
 MppBufferGroupImpl *mpp_buffer_get_misc_group(MppBufferMode mode, MppBufferType type);
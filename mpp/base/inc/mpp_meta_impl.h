@@ -19,25 +19,50 @@
 
 #include "mpp_common.h"
 
-#include "mpp_list.h"
 #include "mpp_meta.h"
 
+/*
+ * All meta key / type pairs. The position in this table is the value slot
+ * index of the key in MppMetaImpl.
+ */
+#define META_ENTRY_TABLE(ENTRY) \
+    /* data flow type */ \
+    ENTRY(INPUT_FRAME,          FRAME)  \
+    ENTRY(OUTPUT_FRAME,         FRAME)  \
+    ENTRY(INPUT_PACKET,         PACKET) \
+    ENTRY(OUTPUT_PACKET,        PACKET) \
+    /* buffer for motion detection */ \
+    ENTRY(MOTION_INFO,          BUFFER) \
+    /* buffer storing the HDR information for current frame*/ \
+    ENTRY(HDR_INFO,             BUFFER) \
+    ENTRY(OUTPUT_INTRA,         S32)    \
+    ENTRY(INPUT_BLOCK,          S32)    \
+    ENTRY(OUTPUT_BLOCK,         S32)    \
+    /* extra information for tsvc */ \
+    ENTRY(TEMPORAL_ID,          S32)    \
+    ENTRY(LONG_REF_IDX,         S32)    \
+    ENTRY(ROI_DATA,             PTR)    \
+    ENTRY(OSD_DATA,             PTR)    \
+    ENTRY(USER_DATA,            PTR)    \
+    ENTRY(MV_LIST,              PTR)    \
+    ENTRY(ENC_MARK_LTR,         S32)    \
+    ENTRY(ENC_USE_LTR,          S32)    \
+    ENTRY(ENC_FRAME_QP,         S32)    \
+    ENTRY(ENC_BASE_LAYER_PID,   S32)
+
+#define EXPAND_AS_META_INDEX(key, type) \
+    META_INDEX_##key,
+
+typedef enum MppMetaIndex_e {
+    META_ENTRY_TABLE(EXPAND_AS_META_INDEX)
+    META_INDEX_BUTT,
+} MppMetaIndex;
+
 typedef struct MppMetaDef_t {
     MppMetaKey          key;
     MppMetaType         type;
 } MppMetaDef;
 
-typedef struct MppMetaImpl_t {
-    char                tag[MPP_TAG_SIZE];
-    const char          *caller;
-    RK_S32              meta_id;
-    RK_S32              ref_count;
-
-    struct list_head    list_meta;
-    struct list_head    list_node;
-    RK_S32              node_count;
-} MppMetaImpl;
-
 typedef union MppMetaVal_u {
     RK_S32              val_s32;
     RK_S64              val_s64;
@@ -47,15 +72,20 @@ typedef union MppMetaVal_u {
     MppBuffer           buffer;
 } MppMetaVal;
 
-typedef struct MppMetaNode_t {
-    struct list_head    list_meta;
-    struct list_head    list_node;
-    MppMetaImpl         *meta;
-    RK_S32              node_id;
+/*
+ * Meta value is stored in the slot of its key index and is valid when the
+ * slot is marked in is_set. Get on a key consumes the value.
+ */
+typedef struct MppMetaImpl_t {
+    char                tag[MPP_TAG_SIZE];
+    const char          *caller;
+    RK_S32              meta_id;
+    RK_S32              ref_count;
 
-    RK_S32              type_id;
-    MppMetaVal          val;
-} MppMetaNode;
+    RK_S32              node_count;
+    RK_U8               is_set[META_INDEX_BUTT];
+    MppMetaVal          vals[META_INDEX_BUTT];
+} MppMetaImpl;
 
 #ifdef __cplusplus
 extern "C" {
@@ -63,7 +93,7 @@ extern "C" {
 
 RK_S32 mpp_meta_size(MppMeta meta);
 MPP_RET mpp_meta_inc_ref(MppMeta meta);
-MppMetaNode *mpp_meta_next_node(MppMeta meta);
+void mpp_meta_dump(MppMeta meta);
 
 #ifdef __cplusplus
 }
@@ -18,6 +18,7 @@
 #define __MPP_PACKET_IMPL_H__
 
 #include "mpp_meta.h"
+#include "mpp_mem_pool.h"
 
 #define MPP_PACKET_FLAG_EOS             (0x00000001)
 #define MPP_PACKET_FLAG_EXTRA_DATA      (0x00000002)
@@ -32,6 +33,8 @@
  * length   : valid data length
  * pts      : packet pts
  * dts      : packet dts
+ * pool     : memory pool of internal data, NULL for malloc data
+ * release  : release callback of referenced data from user
  */
 typedef struct MppPacketImpl_t {
     const char  *name;
@@ -48,6 +51,10 @@ typedef struct MppPacketImpl_t {
 
     MppBuffer   buffer;
     MppMeta     meta;
+    MppMemPool  pool;
+
+    MppPacketReleaseCb release;
+    void        *release_ctx;
 } MppPacketImpl;
 
 #ifdef __cplusplus
@@ -59,6 +66,12 @@ extern "C" {
 MPP_RET mpp_packet_reset(MppPacketImpl *packet);
 MPP_RET mpp_packet_copy(MppPacket dst, MppPacket src);
 MPP_RET mpp_packet_append(MppPacket dst, MppPacket src);
+/*
+ * mpp_packet_ref_init is copy_init without payload copy. The payload of src is
+ * given to the new packet and released by the callback on its deinit.
+ */
+MPP_RET mpp_packet_ref_init(MppPacket *packet, const MppPacket src,
+                            MppPacketReleaseCb release, void *ctx);
 
 /* pointer check function */
 MPP_RET check_is_mpp_packet(void *ptr);
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_PS_CACHE_H__
+#define __MPP_PS_CACHE_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+/*
+ * Parameter set cache for the decoder parsers
+ *
+ * The cache has one slot per parameter set id and keeps the raw bytes the
+ * parameter set in that id was parsed from. A parser looks up the raw bytes
+ * of each new parameter set before parsing it. On hit the parameter set in
+ * the returned id is already the one these bytes describe and the parse can
+ * be skipped. On miss the parser parses as usual and updates the slot when
+ * the parsed parameter set is stored.
+ *
+ * The parser MUST remove the slot whenever the parameter set stored in the
+ * id is dropped or becomes invalid without update.
+ */
+typedef void* MppPsCache;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_ps_cache_init(MppPsCache *cache, RK_S32 count);
+MPP_RET mpp_ps_cache_deinit(MppPsCache cache);
+
+/* return the id holding the same bytes or -1 on miss */
+RK_S32  mpp_ps_cache_lookup(MppPsCache cache, const RK_U8 *data, RK_S32 size);
+MPP_RET mpp_ps_cache_update(MppPsCache cache, RK_S32 id, const RK_U8 *data, RK_S32 size);
+/* remove one id or all ids with id -1 */
+void    mpp_ps_cache_remove(MppPsCache cache, RK_S32 id);
+
+/* accumulate the lookup hit / miss count of the cache */
+void    mpp_ps_cache_stats(MppPsCache cache, RK_U32 *hit, RK_U32 *miss);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_PS_CACHE_H__*/
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_STARTCODE_H__
+#define __MPP_STARTCODE_H__
+
+#include "rk_type.h"
+
+/*
+ * Annex-B / MPEG start code (0x000001) search shared by all byte stream
+ * parsers.
+ *
+ * The search is done with SSE2/AVX2 on x86, NEON on ARM and a word-at-a-time
+ * fallback elsewhere. The backend is selected once on the first call.
+ *
+ * All offsets returned point to the first 0x00 of the 0x000001 sequence and
+ * only start codes which are fully contained in the buffer are reported.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * mpp_find_startcode    - return the offset of the first start code or -1
+ * mpp_find_startcodes   - store the offsets of up to max start codes into pos
+ *                         and return the count of start codes found
+ */
+RK_S32 mpp_find_startcode(const RK_U8 *buf, RK_S32 size);
+RK_S32 mpp_find_startcodes(const RK_U8 *buf, RK_S32 size, RK_S32 *pos, RK_S32 max);
+
+/*
+ * Shift the last (up to 8) bytes of buf into a byte history register like
+ * the prefix / state variable used by the per-byte parser loops.
+ */
+RK_U64 mpp_startcode_state(RK_U64 state, const RK_U8 *buf, RK_S32 size);
+
+/*
+ * Return the byte count which can be consumed from buf before the parser has
+ * to look at the stream again: up to and including the next start code, the
+ * whole buffer when there is none or one byte when state already ends with a
+ * partial start code.
+ */
+RK_S32 mpp_startcode_skip(RK_U64 state, const RK_U8 *buf, RK_S32 size);
+
+/* name of the search backend in use */
+const char *mpp_startcode_impl_name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_STARTCODE_H__*/
@@ -22,30 +22,154 @@
 #include "mpp_bitread.h"
 
 
-static MPP_RET update_curbyte(BitReadCtx_t *bitctx)
+#define BITREAD_BYTE_03     0x0303030303030303ULL
+#define BITREAD_BYTE_LSB    0x0101010101010101ULL
+#define BITREAD_BYTE_MSB    0x8080808080808080ULL
+
+static inline RK_S32 bitread_clz64(RK_U64 val)
 {
-    if (bitctx->bytes_left_ < 1)
-        return  MPP_ERR_READ_BIT;
+#if defined(__GNUC__)
+    return __builtin_clzll(val);
+#else
+    RK_S32 cnt = 0;
 
-    // Emulation prevention three-byte detection.
-    // If a sequence of 0x000003 is found, skip (ignore) the last byte (0x03).
-    if (bitctx->need_prevention_detection
-        && (*bitctx->data_ == 0x03)
-        && ((bitctx->prev_two_bytes_ & 0xffff) == 0)) {
-        // Detected 0x000003, skip last byte.
-        ++bitctx->data_;
-        --bitctx->bytes_left_;
-        ++bitctx->emulation_prevention_bytes_;
-        // Need another full three bytes before we can detect the sequence again.
-        bitctx->prev_two_bytes_ = 0xffff;
-        if (bitctx->bytes_left_ < 1)
-            return  MPP_ERR_READ_BIT;
+    while (!(val & (1ULL << 63))) {
+        val <<= 1;
+        cnt++;
+    }
+    return cnt;
+#endif
+}
+
+static inline RK_S32 bitread_popcount(RK_U32 val)
+{
+#if defined(__GNUC__)
+    return __builtin_popcount(val);
+#else
+    RK_S32 cnt = 0;
+
+    while (val) {
+        val &= val - 1;
+        cnt++;
+    }
+    return cnt;
+#endif
+}
+
+static inline RK_U64 bitread_load_be64(const RK_U8 *data)
+{
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    RK_U64 val;
+
+    memcpy(&val, data, sizeof(val));
+    return __builtin_bswap64(val);
+#else
+    RK_U64 val = 0;
+    RK_S32 i;
+
+    for (i = 0; i < 8; i++)
+        val = (val << 8) | data[i];
+    return val;
+#endif
+}
+
+/*!
+***********************************************************************
+* \brief
+*   update the byte reader fields from the cache state
+***********************************************************************
+*/
+static void bitread_sync(BitReadCtx_t *bitctx)
+{
+    // full bytes in cache and the emulation prevention bytes before them
+    RK_S32 bytes = bitctx->cache_bits_ >> 3;
+    RK_S32 skipped = bitread_popcount(bitctx->cache_epb_ & ((1 << bytes) - 1));
+
+    bitctx->data_ = bitctx->cache_ptr_ - bytes - skipped;
+    bitctx->bytes_left_ = bitctx->cache_left_ + bytes + skipped;
+    bitctx->num_remaining_bits_in_curr_byte_ = bitctx->cache_bits_ & 7;
+    bitctx->curr_byte_ = (bytes < 8) ? ((bitctx->cache_ >> (bytes * 8)) & 0xff) : 0;
+    bitctx->emulation_prevention_bytes_ = bitctx->cache_epb_cnt_ - skipped;
+}
+
+/*!
+***********************************************************************
+* \brief
+*   fill the cache with as many whole bytes as it can hold
+*   8 bytes are loaded at once when they contain no 0x03 byte
+***********************************************************************
+*/
+static void bitread_refill(BitReadCtx_t *bitctx)
+{
+    RK_S32 bytes = (64 - bitctx->cache_bits_) >> 3;
+
+    if (!bytes)
+        return;
+
+    if (bitctx->cache_left_ >= 8) {
+        RK_U64 val = bitread_load_be64(bitctx->cache_ptr_);
+        RK_U64 cmp = val ^ BITREAD_BYTE_03;
+
+        if (!bitctx->need_prevention_detection ||
+            !((cmp - BITREAD_BYTE_LSB) & ~cmp & BITREAD_BYTE_MSB)) {
+            RK_S32 shift = bytes * 8;
+            RK_U64 add = (bytes == 8) ? val : (val >> (64 - shift));
+
+            bitctx->cache_ = (bytes == 8) ? val : ((bitctx->cache_ << shift) | add);
+            bitctx->cache_bits_ += shift;
+            bitctx->cache_ptr_ += bytes;
+            bitctx->cache_left_ -= bytes;
+            bitctx->cache_epb_ <<= bytes;
+            bitctx->prev_two_bytes_ = ((bitctx->prev_two_bytes_ << 8) | add) & 0xffff;
+            if (bytes > 1)
+                bitctx->prev_two_bytes_ = add & 0xffff;
+            return;
+        }
     }
-    // Load a new byte and advance pointers.
-    bitctx->curr_byte_ = *bitctx->data_++ & 0xff;
-    --bitctx->bytes_left_;
-    bitctx->num_remaining_bits_in_curr_byte_ = 8;
-    bitctx->prev_two_bytes_ = (bitctx->prev_two_bytes_ << 8) | bitctx->curr_byte_;
+
+    while (bytes-- && bitctx->cache_left_) {
+        RK_U32 skip = 0;
+        RK_U8 byte;
+
+        // Emulation prevention three-byte detection.
+        // If a sequence of 0x000003 is found, skip (ignore) the last byte (0x03).
+        if (bitctx->need_prevention_detection
+            && (*bitctx->cache_ptr_ == 0x03)
+            && ((bitctx->prev_two_bytes_ & 0xffff) == 0)) {
+            // Keep the trailing 0x03 unread like the byte reader does.
+            if (bitctx->cache_left_ < 2)
+                break;
+            ++bitctx->cache_ptr_;
+            --bitctx->cache_left_;
+            ++bitctx->cache_epb_cnt_;
+            // Need another full three bytes before we can detect the sequence again.
+            bitctx->prev_two_bytes_ = 0xffff;
+            skip = 1;
+        }
+        byte = *bitctx->cache_ptr_++;
+        --bitctx->cache_left_;
+        bitctx->cache_ = (bitctx->cache_ << 8) | byte;
+        bitctx->cache_bits_ += 8;
+        bitctx->cache_epb_ = (bitctx->cache_epb_ << 1) | skip;
+        bitctx->prev_two_bytes_ = ((bitctx->prev_two_bytes_ << 8) | byte) & 0xffff;
+    }
+}
+
+/*!
+***********************************************************************
+* \brief
+*   get |num_bits| (0 to 32 inclusive) from the cache
+***********************************************************************
+*/
+static inline MPP_RET bitread_peek(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_U32 *out)
+{
+    if (bitctx->cache_bits_ < num_bits) {
+        bitread_refill(bitctx);
+        if (bitctx->cache_bits_ < num_bits)
+            return MPP_ERR_READ_BIT;
+    }
+    *out = (RK_U32)((bitctx->cache_ >> (bitctx->cache_bits_ - num_bits)) &
+                    ((1ULL << num_bits) - 1));
 
     return MPP_OK;
 }
@@ -60,23 +184,19 @@ static MPP_RET update_curbyte(BitReadCtx_t *bitctx)
 */
 MPP_RET mpp_read_bits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_S32 *out)
 {
-    RK_S32 bits_left = num_bits;
+    RK_U32 val = 0;
+
     *out = 0;
-    if (num_bits > 31) {
+    if (num_bits < 0 || num_bits > 31) {
         return  MPP_ERR_READ_BIT;
     }
-    while (bitctx->num_remaining_bits_in_curr_byte_ < bits_left) {
-        // Take all that's left in current byte, shift to make space for the rest.
-        *out |= (bitctx->curr_byte_ << (bits_left - bitctx->num_remaining_bits_in_curr_byte_));
-        bits_left -= bitctx->num_remaining_bits_in_curr_byte_;
-        if (update_curbyte(bitctx)) {
-            return  MPP_ERR_READ_BIT;
-        }
+    if (bitread_peek(bitctx, num_bits, &val)) {
+        return  MPP_ERR_READ_BIT;
     }
-    *out |= (bitctx->curr_byte_ >> (bitctx->num_remaining_bits_in_curr_byte_ - bits_left));
-    *out &= ((1 << num_bits) - 1);
-    bitctx->num_remaining_bits_in_curr_byte_ -= bits_left;
+    *out = (RK_S32)val;
+    bitctx->cache_bits_ -= num_bits;
     bitctx->used_bits += num_bits;
+    bitread_sync(bitctx);
 
     return MPP_OK;
 }
@@ -93,6 +213,16 @@ MPP_RET mpp_read_longbits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_U32 *out)
     if (num_bits < 32)
         return mpp_read_bits(bitctx, num_bits, (RK_S32 *)out);
 
+    if (num_bits == 32) {
+        if (bitread_peek(bitctx, num_bits, out)) {
+            return  MPP_ERR_READ_BIT;
+        }
+        bitctx->cache_bits_ -= num_bits;
+        bitctx->used_bits += num_bits;
+        bitread_sync(bitctx);
+        return MPP_OK;
+    }
+
     if (mpp_read_bits(bitctx, 16, &val)) {
         return  MPP_ERR_READ_BIT;
     }
@@ -114,15 +244,20 @@ MPP_RET mpp_skip_bits(BitReadCtx_t *bitctx, RK_S32 num_bits)
 {
     RK_S32 bits_left = num_bits;
 
-    while (bitctx->num_remaining_bits_in_curr_byte_ < bits_left) {
-        // Take all that's left in current byte, shift to make space for the rest.
-        bits_left -= bitctx->num_remaining_bits_in_curr_byte_;
-        if (update_curbyte(bitctx)) {
+    while (bitctx->cache_bits_ < bits_left) {
+        // Take all that's left in the cache and load the rest.
+        bits_left -= bitctx->cache_bits_;
+        bitctx->cache_bits_ = 0;
+        bitread_refill(bitctx);
+        if (!bitctx->cache_bits_) {
+            bitread_sync(bitctx);
             return  MPP_ERR_READ_BIT;
         }
     }
-    bitctx->num_remaining_bits_in_curr_byte_ -= bits_left;
+    if (bits_left > 0)
+        bitctx->cache_bits_ -= bits_left;
     bitctx->used_bits += num_bits;
+    bitread_sync(bitctx);
 
     return MPP_OK;
 }
@@ -134,13 +269,7 @@ MPP_RET mpp_skip_bits(BitReadCtx_t *bitctx, RK_S32 num_bits)
 */
 MPP_RET mpp_skip_longbits(BitReadCtx_t *bitctx, RK_S32 num_bits)
 {
-    if (mpp_skip_bits(bitctx, 16)) {
-        return  MPP_ERR_READ_BIT;
-    }
-    if (mpp_skip_bits(bitctx, (num_bits - 16))) {
-        return  MPP_ERR_READ_BIT;
-    }
-    return MPP_OK;
+    return mpp_skip_bits(bitctx, num_bits);
 }
 /*!
 ***********************************************************************
@@ -150,15 +279,11 @@ MPP_RET mpp_skip_longbits(BitReadCtx_t *bitctx, RK_S32 num_bits)
 */
 MPP_RET mpp_show_bits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_S32 *out)
 {
-    MPP_RET ret = MPP_ERR_UNKNOW;
-    BitReadCtx_t tmp_ctx = *bitctx;
-
-    if (num_bits < 32)
-        ret = mpp_read_bits(&tmp_ctx, num_bits, out);
-    else
-        ret = mpp_read_longbits(&tmp_ctx, num_bits, (RK_U32 *)out);
+    *out = 0;
+    if (num_bits >= 0 && num_bits <= 32)
+        return bitread_peek(bitctx, num_bits, (RK_U32 *)out);
 
-    return ret;
+    return mpp_show_longbits(bitctx, num_bits, (RK_U32 *)out);
 }
 /*!
 ***********************************************************************
@@ -169,7 +294,12 @@ MPP_RET mpp_show_bits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_S32 *out)
 MPP_RET mpp_show_longbits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_U32 *out)
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
-    BitReadCtx_t tmp_ctx = *bitctx;
+    BitReadCtx_t tmp_ctx;
+
+    if (num_bits >= 0 && num_bits <= 32)
+        return bitread_peek(bitctx, num_bits, out);
+
+    tmp_ctx = *bitctx;
 
     ret = mpp_read_longbits(&tmp_ctx, num_bits, out);
 
@@ -186,6 +316,26 @@ MPP_RET mpp_read_ue(BitReadCtx_t *bitctx, RK_U32 *val)
     RK_S32 num_bits = -1;
     RK_S32 bit;
     RK_S32 rest;
+
+    if (bitctx->cache_bits_ < 32)
+        bitread_refill(bitctx);
+    // Whole code in cache, count leading zero bits and read it at once.
+    if (bitctx->cache_bits_) {
+        RK_U64 top = bitctx->cache_ << (64 - bitctx->cache_bits_);
+
+        if (top) {
+            RK_S32 len = bitread_clz64(top) * 2 + 1;
+
+            if (len <= bitctx->cache_bits_) {
+                *val = (RK_U32)((bitctx->cache_ >> (bitctx->cache_bits_ - len)) &
+                                ((1ULL << len) - 1)) - 1;
+                bitctx->cache_bits_ -= len;
+                bitctx->used_bits += len;
+                bitread_sync(bitctx);
+                return MPP_OK;
+            }
+        }
+    }
     // Count the number of contiguous zero bits.
     do {
         if (mpp_read_bits(bitctx, 1, &bit)) {
@@ -236,23 +386,52 @@ MPP_RET mpp_read_se(BitReadCtx_t *bitctx, RK_S32 *val)
 */
 RK_U32 mpp_has_more_rbsp_data(BitReadCtx_t *bitctx)
 {
+    RK_U32 ret = 0;
+
     // remove tail byte which equal zero
-    while (bitctx->bytes_left_ &&
-           bitctx->data_[bitctx->bytes_left_ - 1] == 0)
-        bitctx->bytes_left_--;
-
-    // Make sure we have more bits, if we are at 0 bits in current byte
-    // and updating current byte fails, we don't have more data anyway.
-    if (bitctx->num_remaining_bits_in_curr_byte_ == 0 && update_curbyte(bitctx))
-        return 0;
-    // On last byte?
-    if (bitctx->bytes_left_)
-        return 1;
-    // Last byte, look for stop bit;
-    // We have more RBSP data if the last non-zero bit we find is not the
-    // first available bit.
-    return (bitctx->curr_byte_ &
-            ((1 << (bitctx->num_remaining_bits_in_curr_byte_ - 1)) - 1)) != 0;
+    while (bitctx->cache_left_ &&
+           bitctx->cache_ptr_[bitctx->cache_left_ - 1] == 0)
+        bitctx->cache_left_--;
+
+    // tail bytes may have been loaded into the cache already
+    if (!bitctx->cache_left_) {
+        while (bitctx->cache_bits_ >= 8 && !(bitctx->cache_ & 0xff)) {
+            RK_U32 epb = bitctx->cache_epb_ & 1;
+
+            bitctx->cache_ >>= 8;
+            bitctx->cache_bits_ -= 8;
+            bitctx->cache_epb_ >>= 1;
+            bitctx->cache_ptr_--;
+            if (epb) {
+                // stop at the emulation prevention byte and put it back
+                bitctx->cache_ptr_--;
+                bitctx->cache_left_ = 1;
+                bitctx->cache_epb_cnt_--;
+                bitctx->prev_two_bytes_ = 0;
+                break;
+            }
+        }
+    }
+
+    // Make sure we have more bits, if we are at 0 bits in cache
+    // and updating cache fails, we don't have more data anyway.
+    if (!bitctx->cache_bits_)
+        bitread_refill(bitctx);
+
+    if (!bitctx->cache_bits_) {
+        ret = 0;
+    } else if (((bitctx->cache_bits_ - 1) >> 3) || bitctx->cache_left_) {
+        // Not on last byte
+        ret = 1;
+    } else {
+        // Last byte, look for stop bit;
+        // We have more RBSP data if the last non-zero bit we find is not the
+        // first available bit.
+        ret = (bitctx->cache_ & ((1 << (bitctx->cache_bits_ - 1)) - 1)) != 0;
+    }
+    bitread_sync(bitctx);
+
+    return ret;
 }
 /*!
 ***********************************************************************
@@ -274,6 +453,8 @@ void mpp_set_bitread_ctx(BitReadCtx_t *bitctx, RK_U8 *data, RK_S32 size)
     bitctx->buf_len = size;
     bitctx->used_bits = 0;
     bitctx->need_prevention_detection = 0;
+    bitctx->cache_ptr_ = data;
+    bitctx->cache_left_ = size;
 }
 /*!
 ***********************************************************************
@@ -293,7 +474,7 @@ void mpp_set_pre_detection(BitReadCtx_t *bitctx)
 */
 RK_U8 *mpp_align_get_bits(BitReadCtx_t *bitctx)
 {
-    int n = bitctx->num_remaining_bits_in_curr_byte_;
+    int n = bitctx->cache_bits_ & 7;
     if (n)
         mpp_skip_bits(bitctx, n);
     return bitctx->data_;
@@ -22,6 +22,7 @@
 #include "mpp_mem.h"
 #include "mpp_env.h"
 #include "mpp_list.h"
+#include "mpp_atomic.h"
 #include "mpp_common.h"
 
 #include "mpp_frame_impl.h"
@@ -180,6 +181,7 @@ typedef struct MppBufSlotLog_t {
 struct MppBufSlotEntry_t {
     MppBufSlotsImpl     *slots;
     struct list_head    list;
+    // status is changed by atomic operation without lock
     SlotStatus          status;
     RK_S32              index;
 
@@ -188,6 +190,12 @@ struct MppBufSlotEntry_t {
     MppBuffer           buffer;
 };
 
+/*
+ * Slot status flag set / clear is lock free by atomic operation on status.
+ * The lock is for the queues, the slot frame / buffer property and the info.
+ * Slot release on last flag clear also takes the lock for frame / buffer.
+ * Slot count change on setup / ready requires all slots to be unused.
+ */
 struct MppBufSlotsImpl_t {
     Mutex               *lock;
     RK_U32              slots_idx;
@@ -209,6 +217,7 @@ struct MppBufSlotsImpl_t {
     AlignFunc           hal_len_align;          // default NULL
     size_t              buf_size;
     RK_S32              buf_count;
+    // changed by atomic operation
     RK_S32              used_count;
     // buffer size equal to (h_stride * v_stride) * numerator / denominator
     // internal parameter
@@ -237,7 +246,8 @@ static RK_U32 default_align_16(RK_U32 val)
     return MPP_ALIGN(val, 16);
 }
 
-static void generate_info_set(MppBufSlotsImpl *impl, MppFrame frame, RK_U32 force_default_align)
+static RK_U32 calc_info_size(MppBufSlotsImpl *impl, MppFrame frame, RK_U32 force_default_align,
+                             RK_U32 *hor_stride, RK_U32 *ver_stride)
 {
     RK_U32 width  = mpp_frame_get_width(frame);
     RK_U32 height = mpp_frame_get_height(frame);
@@ -261,6 +271,21 @@ static void generate_info_set(MppBufSlotsImpl *impl, MppFrame frame, RK_U32 forc
     size /= impl->denominator;
     size = impl->hal_len_align ? impl->hal_len_align(hal_hor_stride * hal_ver_stride) : size;
 
+    *hor_stride = hal_hor_stride;
+    *ver_stride = hal_ver_stride;
+    return size;
+}
+
+static void generate_info_set(MppBufSlotsImpl *impl, MppFrame frame, RK_U32 force_default_align)
+{
+    RK_U32 width  = mpp_frame_get_width(frame);
+    RK_U32 height = mpp_frame_get_height(frame);
+    MppFrameFormat fmt = mpp_frame_get_fmt(frame);
+    RK_U32 hal_hor_stride = 0;
+    RK_U32 hal_ver_stride = 0;
+    RK_U32 size = calc_info_size(impl, frame, force_default_align,
+                                 &hal_hor_stride, &hal_ver_stride);
+
     mpp_frame_set_width(impl->info_set, width);
     mpp_frame_set_height(impl->info_set, height);
     mpp_frame_set_fmt(impl->info_set, fmt);
@@ -302,6 +327,8 @@ static void _dump_slots(const char *caller, MppBufSlotsImpl *impl)
 
     mpp_list *logs = impl->logs;
     if (logs) {
+        AutoMutex auto_lock(logs->mutex());
+
         while (logs->list_size()) {
             MppBufSlotLog log;
             logs->del_at_head(&log, sizeof(log));
@@ -324,18 +351,20 @@ static void add_slot_log(mpp_list *logs, RK_S32 index, MppBufSlotOps op, SlotSta
             before,
             after,
         };
+        // log has its own lock for lock free status operation
+        AutoMutex auto_lock(logs->mutex());
+
         if (logs->list_size() >= SLOT_OPS_MAX_COUNT)
             logs->del_at_head(NULL, sizeof(log));
         logs->add_at_tail(&log, sizeof(log));
     }
 }
 
-static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppBufSlotOps op, void *arg)
+static RK_U32 status_op(SlotStatus *p, MppBufSlotOps op, void *arg, RK_S32 index)
 {
+    SlotStatus status = *p;
     RK_U32 error = 0;
-    RK_S32 index = slot->index;
-    SlotStatus status = slot->status;
-    SlotStatus before = status;
+
     switch (op) {
     case SLOT_INIT : {
         status.val = 0;
@@ -371,7 +400,7 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
         if (status.hal_use)
             status.hal_use--;
         else {
-            mpp_err("can not clr hal_input on slot %d\n", slot->index);
+            mpp_err("can not clr hal_input on slot %d\n", index);
             error = 1;
         }
     } break;
@@ -399,7 +428,7 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
         if (status.queue_use)
             status.queue_use--;
         else {
-            mpp_err("can not clr queue_use on slot %d\n", slot->index);
+            mpp_err("can not clr queue_use on slot %d\n", index);
             error = 1;
         }
     } break;
@@ -408,7 +437,6 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
     } break;
     case SLOT_CLR_EOS : {
         status.eos = 0;
-        slot->eos = 0;
     } break;
     case SLOT_SET_FRAME : {
         status.has_frame = (arg) ? (1) : (0);
@@ -427,12 +455,44 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
         error = 1;
     } break;
     }
-    slot->status = status;
+    *p = status;
+
+    return error;
+}
+
+static SlotStatus slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppBufSlotOps op, void *arg)
+{
+    RK_U32 error = 0;
+    RK_S32 index = slot->index;
+    SlotStatus before;
+    SlotStatus status;
+
+    do {
+        before.val = MPP_LOAD_ACQUIRE(&slot->status.val);
+        status = before;
+        error = status_op(&status, op, arg, index);
+    } while (!MPP_BOOL_CAS(&slot->status.val, before.val, status.val));
+
+    if (op == SLOT_CLR_EOS)
+        slot->eos = 0;
+
     buf_slot_dbg(BUF_SLOT_DBG_OPS_RUNTIME, "slot %3d index %2d op: %s arg %010p status in %08x out %08x",
                  impl->slots_idx, index, op_string[op], arg, before.val, status.val);
     add_slot_log(impl->logs, index, op, before, status);
     if (error)
         dump_slots(impl);
+
+    return status;
+}
+
+static RK_U32 is_entry_unused(SlotStatus status)
+{
+    return status.on_used &&
+           !status.not_ready &&
+           !status.codec_use &&
+           !status.hal_output &&
+           !status.hal_use &&
+           !status.queue_use;
 }
 
 static void init_slot_entry(MppBufSlotsImpl *impl, RK_S32 pos, RK_S32 count)
@@ -448,21 +508,18 @@ static void init_slot_entry(MppBufSlotsImpl *impl, RK_S32 pos, RK_S32 count)
 }
 
 /*
- * only called on unref / displayed / decoded
+ * only called on unref / displayed / decoded with lock
  *
  * NOTE: MppFrame will be destroyed outside mpp
  *       but MppBuffer must dec_ref here
  */
 static void check_entry_unused(MppBufSlotsImpl *impl, MppBufSlotEntry *entry)
 {
-    SlotStatus status = entry->status;
-
-    if (status.on_used &&
-        !status.not_ready &&
-        !status.codec_use &&
-        !status.hal_output &&
-        !status.hal_use &&
-        !status.queue_use) {
+    SlotStatus status;
+
+    status.val = MPP_LOAD_ACQUIRE(&entry->status.val);
+
+    if (is_entry_unused(status)) {
         if (entry->frame) {
             slot_ops_with_log(impl, entry, SLOT_CLR_FRAME, entry->frame);
             mpp_frame_deinit(&entry->frame);
@@ -474,7 +531,7 @@ static void check_entry_unused(MppBufSlotsImpl *impl, MppBufSlotEntry *entry)
         }
 
         slot_ops_with_log(impl, entry, SLOT_CLR_ON_USE, NULL);
-        impl->used_count--;
+        MPP_SUB_FETCH(&impl->used_count, 1);
     }
 }
 
@@ -540,7 +597,7 @@ MPP_RET mpp_buf_slot_init(MppBufSlots *slots)
         }
 
         if (buf_slot_debug & BUF_SLOT_DBG_OPS_HISTORY) {
-            impl->logs = new mpp_list(NULL);
+            impl->logs = new mpp_list(sizeof(MppBufSlotLog), SLOT_OPS_MAX_COUNT);
             if (NULL == impl->logs)
                 break;
         }
@@ -649,6 +706,8 @@ MPP_RET mpp_buf_slot_ready(MppBufSlots slots)
 
     if (impl->logs) {
         mpp_list *logs = impl->logs;
+        AutoMutex auto_log_lock(logs->mutex());
+
         while (logs->list_size())
             logs->del_at_head(NULL, sizeof(MppBufSlotLog));
     }
@@ -656,6 +715,21 @@ MPP_RET mpp_buf_slot_ready(MppBufSlots slots)
     return MPP_OK;
 }
 
+size_t mpp_buf_slot_calc_size(MppBufSlots slots, MppFrame frame)
+{
+    if (NULL == slots || NULL == frame) {
+        mpp_err_f("found NULL input slots %p frame %p\n", slots, frame);
+        return 0;
+    }
+
+    MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
+    AutoMutex auto_lock(impl->lock);
+    RK_U32 hor_stride = 0;
+    RK_U32 ver_stride = 0;
+
+    return calc_info_size(impl, frame, 0, &hor_stride, &ver_stride);
+}
+
 size_t mpp_buf_slot_get_size(MppBufSlots slots)
 {
     if (NULL == slots) {
@@ -676,19 +750,34 @@ MPP_RET mpp_buf_slot_get_unused(MppBufSlots slots, RK_S32 *index)
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
     RK_S32 i;
     MppBufSlotEntry *slot = impl->slots;
     for (i = 0; i < impl->buf_count; i++, slot++) {
-        if (!slot->status.on_used) {
-            *index = i;
-            slot_ops_with_log(impl, slot, SLOT_SET_ON_USE, NULL);
-            slot_ops_with_log(impl, slot, SLOT_SET_NOT_READY, NULL);
-            impl->used_count++;
-            return MPP_OK;
-        }
+        SlotStatus before;
+        SlotStatus status;
+
+        before.val = MPP_LOAD_ACQUIRE(&slot->status.val);
+        if (before.on_used)
+            continue;
+
+        // take the slot only when it is still unused
+        status = before;
+        status.on_used = 1;
+        if (!MPP_BOOL_CAS(&slot->status.val, before.val, status.val))
+            continue;
+
+        buf_slot_dbg(BUF_SLOT_DBG_OPS_RUNTIME, "slot %3d index %2d op: %s arg %010p status in %08x out %08x",
+                     impl->slots_idx, i, op_string[SLOT_SET_ON_USE], NULL, before.val, status.val);
+        add_slot_log(impl->logs, i, SLOT_SET_ON_USE, before, status);
+
+        *index = i;
+        slot_ops_with_log(impl, slot, SLOT_SET_NOT_READY, NULL);
+        MPP_ADD_FETCH(&impl->used_count, 1);
+        return MPP_OK;
     }
 
+    AutoMutex auto_lock(impl->lock);
+
     *index = -1;
     mpp_err_f("failed to get a unused slot\n");
     dump_slots(impl);
@@ -704,7 +793,6 @@ MPP_RET mpp_buf_slot_set_flag(MppBufSlots slots, RK_S32 index, SlotUsageType typ
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
     slot_ops_with_log(impl, &impl->slots[index], set_flag_op[type], NULL);
     return MPP_OK;
@@ -718,15 +806,18 @@ MPP_RET mpp_buf_slot_clr_flag(MppBufSlots slots, RK_S32 index, SlotUsageType typ
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
     MppBufSlotEntry *slot = &impl->slots[index];
-    slot_ops_with_log(impl, slot, clr_flag_op[type], NULL);
+    SlotStatus status = slot_ops_with_log(impl, slot, clr_flag_op[type], NULL);
 
     if (type == SLOT_HAL_OUTPUT)
-        impl->decode_count++;
+        MPP_ADD_FETCH(&impl->decode_count, 1);
 
-    check_entry_unused(impl, slot);
+    // only the slot release needs lock for frame and buffer
+    if (is_entry_unused(status)) {
+        AutoMutex auto_lock(impl->lock);
+        check_entry_unused(impl, slot);
+    }
     return MPP_OK;
 }
 
@@ -980,8 +1071,7 @@ RK_S32 mpp_slots_get_used_count(MppBufSlots slots)
         return 0;
     }
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    return impl->used_count;
+    return MPP_LOAD_ACQUIRE(&impl->used_count);
 }
 
 RK_S32 mpp_slots_get_unused_count(MppBufSlots slots)
@@ -992,9 +1082,10 @@ RK_S32 mpp_slots_get_unused_count(MppBufSlots slots)
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    slot_assert(impl, (impl->used_count >= 0) && (impl->used_count <= impl->buf_count));
-    return impl->buf_count - impl->used_count;
+    RK_S32 used_count = MPP_LOAD_ACQUIRE(&impl->used_count);
+
+    slot_assert(impl, (used_count >= 0) && (used_count <= impl->buf_count));
+    return impl->buf_count - used_count;
 }
 
 MPP_RET mpp_slots_set_prop(MppBufSlots slots, SlotsPropType type, void *val)
@@ -377,3 +377,154 @@ MPP_RET mpp_buffer_group_limit_config(MppBufferGroup group, size_t size, RK_S32
     return MPP_OK;
 }
 
+MPP_RET mpp_buffer_group_reuse_config(MppBufferGroup group, RK_U32 keep_undersized)
+{
+    if (NULL == group) {
+        mpp_err_f("input invalid group %p\n", group);
+        return MPP_NOK;
+    }
+
+    MppBufferGroupImpl *p = (MppBufferGroupImpl *)group;
+    p->keep_undersized = (keep_undersized) ? (1) : (0);
+    return MPP_OK;
+}
+
+MPP_RET mpp_buffer_group_placement_config(MppBufferGroup group, MppBufferPage page,
+                                          RK_S32 numa_node)
+{
+    if (NULL == group || page >= MPP_BUFFER_PAGE_BUTT) {
+        mpp_err_f("input invalid group %p page %d\n", group, page);
+        return MPP_NOK;
+    }
+
+    MppBufferGroupImpl *p = (MppBufferGroupImpl *)group;
+    MppAllocatorCfg cfg;
+    MPP_RET ret = MPP_NOK;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.page = page;
+    cfg.numa_node = (numa_node < 0) ? (-1) : (numa_node);
+
+    if (p->alloc_api && p->alloc_api->version >= 2 && p->alloc_api->config)
+        ret = p->alloc_api->config(p->allocator, &cfg);
+
+    if (ret) {
+        mpp_err_f("group %d type %d does not support placement\n",
+                  p->group_id, p->type);
+        return ret;
+    }
+
+    p->page = page;
+    p->numa_node = cfg.numa_node;
+    return MPP_OK;
+}
+
+MPP_RET mpp_buffer_group_prealloc(MppBufferGroup group, size_t size, RK_S32 count)
+{
+    MppBufferGroupImpl *p = (MppBufferGroupImpl *)group;
+    MppBuffer *buffers = NULL;
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
+
+    if (NULL == p || 0 == size || count <= 0 || p->mode != MPP_BUFFER_INTERNAL) {
+        mpp_err_f("input invalid group %p size %d count %d\n", group, size, count);
+        return MPP_NOK;
+    }
+
+    buffers = mpp_calloc(MppBuffer, count);
+    if (NULL == buffers) {
+        mpp_err_f("failed to malloc %d buffers\n", count);
+        return MPP_ERR_MALLOC;
+    }
+
+    /* hold all buffers first then the fit unused ones are not fetched twice */
+    for (i = 0; i < count; i++) {
+        ret = mpp_buffer_get(group, &buffers[i], size);
+        if (ret) {
+            mpp_err_f("group %d only got %d of %d buffers size %d\n",
+                      p->group_id, i, count, size);
+            break;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        if (buffers[i])
+            mpp_buffer_put(buffers[i]);
+    }
+
+    mpp_free(buffers);
+    return ret;
+}
+
+MPP_RET mpp_buffer_pool_get(MppBufferPool *pool, MppBufferType type, size_t limit)
+{
+    if (NULL == pool || (type & MPP_BUFFER_TYPE_MASK) >= MPP_BUFFER_TYPE_BUTT) {
+        mpp_err_f("input invalid pool %p type %x\n", pool, type);
+        return MPP_ERR_UNKNOW;
+    }
+
+    return mpp_buffer_pool_init((MppBufferPoolImpl **)pool, type, limit);
+}
+
+MPP_RET mpp_buffer_pool_put(MppBufferPool pool)
+{
+    if (NULL == pool) {
+        mpp_err_f("input invalid pool %p\n", pool);
+        return MPP_NOK;
+    }
+
+    return mpp_buffer_pool_deinit((MppBufferPoolImpl *)pool);
+}
+
+MPP_RET mpp_buffer_group_attach_pool(MppBufferGroup group, MppBufferPool pool,
+                                     size_t reserve)
+{
+    if (NULL == group) {
+        mpp_err_f("input invalid group %p\n", group);
+        return MPP_NOK;
+    }
+
+    return mpp_buffer_group_set_pool((MppBufferGroupImpl *)group,
+                                     (MppBufferPoolImpl *)pool, reserve);
+}
+
+MPP_RET mpp_buffer_pool_stats(MppBufferPool pool, size_t *usage, size_t *idle,
+                              size_t *peak)
+{
+    if (NULL == pool) {
+        mpp_err_f("input invalid pool %p\n", pool);
+        return MPP_NOK;
+    }
+
+    MppBufferPoolImpl *p = (MppBufferPoolImpl *)pool;
+
+    pthread_mutex_lock(&p->lock);
+    if (usage)
+        *usage = p->usage;
+    if (idle)
+        *idle = p->idle;
+    if (peak)
+        *peak = p->peak;
+    pthread_mutex_unlock(&p->lock);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_buffer_group_reuse_stats(MppBufferGroup group, RK_U32 *hit,
+                                     RK_U32 *miss, RK_U32 *evict)
+{
+    if (NULL == group) {
+        mpp_err_f("input invalid group %p\n", group);
+        return MPP_NOK;
+    }
+
+    MppBufferGroupImpl *p = (MppBufferGroupImpl *)group;
+    if (hit)
+        *hit = p->hit_count;
+    if (miss)
+        *miss = p->miss_count;
+    if (evict)
+        *evict = p->evict_count;
+    return MPP_OK;
+}
+
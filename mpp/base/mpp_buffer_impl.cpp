@@ -21,15 +21,29 @@
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_env.h"
+#include "mpp_atomic.h"
 
 #include "mpp_buffer_impl.h"
 
 #define BUFFER_OPS_MAX_COUNT            1024
+// initial group table size for group id lookup, must be power of 2
+#define BUFFER_GROUP_TABLE_SIZE         1024
 
 #define SEARCH_GROUP_BY_ID(id)  ((MppBufferService::get_instance())->get_group_by_id(id))
 
 typedef MPP_RET (*BufferOp)(MppAllocator allocator, MppBufferInfo *data);
 
+/*
+ * group table indexed by group id & mask
+ * table is doubled when half full and the retired tables are kept on prev
+ * list until service exit for the readers without lock
+ */
+typedef struct MppBufferGroupTable_t {
+    struct MppBufferGroupTable_t *prev;
+    RK_U32              mask;
+    MppBufferGroupImpl  **slots;
+} MppBufferGroupTable;
+
 typedef enum MppBufOps_e {
     GRP_CREATE,
     GRP_RELEASE,
@@ -45,6 +59,8 @@ typedef enum MppBufOps_e {
     BUF_REF_DEC,
     BUF_DISCARD,
     BUF_DESTROY,
+    BUF_RETURN,
+    BUF_BORROW,
     BUF_OPS_BUTT,
 } MppBufOps;
 
@@ -70,7 +86,9 @@ private:
 
     // buffer group final release function
     void                destroy_group(MppBufferGroupImpl *group);
+    void                destroy_pool(MppBufferPoolImpl *pool);
 
+    MPP_RET             grow_table(RK_U32 size);
     RK_U32              get_group_id();
     RK_U32              group_id;
     RK_U32              group_count;
@@ -85,6 +103,15 @@ private:
     // list for used buffer which do not have group
     struct list_head    mListOrphan;
 
+    // shared pool of groups
+    struct list_head    mListPool;
+
+    /*
+     * group table indexed by group id for lookup without lock
+     * group id is allocated to avoid slot conflict in table
+     */
+    MppBufferGroupTable *mTable;
+
 public:
     static MppBufferService *get_instance() {
         static MppBufferService instance;
@@ -102,6 +129,10 @@ public:
     void                set_misc(MppBufferMode mode, MppBufferType type, MppBufferGroupImpl *val);
     void                put_group(MppBufferGroupImpl *group);
     MppBufferGroupImpl  *get_group_by_id(RK_U32 id);
+    MppBufferPoolImpl   *get_pool(MppBufferType type, size_t limit);
+    void                put_pool(MppBufferPoolImpl *pool);
+    MPP_RET             set_pool(MppBufferGroupImpl *group, MppBufferPoolImpl *pool,
+                                 size_t reserve);
     void                dump_misc_group();
     RK_U32              is_finalizing();
 };
@@ -111,11 +142,18 @@ static const char *mode2str[MPP_BUFFER_MODE_BUTT] = {
     "external",
 };
 
+static const char *page2str[MPP_BUFFER_PAGE_BUTT] = {
+    "default",
+    "thp",
+    "hugetlb",
+};
+
 static const char *type2str[MPP_BUFFER_TYPE_BUTT] = {
     "normal",
     "ion",
     "dma-buf",
     "drm",
+    "memfd",
 };
 static const char *ops2str[BUF_OPS_BUTT] = {
     "grp create ",
@@ -131,6 +169,8 @@ static const char *ops2str[BUF_OPS_BUTT] = {
     "buf ref dec",
     "buf discard",
     "buf destroy",
+    "buf return ",
+    "buf borrow ",
 };
 
 RK_U32 mpp_buffer_debug = 0;
@@ -193,6 +233,56 @@ static void buffer_group_dump_log(MppBufferGroupImpl *group)
     }
 }
 
+/*
+ * NOTE: pool helpers below are called with group lock held and take the
+ * pool lock inside.
+ */
+static void pool_free_idle_no_lock(MppBufferPoolImpl *pool, MppBufferImpl *buffer)
+{
+    list_del_init(&buffer->list_status);
+    pool->alloc_api->free(pool->allocator, &buffer->info);
+    pool->idle -= buffer->info.size;
+    pool->usage -= buffer->info.size;
+    mpp_free(buffer);
+}
+
+/* wake up the groups failed on pool limit */
+static void pool_notify_no_lock(MppBufferPoolImpl *pool, MppBufferGroupImpl *group)
+{
+    MppBufferGroupImpl *pos;
+
+    if (!pool->waiting)
+        return;
+
+    pool->waiting = 0;
+    list_for_each_entry(pos, &pool->list_members, MppBufferGroupImpl, list_member) {
+        if (pos == group)
+            continue;
+
+        /* do not wait on the other group lock to avoid dead lock */
+        if (pthread_mutex_trylock(&pos->buf_lock)) {
+            pool->waiting = 1;
+            continue;
+        }
+
+        if (pos->callback)
+            pos->callback(pos->arg, pos);
+
+        MPP_BUF_GROUP_UNLOCK(pos);
+    }
+}
+
+static void pool_release(MppBufferGroupImpl *group, size_t size)
+{
+    MppBufferPoolImpl *pool = group->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->usage -= size;
+    group->pool_usage -= size;
+    pool_notify_no_lock(pool, group);
+    pthread_mutex_unlock(&pool->lock);
+}
+
 static MPP_RET deinit_buffer_no_lock(MppBufferImpl *buffer, const char *caller)
 {
     if (!MppBufferService::get_instance()->is_finalizing()) {
@@ -209,12 +299,10 @@ static MPP_RET deinit_buffer_no_lock(MppBufferImpl *buffer, const char *caller)
         func(group->allocator, &buffer->info);
         group->usage -= buffer->info.size;
         group->buffer_count--;
+        if (group->pool)
+            pool_release(group, buffer->info.size);
 
         buffer_group_add_log(group, buffer, BUF_DESTROY, caller);
-
-        if (group->is_orphan && !group->usage) {
-            MppBufferService::get_instance()->put_group(group);
-        }
     } else {
         mpp_assert(MppBufferService::get_instance()->is_finalizing());
     }
@@ -243,10 +331,207 @@ static MPP_RET inc_buffer_ref_no_lock(MppBufferImpl *buffer, const char *caller)
         }
     }
     buffer_group_add_log(group, buffer, BUF_REF_INC, caller);
-    buffer->ref_count++;
+    MPP_ADD_FETCH(&buffer->ref_count, 1);
     return ret;
 }
 
+/*
+ * When no log is required the reference change which does not touch zero
+ * only need atomic operation on ref_count and does not take any lock.
+ */
+static RK_S32 try_change_ref_no_lock(MppBufferGroupImpl *group, MppBufferImpl *buffer, RK_S32 delta)
+{
+    RK_S32 ref;
+
+    if (group->log_runtime_en || group->log_history_en)
+        return 0;
+
+    ref = MPP_LOAD_RELAXED(&buffer->ref_count);
+    while (ref > 0 && ref + delta > 0) {
+        RK_S32 old = MPP_VAL_CAS(&buffer->ref_count, ref, ref + delta);
+
+        if (old == ref)
+            return 1;
+
+        ref = old;
+    }
+
+    return 0;
+}
+
+static RK_S32 buffer_bucket_idx(size_t size)
+{
+    RK_S32 idx = 0;
+
+    size >>= MPP_BUF_BUCKET_SHIFT;
+    while (size > 1 && idx < MPP_BUF_BUCKET_COUNT - 1) {
+        size >>= 1;
+        idx++;
+    }
+
+    return idx;
+}
+
+static void add_unused_buffer_no_lock(MppBufferGroupImpl *group, MppBufferImpl *buffer)
+{
+    RK_S32 idx = buffer_bucket_idx(buffer->info.size);
+
+    list_add_tail(&buffer->list_status, &group->list_unused[idx]);
+    group->count_unused++;
+}
+
+static void clear_unused_buffer_no_lock(MppBufferGroupImpl *group, const char *caller)
+{
+    RK_S32 i;
+
+    for (i = 0; i < MPP_BUF_BUCKET_COUNT; i++) {
+        MppBufferImpl *pos, *n;
+
+        list_for_each_entry_safe(pos, n, &group->list_unused[i], MppBufferImpl, list_status) {
+            deinit_buffer_no_lock(pos, caller);
+            group->count_unused--;
+        }
+    }
+}
+
+/*
+ * evict unused buffer smaller than size
+ * all - evict all undersized buffer, otherwise only evict the smallest one
+ */
+static void evict_unused_buffer_no_lock(MppBufferGroupImpl *group, size_t size, RK_S32 all)
+{
+    RK_S32 last = buffer_bucket_idx(size);
+    RK_S32 i;
+
+    for (i = 0; i <= last; i++) {
+        MppBufferImpl *pos, *n;
+        MppBufferImpl *smallest = NULL;
+
+        list_for_each_entry_safe(pos, n, &group->list_unused[i], MppBufferImpl, list_status) {
+            if (pos->info.size >= size)
+                continue;
+
+            if (all) {
+                deinit_buffer_no_lock(pos, __FUNCTION__);
+                group->count_unused--;
+                group->evict_count++;
+            } else if (NULL == smallest || pos->info.size < smallest->info.size) {
+                smallest = pos;
+            }
+        }
+
+        if (smallest) {
+            deinit_buffer_no_lock(smallest, __FUNCTION__);
+            group->count_unused--;
+            group->evict_count++;
+            break;
+        }
+    }
+}
+
+/* account new buffer size to pool, idle buffers are freed for the limit */
+static MPP_RET pool_admit(MppBufferGroupImpl *group, size_t size)
+{
+    MppBufferPoolImpl *pool = group->pool;
+    MPP_RET ret = MPP_OK;
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (pool->limit) {
+        MppBufferGroupImpl *pos;
+        size_t guard = 0;
+
+        list_for_each_entry(pos, &pool->list_members, MppBufferGroupImpl, list_member) {
+            if (pos != group && pos->pool_usage < pos->pool_reserve)
+                guard += pos->pool_reserve - pos->pool_usage;
+        }
+
+        while (pool->usage + size + guard > pool->limit && !list_empty(&pool->list_idle))
+            pool_free_idle_no_lock(pool, list_entry(pool->list_idle.next,
+                                                    MppBufferImpl, list_status));
+
+        if (pool->usage + size + guard > pool->limit) {
+            pool->waiting = 1;
+            ret = MPP_NOK;
+        }
+    }
+
+    if (!ret) {
+        pool->usage += size;
+        group->pool_usage += size;
+        if (pool->usage > pool->peak)
+            pool->peak = pool->usage;
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    return ret;
+}
+
+/*
+ * move unused buffer above the reserve of group to pool
+ * NOTE: buffer in pool idle list can be freed by other group once the pool
+ * lock is released so it is logged before that.
+ */
+static RK_S32 pool_return(MppBufferGroupImpl *group, MppBufferImpl *buffer,
+                          const char *caller)
+{
+    MppBufferPoolImpl *pool = group->pool;
+    size_t size = buffer->info.size;
+    RK_S32 ret = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    if (group->pool_usage >= group->pool_reserve + size) {
+        buffer_group_add_log(group, buffer, BUF_RETURN, caller);
+        group->pool_usage -= size;
+        group->usage -= size;
+        group->buffer_count--;
+        list_add_tail(&buffer->list_status, &pool->list_idle);
+        pool->idle += size;
+        pool_notify_no_lock(pool, group);
+        ret = 1;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return ret;
+}
+
+/* lend the best fit idle buffer in pool to group */
+static MppBufferImpl *pool_borrow(MppBufferGroupImpl *group, size_t size)
+{
+    MppBufferPoolImpl *pool = group->pool;
+    MppBufferImpl *buffer = NULL;
+    MppBufferImpl *pos;
+
+    if (group->limit_count && group->buffer_count >= group->limit_count)
+        return NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    list_for_each_entry(pos, &pool->list_idle, MppBufferImpl, list_status) {
+        if (pos->info.size >= size &&
+            (NULL == buffer || pos->info.size < buffer->info.size))
+            buffer = pos;
+    }
+
+    if (buffer) {
+        list_del_init(&buffer->list_status);
+        pool->idle -= buffer->info.size;
+        group->pool_usage += buffer->info.size;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (buffer) {
+        buffer->group_id = group->group_id;
+        buffer->buffer_id = group->buffer_id++;
+        group->usage += buffer->info.size;
+        group->buffer_count++;
+        add_unused_buffer_no_lock(group, buffer);
+        buffer_group_add_log(group, buffer, BUF_BORROW, __FUNCTION__);
+        inc_buffer_ref_no_lock(buffer, __FUNCTION__);
+    }
+
+    return buffer;
+}
+
 static void dump_buffer_info(MppBufferImpl *buffer)
 {
     mpp_log("buffer %p fd %4d size %10d ref_count %3d discard %d caller %s\n",
@@ -258,7 +543,6 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
                           MppBufferGroupImpl *group, MppBufferInfo *info,
                           MppBufferImpl **buffer)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     MPP_BUF_FUNCTION_ENTER();
 
     MPP_RET ret = MPP_OK;
@@ -267,10 +551,12 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
 
     if (NULL == group) {
         mpp_err_f("can not create buffer without group\n");
-        ret = MPP_NOK;
-        goto RET;
+        MPP_BUF_FUNCTION_LEAVE();
+        return MPP_NOK;
     }
 
+    MPP_BUF_GROUP_LOCK(group);
+
     if (group->limit_count && group->buffer_count >= group->limit_count) {
         if (group->log_runtime_en)
             mpp_log_f("group %d reach count limit %d\n", group->group_id, group->limit_count);
@@ -284,9 +570,18 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
         goto RET;
     }
 
+    if (group->pool && pool_admit(group, info->size)) {
+        if (group->log_runtime_en)
+            mpp_log_f("group %d reach pool limit\n", group->group_id);
+        ret = MPP_NOK;
+        goto RET;
+    }
+
     p = mpp_calloc(MppBufferImpl, 1);
     if (NULL == p) {
         mpp_err_f("failed to allocate context\n");
+        if (group->pool)
+            pool_release(group, info->size);
         ret = MPP_ERR_MALLOC;
         goto RET;
     }
@@ -297,6 +592,8 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
     if (MPP_OK != ret) {
         mpp_err_f("failed to create buffer with size %d\n", info->size);
         mpp_free(p);
+        if (group->pool)
+            pool_release(group, info->size);
         ret = MPP_ERR_MALLOC;
         goto RET;
     }
@@ -312,12 +609,11 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
     p->group_id = group->group_id;
     p->buffer_id = group->buffer_id;
     INIT_LIST_HEAD(&p->list_status);
-    list_add_tail(&p->list_status, &group->list_unused);
+    add_unused_buffer_no_lock(group, p);
 
     group->buffer_id++;
     group->usage += info->size;
     group->buffer_count++;
-    group->count_unused++;
 
     buffer_group_add_log(group, p,
                          (group->mode == MPP_BUFFER_INTERNAL) ? (BUF_CREATE) : (BUF_COMMIT),
@@ -331,22 +627,29 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
     if (group->callback)
         group->callback(group->arg, group);
 RET:
+    MPP_BUF_GROUP_UNLOCK(group);
     MPP_BUF_FUNCTION_LEAVE();
     return ret;
 }
 
 MPP_RET mpp_buffer_mmap(MppBufferImpl *buffer, const char* caller)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     MPP_BUF_FUNCTION_ENTER();
 
     MPP_RET ret = MPP_NOK;
     MppBufferGroupImpl *group = SEARCH_GROUP_BY_ID(buffer->group_id);
 
     if (group && group->alloc_api && group->alloc_api->mmap) {
-        ret = group->alloc_api->mmap(group->allocator, &buffer->info);
+        MPP_BUF_GROUP_LOCK(group);
+        // buffer may be mapped by other thread when waiting for lock
+        if (buffer->info.ptr) {
+            ret = MPP_OK;
+        } else {
+            ret = group->alloc_api->mmap(group->allocator, &buffer->info);
 
-        buffer_group_add_log(group, buffer, BUF_MMAP, caller);
+            buffer_group_add_log(group, buffer, BUF_MMAP, caller);
+        }
+        MPP_BUF_GROUP_UNLOCK(group);
     }
 
     if (ret)
@@ -359,10 +662,19 @@ MPP_RET mpp_buffer_mmap(MppBufferImpl *buffer, const char* caller)
 
 MPP_RET mpp_buffer_ref_inc(MppBufferImpl *buffer, const char* caller)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     MPP_BUF_FUNCTION_ENTER();
 
-    MPP_RET ret = inc_buffer_ref_no_lock(buffer, caller);
+    MPP_RET ret = MPP_OK;
+    MppBufferGroupImpl *group = SEARCH_GROUP_BY_ID(buffer->group_id);
+
+    if (NULL == group) {
+        mpp_err_f("buffer %p without group caller %s\n", buffer, caller);
+        ret = MPP_NOK;
+    } else if (!try_change_ref_no_lock(group, buffer, 1)) {
+        MPP_BUF_GROUP_LOCK(group);
+        ret = inc_buffer_ref_no_lock(buffer, caller);
+        MPP_BUF_GROUP_UNLOCK(group);
+    }
 
     MPP_BUF_FUNCTION_LEAVE();
     return ret;
@@ -371,13 +683,26 @@ MPP_RET mpp_buffer_ref_inc(MppBufferImpl *buffer, const char* caller)
 
 MPP_RET mpp_buffer_ref_dec(MppBufferImpl *buffer, const char* caller)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     MPP_BUF_FUNCTION_ENTER();
 
     MPP_RET ret = MPP_OK;
+    RK_U32 release_group = 0;
     MppBufferGroupImpl *group = SEARCH_GROUP_BY_ID(buffer->group_id);
-    if (group)
-        buffer_group_add_log(group, buffer, BUF_REF_DEC, caller);
+
+    if (NULL == group) {
+        mpp_err_f("buffer %p without group caller %s\n", buffer, caller);
+        MPP_BUF_FUNCTION_LEAVE();
+        return MPP_NOK;
+    }
+
+    if (try_change_ref_no_lock(group, buffer, -1)) {
+        MPP_BUF_FUNCTION_LEAVE();
+        return ret;
+    }
+
+    MPP_BUF_GROUP_LOCK(group);
+
+    buffer_group_add_log(group, buffer, BUF_REF_DEC, caller);
 
     if (buffer->ref_count <= 0) {
         mpp_err_f("found non-positive ref_count %d caller %s\n",
@@ -385,8 +710,7 @@ MPP_RET mpp_buffer_ref_dec(MppBufferImpl *buffer, const char* caller)
         mpp_abort();
         ret = MPP_NOK;
     } else {
-        buffer->ref_count--;
-        if (0 == buffer->ref_count) {
+        if (0 == MPP_SUB_FETCH(&buffer->ref_count, 1)) {
             buffer->used = 0;
             list_del_init(&buffer->list_status);
             if (group == MppBufferService::get_instance()->get_misc(group->mode, group->type)) {
@@ -394,54 +718,83 @@ MPP_RET mpp_buffer_ref_dec(MppBufferImpl *buffer, const char* caller)
             } else {
                 if (buffer->discard) {
                     deinit_buffer_no_lock(buffer, caller);
-                } else {
-                    list_add_tail(&buffer->list_status, &group->list_unused);
-                    group->count_unused++;
+                } else if (!group->pool || !pool_return(group, buffer, caller)) {
+                    add_unused_buffer_no_lock(group, buffer);
                 }
             }
             group->count_used--;
             if (group->callback)
                 group->callback(group->arg, group);
+
+            // only the last buffer release on orphan group can see this
+            release_group = group->is_orphan && !group->usage;
         }
     }
 
+    MPP_BUF_GROUP_UNLOCK(group);
+
+    if (release_group) {
+        AutoMutex auto_lock(MppBufferService::get_lock());
+        MppBufferService::get_instance()->put_group(group);
+    }
+
     MPP_BUF_FUNCTION_LEAVE();
     return ret;
 }
 
 MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     MPP_BUF_FUNCTION_ENTER();
+    MPP_BUF_GROUP_LOCK(p);
 
     MppBufferImpl *buffer = NULL;
 
-    if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-        RK_S32 found = 0;
-        RK_S32 search_count = 0;
-
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
-            mpp_buf_dbg(MPP_BUF_DBG_CHECK_SIZE, "request size %d on buf idx %d size %d\n",
-                        size, pos->buffer_id, pos->info.size);
-            if (pos->info.size >= size) {
-                buffer = pos;
-                inc_buffer_ref_no_lock(buffer, __FUNCTION__);
-                found = 1;
-                break;
-            } else {
-                if (MPP_BUFFER_INTERNAL == p->mode) {
-                    deinit_buffer_no_lock(pos, __FUNCTION__);
-                    p->count_unused--;
-                } else
-                    search_count++;
+    if (p->count_unused) {
+        MppBufferImpl *pos;
+        RK_S32 i;
+
+        /*
+         * Buffers in the higher buckets are all larger than the request. So
+         * the best fit is the smallest fit one in the first bucket with fit.
+         */
+        for (i = buffer_bucket_idx(size); i < MPP_BUF_BUCKET_COUNT && !buffer; i++) {
+            list_for_each_entry(pos, &p->list_unused[i], MppBufferImpl, list_status) {
+                mpp_buf_dbg(MPP_BUF_DBG_CHECK_SIZE, "request size %d on buf idx %d size %d\n",
+                            size, pos->buffer_id, pos->info.size);
+                if (pos->info.size >= size &&
+                    (NULL == buffer || pos->info.size < buffer->info.size)) {
+                    buffer = pos;
+                    // same size buffer is the common case on fixed resolution
+                    if (pos->info.size == size)
+                        break;
+                }
             }
         }
 
-        if (!found && search_count)
+        if (buffer) {
+            inc_buffer_ref_no_lock(buffer, __FUNCTION__);
+            p->hit_count++;
+        } else if (MPP_BUFFER_INTERNAL == p->mode) {
+            /* keep undersized buffer until the group has no room for new one */
+            if (!p->keep_undersized)
+                evict_unused_buffer_no_lock(p, size, 1);
+            else if (p->limit_count && p->buffer_count >= p->limit_count)
+                evict_unused_buffer_no_lock(p, size, 0);
+        } else {
             mpp_err_f("can not found match buffer with size larger than %d\n", size);
+        }
+    }
+
+    if (NULL == buffer && p->pool) {
+        buffer = pool_borrow(p, size);
+        if (buffer)
+            p->hit_count++;
     }
 
+    if (NULL == buffer)
+        p->miss_count++;
+
+    MPP_BUF_GROUP_UNLOCK(p);
     MPP_BUF_FUNCTION_LEAVE();
     return buffer;
 }
@@ -502,13 +855,13 @@ MPP_RET mpp_buffer_group_deinit(MppBufferGroupImpl *p)
 
 MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     if (NULL == p) {
         mpp_err_f("found NULL pointer\n");
         return MPP_ERR_NULL_PTR;
     }
 
     MPP_BUF_FUNCTION_ENTER();
+    MPP_BUF_GROUP_LOCK(p);
 
     buffer_group_add_log(p, NULL, GRP_RESET, NULL);
 
@@ -521,14 +874,9 @@ MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p)
     }
 
     // remove unused list
-    if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
-            deinit_buffer_no_lock(pos, __FUNCTION__);
-            p->count_unused--;
-        }
-    }
+    clear_unused_buffer_no_lock(p, __FUNCTION__);
 
+    MPP_BUF_GROUP_UNLOCK(p);
     MPP_BUF_FUNCTION_LEAVE();
     return MPP_OK;
 }
@@ -536,7 +884,6 @@ MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p)
 MPP_RET mpp_buffer_group_set_callback(MppBufferGroupImpl *p,
                                       MppBufCallback callback, void *arg)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     if (NULL == p) {
         mpp_err_f("found NULL pointer\n");
         return MPP_ERR_NULL_PTR;
@@ -544,8 +891,10 @@ MPP_RET mpp_buffer_group_set_callback(MppBufferGroupImpl *p,
 
     MPP_BUF_FUNCTION_ENTER();
 
+    MPP_BUF_GROUP_LOCK(p);
     p->callback = callback;
     p->arg      = arg;
+    MPP_BUF_GROUP_UNLOCK(p);
 
     MPP_BUF_FUNCTION_LEAVE();
     return MPP_OK;
@@ -558,6 +907,16 @@ void mpp_buffer_group_dump(MppBufferGroupImpl *group, const char *caller)
     mpp_log("mode %s\n", mode2str[group->mode]);
     mpp_log("type %s\n", type2str[group->type]);
     mpp_log("limit size %d count %d\n", group->limit_size, group->limit_count);
+    mpp_log("reuse hit %d miss %d evict %d keep undersized %d\n",
+            group->hit_count, group->miss_count, group->evict_count,
+            group->keep_undersized);
+    mpp_log("placement page %s numa node %d\n", page2str[group->page],
+            group->numa_node);
+    if (group->pool)
+        mpp_log("pool %p reserve %d usage %d\n", group->pool,
+                group->pool_reserve, group->pool_usage);
+
+    MPP_BUF_GROUP_LOCK(group);
 
     mpp_log("used buffer count %d\n", group->count_used);
 
@@ -567,11 +926,69 @@ void mpp_buffer_group_dump(MppBufferGroupImpl *group, const char *caller)
     }
 
     mpp_log("unused buffer count %d\n", group->count_unused);
-    list_for_each_entry_safe(pos, n, &group->list_unused, MppBufferImpl, list_status) {
-        dump_buffer_info(pos);
+    for (RK_S32 i = 0; i < MPP_BUF_BUCKET_COUNT; i++) {
+        list_for_each_entry_safe(pos, n, &group->list_unused[i], MppBufferImpl, list_status) {
+            dump_buffer_info(pos);
+        }
     }
 
     buffer_group_dump_log(group);
+
+    MPP_BUF_GROUP_UNLOCK(group);
+}
+
+MPP_RET mpp_buffer_pool_init(MppBufferPoolImpl **pool, MppBufferType type, size_t limit)
+{
+    AutoMutex auto_lock(MppBufferService::get_lock());
+
+    *pool = MppBufferService::get_instance()->get_pool(type, limit);
+
+    return ((*pool) ? (MPP_OK) : (MPP_NOK));
+}
+
+MPP_RET mpp_buffer_pool_deinit(MppBufferPoolImpl *pool)
+{
+    AutoMutex auto_lock(MppBufferService::get_lock());
+
+    if (NULL == pool) {
+        mpp_err_f("found NULL pointer\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppBufferService::get_instance()->put_pool(pool);
+    return MPP_OK;
+}
+
+/*
+ * placement from env only goes to internal frame group, small buffers like
+ * stream and register buffers keep the default allocation
+ */
+void mpp_buffer_group_env_placement(MppBufferGroupImpl *p)
+{
+    RK_U32 page = MPP_BUFFER_PAGE_DEFAULT;
+    RK_U32 node = (RK_U32) - 1;
+
+    if (NULL == p || p->mode != MPP_BUFFER_INTERNAL || NULL == p->alloc_api)
+        return;
+
+    mpp_env_get_u32("mpp_buffer_page", &page, MPP_BUFFER_PAGE_DEFAULT);
+    mpp_env_get_u32("mpp_buffer_numa_node", &node, (RK_U32) - 1);
+
+    if (page != MPP_BUFFER_PAGE_DEFAULT || (RK_S32)node >= 0)
+        mpp_buffer_group_placement_config(p, (MppBufferPage)page, (RK_S32)node);
+}
+
+MPP_RET mpp_buffer_group_set_pool(MppBufferGroupImpl *p, MppBufferPoolImpl *pool,
+                                  size_t reserve)
+{
+    AutoMutex auto_lock(MppBufferService::get_lock());
+
+    if (NULL == p) {
+        mpp_err_f("found NULL pointer\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    return MppBufferService::get_instance()->set_pool(p, pool, reserve);
 }
 
 void mpp_buffer_service_dump()
@@ -591,7 +1008,8 @@ MppBufferGroupImpl *mpp_buffer_get_misc_group(MppBufferMode mode, MppBufferType
         offset += snprintf(tag + offset, sizeof(tag) - offset, "misc");
         offset += snprintf(tag + offset, sizeof(tag) - offset, "_%s",
                            type == MPP_BUFFER_TYPE_ION ? "ion" :
-                           type == MPP_BUFFER_TYPE_DRM ? "drm" : "na");
+                           type == MPP_BUFFER_TYPE_DRM ? "drm" :
+                           type == MPP_BUFFER_TYPE_MEMFD ? "memfd" : "na");
         offset += snprintf(tag + offset, sizeof(tag) - offset, "_%s",
                            mode == MPP_BUFFER_INTERNAL ? "int" : "ext");
 
@@ -604,17 +1022,21 @@ MppBufferService::MppBufferService()
     : group_id(0),
       group_count(0),
       finalizing(0),
-      misc_count(0)
+      misc_count(0),
+      mTable(NULL)
 {
     RK_S32 i, j;
 
     INIT_LIST_HEAD(&mListGroup);
     INIT_LIST_HEAD(&mListOrphan);
+    INIT_LIST_HEAD(&mListPool);
 
     // NOTE: Do not create misc group at beginning. Only create on when needed.
     for (i = 0; i < MPP_BUFFER_MODE_BUTT; i++)
         for (j = 0; j < MPP_BUFFER_TYPE_BUTT; j++)
             misc[i][j] = NULL;
+
+    grow_table(BUFFER_GROUP_TABLE_SIZE);
 }
 
 MppBufferService::~MppBufferService()
@@ -655,15 +1077,67 @@ MppBufferService::~MppBufferService()
             deinit_buffer_no_lock(pos, __FUNCTION__);
         }
     }
+
+    // pool without group left here is the leak one
+    if (!list_empty(&mListPool)) {
+        MppBufferPoolImpl *pos, *n;
+
+        mpp_log_f("cleaning leaked pool\n");
+        list_for_each_entry_safe(pos, n, &mListPool, MppBufferPoolImpl, list_pool) {
+            if (list_empty(&pos->list_members))
+                destroy_pool(pos);
+        }
+    }
+
+    while (mTable) {
+        MppBufferGroupTable *prev = mTable->prev;
+
+        mpp_free(mTable->slots);
+        mpp_free(mTable);
+        mTable = prev;
+    }
+}
+
+MPP_RET MppBufferService::grow_table(RK_U32 size)
+{
+    MppBufferGroupTable *old = mTable;
+    MppBufferGroupTable *table = mpp_calloc(MppBufferGroupTable, 1);
+    RK_U32 i;
+
+    if (table)
+        table->slots = mpp_calloc(MppBufferGroupImpl *, size);
+
+    if (NULL == table || NULL == table->slots) {
+        mpp_err("MppBufferService failed to grow group table to %d\n", size);
+        MPP_FREE(table);
+        return MPP_ERR_MALLOC;
+    }
+
+    table->prev = old;
+    table->mask = size - 1;
+
+    // ids differ in low bits of old table still differ in the larger table
+    if (old) {
+        for (i = 0; i <= old->mask; i++) {
+            MppBufferGroupImpl *p = old->slots[i];
+
+            if (p)
+                table->slots[p->group_id & table->mask] = p;
+        }
+    }
+
+    MPP_STORE_RELEASE(&mTable, table);
+    return MPP_OK;
 }
 
 RK_U32 MppBufferService::get_group_id()
 {
-    // avoid group_id reuse
     RK_U32 id = group_id++;
-    while (get_group_by_id(group_id)) {
-        group_id++;
-    }
+
+    // avoid group_id reuse and slot conflict in group table
+    while (mTable->slots[id & mTable->mask])
+        id = group_id++;
+
     group_count++;
     return id;
 }
@@ -673,6 +1147,15 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
                                                 RK_U32 is_misc)
 {
     MppBufferType buffer_type = (MppBufferType)(type & MPP_BUFFER_TYPE_MASK);
+
+    // keep group table at most half full for short slot search
+    if (NULL == mTable || group_count >= (mTable->mask + 1) / 2) {
+        RK_U32 size = mTable ? (mTable->mask + 1) * 2 : BUFFER_GROUP_TABLE_SIZE;
+
+        if (grow_table(size) && (NULL == mTable || group_count > mTable->mask))
+            return NULL;
+    }
+
     MppBufferGroupImpl *p = mpp_calloc(MppBufferGroupImpl, 1);
     if (NULL == p) {
         mpp_err("MppBufferService failed to allocate group context\n");
@@ -680,11 +1163,19 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
     }
 
     RK_U32 id = get_group_id();
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&p->buf_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
 
     INIT_LIST_HEAD(&p->list_logs);
     INIT_LIST_HEAD(&p->list_group);
+    INIT_LIST_HEAD(&p->list_member);
     INIT_LIST_HEAD(&p->list_used);
-    INIT_LIST_HEAD(&p->list_unused);
+    for (RK_S32 i = 0; i < MPP_BUF_BUCKET_COUNT; i++)
+        INIT_LIST_HEAD(&p->list_unused[i]);
 
     mpp_env_get_u32("mpp_buffer_debug", &mpp_buffer_debug, 0);
     p->log_runtime_en   = (mpp_buffer_debug & MPP_BUF_DBG_OPS_RUNTIME) ? (1) : (0);
@@ -702,10 +1193,14 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
     p->type     = buffer_type;
     p->limit    = BUFFER_GROUP_SIZE_DEFAULT;
     p->group_id = id;
+    mTable->slots[id & mTable->mask] = p;
     p->clear_on_exit = (mpp_buffer_debug & MPP_BUF_DBG_CLR_ON_EXIT) ? (1) : (0);
 
     mpp_allocator_get(&p->allocator, &p->alloc_api, type);
 
+    p->page = MPP_BUFFER_PAGE_DEFAULT;
+    p->numa_node = -1;
+
     buffer_group_add_log(p, NULL, GRP_CREATE, __FUNCTION__);
 
     mpp_assert(mode < MPP_BUFFER_MODE_BUTT);
@@ -745,18 +1240,15 @@ void MppBufferService::set_misc(MppBufferMode mode, MppBufferType type, MppBuffe
 
 void MppBufferService::put_group(MppBufferGroupImpl *p)
 {
+    MPP_BUF_GROUP_LOCK(p);
+
     buffer_group_add_log(p, NULL, GRP_RELEASE, __FUNCTION__);
 
     // remove unused list
-    if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
-            deinit_buffer_no_lock(pos, __FUNCTION__);
-            p->count_unused--;
-        }
-    }
+    clear_unused_buffer_no_lock(p, __FUNCTION__);
 
     if (list_empty(&p->list_used)) {
+        MPP_BUF_GROUP_UNLOCK(p);
         destroy_group(p);
     } else {
         if (!finalizing ||
@@ -782,6 +1274,7 @@ void MppBufferService::put_group(MppBufferGroupImpl *p)
                 p->count_used--;
             }
 
+            MPP_BUF_GROUP_UNLOCK(p);
             destroy_group(p);
         } else {
             // otherwise move the group to list_orphan and wait for buffer release
@@ -789,6 +1282,7 @@ void MppBufferService::put_group(MppBufferGroupImpl *p)
             list_del_init(&p->list_group);
             list_add_tail(&p->list_group, &mListOrphan);
             p->is_orphan = 1;
+            MPP_BUF_GROUP_UNLOCK(p);
         }
     }
 }
@@ -820,9 +1314,15 @@ void MppBufferService::destroy_group(MppBufferGroupImpl *group)
         mpp_assert(group->log_count == 0);
     }
 
+    if (group->pool)
+        set_pool(group, NULL, 0);
+
     mpp_assert(group->allocator);
     mpp_allocator_put(&group->allocator);
     list_del_init(&group->list_group);
+    if (mTable->slots[group->group_id & mTable->mask] == group)
+        mTable->slots[group->group_id & mTable->mask] = NULL;
+    pthread_mutex_destroy(&group->buf_lock);
     mpp_free(group);
     group_count--;
 
@@ -834,20 +1334,132 @@ void MppBufferService::destroy_group(MppBufferGroupImpl *group)
 
 MppBufferGroupImpl *MppBufferService::get_group_by_id(RK_U32 id)
 {
-    MppBufferGroupImpl *pos, *n;
-    list_for_each_entry_safe(pos, n, &mListGroup, MppBufferGroupImpl, list_group) {
-        if (pos->group_id == id) {
-            return pos;
-        }
+    MppBufferGroupTable *table = MPP_LOAD_ACQUIRE(&mTable);
+    MppBufferGroupImpl *p = (table) ? table->slots[id & table->mask] : NULL;
+
+    return (p && p->group_id == id) ? p : NULL;
+}
+
+MppBufferPoolImpl *MppBufferService::get_pool(MppBufferType type, size_t limit)
+{
+    MppBufferPoolImpl *p = mpp_calloc(MppBufferPoolImpl, 1);
+
+    if (NULL == p) {
+        mpp_err("MppBufferService failed to allocate pool context\n");
+        return NULL;
     }
 
-    list_for_each_entry_safe(pos, n, &mListOrphan, MppBufferGroupImpl, list_group) {
-        if (pos->group_id == id) {
-            return pos;
+    p->type = (MppBufferType)(type & MPP_BUFFER_TYPE_MASK);
+    p->limit = limit;
+    pthread_mutex_init(&p->lock, NULL);
+    INIT_LIST_HEAD(&p->list_pool);
+    INIT_LIST_HEAD(&p->list_members);
+    INIT_LIST_HEAD(&p->list_idle);
+
+    mpp_allocator_get(&p->allocator, &p->alloc_api, type);
+    if (NULL == p->allocator) {
+        mpp_err("MppBufferService failed to get pool allocator type %d\n", type);
+        pthread_mutex_destroy(&p->lock);
+        mpp_free(p);
+        return NULL;
+    }
+
+    list_add_tail(&p->list_pool, &mListPool);
+    return p;
+}
+
+void MppBufferService::put_pool(MppBufferPoolImpl *pool)
+{
+    pool->is_orphan = 1;
+
+    if (list_empty(&pool->list_members))
+        destroy_pool(pool);
+}
+
+void MppBufferService::destroy_pool(MppBufferPoolImpl *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (!list_empty(&pool->list_idle))
+        pool_free_idle_no_lock(pool, list_entry(pool->list_idle.next,
+                                                MppBufferImpl, list_status));
+    pthread_mutex_unlock(&pool->lock);
+
+    mpp_assert(pool->usage == 0);
+
+    mpp_allocator_put(&pool->allocator);
+    list_del_init(&pool->list_pool);
+    pthread_mutex_destroy(&pool->lock);
+    mpp_free(pool);
+}
+
+MPP_RET MppBufferService::set_pool(MppBufferGroupImpl *group, MppBufferPoolImpl *pool,
+                                   size_t reserve)
+{
+    MppBufferPoolImpl *old = group->pool;
+    MPP_RET ret = MPP_OK;
+
+    MPP_BUF_GROUP_LOCK(group);
+
+    if (group->buffer_count) {
+        mpp_err("group %d can not change pool with %d buffers\n",
+                group->group_id, group->buffer_count);
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    if (pool && (group->mode != MPP_BUFFER_INTERNAL || group->type != pool->type ||
+                 pool->is_orphan)) {
+        mpp_err("group %d mode %d type %d can not attach pool type %d\n",
+                group->group_id, group->mode, group->type, pool->type);
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    if (pool && pool->limit) {
+        size_t reserved = pool->reserved - ((pool == old) ? group->pool_reserve : 0);
+
+        if (reserved + reserve > pool->limit) {
+            mpp_err("group %d reserve %d exceeds pool reserved %d limit %d\n",
+                    group->group_id, reserve, reserved, pool->limit);
+            ret = MPP_NOK;
+            goto DONE;
         }
     }
 
-    return NULL;
+    if (old) {
+        pthread_mutex_lock(&old->lock);
+        list_del_init(&group->list_member);
+        old->reserved -= group->pool_reserve;
+        pthread_mutex_unlock(&old->lock);
+
+        group->allocator = group->own_allocator;
+        group->alloc_api = group->own_alloc_api;
+        group->pool = NULL;
+        group->pool_reserve = 0;
+    }
+
+    if (pool) {
+        group->own_allocator = group->allocator;
+        group->own_alloc_api = group->alloc_api;
+        group->allocator = pool->allocator;
+        group->alloc_api = pool->alloc_api;
+        group->pool = pool;
+        group->pool_reserve = reserve;
+        group->pool_usage = 0;
+
+        pthread_mutex_lock(&pool->lock);
+        list_add_tail(&group->list_member, &pool->list_members);
+        pool->reserved += reserve;
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+DONE:
+    MPP_BUF_GROUP_UNLOCK(group);
+
+    if (!ret && old && old->is_orphan && list_empty(&old->list_members))
+        destroy_pool(old);
+
+    return ret;
 }
 
 void MppBufferService::dump_misc_group()
@@ -21,11 +21,32 @@
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_common.h"
+#include "mpp_mem_pool.h"
 #include "mpp_frame_impl.h"
 #include "mpp_meta_impl.h"
 
 static const char *module_name = MODULE_TAG;
 
+/* pool is released on static destruction after all mpp context is gone */
+class MppFramePool
+{
+public:
+    MppFramePool() { pool = mpp_mem_pool_init(sizeof(MppFrameImpl)); }
+    ~MppFramePool() { mpp_mem_pool_deinit(pool); }
+
+    MppMemPool  pool;
+
+private:
+    MppFramePool(const MppFramePool &);
+    MppFramePool &operator=(const MppFramePool &);
+};
+
+static MppMemPool get_frame_pool(void)
+{
+    static MppFramePool instance;
+    return instance.pool;
+}
+
 static void setup_mpp_frame_name(MppFrameImpl *frame)
 {
     frame->name = module_name;
@@ -48,12 +69,14 @@ MPP_RET mpp_frame_init(MppFrame *frame)
         return MPP_ERR_NULL_PTR;
     }
 
-    MppFrameImpl *p = mpp_calloc(MppFrameImpl, 1);
+    MppFrameImpl *p = (MppFrameImpl *)mpp_mem_pool_get(get_frame_pool());
     if (NULL == p) {
         mpp_err_f("malloc failed\n");
         return MPP_ERR_NULL_PTR;
     }
 
+    memset(p, 0, sizeof(*p));
+
     setup_mpp_frame_name(p);
     *frame = p;
 
@@ -74,7 +97,7 @@ MPP_RET mpp_frame_deinit(MppFrame *frame)
     if (p->meta)
         mpp_meta_put(p->meta);
 
-    mpp_free(*frame);
+    mpp_mem_pool_put(get_frame_pool(), p);
     *frame = NULL;
     return MPP_OK;
 }
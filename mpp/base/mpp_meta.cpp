@@ -18,40 +18,21 @@
 
 #include <string.h>
 
+#include "mpp_log.h"
 #include "mpp_mem.h"
-#include "mpp_list.h"
+#include "mpp_atomic.h"
+#include "mpp_mem_pool.h"
 
 #include "mpp_meta_impl.h"
 
+#define EXPAND_AS_META_DEF(key, type) \
+    {   KEY_##key,  TYPE_##type,    },
+
+#define EXPAND_AS_META_CASE(key, type) \
+    case KEY_##key : { index = META_INDEX_##key; } break;
+
 static MppMetaDef meta_defs[] = {
-    /* categorized by type */
-    /* data flow type */
-    {   KEY_INPUT_FRAME,        TYPE_FRAME,     },
-    {   KEY_OUTPUT_FRAME,       TYPE_FRAME,     },
-    {   KEY_INPUT_PACKET,       TYPE_PACKET,    },
-    {   KEY_OUTPUT_PACKET,      TYPE_PACKET,    },
-    /* buffer for motion detection */
-    {   KEY_MOTION_INFO,        TYPE_BUFFER,    },
-    /* buffer storing the HDR information for current frame*/
-    {   KEY_HDR_INFO,           TYPE_BUFFER,    },
-
-    {   KEY_OUTPUT_INTRA,       TYPE_S32,       },
-    {   KEY_INPUT_BLOCK,        TYPE_S32,       },
-    {   KEY_OUTPUT_BLOCK,       TYPE_S32,       },
-
-    /* extra information for tsvc */
-    {   KEY_TEMPORAL_ID,        TYPE_S32,       },
-    {   KEY_LONG_REF_IDX,       TYPE_S32,       },
-
-    {   KEY_ROI_DATA,           TYPE_PTR,       },
-    {   KEY_OSD_DATA,           TYPE_PTR,       },
-    {   KEY_USER_DATA,          TYPE_PTR,       },
-    {   KEY_MV_LIST,            TYPE_PTR,       },
-
-    {   KEY_ENC_MARK_LTR,       TYPE_S32,       },
-    {   KEY_ENC_USE_LTR,        TYPE_S32,       },
-    {   KEY_ENC_FRAME_QP,       TYPE_S32,       },
-    {   KEY_ENC_BASE_LAYER_PID, TYPE_S32,       },
+    META_ENTRY_TABLE(EXPAND_AS_META_DEF)
 };
 
 class MppMetaService
@@ -63,100 +44,75 @@ private:
     MppMetaService(const MppMetaService &);
     MppMetaService &operator=(const MppMetaService &);
 
-    struct list_head    mlist_meta;
-    struct list_head    mlist_node;
+    MppMemPool          pool;
 
-    RK_U32              meta_id;
-    RK_U32              meta_count;
-    RK_U32              node_count;
+    RK_S32              meta_id;
+    RK_S32              meta_count;
 
 public:
     static MppMetaService *get_instance() {
         static MppMetaService instance;
         return &instance;
     }
-    static Mutex *get_lock() {
-        static Mutex lock;
-        return &lock;
-    }
 
     /*
      * get_index_of_key does two things:
      * 1. Check the key / type pair is correct or not.
      *    If failed on check return negative value
-     * 2. Compare all exsisting meta data defines to find the non-negative index
+     * 2. Return the value slot index of the key
      */
-    RK_S32 get_index_of_key(MppMetaKey key, MppMetaType type);
+    static RK_S32 get_index_of_key(MppMetaKey key, MppMetaType type);
 
     MppMetaImpl  *get_meta(const char *tag, const char *caller);
     void          put_meta(MppMetaImpl *meta);
     void          inc_ref(MppMetaImpl *meta);
-
-    MppMetaNode  *get_node(MppMetaImpl *meta, RK_S32 index);
-    void          put_node(MppMetaNode *node);
-    MppMetaNode  *find_node(MppMetaImpl *meta, RK_S32 index);
-    MppMetaNode  *next_node(MppMetaImpl *meta);
 };
 
 MppMetaService::MppMetaService()
     : meta_id(0),
-      meta_count(0),
-      node_count(0)
+      meta_count(0)
 {
-    INIT_LIST_HEAD(&mlist_meta);
-    INIT_LIST_HEAD(&mlist_node);
+    pool = mpp_mem_pool_init(sizeof(MppMetaImpl));
 }
 
 MppMetaService::~MppMetaService()
 {
-    mpp_assert(list_empty(&mlist_meta));
-    mpp_assert(list_empty(&mlist_node));
-
-    while (!list_empty(&mlist_meta)) {
-        MppMetaImpl *pos, *n;
-        list_for_each_entry_safe(pos, n, &mlist_meta, MppMetaImpl, list_meta) {
-            put_meta(pos);
-        }
-    }
-
-    mpp_assert(list_empty(&mlist_node));
+    mpp_assert(meta_count == 0);
 
-    while (!list_empty(&mlist_node)) {
-        MppMetaNode *pos, *n;
-        list_for_each_entry_safe(pos, n, &mlist_node, MppMetaNode, list_node) {
-            put_node(pos);
-        }
-    }
+    mpp_mem_pool_deinit(pool);
+    pool = NULL;
 }
 
 RK_S32 MppMetaService::get_index_of_key(MppMetaKey key, MppMetaType type)
 {
-    RK_S32 i = 0;
-    RK_S32 num = MPP_ARRAY_ELEMS(meta_defs);
+    RK_S32 index = -1;
 
-    for (i = 0; i < num; i++) {
-        if ((meta_defs[i].key == key) && (meta_defs[i].type == type))
-            break;
+    switch (key) {
+        META_ENTRY_TABLE(EXPAND_AS_META_CASE)
+    default : {
+    } break;
     }
 
-    return (i < num) ? (i) : (-1);
+    if (index >= 0 && meta_defs[index].type != type)
+        index = -1;
+
+    return index;
 }
 
 MppMetaImpl *MppMetaService::get_meta(const char *tag, const char *caller)
 {
-    MppMetaImpl *impl = mpp_malloc(MppMetaImpl, 1);
+    MppMetaImpl *impl = (MppMetaImpl *)mpp_mem_pool_get(pool);
+
     if (impl) {
         const char *tag_src = (tag) ? (tag) : (MODULE_TAG);
         strncpy(impl->tag, tag_src, sizeof(impl->tag));
         impl->caller = caller;
-        impl->meta_id = meta_id++;
-        INIT_LIST_HEAD(&impl->list_meta);
-        INIT_LIST_HEAD(&impl->list_node);
+        impl->meta_id = MPP_FETCH_ADD(&meta_id, 1);
         impl->ref_count = 1;
         impl->node_count = 0;
+        memset(impl->is_set, 0, sizeof(impl->is_set));
 
-        list_add_tail(&impl->list_meta, &mlist_meta);
-        meta_count++;
+        MPP_FETCH_ADD(&meta_count, 1);
     } else {
         mpp_err_f("failed to malloc meta data\n");
     }
@@ -165,107 +121,23 @@ MppMetaImpl *MppMetaService::get_meta(const char *tag, const char *caller)
 
 void MppMetaService::put_meta(MppMetaImpl *meta)
 {
-    mpp_assert(meta->ref_count);
-    if (meta->ref_count)
-        meta->ref_count--;
+    RK_S32 ref_count = MPP_SUB_FETCH(&meta->ref_count, 1);
 
-    if (meta->ref_count)
+    mpp_assert(ref_count >= 0);
+    if (ref_count)
         return;
 
-    while (!list_empty(&meta->list_node)) {
-        MppMetaNode *node = list_entry(meta->list_node.next, MppMetaNode, list_meta);
-        put_node(node);
-    }
-    mpp_assert(meta->node_count == 0);
-    list_del_init(&meta->list_meta);
-    meta_count--;
-    mpp_free(meta);
+    // TODO: may be we need to release MppFrame / MppPacket / MppBuffer here
+    MPP_FETCH_SUB(&meta_count, 1);
+    mpp_mem_pool_put(pool, meta);
 }
 
 void MppMetaService::inc_ref(MppMetaImpl *meta)
 {
-    mpp_assert(meta->ref_count);
-    meta->ref_count++;
-}
+    RK_S32 ref_count = MPP_FETCH_ADD(&meta->ref_count, 1);
 
-MppMetaNode *MppMetaService::find_node(MppMetaImpl *meta, RK_S32 type_id)
-{
-    MppMetaNode *node = NULL;
-    if (meta->node_count) {
-        MppMetaNode *n, *pos;
-
-        list_for_each_entry_safe(pos, n, &meta->list_node, MppMetaNode, list_meta) {
-            if (pos->type_id == type_id) {
-                node = pos;
-                break;
-            }
-        }
-    }
-    return node;
-}
-
-MppMetaNode *MppMetaService::next_node(MppMetaImpl *meta)
-{
-    MppMetaNode *node = NULL;
-    if (meta->node_count) {
-        node = list_entry(meta->list_node.next, MppMetaNode, list_meta);
-
-        list_del_init(&node->list_meta);
-        list_del_init(&node->list_node);
-        meta->node_count--;
-        node_count--;
-    }
-    return node;
-}
-
-MppMetaNode *MppMetaService::get_node(MppMetaImpl *meta, RK_S32 type_id)
-{
-    MppMetaNode *node = find_node(meta, type_id);
-
-    if (NULL == node) {
-        node = mpp_malloc(MppMetaNode, 1);
-        if (node) {
-            INIT_LIST_HEAD(&node->list_meta);
-            INIT_LIST_HEAD(&node->list_node);
-            node->meta = meta;
-            node->node_id = meta->meta_id++;
-            node->type_id = type_id;
-            memset(&node->val, 0, sizeof(node->val));
-
-            meta->node_count++;
-            list_add_tail(&node->list_meta, &meta->list_node);
-            list_add_tail(&node->list_node, &mlist_node);
-            node_count++;
-        } else {
-            mpp_err_f("failed to malloc meta data node\n");
-        }
-    }
-
-    return node;
-}
-
-void MppMetaService::put_node(MppMetaNode *node)
-{
-    MppMetaImpl *meta = node->meta;
-    list_del_init(&node->list_meta);
-    list_del_init(&node->list_node);
-    meta->node_count--;
-    node_count--;
-    // TODO: may be we need to release MppFrame / MppPacket / MppBuffer here
-    switch (meta_defs[node->type_id].type) {
-    case TYPE_FRAME : {
-        // mpp_frame_deinit(&node->val.frame);
-    } break;
-    case TYPE_PACKET : {
-        // mpp_packet_deinit(&node->val.packet);
-    } break;
-    case TYPE_BUFFER : {
-        //mpp_buffer_put(node->val.buffer);
-    } break;
-    default : {
-    } break;
-    }
-    mpp_free(node);
+    mpp_assert(ref_count);
+    (void)ref_count;
 }
 
 MPP_RET mpp_meta_get_with_tag(MppMeta *meta, const char *tag, const char *caller)
@@ -276,7 +148,6 @@ MPP_RET mpp_meta_get_with_tag(MppMeta *meta, const char *tag, const char *caller
     }
 
     MppMetaService *service = MppMetaService::get_instance();
-    AutoMutex auto_lock(service->get_lock());
     MppMetaImpl *impl = service->get_meta(tag, caller);
     *meta = (MppMeta) impl;
     return (impl) ? (MPP_OK) : (MPP_NOK);
@@ -290,7 +161,6 @@ MPP_RET mpp_meta_put(MppMeta meta)
     }
 
     MppMetaService *service = MppMetaService::get_instance();
-    AutoMutex auto_lock(service->get_lock());
     MppMetaImpl *impl = (MppMetaImpl *)meta;
     service->put_meta(impl);
     return MPP_OK;
@@ -304,7 +174,6 @@ MPP_RET mpp_meta_inc_ref(MppMeta meta)
     }
 
     MppMetaService *service = MppMetaService::get_instance();
-    AutoMutex auto_lock(service->get_lock());
     MppMetaImpl *impl = (MppMetaImpl *)meta;
     service->inc_ref(impl);
     return MPP_OK;
@@ -322,54 +191,57 @@ RK_S32 mpp_meta_size(MppMeta meta)
     return impl->node_count;
 }
 
-MppMetaNode *mpp_meta_next_node(MppMeta meta)
+void mpp_meta_dump(MppMeta meta)
 {
+    MppMetaImpl *impl = (MppMetaImpl *)meta;
+    RK_S32 i;
+
     if (NULL == meta) {
         mpp_err_f("found NULL input\n");
-        return NULL;
+        return;
     }
 
-    MppMetaImpl *impl = (MppMetaImpl *)meta;
-    MppMetaService *service = MppMetaService::get_instance();
-    AutoMutex auto_lock(service->get_lock());
-    MppMetaNode *node = service->next_node(impl);
+    mpp_log("dump meta %d tag %s caller %s size %d\n", impl->meta_id,
+            impl->tag, impl->caller, impl->node_count);
+
+    for (i = 0; i < META_INDEX_BUTT; i++) {
+        RK_U32 key = meta_defs[i].key;
 
-    return node;
+        if (!impl->is_set[i])
+            continue;
+
+        mpp_log("key %c%c%c%c type %c%c%c%c val %p\n",
+                (key >> 24) & 0xff, (key >> 16) & 0xff, (key >> 8) & 0xff,
+                key & 0xff, (meta_defs[i].type >> 24) & 0xff,
+                (meta_defs[i].type >> 16) & 0xff, (meta_defs[i].type >> 8) & 0xff,
+                meta_defs[i].type & 0xff, impl->vals[i].val_ptr);
+    }
 }
 
 static MPP_RET set_val_by_key(MppMetaImpl *meta, MppMetaKey key, MppMetaType type, MppMetaVal *val)
 {
-    MPP_RET ret = MPP_NOK;
-    MppMetaService *service = MppMetaService::get_instance();
-    AutoMutex auto_lock(service->get_lock());
-    RK_S32 index = service->get_index_of_key(key, type);
+    RK_S32 index = MppMetaService::get_index_of_key(key, type);
     if (index < 0)
-        return ret;
+        return MPP_NOK;
 
-    MppMetaNode *node = service->get_node(meta, index);
-    if (node) {
-        node->val = *val;
-        ret = MPP_OK;
+    if (!meta->is_set[index]) {
+        meta->is_set[index] = 1;
+        meta->node_count++;
     }
-    return ret;
+    meta->vals[index] = *val;
+    return MPP_OK;
 }
 
 static MPP_RET get_val_by_key(MppMetaImpl *meta, MppMetaKey key, MppMetaType type, MppMetaVal *val)
 {
-    MPP_RET ret = MPP_NOK;
-    MppMetaService *service = MppMetaService::get_instance();
-    AutoMutex auto_lock(service->get_lock());
-    RK_S32 index = service->get_index_of_key(key, type);
-    if (index < 0)
-        return ret;
+    RK_S32 index = MppMetaService::get_index_of_key(key, type);
+    if (index < 0 || !meta->is_set[index])
+        return MPP_NOK;
 
-    MppMetaNode *node = service->find_node(meta, index);
-    if (node) {
-        *val = node->val;
-        service->put_node(node);
-        ret = MPP_OK;
-    }
-    return ret;
+    *val = meta->vals[index];
+    meta->is_set[index] = 0;
+    meta->node_count--;
+    return MPP_OK;
 }
 
 MPP_RET mpp_meta_set_s32(MppMeta meta, MppMetaKey key, RK_S32 val)
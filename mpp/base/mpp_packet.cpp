@@ -20,11 +20,56 @@
 
 #include "mpp_log.h"
 #include "mpp_mem.h"
+#include "mpp_mem_pool.h"
 #include "mpp_packet_impl.h"
 #include "mpp_meta_impl.h"
 
+/*
+ * due to parser may be read 32 bit interface so we must alloc more size
+ * then real size to avoid read carsh
+ */
+#define MPP_PACKET_PAYLOAD_PAD          256
+// copied payload is pooled by power of two size from 1K to 128K
+#define MPP_PACKET_PAYLOAD_MIN_SHIFT    10
+#define MPP_PACKET_PAYLOAD_POOL_COUNT   8
+
 static const char *module_name = MODULE_TAG;
 
+/* pools are released on static destruction after all mpp context is gone */
+class MppPacketPool
+{
+private:
+    MppPacketPool() {
+        packet = mpp_mem_pool_init(sizeof(MppPacketImpl));
+        for (RK_S32 i = 0; i < MPP_PACKET_PAYLOAD_POOL_COUNT; i++)
+            payload[i] = mpp_mem_pool_init(1 << (i + MPP_PACKET_PAYLOAD_MIN_SHIFT));
+    }
+    ~MppPacketPool() {
+        mpp_mem_pool_deinit(packet);
+        for (RK_S32 i = 0; i < MPP_PACKET_PAYLOAD_POOL_COUNT; i++)
+            mpp_mem_pool_deinit(payload[i]);
+    }
+    MppPacketPool(const MppPacketPool &);
+    MppPacketPool &operator=(const MppPacketPool &);
+
+public:
+    static MppPacketPool *get_instance() {
+        static MppPacketPool instance;
+        return &instance;
+    }
+
+    MppMemPool get_payload_pool(size_t size) {
+        for (RK_S32 i = 0; i < MPP_PACKET_PAYLOAD_POOL_COUNT; i++) {
+            if (size <= ((size_t)1 << (i + MPP_PACKET_PAYLOAD_MIN_SHIFT)))
+                return payload[i];
+        }
+        return NULL;
+    }
+
+    MppMemPool  packet;
+    MppMemPool  payload[MPP_PACKET_PAYLOAD_POOL_COUNT];
+};
+
 #define setup_mpp_packet_name(packet) \
     ((MppPacketImpl*)packet)->name = module_name;
 
@@ -45,12 +90,13 @@ MPP_RET mpp_packet_new(MppPacket *packet)
         return MPP_ERR_NULL_PTR;
     }
 
-    MppPacketImpl *p = mpp_calloc(MppPacketImpl, 1);
+    MppPacketImpl *p = (MppPacketImpl *)mpp_mem_pool_get(MppPacketPool::get_instance()->packet);
     *packet = p;
     if (NULL == p) {
         mpp_err_f("malloc failed\n");
         return MPP_ERR_NULL_PTR;
     }
+    memset(p, 0, sizeof(*p));
     setup_mpp_packet_name(p);
 
     return MPP_OK;
@@ -113,6 +159,9 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
 
     /* copy the source data */
     memcpy(pkt, src_impl, sizeof(*src_impl));
+    ((MppPacketImpl *)pkt)->pool = NULL;
+    ((MppPacketImpl *)pkt)->release = NULL;
+    ((MppPacketImpl *)pkt)->release_ctx = NULL;
 
     /* increase reference of meta data */
     if (src_impl->meta)
@@ -126,11 +175,11 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
          * NOTE: only copy valid data
          */
         size_t length = mpp_packet_get_length(src);
-        /*
-         * due to parser may be read 32 bit interface so we must alloc more size
-         * then real size to avoid read carsh
-         */
-        void *pos = mpp_malloc_size(void, length + 256);
+        size_t size = length + MPP_PACKET_PAYLOAD_PAD;
+        MppMemPool pool = MppPacketPool::get_instance()->get_payload_pool(size);
+        void *pos = (pool) ? mpp_mem_pool_get(pool) :
+                    mpp_malloc_size(void, size);
+
         if (NULL == pos) {
             mpp_err_f("malloc failed, size %d\n", length);
             mpp_packet_deinit(&pkt);
@@ -141,13 +190,14 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
         p->data = p->pos = pos;
         p->size = p->length = length;
         p->flag |= MPP_PACKET_FLAG_INTERNAL;
+        p->pool = pool;
 
         if (length) {
             memcpy(pos, src_impl->pos, length);
             /*
              * clean more alloc byte to zero
              */
-            memset((RK_U8*)pos + length, 0, 256);
+            memset((RK_U8*)pos + length, 0, MPP_PACKET_PAYLOAD_PAD);
         }
     }
 
@@ -155,6 +205,42 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
     return MPP_OK;
 }
 
+MPP_RET mpp_packet_ref_init(MppPacket *packet, const MppPacket src,
+                            MppPacketReleaseCb release, void *ctx)
+{
+    if (NULL == packet || check_is_mpp_packet(src)) {
+        mpp_err_f("found invalid input %p %p\n", packet, src);
+        return MPP_ERR_UNKNOW;
+    }
+
+    MppPacketImpl *src_impl = (MppPacketImpl *)src;
+
+    /* buffer packet is referenced by buffer */
+    if (src_impl->buffer || NULL == release)
+        return mpp_packet_copy_init(packet, src);
+
+    *packet = NULL;
+
+    MppPacket pkt;
+    MPP_RET ret = mpp_packet_new(&pkt);
+    if (ret)
+        return ret;
+
+    MppPacketImpl *p = (MppPacketImpl *)pkt;
+
+    memcpy(p, src_impl, sizeof(*src_impl));
+    p->flag &= ~MPP_PACKET_FLAG_INTERNAL;
+    p->pool = NULL;
+    p->release = release;
+    p->release_ctx = ctx;
+
+    if (p->meta)
+        mpp_meta_inc_ref(p->meta);
+
+    *packet = pkt;
+    return MPP_OK;
+}
+
 MPP_RET mpp_packet_deinit(MppPacket *packet)
 {
     if (NULL == packet || check_is_mpp_packet(*packet)) {
@@ -168,13 +254,20 @@ MPP_RET mpp_packet_deinit(MppPacket *packet)
     if (p->buffer)
         mpp_buffer_put(p->buffer);
 
-    if (p->flag & MPP_PACKET_FLAG_INTERNAL)
-        mpp_free(p->data);
+    if (p->release)
+        p->release(p->release_ctx, p->data, p->size);
+
+    if (p->flag & MPP_PACKET_FLAG_INTERNAL) {
+        if (p->pool)
+            mpp_mem_pool_put(p->pool, p->data);
+        else
+            mpp_free(p->data);
+    }
 
     if (p->meta)
         mpp_meta_put(p->meta);
 
-    mpp_free(p);
+    mpp_mem_pool_put(MppPacketPool::get_instance()->packet, p);
     *packet = NULL;
     return MPP_OK;
 }
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_ps_cache"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+
+#include "mpp_ps_cache.h"
+
+#define PS_CACHE_DBG_FUNC               (0x00000001)
+#define PS_CACHE_DBG_LOOKUP             (0x00000002)
+
+#define ps_cache_dbg(flag, fmt, ...)    _mpp_dbg_f(mpp_ps_cache_debug, flag, fmt, ## __VA_ARGS__)
+#define ps_cache_dbg_func(fmt, ...)     ps_cache_dbg(PS_CACHE_DBG_FUNC, fmt, ## __VA_ARGS__)
+#define ps_cache_dbg_lookup(fmt, ...)   ps_cache_dbg(PS_CACHE_DBG_LOOKUP, fmt, ## __VA_ARGS__)
+
+#define PS_CACHE_FNV_BASIS              2166136261U
+#define PS_CACHE_FNV_PRIME              16777619U
+
+typedef struct MppPsEntry_t {
+    RK_U32          hash;
+    RK_S32          size;           // zero for empty slot
+    RK_S32          max;
+    RK_U8           *data;
+} MppPsEntry;
+
+typedef struct MppPsCacheImpl_t {
+    RK_S32          count;
+    MppPsEntry      *entries;
+
+    RK_U32          hit;
+    RK_U32          miss;
+} MppPsCacheImpl;
+
+static RK_U32 mpp_ps_cache_debug = 0;
+
+static RK_U32 ps_cache_hash(const RK_U8 *data, RK_S32 size)
+{
+    RK_U32 hash = PS_CACHE_FNV_BASIS;
+    RK_S32 i;
+
+    for (i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= PS_CACHE_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+MPP_RET mpp_ps_cache_init(MppPsCache *cache, RK_S32 count)
+{
+    MppPsCacheImpl *p = NULL;
+
+    if (NULL == cache || count <= 0) {
+        mpp_err_f("invalid cache %p count %d\n", cache, count);
+        return MPP_ERR_VALUE;
+    }
+
+    mpp_env_get_u32("mpp_ps_cache_debug", &mpp_ps_cache_debug, 0);
+
+    *cache = NULL;
+
+    p = mpp_calloc_size(MppPsCacheImpl, sizeof(MppPsCacheImpl) +
+                        sizeof(MppPsEntry) * count);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc cache with %d slots\n", count);
+        return MPP_ERR_MALLOC;
+    }
+
+    p->count = count;
+    p->entries = (MppPsEntry *)(p + 1);
+
+    ps_cache_dbg_func("cache %p count %d\n", p, count);
+
+    *cache = p;
+    return MPP_OK;
+}
+
+MPP_RET mpp_ps_cache_deinit(MppPsCache cache)
+{
+    MppPsCacheImpl *p = (MppPsCacheImpl *)cache;
+    RK_S32 i;
+
+    if (NULL == p)
+        return MPP_ERR_NULL_PTR;
+
+    ps_cache_dbg_func("cache %p hit %u miss %u\n", p, p->hit, p->miss);
+
+    for (i = 0; i < p->count; i++)
+        MPP_FREE(p->entries[i].data);
+
+    mpp_free(p);
+    return MPP_OK;
+}
+
+RK_S32 mpp_ps_cache_lookup(MppPsCache cache, const RK_U8 *data, RK_S32 size)
+{
+    MppPsCacheImpl *p = (MppPsCacheImpl *)cache;
+    RK_U32 hash;
+    RK_S32 i;
+
+    if (NULL == p || NULL == data || size <= 0)
+        return -1;
+
+    hash = ps_cache_hash(data, size);
+
+    for (i = 0; i < p->count; i++) {
+        MppPsEntry *entry = &p->entries[i];
+
+        if (entry->hash == hash && entry->size == size &&
+            !memcmp(entry->data, data, size)) {
+            ps_cache_dbg_lookup("cache %p hit id %d size %d\n", p, i, size);
+            p->hit++;
+            return i;
+        }
+    }
+
+    ps_cache_dbg_lookup("cache %p miss size %d hash %08x\n", p, size, hash);
+    p->miss++;
+    return -1;
+}
+
+MPP_RET mpp_ps_cache_update(MppPsCache cache, RK_S32 id, const RK_U8 *data, RK_S32 size)
+{
+    MppPsCacheImpl *p = (MppPsCacheImpl *)cache;
+    MppPsEntry *entry = NULL;
+
+    if (NULL == p || id < 0 || id >= p->count)
+        return MPP_ERR_VALUE;
+
+    entry = &p->entries[id];
+    entry->size = 0;
+
+    if (NULL == data || size <= 0)
+        return MPP_OK;
+
+    if (size > entry->max) {
+        MPP_FREE(entry->data);
+        entry->data = mpp_malloc(RK_U8, size);
+        if (NULL == entry->data) {
+            entry->max = 0;
+            return MPP_ERR_MALLOC;
+        }
+        entry->max = size;
+    }
+
+    memcpy(entry->data, data, size);
+    entry->hash = ps_cache_hash(data, size);
+    entry->size = size;
+
+    return MPP_OK;
+}
+
+void mpp_ps_cache_remove(MppPsCache cache, RK_S32 id)
+{
+    MppPsCacheImpl *p = (MppPsCacheImpl *)cache;
+    RK_S32 i;
+
+    if (NULL == p || id >= p->count)
+        return;
+
+    if (id >= 0) {
+        p->entries[id].size = 0;
+        return;
+    }
+
+    for (i = 0; i < p->count; i++)
+        p->entries[i].size = 0;
+}
+
+void mpp_ps_cache_stats(MppPsCache cache, RK_U32 *hit, RK_U32 *miss)
+{
+    MppPsCacheImpl *p = (MppPsCacheImpl *)cache;
+
+    if (NULL == p)
+        return;
+
+    if (hit)
+        *hit += p->hit;
+    if (miss)
+        *miss += p->miss;
+}
@@ -0,0 +1,286 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_startcode"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+
+#include "mpp_startcode.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STARTCODE_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))
+#define STARTCODE_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define STARTCODE_NEON
+#include <arm_neon.h>
+#endif
+
+typedef RK_S32 (*StartCodeFind)(const RK_U8 *buf, RK_S32 size);
+
+static StartCodeFind find_startcode = NULL;
+static const char *find_startcode_name = NULL;
+
+RK_U32 mpp_startcode_debug = 0;
+
+static inline RK_S32 is_startcode(const RK_U8 *p)
+{
+    return !p[0] && !p[1] && p[2] == 1;
+}
+
+static inline RK_S32 ctz32(RK_U32 val)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(val);
+#else
+    RK_S32 cnt = 0;
+
+    while (!(val & 1)) {
+        val >>= 1;
+        cnt++;
+    }
+    return cnt;
+#endif
+}
+
+static RK_S32 find_startcode_tail(const RK_U8 *buf, RK_S32 start, RK_S32 size)
+{
+    RK_S32 i;
+
+    for (i = start; i + 2 < size; i++) {
+        if (is_startcode(buf + i))
+            return i;
+    }
+
+    return -1;
+}
+
+/*
+ * Word-at-a-time fallback. A start code can only begin in a word which has
+ * at least one zero byte so words without zero byte are skipped at once.
+ */
+static RK_S32 find_startcode_word(const RK_U8 *buf, RK_S32 size)
+{
+    const RK_U64 lo = 0x0101010101010101ULL;
+    const RK_U64 hi = 0x8080808080808080ULL;
+    RK_S32 i = 0;
+
+    for (; i + 8 + 2 <= size; i += 8) {
+        RK_U64 val;
+        RK_S32 j;
+
+        memcpy(&val, buf + i, sizeof(val));
+        if (!((val - lo) & ~val & hi))
+            continue;
+
+        for (j = 0; j < 8; j++) {
+            if (is_startcode(buf + i + j))
+                return i + j;
+        }
+    }
+
+    return find_startcode_tail(buf, i, size);
+}
+
+#ifdef STARTCODE_SSE2
+static RK_S32 find_startcode_sse2(const RK_U8 *buf, RK_S32 size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    RK_S32 i = 0;
+
+    for (; i + 16 + 2 <= size; i += 16) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)(buf + i));
+        __m128i z0 = _mm_cmpeq_epi8(v0, zero);
+        __m128i v1, v2, match;
+        RK_U32 mask;
+
+        if (!_mm_movemask_epi8(z0))
+            continue;
+
+        v1 = _mm_loadu_si128((const __m128i *)(buf + i + 1));
+        v2 = _mm_loadu_si128((const __m128i *)(buf + i + 2));
+        match = _mm_and_si128(z0, _mm_cmpeq_epi8(v1, zero));
+        match = _mm_and_si128(match, _mm_cmpeq_epi8(v2, one));
+        mask = (RK_U32)_mm_movemask_epi8(match);
+        if (mask)
+            return i + ctz32(mask);
+    }
+
+    return find_startcode_tail(buf, i, size);
+}
+#endif
+
+#ifdef STARTCODE_AVX2
+__attribute__((target("avx2")))
+static RK_S32 find_startcode_avx2(const RK_U8 *buf, RK_S32 size)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    RK_S32 i = 0;
+
+    for (; i + 32 + 2 <= size; i += 32) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(buf + i));
+        __m256i z0 = _mm256_cmpeq_epi8(v0, zero);
+        __m256i v1, v2, match;
+        RK_U32 mask;
+
+        if (!_mm256_movemask_epi8(z0))
+            continue;
+
+        v1 = _mm256_loadu_si256((const __m256i *)(buf + i + 1));
+        v2 = _mm256_loadu_si256((const __m256i *)(buf + i + 2));
+        match = _mm256_and_si256(z0, _mm256_cmpeq_epi8(v1, zero));
+        match = _mm256_and_si256(match, _mm256_cmpeq_epi8(v2, one));
+        mask = (RK_U32)_mm256_movemask_epi8(match);
+        if (mask)
+            return i + ctz32(mask);
+    }
+
+    return find_startcode_tail(buf, i, size);
+}
+#endif
+
+#ifdef STARTCODE_NEON
+static RK_S32 find_startcode_neon(const RK_U8 *buf, RK_S32 size)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+    RK_S32 i = 0;
+
+    for (; i + 16 + 2 <= size; i += 16) {
+        uint8x16_t z0 = vceqq_u8(vld1q_u8(buf + i), zero);
+        uint8x16_t match;
+        uint64x2_t any;
+        RK_S32 j;
+
+        any = vreinterpretq_u64_u8(z0);
+        if (!(vgetq_lane_u64(any, 0) | vgetq_lane_u64(any, 1)))
+            continue;
+
+        match = vandq_u8(z0, vceqq_u8(vld1q_u8(buf + i + 1), zero));
+        match = vandq_u8(match, vceqq_u8(vld1q_u8(buf + i + 2), one));
+        any = vreinterpretq_u64_u8(match);
+        if (!(vgetq_lane_u64(any, 0) | vgetq_lane_u64(any, 1)))
+            continue;
+
+        for (j = 0; j < 16; j++) {
+            if (is_startcode(buf + i + j))
+                return i + j;
+        }
+    }
+
+    return find_startcode_tail(buf, i, size);
+}
+#endif
+
+static void startcode_init(void)
+{
+    mpp_env_get_u32("mpp_startcode_debug", &mpp_startcode_debug, 0);
+
+    find_startcode = find_startcode_word;
+    find_startcode_name = "word";
+
+    /* mpp_startcode_debug bit 0 forces the portable path for comparison */
+    if (mpp_startcode_debug & 1)
+        return;
+
+#ifdef STARTCODE_SSE2
+    find_startcode = find_startcode_sse2;
+    find_startcode_name = "sse2";
+#endif
+#ifdef STARTCODE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        find_startcode = find_startcode_avx2;
+        find_startcode_name = "avx2";
+    }
+#endif
+#ifdef STARTCODE_NEON
+    find_startcode = find_startcode_neon;
+    find_startcode_name = "neon";
+#endif
+}
+
+RK_S32 mpp_find_startcode(const RK_U8 *buf, RK_S32 size)
+{
+    if (NULL == find_startcode)
+        startcode_init();
+
+    if (NULL == buf || size < 3)
+        return -1;
+
+    return find_startcode(buf, size);
+}
+
+RK_S32 mpp_find_startcodes(const RK_U8 *buf, RK_S32 size, RK_S32 *pos, RK_S32 max)
+{
+    RK_S32 offset = 0;
+    RK_S32 count = 0;
+
+    while (count < max) {
+        RK_S32 found = mpp_find_startcode(buf + offset, size - offset);
+
+        if (found < 0)
+            break;
+
+        pos[count++] = offset + found;
+        offset += found + 3;
+    }
+
+    return count;
+}
+
+RK_U64 mpp_startcode_state(RK_U64 state, const RK_U8 *buf, RK_S32 size)
+{
+    RK_S32 i = (size > 8) ? (size - 8) : 0;
+
+    for (; i < size; i++)
+        state = (state << 8) | buf[i];
+
+    return state;
+}
+
+RK_S32 mpp_startcode_skip(RK_U64 state, const RK_U8 *buf, RK_S32 size)
+{
+    RK_S32 found;
+
+    if (size <= 0)
+        return 0;
+
+    if (!(state & 0xFF) || (state & 0xFFFFFF) == 0x000001)
+        return 1;
+
+    found = mpp_find_startcode(buf, size);
+
+    return (found < 0) ? size : (found + 3);
+}
+
+const char *mpp_startcode_impl_name(void)
+{
+    if (NULL == find_startcode)
+        startcode_init();
+
+    return find_startcode_name;
+}
@@ -472,14 +472,8 @@ MPP_RET mpp_task_queue_deinit(MppTaskQueue queue)
                           &p->tasks[i], p->tasks[i].status,
                           mpp_meta_size(meta));
 
-                while (mpp_meta_size(meta)) {
-                    MppMetaNode *node = mpp_meta_next_node(meta);
-
-                    mpp_err_f("meta %p node %p id %d type %d\n",
-                              meta, node, node->node_id, node->type_id);
-
-                    MPP_FREE(node);
-                }
+                if (mpp_meta_size(meta))
+                    mpp_meta_dump(meta);
             }
 
             mpp_assert(p->tasks[i].status == MPP_INPUT_PORT ||
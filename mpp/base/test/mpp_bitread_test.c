@@ -0,0 +1,205 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_bitread_test"
+
+#include <stdlib.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_bitread.h"
+#include "mpp_bitwrite.h"
+
+#define SYNTAX_COUNT        (256 * 1024)
+#define STREAM_SIZE         (SYNTAX_COUNT * 8)
+#define LOOP_COUNT          16
+
+typedef enum BitReadOpsType_e {
+    BIT_READ_BITS,
+    BIT_READ_UE,
+    BIT_READ_SE,
+    BIT_READ_OPS_BUTT,
+} BitReadOpsType;
+
+typedef struct BitReadOps_t {
+    BitReadOpsType  type;
+    RK_S32          val;
+    RK_S32          len;
+} BitReadOps;
+
+/* header syntax is mostly short ue / se with a few fixed length fields */
+static void gen_ops(BitReadOps *ops, RK_S32 count)
+{
+    RK_S32 i;
+
+    srand(0x1234);
+
+    for (i = 0; i < count; i++) {
+        BitReadOps *op = &ops[i];
+
+        op->type = (BitReadOpsType)(rand() % BIT_READ_OPS_BUTT);
+        switch (op->type) {
+        case BIT_READ_BITS : {
+            op->len = rand() % 24 + 1;
+            op->val = (rand() & 1) ? 0 : (rand() & ((1 << op->len) - 1));
+        } break;
+        case BIT_READ_UE : {
+            op->val = (rand() & 7) ? (rand() & 0xf) : (rand() & 0xffff);
+        } break;
+        case BIT_READ_SE : {
+            op->val = (rand() & 0xff) - 0x80;
+        } break;
+        default : {
+        } break;
+        }
+    }
+}
+
+static RK_S32 write_ops(MppWriteCtx *writer, BitReadOps *ops, RK_S32 count)
+{
+    RK_S32 bits = 0;
+    RK_S32 i;
+
+    for (i = 0; i < count; i++) {
+        BitReadOps *op = &ops[i];
+        RK_S32 start = mpp_writer_bits(writer);
+
+        switch (op->type) {
+        case BIT_READ_BITS : {
+            mpp_writer_put_bits(writer, op->val, op->len);
+        } break;
+        case BIT_READ_UE : {
+            mpp_writer_put_ue(writer, op->val);
+        } break;
+        case BIT_READ_SE : {
+            mpp_writer_put_se(writer, op->val);
+        } break;
+        default : {
+        } break;
+        }
+        bits += mpp_writer_bits(writer) - start;
+    }
+    /* emulation prevention bytes are not counted by the reader */
+    bits -= writer->emul_cnt * 8;
+    mpp_writer_trailing(writer);
+
+    return bits;
+}
+
+static MPP_RET read_ops(BitReadCtx_t *bitctx, BitReadOps *ops, RK_S32 count)
+{
+    RK_S32 i;
+
+    for (i = 0; i < count; i++) {
+        BitReadOps *op = &ops[i];
+        RK_S32 val = 0;
+
+        switch (op->type) {
+        case BIT_READ_BITS : {
+            READ_BITS(bitctx, op->len, &val);
+        } break;
+        case BIT_READ_UE : {
+            READ_UE(bitctx, &val);
+        } break;
+        case BIT_READ_SE : {
+            READ_SE(bitctx, &val);
+        } break;
+        default : {
+        } break;
+        }
+        if (val != op->val) {
+            mpp_err("syntax %d type %d mismatch write %d read %d\n",
+                    i, op->type, op->val, val);
+            return MPP_NOK;
+        }
+    }
+
+    return MPP_OK;
+__BITREAD_ERR:
+    mpp_err("syntax %d type %d read failed\n", i, ops[i].type);
+    return bitctx->ret;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    BitReadOps *ops = mpp_malloc(BitReadOps, SYNTAX_COUNT);
+    RK_U8 *data = mpp_malloc(RK_U8, STREAM_SIZE);
+    MppWriteCtx writer;
+    BitReadCtx_t bitctx;
+    RK_S32 bits;
+    RK_S32 len;
+    RK_S64 time;
+    RK_S32 i;
+
+    mpp_log("mpp_bitread_test start\n");
+
+    if (NULL == ops || NULL == data) {
+        mpp_err("mpp_bitread_test malloc failed\n");
+        goto TEST_FAILED;
+    }
+
+    gen_ops(ops, SYNTAX_COUNT);
+
+    /* written with emulation prevention so the 0x03 skip path is covered */
+    mpp_writer_init(&writer, data, STREAM_SIZE);
+    bits = write_ops(&writer, ops, SYNTAX_COUNT);
+    len = mpp_writer_bytes(&writer);
+
+    mpp_log("stream %d bytes with %d emulation prevention bytes\n",
+            len, writer.emul_cnt);
+
+    mpp_set_bitread_ctx(&bitctx, data, len);
+    mpp_set_pre_detection(&bitctx);
+    if (read_ops(&bitctx, ops, SYNTAX_COUNT))
+        goto TEST_FAILED;
+
+    if (bitctx.used_bits != bits) {
+        mpp_err("used bits mismatch write %d read %d\n", bits, bitctx.used_bits);
+        goto TEST_FAILED;
+    }
+
+    if (mpp_has_more_rbsp_data(&bitctx)) {
+        mpp_err("found more rbsp data after the trailing bits\n");
+        goto TEST_FAILED;
+    }
+
+    time = mpp_time();
+    for (i = 0; i < LOOP_COUNT; i++) {
+        mpp_set_bitread_ctx(&bitctx, data, len);
+        mpp_set_pre_detection(&bitctx);
+        read_ops(&bitctx, ops, SYNTAX_COUNT);
+    }
+    time = mpp_time() - time;
+
+    mpp_log("read %d syntax x %d loops in %.2f ms, %.2f M syntax/s\n",
+            SYNTAX_COUNT, LOOP_COUNT, time / 1000.0,
+            (double)SYNTAX_COUNT * LOOP_COUNT / MPP_MAX(time, 1));
+
+    ret = MPP_OK;
+TEST_FAILED:
+    MPP_FREE(ops);
+    MPP_FREE(data);
+
+    if (ret)
+        mpp_log("mpp_bitread_test failed\n");
+    else
+        mpp_log("mpp_bitread_test success\n");
+
+    return ret;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_buf_slot_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
+#include "mpp_common.h"
+#include "mpp_buf_slot.h"
+
+#define SLOT_TEST_COUNT         16
+#define SLOT_TEST_FRAME_COUNT   100000
+
+typedef struct SlotTestCtx_t {
+    MppBufSlots     slots;
+    MppFrame        frame;
+    volatile RK_S32 done;
+
+    // slot operation time on decoder thread
+    RK_S64          time_max;
+    RK_S64          time_sum;
+    RK_S32          frame_count;
+    RK_S32          display_count;
+    RK_S32          query_count;
+} SlotTestCtx;
+
+/* parser and hal: get slot, decode, mark output ready and send to display */
+static void *slot_test_dec_proc(void *arg)
+{
+    SlotTestCtx *ctx = (SlotTestCtx *)arg;
+    MppBufSlots slots = ctx->slots;
+    RK_S32 i;
+
+    for (i = 0; i < SLOT_TEST_FRAME_COUNT; i++) {
+        RK_S64 start;
+        RK_S32 index = -1;
+
+        while (!mpp_slots_get_unused_count(slots))
+            sched_yield();
+
+        start = mpp_time();
+
+        mpp_buf_slot_get_unused(slots, &index);
+        mpp_buf_slot_set_flag(slots, index, SLOT_CODEC_USE);
+        mpp_buf_slot_set_flag(slots, index, SLOT_HAL_OUTPUT);
+        mpp_buf_slot_set_prop(slots, index, SLOT_FRAME, ctx->frame);
+        mpp_buf_slot_set_flag(slots, index, SLOT_QUEUE_USE);
+        mpp_buf_slot_enqueue(slots, index, QUEUE_DISPLAY);
+        mpp_buf_slot_clr_flag(slots, index, SLOT_HAL_OUTPUT);
+        mpp_buf_slot_clr_flag(slots, index, SLOT_CODEC_USE);
+
+        start = mpp_time() - start;
+        ctx->time_sum += start;
+        if (start > ctx->time_max)
+            ctx->time_max = start;
+        ctx->frame_count++;
+    }
+
+    ctx->done = 1;
+    return NULL;
+}
+
+/* user get_frame: take display slot and release it */
+static void *slot_test_dis_proc(void *arg)
+{
+    SlotTestCtx *ctx = (SlotTestCtx *)arg;
+    MppBufSlots slots = ctx->slots;
+
+    while (ctx->display_count < SLOT_TEST_FRAME_COUNT) {
+        MppFrame frame = NULL;
+        RK_S32 index = -1;
+
+        if (mpp_buf_slot_dequeue(slots, &index, QUEUE_DISPLAY)) {
+            if (ctx->done && mpp_slots_is_empty(slots, QUEUE_DISPLAY))
+                break;
+
+            sched_yield();
+            continue;
+        }
+
+        mpp_buf_slot_get_prop(slots, index, SLOT_FRAME_PTR, &frame);
+        mpp_buf_slot_clr_flag(slots, index, SLOT_QUEUE_USE);
+        ctx->display_count++;
+    }
+
+    return NULL;
+}
+
+/* mpp_dec status checking on slots count */
+static void *slot_test_query_proc(void *arg)
+{
+    SlotTestCtx *ctx = (SlotTestCtx *)arg;
+
+    while (!ctx->done) {
+        mpp_slots_get_unused_count(ctx->slots);
+        mpp_slots_get_used_count(ctx->slots);
+        ctx->query_count++;
+    }
+
+    return NULL;
+}
+
+int main()
+{
+    SlotTestCtx ctx;
+    pthread_t thd[3];
+    RK_S64 time;
+    RK_S32 ret = 0;
+
+    mpp_log("mpp_buf_slot_test start\n");
+
+    memset(&ctx, 0, sizeof(ctx));
+
+    mpp_buf_slot_init(&ctx.slots);
+    mpp_buf_slot_setup(ctx.slots, SLOT_TEST_COUNT);
+
+    mpp_frame_init(&ctx.frame);
+    mpp_frame_set_width(ctx.frame, 1920);
+    mpp_frame_set_height(ctx.frame, 1080);
+    mpp_frame_set_hor_stride(ctx.frame, 1920);
+    mpp_frame_set_ver_stride(ctx.frame, 1088);
+
+    time = mpp_time();
+
+    pthread_create(&thd[0], NULL, slot_test_dec_proc, &ctx);
+    pthread_create(&thd[1], NULL, slot_test_dis_proc, &ctx);
+    pthread_create(&thd[2], NULL, slot_test_query_proc, &ctx);
+
+    pthread_join(thd[0], NULL);
+    pthread_join(thd[1], NULL);
+    pthread_join(thd[2], NULL);
+
+    time = mpp_time() - time;
+
+    if (ctx.display_count != SLOT_TEST_FRAME_COUNT ||
+        mpp_slots_get_used_count(ctx.slots)) {
+        mpp_err("mismatch decode %d display %d used %d\n", ctx.frame_count,
+                ctx.display_count, mpp_slots_get_used_count(ctx.slots));
+        ret = -1;
+    }
+
+    mpp_log("%d frames in %.2f ms, %.2f K frames/s, %d count queries\n",
+            ctx.frame_count, time / 1000.0,
+            (double)ctx.frame_count * 1000 / MPP_MAX(time, 1), ctx.query_count);
+    mpp_log("decoder slot operation per frame avg %.2f us max %lld us\n",
+            (double)ctx.time_sum / MPP_MAX(ctx.frame_count, 1), ctx.time_max);
+
+    mpp_frame_deinit(&ctx.frame);
+    mpp_buf_slot_deinit(ctx.slots);
+
+    mpp_log("mpp_buf_slot_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
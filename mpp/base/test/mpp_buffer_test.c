@@ -23,6 +23,8 @@
 #endif
 #include "mpp_log.h"
 #include "mpp_env.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
 #include "mpp_common.h"
 #include "mpp_buffer.h"
 #include "mpp_allocator.h"
@@ -32,6 +34,488 @@
 #define MPP_BUFFER_TEST_COMMIT_COUNT    10
 #define MPP_BUFFER_TEST_NORMAL_COUNT    10
 
+/* reuse test: buffer count on each resolution */
+#define MPP_BUFFER_TEST_REUSE_COUNT     4
+
+/* pool test: each session reserves 2 buffers and peaks to 8 in turn */
+#define MPP_BUFFER_TEST_POOL_SESSIONS   4
+#define MPP_BUFFER_TEST_POOL_RESERVE    2
+#define MPP_BUFFER_TEST_POOL_PEAK       8
+#define MPP_BUFFER_TEST_POOL_LIMIT      16
+
+/* contention test: each thread works like one decoder instance */
+#define MPP_BUFFER_TEST_THREAD_COUNT    4
+#define MPP_BUFFER_TEST_FRAME_COUNT     4
+#define MPP_BUFFER_TEST_LOOP_COUNT      20000
+
+/* group count test: live groups above the initial group table size */
+#define MPP_BUFFER_TEST_GROUP_COUNT     3000
+
+typedef struct MppBufferTestCtx_t {
+    MppBufferGroup  group;
+    MppBuffer       shared;
+    RK_S32          loop;
+    MPP_RET         ret;
+} MppBufferTestCtx;
+
+/*
+ * Per frame buffer flow of a decoder: get from its own group, reference by
+ * decoder / display, release all. The shared buffer reference change is for
+ * buffer shared between instances.
+ */
+static void *mpp_buffer_test_proc(void *arg)
+{
+    MppBufferTestCtx *ctx = (MppBufferTestCtx *)arg;
+    MppBuffer buf[MPP_BUFFER_TEST_FRAME_COUNT];
+    RK_S32 i, j;
+
+    for (i = 0; i < ctx->loop; i++) {
+        for (j = 0; j < MPP_BUFFER_TEST_FRAME_COUNT; j++) {
+            ctx->ret = mpp_buffer_get(ctx->group, &buf[j], MPP_BUFFER_TEST_SIZE);
+            if (ctx->ret)
+                return NULL;
+
+            mpp_buffer_inc_ref(buf[j]);
+            mpp_buffer_inc_ref(ctx->shared);
+        }
+
+        for (j = 0; j < MPP_BUFFER_TEST_FRAME_COUNT; j++) {
+            mpp_buffer_put(buf[j]);
+            mpp_buffer_put(buf[j]);
+            mpp_buffer_put(ctx->shared);
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Resolution switch on a group: small -> large -> small. The unused small
+ * buffers are evicted on large request unless keep undersized is enabled.
+ * The final small request should be served by the best fit unused buffer.
+ */
+static MPP_RET mpp_buffer_reuse_test(RK_U32 keep_undersized)
+{
+    static const size_t sizes[3] = { SZ_1K * 16, SZ_1K * 32, SZ_1K * 8 };
+    MppBuffer buf[MPP_BUFFER_TEST_REUSE_COUNT];
+    MppBufferGroup group = NULL;
+    size_t fit = (keep_undersized) ? (sizes[0]) : (sizes[1]);
+    RK_U32 hit = 0, miss = 0, evict = 0;
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i, j;
+
+    if (mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_ION)) {
+        mpp_err("mpp_buffer_test mpp_buffer_group_get failed\n");
+        return MPP_NOK;
+    }
+
+    mpp_buffer_group_reuse_config(group, keep_undersized);
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < MPP_BUFFER_TEST_REUSE_COUNT; j++) {
+            if (mpp_buffer_get(group, &buf[j], sizes[i])) {
+                mpp_err("mpp_buffer_test get buffer size %d failed\n", sizes[i]);
+                goto DONE;
+            }
+        }
+
+        for (j = 0; j < MPP_BUFFER_TEST_REUSE_COUNT; j++) {
+            if (i == 2 && mpp_buffer_get_size(buf[j]) != fit) {
+                mpp_err("mpp_buffer_test reuse size %d not best fit %d\n",
+                        mpp_buffer_get_size(buf[j]), fit);
+                goto DONE;
+            }
+            mpp_buffer_put(buf[j]);
+        }
+    }
+
+    mpp_buffer_group_reuse_stats(group, &hit, &miss, &evict);
+
+    mpp_log("mpp_buffer_test keep undersized %d reuse hit %d miss %d evict %d\n",
+            keep_undersized, hit, miss, evict);
+
+    if (hit != MPP_BUFFER_TEST_REUSE_COUNT ||
+        miss != MPP_BUFFER_TEST_REUSE_COUNT * 2 ||
+        evict != ((keep_undersized) ? (0) : (MPP_BUFFER_TEST_REUSE_COUNT))) {
+        mpp_err("mpp_buffer_test reuse stats mismatch\n");
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    mpp_buffer_group_put(group);
+    return ret;
+}
+
+/*
+ * pre-allocated buffers for the max size are reused by the smaller requests
+ * after it without any new allocation
+ */
+static MPP_RET mpp_buffer_prealloc_test(void)
+{
+    MppBuffer buf[MPP_BUFFER_TEST_REUSE_COUNT];
+    MppBufferGroup group = NULL;
+    RK_U32 hit = 0, miss = 0, evict = 0;
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i;
+
+    if (mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_ION)) {
+        mpp_err("mpp_buffer_test mpp_buffer_group_get failed\n");
+        return MPP_NOK;
+    }
+
+    /* the second call finds the buffers of the first call */
+    if (mpp_buffer_group_prealloc(group, SZ_1K * 32, MPP_BUFFER_TEST_REUSE_COUNT) ||
+        mpp_buffer_group_prealloc(group, SZ_1K * 32, MPP_BUFFER_TEST_REUSE_COUNT)) {
+        mpp_err("mpp_buffer_test prealloc failed\n");
+        goto DONE;
+    }
+
+    for (i = 0; i < MPP_BUFFER_TEST_REUSE_COUNT; i++) {
+        if (mpp_buffer_get(group, &buf[i], SZ_1K * 16)) {
+            mpp_err("mpp_buffer_test get buffer failed\n");
+            goto DONE;
+        }
+    }
+
+    for (i = 0; i < MPP_BUFFER_TEST_REUSE_COUNT; i++)
+        mpp_buffer_put(buf[i]);
+
+    mpp_buffer_group_reuse_stats(group, &hit, &miss, &evict);
+
+    mpp_log("mpp_buffer_test prealloc hit %d miss %d evict %d\n", hit, miss, evict);
+
+    if (hit != MPP_BUFFER_TEST_REUSE_COUNT * 2 ||
+        miss != MPP_BUFFER_TEST_REUSE_COUNT || evict) {
+        mpp_err("mpp_buffer_test prealloc stats mismatch\n");
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    mpp_buffer_group_put(group);
+    return ret;
+}
+
+/*
+ * Sessions peak one after another on a shared pool. The peak usage is the
+ * reserve of all sessions plus one peak instead of the sum of all peaks.
+ * Buffers above the reserve are lent between sessions without allocation.
+ */
+static MPP_RET mpp_buffer_pool_test(void)
+{
+    MppBuffer held[MPP_BUFFER_TEST_POOL_SESSIONS][MPP_BUFFER_TEST_POOL_PEAK + 2];
+    MppBufferGroup groups[MPP_BUFFER_TEST_POOL_SESSIONS];
+    MppBufferPool pool = NULL;
+    size_t usage = 0, idle = 0, peak = 0;
+    RK_U32 miss = 0;
+    RK_S32 extra = 0;
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i, j;
+
+    memset(held, 0, sizeof(held));
+    memset(groups, 0, sizeof(groups));
+
+    if (mpp_buffer_pool_get(&pool, MPP_BUFFER_TYPE_NORMAL,
+                            SZ_1M * MPP_BUFFER_TEST_POOL_LIMIT)) {
+        mpp_err("mpp_buffer_test pool get failed\n");
+        return MPP_NOK;
+    }
+
+    for (i = 0; i < MPP_BUFFER_TEST_POOL_SESSIONS; i++) {
+        if (mpp_buffer_group_get_internal(&groups[i], MPP_BUFFER_TYPE_NORMAL) ||
+            mpp_buffer_group_attach_pool(groups[i], pool,
+                                         SZ_1M * MPP_BUFFER_TEST_POOL_RESERVE)) {
+            mpp_err("mpp_buffer_test pool attach group %d failed\n", i);
+            goto DONE;
+        }
+
+        for (j = 0; j < MPP_BUFFER_TEST_POOL_RESERVE; j++) {
+            if (mpp_buffer_get(groups[i], &held[i][j], SZ_1M))
+                goto DONE;
+        }
+    }
+
+    for (i = 0; i < MPP_BUFFER_TEST_POOL_SESSIONS; i++) {
+        for (j = MPP_BUFFER_TEST_POOL_RESERVE; j < MPP_BUFFER_TEST_POOL_PEAK; j++) {
+            if (mpp_buffer_get(groups[i], &held[i][j], SZ_1M)) {
+                mpp_err("mpp_buffer_test pool session %d peak failed\n", i);
+                goto DONE;
+            }
+        }
+
+        /* buffers above reserve go back to pool for the next session */
+        for (j = MPP_BUFFER_TEST_POOL_RESERVE; j < MPP_BUFFER_TEST_POOL_PEAK; j++) {
+            mpp_buffer_put(held[i][j]);
+            held[i][j] = NULL;
+        }
+    }
+
+    mpp_buffer_pool_stats(pool, &usage, &idle, &peak);
+
+    mpp_log("mpp_buffer_test pool peak %d MB of %d MB without pool, usage %d MB idle %d MB\n",
+            peak / SZ_1M, MPP_BUFFER_TEST_POOL_SESSIONS * MPP_BUFFER_TEST_POOL_PEAK,
+            usage / SZ_1M, idle / SZ_1M);
+
+    if (peak != SZ_1M * (MPP_BUFFER_TEST_POOL_SESSIONS * MPP_BUFFER_TEST_POOL_RESERVE +
+                         MPP_BUFFER_TEST_POOL_PEAK - MPP_BUFFER_TEST_POOL_RESERVE)) {
+        mpp_err("mpp_buffer_test pool peak mismatch\n");
+        goto DONE;
+    }
+
+    /* session 0 takes all idle buffers then reaches the pool limit */
+    for (j = MPP_BUFFER_TEST_POOL_RESERVE; j < MPP_BUFFER_TEST_POOL_PEAK + 2; j++) {
+        if (mpp_buffer_get(groups[0], &held[0][j], SZ_1M))
+            break;
+        extra++;
+    }
+
+    mpp_buffer_pool_stats(pool, &usage, NULL, &peak);
+
+    for (i = 1; i < MPP_BUFFER_TEST_POOL_SESSIONS; i++) {
+        RK_U32 m = 0;
+
+        mpp_buffer_group_reuse_stats(groups[i], NULL, &m, NULL);
+        miss += m;
+    }
+
+    mpp_log("mpp_buffer_test pool session 0 got %d more buffers, other sessions allocate %d\n",
+            extra, miss);
+
+    if (peak != SZ_1M * MPP_BUFFER_TEST_POOL_LIMIT ||
+        extra != MPP_BUFFER_TEST_POOL_LIMIT - MPP_BUFFER_TEST_POOL_RESERVE *
+        (MPP_BUFFER_TEST_POOL_SESSIONS - 1) - MPP_BUFFER_TEST_POOL_RESERVE ||
+        miss != (MPP_BUFFER_TEST_POOL_SESSIONS - 1) * MPP_BUFFER_TEST_POOL_RESERVE) {
+        mpp_err("mpp_buffer_test pool stats mismatch\n");
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    for (i = 0; i < MPP_BUFFER_TEST_POOL_SESSIONS; i++) {
+        for (j = 0; j < MPP_BUFFER_TEST_POOL_PEAK + 2; j++) {
+            if (held[i][j])
+                mpp_buffer_put(held[i][j]);
+        }
+        if (groups[i])
+            mpp_buffer_group_put(groups[i]);
+    }
+    mpp_buffer_pool_put(pool);
+    return ret;
+}
+
+/*
+ * memfd buffer is imported by its fd like in the other process. The imported
+ * buffer is a different mapping of the same pages.
+ */
+static MPP_RET mpp_buffer_memfd_test(void)
+{
+    MppBufferGroup group = NULL;
+    MppBuffer buffer = NULL;
+    MppBuffer imported = NULL;
+    MppBufferInfo info;
+    RK_U8 *src = NULL;
+    RK_U8 *dst = NULL;
+    MPP_RET ret = MPP_NOK;
+
+    if (mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_MEMFD) ||
+        mpp_buffer_get(group, &buffer, SZ_1M)) {
+        mpp_err("mpp_buffer_test get memfd buffer failed\n");
+        goto DONE;
+    }
+
+    src = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+    memset(src, 0x5a, SZ_1M);
+
+    memset(&info, 0, sizeof(info));
+    info.type = MPP_BUFFER_TYPE_MEMFD;
+    info.size = SZ_1M;
+    info.fd = mpp_buffer_get_fd(buffer);
+
+    if (mpp_buffer_import(&imported, &info)) {
+        mpp_err("mpp_buffer_test import memfd %d failed\n", info.fd);
+        goto DONE;
+    }
+
+    dst = (RK_U8 *)mpp_buffer_get_ptr(imported);
+    if (NULL == dst || dst == src || dst[SZ_1M - 1] != 0x5a) {
+        mpp_err("mpp_buffer_test memfd import mapping %p mismatch\n", dst);
+        goto DONE;
+    }
+
+    dst[0] = 0xa5;
+    if (src[0] != 0xa5) {
+        mpp_err("mpp_buffer_test memfd write is not shared\n");
+        goto DONE;
+    }
+
+    mpp_log("mpp_buffer_test memfd fd %d imported fd %d\n",
+            mpp_buffer_get_fd(buffer), mpp_buffer_get_fd(imported));
+    ret = MPP_OK;
+DONE:
+    if (imported)
+        mpp_buffer_put(imported);
+    if (buffer)
+        mpp_buffer_put(buffer);
+    if (group)
+        mpp_buffer_group_put(group);
+    return ret;
+}
+
+/*
+ * Huge page and numa node 0 placement on normal and memfd group. The thp
+ * buffer from normal allocator should be huge page aligned.
+ */
+static MPP_RET mpp_buffer_placement_test(MppBufferType type, MppBufferPage page)
+{
+    MppBufferGroup group = NULL;
+    MppBuffer buffer = NULL;
+    void *ptr = NULL;
+    MPP_RET ret = MPP_NOK;
+
+    if (mpp_buffer_group_get_internal(&group, type) ||
+        mpp_buffer_group_placement_config(group, page, 0) ||
+        mpp_buffer_get(group, &buffer, SZ_1M * 3)) {
+        mpp_err("mpp_buffer_test placement type %d page %d failed\n", type, page);
+        goto DONE;
+    }
+
+    ptr = mpp_buffer_get_ptr(buffer);
+    if (NULL == ptr ||
+        (type == MPP_BUFFER_TYPE_NORMAL && page == MPP_BUFFER_PAGE_THP &&
+         ((intptr_t)ptr & (SZ_1M * 2 - 1)))) {
+        mpp_err("mpp_buffer_test placement type %d page %d ptr %p invalid\n",
+                type, page, ptr);
+        goto DONE;
+    }
+
+    memset(ptr, 0, SZ_1M * 3);
+    mpp_log("mpp_buffer_test placement type %d page %d ptr %p\n", type, page, ptr);
+    ret = MPP_OK;
+DONE:
+    if (buffer)
+        mpp_buffer_put(buffer);
+    if (group)
+        mpp_buffer_group_put(group);
+    return ret;
+}
+
+/*
+ * Many sessions keep their groups alive at the same time. Each group gets
+ * one buffer with reference change to check the group lookup by id.
+ */
+static MPP_RET mpp_buffer_group_count_test(void)
+{
+    MppBufferGroup *groups = NULL;
+    MppBuffer buffer = NULL;
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i;
+
+    groups = (MppBufferGroup *)calloc(MPP_BUFFER_TEST_GROUP_COUNT, sizeof(*groups));
+    if (NULL == groups) {
+        mpp_err("mpp_buffer_test malloc groups failed\n");
+        return MPP_NOK;
+    }
+
+    for (i = 0; i < MPP_BUFFER_TEST_GROUP_COUNT; i++) {
+        if (mpp_buffer_group_get_internal(&groups[i], MPP_BUFFER_TYPE_NORMAL)) {
+            mpp_err("mpp_buffer_test get group %d failed\n", i);
+            goto DONE;
+        }
+
+        if (mpp_buffer_get(groups[i], &buffer, SZ_1K)) {
+            mpp_err("mpp_buffer_test get buffer on group %d failed\n", i);
+            goto DONE;
+        }
+
+        /* both ref change looks up the group by id of the buffer */
+        if (mpp_buffer_inc_ref(buffer) || mpp_buffer_put(buffer) ||
+            mpp_buffer_put(buffer)) {
+            mpp_err("mpp_buffer_test ref buffer on group %d failed\n", i);
+            goto DONE;
+        }
+        buffer = NULL;
+    }
+
+    ret = MPP_OK;
+DONE:
+    for (i = 0; i < MPP_BUFFER_TEST_GROUP_COUNT; i++) {
+        if (groups[i])
+            mpp_buffer_group_put(groups[i]);
+    }
+    free(groups);
+    return ret;
+}
+
+static MPP_RET mpp_buffer_contention_test(RK_S32 thread_count)
+{
+    MppBufferTestCtx ctx[MPP_BUFFER_TEST_THREAD_COUNT];
+    pthread_t thd[MPP_BUFFER_TEST_THREAD_COUNT];
+    MppBufferGroup group = NULL;
+    MppBuffer shared = NULL;
+    MPP_RET ret = MPP_OK;
+    RK_S64 time;
+    RK_S64 ops;
+    RK_S32 i;
+
+    memset(ctx, 0, sizeof(ctx));
+
+    ret = mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_ION);
+    if (ret) {
+        mpp_err("mpp_buffer_test mpp_buffer_group_get failed\n");
+        return ret;
+    }
+
+    ret = mpp_buffer_get(group, &shared, MPP_BUFFER_TEST_SIZE);
+    if (ret) {
+        mpp_err("mpp_buffer_test get shared buffer failed\n");
+        mpp_buffer_group_put(group);
+        return ret;
+    }
+
+    for (i = 0; i < thread_count; i++) {
+        ret = mpp_buffer_group_get_internal(&ctx[i].group, MPP_BUFFER_TYPE_ION);
+        if (ret) {
+            mpp_err("mpp_buffer_test mpp_buffer_group_get failed\n");
+            goto DONE;
+        }
+
+        ctx[i].shared = shared;
+        ctx[i].loop = MPP_BUFFER_TEST_LOOP_COUNT;
+    }
+
+    time = mpp_time();
+
+    for (i = 0; i < thread_count; i++)
+        pthread_create(&thd[i], NULL, mpp_buffer_test_proc, &ctx[i]);
+
+    for (i = 0; i < thread_count; i++) {
+        pthread_join(thd[i], NULL);
+        if (ctx[i].ret)
+            ret = ctx[i].ret;
+    }
+
+    time = mpp_time() - time;
+
+    /* one get, two ref inc and three put on each frame */
+    ops = (RK_S64)thread_count * MPP_BUFFER_TEST_LOOP_COUNT *
+          MPP_BUFFER_TEST_FRAME_COUNT * 6;
+
+    mpp_log("mpp_buffer_test %d instance %lld buffer ops in %.2f ms, %.2f M ops/s\n",
+            thread_count, ops, time / 1000.0, (double)ops / MPP_MAX(time, 1));
+
+DONE:
+    for (i = 0; i < thread_count; i++) {
+        if (ctx[i].group)
+            mpp_buffer_group_put(ctx[i].group);
+    }
+
+    mpp_buffer_put(shared);
+    mpp_buffer_group_put(group);
+
+    return ret;
+}
+
 int main()
 {
     MPP_RET ret = MPP_OK;
@@ -252,9 +736,87 @@ int main()
         mpp_log("mpp_buffer_test mpp_buffer_put legacy buffer failed\n");
         goto MPP_BUFFER_failed;
     }
+    legacy_buffer = NULL;
 
+    mpp_log("mpp_buffer_test memfd start\n");
+
+    ret = mpp_buffer_memfd_test();
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test memfd failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    mpp_log("mpp_buffer_test memfd success\n");
+
+    mpp_log("mpp_buffer_test placement start\n");
+
+    for (i = MPP_BUFFER_PAGE_DEFAULT; i < MPP_BUFFER_PAGE_BUTT; i++) {
+        ret = mpp_buffer_placement_test(MPP_BUFFER_TYPE_NORMAL, (MppBufferPage)i);
+        if (!ret)
+            ret = mpp_buffer_placement_test(MPP_BUFFER_TYPE_MEMFD, (MppBufferPage)i);
+        if (ret)
+            goto MPP_BUFFER_failed;
+    }
+
+    mpp_log("mpp_buffer_test placement success\n");
+
+    /* reuse and contention test runs without buffer log */
     mpp_env_set_u32("mpp_buffer_debug", 0);
 
+    mpp_log("mpp_buffer_test reuse start\n");
+
+    for (i = 0; i < 2; i++) {
+        ret = mpp_buffer_reuse_test(i);
+        if (MPP_OK != ret) {
+            mpp_err("mpp_buffer_test reuse with keep undersized %d failed\n", i);
+            goto MPP_BUFFER_failed;
+        }
+    }
+
+    mpp_log("mpp_buffer_test reuse success\n");
+
+    mpp_log("mpp_buffer_test prealloc start\n");
+
+    ret = mpp_buffer_prealloc_test();
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test prealloc failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    mpp_log("mpp_buffer_test prealloc success\n");
+
+    mpp_log("mpp_buffer_test pool start\n");
+
+    ret = mpp_buffer_pool_test();
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test pool failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    mpp_log("mpp_buffer_test pool success\n");
+
+    mpp_log("mpp_buffer_test contention start\n");
+
+    for (i = 1; i <= MPP_BUFFER_TEST_THREAD_COUNT; i <<= 1) {
+        ret = mpp_buffer_contention_test(i);
+        if (MPP_OK != ret) {
+            mpp_err("mpp_buffer_test contention with %d instance failed\n", i);
+            goto MPP_BUFFER_failed;
+        }
+    }
+
+    mpp_log("mpp_buffer_test contention success\n");
+
+    mpp_log("mpp_buffer_test group count start\n");
+
+    ret = mpp_buffer_group_count_test();
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test group count failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    mpp_log("mpp_buffer_test group count success\n");
+
     return ret;
 
 MPP_BUFFER_failed:
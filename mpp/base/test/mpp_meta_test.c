@@ -0,0 +1,122 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_meta_test"
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_meta.h"
+
+#define META_TEST_LOOP      (1000 * 1000)
+
+static MPP_RET mpp_meta_check(void)
+{
+    MppMeta meta = NULL;
+    MppPacket packet = NULL;
+    void *ptr = NULL;
+    RK_S64 val_s64 = 0;
+    RK_S32 val = 0;
+
+    if (mpp_meta_get(&meta))
+        return MPP_NOK;
+
+    /* key with wrong type should be rejected */
+    if (MPP_OK == mpp_meta_set_s32(meta, KEY_ROI_DATA, 1) ||
+        MPP_OK == mpp_meta_set_s64(meta, KEY_TEMPORAL_ID, 1)) {
+        mpp_err("set on mismatch key type success\n");
+        goto FAILED;
+    }
+
+    mpp_meta_set_s32(meta, KEY_TEMPORAL_ID, 1);
+    mpp_meta_set_s32(meta, KEY_TEMPORAL_ID, 2);
+    mpp_meta_set_ptr(meta, KEY_ROI_DATA, &val);
+    mpp_meta_set_packet(meta, KEY_OUTPUT_PACKET, (MppPacket)&val_s64);
+
+    if (mpp_meta_size(meta) != 3) {
+        mpp_err("meta size %d mismatch\n", mpp_meta_size(meta));
+        goto FAILED;
+    }
+
+    if (mpp_meta_get_s32(meta, KEY_TEMPORAL_ID, &val) || val != 2 ||
+        mpp_meta_get_ptr(meta, KEY_ROI_DATA, &ptr) || ptr != &val ||
+        mpp_meta_get_packet(meta, KEY_OUTPUT_PACKET, &packet) ||
+        packet != (MppPacket)&val_s64) {
+        mpp_err("meta value mismatch\n");
+        goto FAILED;
+    }
+
+    /* get consumes the value */
+    if (MPP_OK == mpp_meta_get_s32(meta, KEY_TEMPORAL_ID, &val) ||
+        MPP_OK == mpp_meta_get_s64(meta, KEY_TEMPORAL_ID, &val_s64) ||
+        mpp_meta_size(meta)) {
+        mpp_err("meta value is not consumed by get\n");
+        goto FAILED;
+    }
+
+    mpp_meta_put(meta);
+    return MPP_OK;
+FAILED:
+    mpp_meta_put(meta);
+    return MPP_NOK;
+}
+
+/* encoder frame meta flow: get meta, set a few keys, read them back and put */
+static void mpp_meta_bench(void)
+{
+    RK_S64 time = mpp_time();
+    RK_S32 i;
+
+    for (i = 0; i < META_TEST_LOOP; i++) {
+        MppMeta meta = NULL;
+        MppPacket packet = NULL;
+        void *roi = NULL;
+        void *osd = NULL;
+        RK_S32 intra = 0;
+
+        mpp_meta_get(&meta);
+        mpp_meta_set_ptr(meta, KEY_ROI_DATA, &roi);
+        mpp_meta_set_ptr(meta, KEY_OSD_DATA, &osd);
+        mpp_meta_set_packet(meta, KEY_OUTPUT_PACKET, (MppPacket)&packet);
+        mpp_meta_set_s32(meta, KEY_OUTPUT_INTRA, 1);
+
+        mpp_meta_get_ptr(meta, KEY_ROI_DATA, &roi);
+        mpp_meta_get_ptr(meta, KEY_OSD_DATA, &osd);
+        mpp_meta_get_packet(meta, KEY_OUTPUT_PACKET, &packet);
+        mpp_meta_get_s32(meta, KEY_OUTPUT_INTRA, &intra);
+        mpp_meta_put(meta);
+    }
+
+    time = mpp_time() - time;
+
+    mpp_log("%d meta get / set / put in %.2f ms, %.2f ns per frame\n",
+            META_TEST_LOOP, time / 1000.0, (double)time * 1000 / META_TEST_LOOP);
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("mpp_meta_test start\n");
+
+    ret = mpp_meta_check();
+    if (!ret)
+        mpp_meta_bench();
+
+    mpp_log("mpp_meta_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -17,16 +17,32 @@
 #define MODULE_TAG "mpp_packet_test"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "mpp_log.h"
 #include "mpp_packet.h"
+#include "mpp_packet_impl.h"
 
 #define MPP_PACKET_TEST_SIZE    1024
 
+static void *release_data = NULL;
+static size_t release_size = 0;
+
+static void mpp_packet_test_release(void *ctx, void *data, size_t size)
+{
+    RK_S32 *count = (RK_S32 *)ctx;
+
+    release_data = data;
+    release_size = size;
+    (*count)++;
+}
+
 int main()
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
     MppPacket packet = NULL;
+    MppPacket copy = NULL;
+    RK_S32 release_count = 0;
     void *data = NULL;
     size_t size = MPP_PACKET_TEST_SIZE;
 
@@ -48,6 +64,36 @@ int main()
         mpp_err("mpp_packet_test mpp_packet_set_eos failed\n");
         goto MPP_PACKET_failed;
     }
+
+    /* copy init takes payload from pool and should copy valid data only */
+    memset(data, 0xa5, size);
+    mpp_packet_set_pos(packet, (RK_U8 *)data + 16);
+    ret = mpp_packet_copy_init(&copy, packet);
+    if (MPP_OK != ret || mpp_packet_get_length(copy) != size - 16 ||
+        memcmp(mpp_packet_get_pos(copy), (RK_U8 *)data + 16, size - 16) ||
+        ((RK_U8 *)mpp_packet_get_pos(copy))[size - 16]) {
+        mpp_err("mpp_packet_test mpp_packet_copy_init failed\n");
+        ret = MPP_NOK;
+        goto MPP_PACKET_failed;
+    }
+    mpp_packet_deinit(&copy);
+
+    /* reference init shares payload and releases it by callback on deinit */
+    ret = mpp_packet_ref_init(&copy, packet, mpp_packet_test_release, &release_count);
+    if (MPP_OK != ret || mpp_packet_get_pos(copy) != mpp_packet_get_pos(packet) ||
+        mpp_packet_get_length(copy) != size - 16) {
+        mpp_err("mpp_packet_test mpp_packet_ref_init failed\n");
+        ret = MPP_NOK;
+        goto MPP_PACKET_failed;
+    }
+    mpp_packet_deinit(&copy);
+    if (release_count != 1 || release_data != data || release_size != size) {
+        mpp_err("mpp_packet_test release count %d data %p size %d mismatch\n",
+                release_count, release_data, release_size);
+        ret = MPP_NOK;
+        goto MPP_PACKET_failed;
+    }
+
     mpp_packet_deinit(&packet);
 
     free(data);
@@ -55,6 +101,9 @@ int main()
     return ret;
 
 MPP_PACKET_failed:
+    if (copy)
+        mpp_packet_deinit(&copy);
+
     if (packet)
         mpp_packet_deinit(&packet);
 
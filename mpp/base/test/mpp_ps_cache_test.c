@@ -0,0 +1,98 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_ps_cache_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_common.h"
+
+#include "mpp_ps_cache.h"
+
+#define PS_TEST_SLOTS       4
+
+#define PS_TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            mpp_err("check %s failed at line %d\n", #cond, __LINE__); \
+            ret = MPP_NOK; \
+            goto DONE; \
+        } \
+    } while (0)
+
+int main()
+{
+    /* sps like payload: same size, one byte different */
+    static const RK_U8 ps0[] = { 0x64, 0x00, 0x28, 0xac, 0xd9, 0x40, 0x78, 0x02, 0x27, 0xe5, 0x80 };
+    static const RK_U8 ps1[] = { 0x64, 0x00, 0x28, 0xac, 0xd9, 0x40, 0x78, 0x02, 0x27, 0xe5, 0x84 };
+    static const RK_U8 ps2[] = { 0x68, 0xeb, 0xe3, 0xcb, 0x22, 0xc0 };
+    MppPsCache cache = NULL;
+    RK_U32 hit = 0;
+    RK_U32 miss = 0;
+    MPP_RET ret = MPP_OK;
+
+    mpp_log("mpp_ps_cache_test start\n");
+
+    ret = mpp_ps_cache_init(&cache, PS_TEST_SLOTS);
+    PS_TEST_CHECK(!ret && cache);
+
+    /* empty cache never hit */
+    PS_TEST_CHECK(mpp_ps_cache_lookup(cache, ps0, sizeof(ps0)) < 0);
+
+    PS_TEST_CHECK(!mpp_ps_cache_update(cache, 0, ps0, sizeof(ps0)));
+    PS_TEST_CHECK(!mpp_ps_cache_update(cache, 2, ps2, sizeof(ps2)));
+
+    /* identical resend */
+    PS_TEST_CHECK(mpp_ps_cache_lookup(cache, ps0, sizeof(ps0)) == 0);
+    PS_TEST_CHECK(mpp_ps_cache_lookup(cache, ps2, sizeof(ps2)) == 2);
+
+    /* different content, shorter content and prefix */
+    PS_TEST_CHECK(mpp_ps_cache_lookup(cache, ps1, sizeof(ps1)) < 0);
+    PS_TEST_CHECK(mpp_ps_cache_lookup(cache, ps0, sizeof(ps0) - 1) < 0);
+
+    /* id 0 replaced by new content */
+    PS_TEST_CHECK(!mpp_ps_cache_update(cache, 0, ps1, sizeof(ps1)));
+    PS_TEST_CHECK(mpp_ps_cache_lookup(cache, ps0, sizeof(ps0)) < 0);
+    PS_TEST_CHECK(mpp_ps_cache_lookup(cache, ps1, sizeof(ps1)) == 0);
+
+    /* same content moved to another id */
+    PS_TEST_CHECK(!mpp_ps_cache_update(cache, 0, NULL, 0));
+    PS_TEST_CHECK(!mpp_ps_cache_update(cache, 3, ps1, sizeof(ps1)));
+    PS_TEST_CHECK(mpp_ps_cache_lookup(cache, ps1, sizeof(ps1)) == 3);
+
+    /* removal */
+    mpp_ps_cache_remove(cache, 3);
+    PS_TEST_CHECK(mpp_ps_cache_lookup(cache, ps1, sizeof(ps1)) < 0);
+    PS_TEST_CHECK(mpp_ps_cache_lookup(cache, ps2, sizeof(ps2)) == 2);
+    mpp_ps_cache_remove(cache, -1);
+    PS_TEST_CHECK(mpp_ps_cache_lookup(cache, ps2, sizeof(ps2)) < 0);
+
+    /* invalid id */
+    PS_TEST_CHECK(mpp_ps_cache_update(cache, PS_TEST_SLOTS, ps0, sizeof(ps0)));
+
+    mpp_ps_cache_stats(cache, &hit, &miss);
+    mpp_log("hit %u miss %u\n", hit, miss);
+    PS_TEST_CHECK(hit == 5 && miss == 6);
+
+DONE:
+    if (cache)
+        mpp_ps_cache_deinit(cache);
+
+    mpp_log("mpp_ps_cache_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
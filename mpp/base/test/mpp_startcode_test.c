@@ -0,0 +1,175 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_startcode_test"
+
+#include <stdlib.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "mpp_startcode.h"
+
+#define STREAM_SIZE         (16 * 1024 * 1024)
+#define NALU_SIZE_MAX       (64 * 1024)
+#define STARTCODE_MAX       (STREAM_SIZE / 4)
+#define LOOP_COUNT          8
+
+/*
+ * Generate an Annex-B like stream: random payload with emulation prevention
+ * applied and 3 / 4 byte start codes between nalus of random size.
+ */
+static RK_S32 gen_stream(RK_U8 *buf, RK_S32 size)
+{
+    RK_S32 pos = 0;
+    RK_S32 zeros = 0;
+    RK_S32 count = 0;
+
+    srand(0x5a5a);
+
+    while (pos + 4 < size) {
+        RK_S32 nalu_len = rand() % NALU_SIZE_MAX + 1;
+        RK_S32 i;
+
+        if (rand() & 1)
+            buf[pos++] = 0;
+        buf[pos++] = 0;
+        buf[pos++] = 0;
+        buf[pos++] = 1;
+        count++;
+        zeros = 0;
+
+        for (i = 0; i < nalu_len && pos + 1 < size; i++) {
+            /* entropy coded data is close to uniform random bytes */
+            RK_U8 val = (RK_U8)(rand() >> 4);
+
+            if (zeros >= 2 && val <= 3) {
+                buf[pos++] = 3;
+                zeros = 0;
+            }
+            buf[pos++] = val;
+            zeros = val ? 0 : zeros + 1;
+        }
+        /* nalu never ends with zero byte */
+        if (!buf[pos - 1])
+            buf[pos++] = 0x80;
+    }
+
+    while (pos < size)
+        buf[pos++] = 0xff;
+
+    return count;
+}
+
+/* the per-byte search done by the parsers before */
+static RK_S32 find_startcodes_ref(const RK_U8 *buf, RK_S32 size, RK_S32 *pos, RK_S32 max)
+{
+    RK_U32 prefix = 0xffffffff;
+    RK_S32 count = 0;
+    RK_S32 i;
+
+    for (i = 0; i < size && count < max; i++) {
+        prefix = (prefix << 8) | buf[i];
+        if ((prefix & 0x00ffffff) == 0x000001)
+            pos[count++] = i - 2;
+    }
+
+    return count;
+}
+
+int main()
+{
+    RK_U8 *buf = mpp_malloc(RK_U8, STREAM_SIZE);
+    RK_S32 *pos_ref = mpp_malloc(RK_S32, STARTCODE_MAX);
+    RK_S32 *pos = mpp_malloc(RK_S32, STARTCODE_MAX);
+    RK_S32 cnt_gen, cnt_ref = 0, cnt = 0;
+    RK_S64 time_ref = 0, time_new = 0;
+    RK_S32 ret = 0;
+    RK_S32 i;
+
+    if (NULL == buf || NULL == pos_ref || NULL == pos) {
+        mpp_err("malloc failed\n");
+        ret = -1;
+        goto DONE;
+    }
+
+    mpp_log("mpp_startcode_test start with %s backend\n", mpp_startcode_impl_name());
+
+    cnt_gen = gen_stream(buf, STREAM_SIZE);
+
+    for (i = 0; i < LOOP_COUNT; i++) {
+        RK_S64 start = mpp_time();
+
+        cnt_ref = find_startcodes_ref(buf, STREAM_SIZE, pos_ref, STARTCODE_MAX);
+        time_ref += mpp_time() - start;
+
+        start = mpp_time();
+        cnt = mpp_find_startcodes(buf, STREAM_SIZE, pos, STARTCODE_MAX);
+        time_new += mpp_time() - start;
+    }
+
+    if (cnt != cnt_ref || cnt != cnt_gen) {
+        mpp_err("start code count mismatch gen %d ref %d found %d\n",
+                cnt_gen, cnt_ref, cnt);
+        ret = -1;
+        goto DONE;
+    }
+
+    for (i = 0; i < cnt; i++) {
+        if (pos[i] != pos_ref[i]) {
+            mpp_err("start code %d mismatch ref %d found %d\n", i, pos_ref[i], pos[i]);
+            ret = -1;
+            goto DONE;
+        }
+    }
+
+    /* short buffers and buffer tails */
+    for (i = 0; i < 64; i++) {
+        RK_S32 len = i + 3;
+        RK_S32 off = STREAM_SIZE - len - 1;
+        RK_S32 n_ref, n;
+
+        buf[off + i] = 0;
+        buf[off + i + 1] = 0;
+        buf[off + i + 2] = 1;
+        n_ref = find_startcodes_ref(buf + off, len, pos_ref, STARTCODE_MAX);
+        n = mpp_find_startcodes(buf + off, len, pos, STARTCODE_MAX);
+        if (n != n_ref || (n && pos[n - 1] != pos_ref[n_ref - 1])) {
+            mpp_err("short buffer %d mismatch ref %d found %d\n", len, n_ref, n);
+            ret = -1;
+            goto DONE;
+        }
+    }
+
+    mpp_log("found %d start codes in %d MB x %d loops\n",
+            cnt, STREAM_SIZE >> 20, LOOP_COUNT);
+    mpp_log("per-byte search %8.2f MB/s\n",
+            (double)STREAM_SIZE * LOOP_COUNT / MPP_MAX(time_ref, 1));
+    mpp_log("%-8s search %8.2f MB/s\n", mpp_startcode_impl_name(),
+            (double)STREAM_SIZE * LOOP_COUNT / MPP_MAX(time_new, 1));
+    mpp_log("speedup %.2fx\n", (double)time_ref / MPP_MAX(time_new, 1));
+
+DONE:
+    MPP_FREE(buf);
+    MPP_FREE(pos_ref);
+    MPP_FREE(pos);
+
+    mpp_log("mpp_startcode_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -23,6 +23,7 @@
 #include "mpp_mem.h"
 #include "mpp_log.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 #include "hal_task.h"
 
 #include "avsd_api.h"
@@ -690,6 +691,8 @@ MPP_RET avsd_parse_prepare(AvsdCtx_t *p_dec, MppPacket *pkt, HalDecTask *task)
     MPP_RET ret = MPP_ERR_UNKNOW;
     RK_U8  *p_curdata = NULL;
     RK_U8  *p_start = NULL;  //!< store nalu start
+    RK_U8  *p_scan = NULL;   //!< start code search position
+    RK_U8  *p_end = NULL;
     RK_U32 nalu_len = 0;
     RK_U8  got_frame_flag = 0;
     RK_U8  got_nalu_flag = 0;
@@ -706,9 +709,24 @@ MPP_RET avsd_parse_prepare(AvsdCtx_t *p_dec, MppPacket *pkt, HalDecTask *task)
     }
 
     pkt_length = (RK_U32)mpp_packet_get_length(pkt);
-    p_curdata = p_start = (RK_U8 *)mpp_packet_get_pos(pkt);
+    p_curdata = p_start = p_scan = (RK_U8 *)mpp_packet_get_pos(pkt);
+    p_end = p_curdata + pkt_length;
 
     while (pkt_length > 0) {
+        //!< jump to the byte after next start code and its header byte
+        RK_S32 found = mpp_find_startcode(p_scan, (RK_S32)(p_end - p_scan));
+
+        if (found < 0 || p_scan + found + 4 >= p_end) {
+            p_curdata = p_end;
+            pkt_length = 0;
+            break;
+        }
+        p_curdata = p_scan + found + 4;
+        pkt_length = (RK_U32)(p_end - p_curdata);
+        prefix = 0x00000100 | p_curdata[-1];
+        //!< next start code may overlap with the header byte
+        p_scan = p_curdata - 1;
+
         //!<  found next nalu start code
         if ((prefix & 0xFFFFFF00) == 0x00000100) {
             if (got_nalu_flag)  {
@@ -729,10 +747,6 @@ MPP_RET avsd_parse_prepare(AvsdCtx_t *p_dec, MppPacket *pkt, HalDecTask *task)
             }
             got_frame_flag = 1;
         }
-
-        prefix = (prefix << 8) | (*p_curdata);
-        p_curdata++;
-        pkt_length--;
     }
     //!< reach the packet end
     if (!pkt_length) {
@@ -86,6 +86,10 @@ MPP_RET dummy_dec_init(void *dec, ParserCfg *cfg)
     for (i = 0; i < DUMMY_DEC_REF_COUNT; i++) {
         p->slot_index[i] = -1;
     }
+
+    /* slot is required before the first parse */
+    mpp_buf_slot_setup(p->frame_slots, DUMMY_DEC_FRAME_COUNT);
+    p->slots_inited = 1;
     return MPP_OK;
 }
 
@@ -206,10 +210,7 @@ MPP_RET dummy_dec_parse(void *dec, HalDecTask *task)
 
     mpp_frame_init(&frame);
 
-    if (!p->slots_inited) {
-        mpp_buf_slot_setup(slots, DUMMY_DEC_FRAME_COUNT);
-        p->slots_inited = 1;
-    } else if (frame_count >= 2) {
+    if (frame_count >= 2) {
         // do info change test
         width = DUMMY_DEC_FRAME_NEW_WIDTH;
         height = DUMMY_DEC_FRAME_NEW_HEIGHT;
@@ -53,6 +53,7 @@ static MPP_RET init_input_ctx(H264dInputCtx_t *p_Inp, ParserCfg *init)
 
     p_Inp->init = *init;
     mpp_env_get_u32("rkv_h264d_mvc_disable", &p_Inp->mvc_disable, 1);
+    mpp_env_get_u32("rkv_h264d_zero_copy", &p_Inp->zero_copy, 1);
     open_stream_file(p_Inp, "/sdcard");
     if (rkv_h264d_parse_debug & H264D_DBG_WRITE_ES_EN) {
         p_Inp->spspps_size = HEAD_BUF_MAX_SIZE;
@@ -128,6 +129,14 @@ static MPP_RET free_vid_ctx(H264dVideoCtx_t *p_Vid)
     for (i = 0; i < MAXSPS; i++) {
         recycle_subsps(&p_Vid->subspsSet[i]);
     }
+    if (p_Vid->sps_cache) {
+        mpp_ps_cache_deinit(p_Vid->sps_cache);
+        p_Vid->sps_cache = NULL;
+    }
+    if (p_Vid->pps_cache) {
+        mpp_ps_cache_deinit(p_Vid->pps_cache);
+        p_Vid->pps_cache = NULL;
+    }
     for (i = 0; i < MAX_NUM_DPB_LAYERS; i++) {
         free_dpb(p_Vid->p_Dpb_layer[i]);
         MPP_FREE(p_Vid->p_Dpb_layer[i]);
@@ -173,6 +182,8 @@ static MPP_RET init_vid_ctx(H264dVideoCtx_t *p_Vid)
         p_Vid->subspsSet[i].num_views_minus1 = -1;
         p_Vid->subspsSet[i].num_level_values_signalled_minus1 = -1;
     }
+    FUN_CHECK(ret = mpp_ps_cache_init(&p_Vid->sps_cache, MAXSPS));
+    FUN_CHECK(ret = mpp_ps_cache_init(&p_Vid->pps_cache, MAXPPS));
 __RETURN:
     return ret = MPP_OK;
 __FAILED:
@@ -405,6 +416,7 @@ MPP_RET h264d_reset(void *decoder)
     p_Dec->p_Vid->last_pic = NULL;
     memset(&p_Dec->p_Vid->old_pic, 0, sizeof(H264_StorePic_t));
     memset(&p_Dec->errctx, 0, sizeof(H264dErrCtx_t));
+    p_Dec->skip_idr_field = 0;
     //!< reset current time stamp
     p_Dec->p_Cur->last_dts  = 0;
     p_Dec->p_Cur->last_pts  = 0;
@@ -419,6 +431,7 @@ MPP_RET h264d_reset(void *decoder)
     p_strm->startcode_found = 0;
     p_strm->endcode_found   = 0;
     p_strm->startcode_found = p_Dec->p_Inp->is_nalff;
+    p_strm->nalu_is_span    = 0;
     //!< reset decoder parameter
     p_Dec->next_state = SliceSTATE_ResetSlice;
     p_Dec->nalu_ret = NALU_NULL;
@@ -480,6 +493,16 @@ MPP_RET  h264d_control(void *decoder, MpiCmd cmd_type, void *param)
     case MPP_DEC_SET_IMMEDIATE_OUT: {
         dec->immediate_out = *((RK_U32 *)param);
     } break;
+    case MPP_DEC_SET_SKIP_MODE: {
+        dec->skip_mode = *((RK_U32 *)param);
+        dec->skip_idr_field = 0;
+    } break;
+    case MPP_GET_STATS: {
+        MppStats *stats = (MppStats *)param;
+
+        mpp_ps_cache_stats(dec->p_Vid->sps_cache, &stats->ps_cache_hit, &stats->ps_cache_miss);
+        mpp_ps_cache_stats(dec->p_Vid->pps_cache, &stats->ps_cache_hit, &stats->ps_cache_miss);
+    } break;
     default : {
     } break;
     }
@@ -612,6 +635,8 @@ MPP_RET h264d_parse(void *decoder, HalDecTask *in_task)
         if (in_task->flags.eos) {
             h264d_flush_dpb_eos(p_Dec);
         }
+    } else if (p_Dec->skip_picture && in_task->flags.eos) {
+        h264d_flush_dpb_eos(p_Dec);
     }
     in_task->valid = 1;
     if (!in_task->flags.parse_err) {
@@ -23,6 +23,7 @@
 
 #include "mpp_log.h"
 #include "mpp_bitread.h"
+#include "mpp_ps_cache.h"
 
 #include "h264d_syntax.h"
 #include "h264d_api.h"
@@ -893,6 +894,7 @@ typedef struct h264d_input_ctx_t {
     RK_S64 in_dts;
     RK_U8  has_get_eos;
     RK_U32 mvc_disable;
+    RK_U32 zero_copy;
     //!< output data
     RK_U8  task_valid;
     RK_U32 task_eos;
@@ -934,6 +936,10 @@ typedef struct h264d_curstrm_t {
     RK_U8     startcode_found;
     RK_U8     endcode_found;
 
+    //!< zero copy mode, nalu data is kept as a span of the input packet
+    RK_U8     nalu_is_span;
+    RK_U32    span_offset;     //!< nalu start offset in the input packet
+
 } H264dCurStream_t;
 
 #define MAX_REORDER_TIMES   17
@@ -974,6 +980,8 @@ typedef struct h264d_video_ctx_t {
     struct h264_sps_t            spsSet[MAXSPS];      //!< MAXSPS, all sps storage
     struct h264_subsps_t         subspsSet[MAXSPS];   //!< MAXSPS, all subpps storage
     struct h264_pps_t            ppsSet[MAXPPS];      //!< MAXPPS, all pps storage
+    MppPsCache                   sps_cache;           //!< raw bytes of spsSet for resend detection
+    MppPsCache                   pps_cache;           //!< raw bytes of ppsSet for resend detection
     struct h264_sps_t            *active_sps;
     struct h264_subsps_t         *active_subsps;
     struct h264_pps_t            *active_pps;
@@ -1134,6 +1142,10 @@ typedef struct h264_dec_ctx_t {
     RK_S32                     last_frame_slot_idx;
     RK_U32                     disable_error;
     RK_U32                     immediate_out;
+    //!< MppDecSkipMode, skip_picture is set when current picture is dropped
+    RK_U32                     skip_mode;
+    RK_U32                     skip_picture;
+    RK_S32                     skip_idr_field; //!< structure of last idr field
     struct h264_err_ctx_t      errctx;
 } H264_DecCtx_t;
 
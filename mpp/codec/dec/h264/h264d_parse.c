@@ -22,6 +22,7 @@
 
 #include "mpp_mem.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 #include "hal_task.h"
 
 #include "h264d_global.h"
@@ -130,9 +131,67 @@ static void reset_nalu(H264dCurStream_t *p_strm)
         p_strm->nalu_len = 0;
         p_strm->nalu_type = H264_NALU_TYPE_NULL;
         p_strm->endcode_found = 0;
+        p_strm->nalu_is_span = 0;
     }
 }
 
+static RK_U8 *get_nalu_data(H264dInputCtx_t *p_Inp, H264dCurStream_t *p_strm)
+{
+    return p_strm->nalu_is_span ? &p_Inp->in_buf[p_strm->span_offset] : p_strm->nalu_buf;
+}
+
+/*!
+***********************************************************************
+* \brief
+*    append current byte to nalu
+*    on zero copy mode only nalu header bytes are stored in nalu_buf
+***********************************************************************
+*/
+static MPP_RET append_nalu_byte(H264dInputCtx_t *p_Inp, H264dCurStream_t *p_strm)
+{
+    MPP_RET ret = MPP_ERR_UNKNOW;
+
+    if (!p_strm->nalu_len) {
+        p_strm->nalu_is_span = p_Inp->zero_copy ? 1 : 0;
+        p_strm->span_offset = (RK_U32)(p_strm->curdata - p_Inp->in_buf);
+    }
+    if (!p_strm->nalu_is_span || p_strm->nalu_len < NALU_TYPE_EXT_LENGTH) {
+        if (p_strm->nalu_len >= p_strm->nalu_max_size) {
+            FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, NALU_BUF_ADD_SIZE));
+        }
+        p_strm->nalu_buf[p_strm->nalu_len] = *p_strm->curdata;
+    }
+    p_strm->nalu_len++;
+
+    return ret = MPP_OK;
+__FAILED:
+    return ret;
+}
+
+/*!
+***********************************************************************
+* \brief
+*    copy nalu span to nalu_buf before the input packet is released
+***********************************************************************
+*/
+static MPP_RET flush_nalu_span(H264dInputCtx_t *p_Inp, H264dCurStream_t *p_strm)
+{
+    MPP_RET ret = MPP_ERR_UNKNOW;
+
+    if (p_strm->nalu_is_span) {
+        if (p_strm->nalu_len >= p_strm->nalu_max_size) {
+            RK_U32 add_size = p_strm->nalu_len + 1 - p_strm->nalu_max_size;
+            FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, MPP_MAX(NALU_BUF_ADD_SIZE, add_size)));
+        }
+        memcpy(p_strm->nalu_buf, &p_Inp->in_buf[p_strm->span_offset], p_strm->nalu_len);
+        p_strm->nalu_is_span = 0;
+    }
+
+    return ret = MPP_OK;
+__FAILED:
+    return ret;
+}
+
 static void find_prefix_code(RK_U8 *p_data, H264dCurStream_t *p_strm)
 {
     (void)p_data;
@@ -146,6 +205,43 @@ static void find_prefix_code(RK_U8 *p_data, H264dCurStream_t *p_strm)
     }
 }
 
+/*!
+***********************************************************************
+* \brief
+*    scan packet data up to next start code in bulk
+*    nalu payload is copied to nalu_buf only when not on zero copy mode
+***********************************************************************
+*/
+static MPP_RET scan_nalu_data(H264dInputCtx_t *p_Inp, H264dCurStream_t *p_strm,
+                              MppPacketImpl *pkt_impl)
+{
+    MPP_RET ret = MPP_ERR_UNKNOW;
+    RK_U8 *p_src = &p_Inp->in_buf[p_strm->nalu_offset];
+    RK_S32 found = mpp_find_startcode(p_src, (RK_S32)pkt_impl->length);
+    RK_U32 len = (found < 0) ? (RK_U32)pkt_impl->length : (RK_U32)(found + START_PREFIX_3BYTE);
+
+    if (p_strm->startcode_found && !p_strm->nalu_is_span) {
+        if ((p_strm->nalu_len + len) >= p_strm->nalu_max_size) {
+            RK_U32 add_size = p_strm->nalu_len + len + 1 - p_strm->nalu_max_size;
+            FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, MPP_MAX(NALU_BUF_ADD_SIZE, add_size)));
+        }
+        memcpy(&p_strm->nalu_buf[p_strm->nalu_len], p_src, len);
+    }
+    if (p_strm->startcode_found)
+        p_strm->nalu_len += len;
+    p_strm->nalu_offset += len;
+    pkt_impl->length -= len;
+    p_strm->curdata = &p_src[len - 1];
+    p_strm->prefixdata = (RK_U32)mpp_startcode_state(p_strm->prefixdata, p_src, len);
+
+    if (found >= 0)
+        find_prefix_code(p_strm->curdata, p_strm);
+
+    return ret = MPP_OK;
+__FAILED:
+    return ret;
+}
+
 static MPP_RET parser_nalu_header(H264_SLICE_t *currSlice)
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
@@ -220,6 +316,36 @@ __BITREAD_ERR:
     return ret = p_bitctx->ret;
 }
 
+static RK_U32 skip_slice(H264_SLICE_t *currSlice)
+{
+    H264_DecCtx_t *p_Dec = currSlice->p_Dec;
+
+    switch (p_Dec->skip_mode) {
+    case MPP_DEC_SKIP_NON_REF : {
+        //!< non-reference picture never changes dpb and frame_num gap
+        return currSlice->nal_reference_idc ? 0 : 1;
+    } break;
+    case MPP_DEC_SKIP_NON_KEY : {
+        if (currSlice->idr_flag) {
+            p_Dec->skip_idr_field = currSlice->field_pic_flag ? currSlice->structure : 0;
+            return 0;
+        }
+        //!< second field of idr picture is a non-idr reference field
+        if (p_Dec->skip_idr_field && currSlice->field_pic_flag
+            && currSlice->structure != p_Dec->skip_idr_field
+            && currSlice->nal_reference_idc && !currSlice->frame_num)
+            return 0;
+
+        p_Dec->skip_idr_field = 0;
+        return 1;
+    } break;
+    default : {
+    } break;
+    }
+
+    return 0;
+}
+
 static MPP_RET parser_one_nalu(H264_SLICE_t *currSlice)
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
@@ -232,6 +358,13 @@ static MPP_RET parser_one_nalu(H264_SLICE_t *currSlice)
         H264D_DBG(H264D_DBG_PARSE_NALU, "nalu_type=SLICE.");
         FUN_CHECK(ret = process_slice(currSlice));
         currSlice->p_Dec->nalu_ret = StartOfPicture;
+        if (skip_slice(currSlice)) {
+            H264D_DBG(H264D_DBG_PARSE_NALU, "skip slice nal_ref_idc=%d, idr=%d",
+                      currSlice->nal_reference_idc, currSlice->idr_flag);
+            currSlice->p_Dec->skip_picture = 1;
+            currSlice->p_Dec->nalu_ret = SkipNALU;
+            break;
+        }
         if (currSlice->layer_id && currSlice->p_Inp->mvc_disable)
             currSlice->p_Dec->nalu_ret = MvcDisAble;
         break;
@@ -326,6 +459,7 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
     RK_U8 *p_des = NULL;
+    RK_U8 *p_src = get_nalu_data(p_Cur->p_Inp, p_strm);
 
     //!< fill head buffer
     if (   (p_strm->nalu_type == H264_NALU_TYPE_SLICE)
@@ -347,7 +481,7 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
         ((H264dNaluHead_t *)p_des)->is_frame_end  = 0;
         ((H264dNaluHead_t *)p_des)->nalu_type = p_strm->nalu_type;
         ((H264dNaluHead_t *)p_des)->sodb_len = head_size;
-        memcpy(p_des + sizeof(H264dNaluHead_t), p_strm->nalu_buf, head_size);
+        memcpy(p_des + sizeof(H264dNaluHead_t), p_src, head_size);
         p_strm->head_offset += add_size;
     }    //!< fill sodb buffer
     if ((p_strm->nalu_type == H264_NALU_TYPE_SLICE)
@@ -361,7 +495,7 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
 
         p_des = &dxva_ctx->bitstream[dxva_ctx->strm_offset];
         memcpy(p_des, g_start_precode, sizeof(g_start_precode));
-        memcpy(p_des + sizeof(g_start_precode), p_strm->nalu_buf, p_strm->nalu_len);
+        memcpy(p_des + sizeof(g_start_precode), p_src, p_strm->nalu_len);
         dxva_ctx->strm_offset += add_size;
     }
     if (rkv_h264d_parse_debug & H264D_DBG_WRITE_ES_EN) {
@@ -371,7 +505,7 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
             if (p_Inp->spspps_update_flag) {
                 p_des = &p_Inp->spspps_buf[p_Inp->spspps_offset];
                 memcpy(p_des, g_start_precode, sizeof(g_start_precode));
-                memcpy(p_des + sizeof(g_start_precode), p_strm->nalu_buf, p_strm->nalu_len);
+                memcpy(p_des + sizeof(g_start_precode), p_src, p_strm->nalu_len);
                 p_Inp->spspps_offset += p_strm->nalu_len + sizeof(g_start_precode);
                 p_Inp->spspps_len = p_Inp->spspps_offset;
             }
@@ -552,33 +686,42 @@ MPP_RET parse_prepare(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
         goto __RETURN;
     }
     while (pkt_impl->length > 0) {
-        p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
-        pkt_impl->length--;
-        p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
-        if (p_strm->startcode_found) {
-            if (p_strm->nalu_len >= p_strm->nalu_max_size) {
-                FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, NALU_BUF_ADD_SIZE));
-            }
-            p_strm->nalu_buf[p_strm->nalu_len++] = *p_strm->curdata;
-            if ((p_strm->nalu_len == NALU_TYPE_NORMAL_LENGTH)
-                || (p_strm->nalu_len == NALU_TYPE_EXT_LENGTH)) {
-                FUN_CHECK(ret = judge_is_new_frame(p_Cur, p_strm));
-                if (p_Cur->p_Dec->is_new_frame) {
-                    FUN_CHECK(ret = add_empty_nalu(&p_Cur->strm));
-                    p_Cur->strm.head_offset = 0;
-                    p_Cur->p_Inp->task_valid = 1;
-                    p_Cur->p_Dec->is_new_frame = 0;
-                    break;
+        /*
+         * When the last byte is not zero no start code can cross the packet
+         * boundary so the data can be scanned in bulk. The nalu header bytes
+         * are still handled one by one for new frame detection.
+         */
+        if ((p_strm->prefixdata & 0xFF) &&
+            (!p_strm->startcode_found || p_strm->nalu_len >= NALU_TYPE_EXT_LENGTH)) {
+            FUN_CHECK(ret = scan_nalu_data(p_Inp, p_strm, pkt_impl));
+        } else {
+            p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
+            pkt_impl->length--;
+            p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
+            if (p_strm->startcode_found) {
+                FUN_CHECK(ret = append_nalu_byte(p_Inp, p_strm));
+                if ((p_strm->nalu_len == NALU_TYPE_NORMAL_LENGTH)
+                    || (p_strm->nalu_len == NALU_TYPE_EXT_LENGTH)) {
+                    FUN_CHECK(ret = judge_is_new_frame(p_Cur, p_strm));
+                    if (p_Cur->p_Dec->is_new_frame) {
+                        FUN_CHECK(ret = add_empty_nalu(&p_Cur->strm));
+                        p_Cur->strm.head_offset = 0;
+                        p_Cur->p_Inp->task_valid = 1;
+                        p_Cur->p_Dec->is_new_frame = 0;
+                        break;
+                    }
                 }
             }
-        }
 
-        find_prefix_code(p_strm->curdata, p_strm);
+            find_prefix_code(p_strm->curdata, p_strm);
+        }
 
         if (p_strm->endcode_found) {
+            RK_U8 *p_nalu = get_nalu_data(p_Inp, p_strm);
+
             p_strm->nalu_len -= START_PREFIX_3BYTE;
             if (p_strm->nalu_len > START_PREFIX_3BYTE) {
-                while (p_strm->nalu_buf[p_strm->nalu_len - 1] == 0x00) {
+                while (p_nalu[p_strm->nalu_len - 1] == 0x00) {
                     p_strm->nalu_len--;
                 }
             }
@@ -591,6 +734,8 @@ MPP_RET parse_prepare(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
     p_Inp->in_length = pkt_impl->length;
     //!< check input
     if (!p_Inp->in_length) {
+        //!< nalu continues in next packet
+        FUN_CHECK(ret = flush_nalu_span(p_Inp, p_strm));
         p_strm->nalu_offset = 0;
         p_Dec->nalu_ret = HaveNoStream;
     }
@@ -620,37 +765,43 @@ MPP_RET parse_prepare_fast(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
     p_Inp->task_valid = 0;
 
     while (pkt_impl->length > 0) {
-        p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
-        pkt_impl->length--;
-        p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
-        if (p_strm->startcode_found) {
-            if (p_strm->nalu_len >= p_strm->nalu_max_size) {
-                FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, NALU_BUF_ADD_SIZE));
-            }
-            p_strm->nalu_buf[p_strm->nalu_len++] = *p_strm->curdata;
-            if (p_strm->nalu_len == 1) {
-                p_strm->nalu_type = p_strm->nalu_buf[0] & 0x1F;
-
-                if (p_strm->nalu_type == H264_NALU_TYPE_SLICE
-                    || p_strm->nalu_type == H264_NALU_TYPE_IDR || p_strm->nalu_type == H264_NALU_TYPE_SLC_EXT) {
-                    p_strm->nalu_len += (RK_U32)pkt_impl->length;
-                    if (p_strm->nalu_len >= p_strm->nalu_max_size) {
-                        RK_U32 add_size =  pkt_impl->length + 1 - p_strm->nalu_max_size;
-                        FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, MPP_MAX(NALU_BUF_ADD_SIZE, add_size)));
+        if ((p_strm->prefixdata & 0xFF) &&
+            (!p_strm->startcode_found || p_strm->nalu_len >= NALU_TYPE_NORMAL_LENGTH)) {
+            FUN_CHECK(ret = scan_nalu_data(p_Inp, p_strm, pkt_impl));
+        } else {
+            p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
+            pkt_impl->length--;
+            p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
+            if (p_strm->startcode_found) {
+                FUN_CHECK(ret = append_nalu_byte(p_Inp, p_strm));
+                if (p_strm->nalu_len == 1) {
+                    p_strm->nalu_type = p_strm->nalu_buf[0] & 0x1F;
+
+                    if (p_strm->nalu_type == H264_NALU_TYPE_SLICE
+                        || p_strm->nalu_type == H264_NALU_TYPE_IDR || p_strm->nalu_type == H264_NALU_TYPE_SLC_EXT) {
+                        p_strm->nalu_len += (RK_U32)pkt_impl->length;
+                        if (!p_strm->nalu_is_span) {
+                            if (p_strm->nalu_len >= p_strm->nalu_max_size) {
+                                RK_U32 add_size =  pkt_impl->length + 1 - p_strm->nalu_max_size;
+                                FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, MPP_MAX(NALU_BUF_ADD_SIZE, add_size)));
+                            }
+                            memcpy(&p_strm->nalu_buf[0], p_strm->curdata, pkt_impl->length + 1);
+                        }
+                        pkt_impl->length = 0;
+                        p_Cur->p_Inp->task_valid = 1;
+                        break;
                     }
-                    memcpy(&p_strm->nalu_buf[0], p_strm->curdata, pkt_impl->length + 1);
-                    pkt_impl->length = 0;
-                    p_Cur->p_Inp->task_valid = 1;
-                    break;
                 }
             }
-        }
 
-        find_prefix_code(p_strm->curdata, p_strm);
+            find_prefix_code(p_strm->curdata, p_strm);
+        }
 
         if (p_strm->endcode_found) {
+            RK_U8 *p_nalu = get_nalu_data(p_Inp, p_strm);
+
             p_strm->nalu_len -= START_PREFIX_3BYTE;
-            while (p_strm->nalu_len > 0 && p_strm->nalu_buf[p_strm->nalu_len - 1] == 0x00) {
+            while (p_strm->nalu_len > 0 && p_nalu[p_strm->nalu_len - 1] == 0x00) {
                 p_strm->nalu_len--;
             }
             p_Dec->nalu_ret = EndOfNalu;
@@ -871,6 +1022,7 @@ MPP_RET parse_loop(H264_DecCtx_t *p_Dec)
     INP_CHECK(ret, !p_Dec);
     //!< ==== loop ====
     p_Dec->next_state = SliceSTATE_ResetSlice;
+    p_Dec->skip_picture = 0;
     p_curdata = p_Dec->p_Cur->strm.head_buf;
 
     while (while_loop_flag) {
@@ -930,6 +1082,11 @@ MPP_RET parse_loop(H264_DecCtx_t *p_Dec)
             break;
         case SliceSTATE_RegisterOneFrame:
             if (!p_Dec->is_parser_end) {
+                //!< all slices are dropped by skip mode
+                if (p_Dec->skip_picture) {
+                    while_loop_flag = 0;
+                    break;
+                }
                 ret = MPP_NOK;
                 goto __FAILED;
             }
@@ -132,15 +132,27 @@ MPP_RET process_pps(H264_SLICE_t *currSlice)
     MPP_RET ret = MPP_ERR_UNKNOW;
 
     H264dCurCtx_t *p_Cur = currSlice->p_Cur;
+    H264dVideoCtx_t *p_Vid = currSlice->p_Vid;
     BitReadCtx_t *p_bitctx = &p_Cur->bitctx;
     H264_PPS_t *cur_pps = &p_Cur->pps;
+    RK_U8 *raw = p_Cur->nalu.sodb_buf + p_Cur->nalu.ualu_header_bytes;
+    RK_S32 raw_len = p_Cur->nalu.sodb_len - p_Cur->nalu.ualu_header_bytes;
+    RK_S32 pps_id = 0;
+
+    //!< resend of a pps in ppsSet parsed with current sps, skip parse
+    pps_id = mpp_ps_cache_lookup(p_Vid->pps_cache, raw, raw_len);
+    if (pps_id >= 0) {
+        memcpy(cur_pps, &p_Vid->ppsSet[pps_id], sizeof(H264_PPS_t));
+        return ret = MPP_OK;
+    }
 
     reset_curpps_data(cur_pps);// reset
 
     FUN_CHECK(ret = parser_pps(p_bitctx, &p_Cur->sps, cur_pps));
     //!< MakePPSavailable
     ASSERT(cur_pps->Valid == 1);
-    memcpy(&currSlice->p_Vid->ppsSet[cur_pps->pic_parameter_set_id], cur_pps, sizeof(H264_PPS_t));
+    memcpy(&p_Vid->ppsSet[cur_pps->pic_parameter_set_id], cur_pps, sizeof(H264_PPS_t));
+    mpp_ps_cache_update(p_Vid->pps_cache, cur_pps->pic_parameter_set_id, raw, raw_len);
 
     return ret = MPP_OK;
 __FAILED:
@@ -444,8 +444,24 @@ MPP_RET process_sps(H264_SLICE_t *currSlice)
     MPP_RET ret = MPP_ERR_UNKNOW;
 
     H264dCurCtx_t *p_Cur = currSlice->p_Cur;
+    H264dVideoCtx_t *p_Vid = currSlice->p_Vid;
     BitReadCtx_t *p_bitctx = &p_Cur->bitctx;
     H264_SPS_t *cur_sps = &p_Cur->sps;
+    RK_U8 *raw = p_Cur->nalu.sodb_buf + p_Cur->nalu.ualu_header_bytes;
+    RK_S32 raw_len = p_Cur->nalu.sodb_len - p_Cur->nalu.ualu_header_bytes;
+    RK_S32 sps_id = 0;
+
+    //!< resend of a sps in spsSet, skip parse
+    sps_id = mpp_ps_cache_lookup(p_Vid->sps_cache, raw, raw_len);
+    if (sps_id >= 0) {
+        //!< pps is parsed with current sps, drop cached pps on sps switch
+        if (memcmp(cur_sps, &p_Vid->spsSet[sps_id], sizeof(H264_SPS_t))) {
+            mpp_ps_cache_remove(p_Vid->pps_cache, -1);
+            memcpy(cur_sps, &p_Vid->spsSet[sps_id], sizeof(H264_SPS_t));
+        }
+        return ret = MPP_OK;
+    }
+    mpp_ps_cache_remove(p_Vid->pps_cache, -1);
 
     reset_cur_sps_data(cur_sps); // reset
     //!< parse sps
@@ -454,7 +470,8 @@ MPP_RET process_sps(H264_SLICE_t *currSlice)
     FUN_CHECK(ret = get_max_dec_frame_buf_size(cur_sps));
     //!< make SPS available, copy
     if (cur_sps->Valid) {
-        memcpy(&currSlice->p_Vid->spsSet[cur_sps->seq_parameter_set_id], cur_sps, sizeof(H264_SPS_t));
+        memcpy(&p_Vid->spsSet[cur_sps->seq_parameter_set_id], cur_sps, sizeof(H264_SPS_t));
+        mpp_ps_cache_update(p_Vid->sps_cache, cur_sps->seq_parameter_set_id, raw, raw_len);
     }
 
     return ret = MPP_OK;
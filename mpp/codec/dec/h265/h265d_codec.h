@@ -139,6 +139,7 @@ typedef struct H265dContext {
 
     RK_U32 need_split;
     RK_U32 disable_error;
+    RK_U32 skip_mode;
 } H265dContext_t;
 #ifdef  __cplusplus
 extern "C" {
@@ -31,6 +31,7 @@
 #include "mpp_mem.h"
 #include "mpp_bitread.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 
 #include "h265d_parser.h"
 #include "h265d_syntax.h"
@@ -48,44 +49,77 @@ FILE *fp = NULL;
  * Find the end of the current frame in the bitstream.
  * @return the position of the first byte of the next frame, or END_NOT_FOUND
  */
+static RK_S32 hevc_check_frame_end(SplitContext_t *sc, const RK_U8 *buf, RK_S32 i)
+{
+    int nut, layer_id;
+
+    if (((sc->state64 >> 3 * 8) & 0xFFFFFF) != START_CODE)
+        return 0;
+    nut = (sc->state64 >> (2 * 8 + 1)) & 0x3F;
+    layer_id  =  (((sc->state64 >> 2 * 8) & 0x01) << 5) + (((sc->state64 >> 1 * 8) & 0xF8) >> 3);
+    //mpp_log("nut = %d layer_id = %d\n",nut,layer_id);
+    // Beginning of access unit
+    if ((nut >= NAL_VPS && nut <= NAL_AUD) || nut == NAL_SEI_PREFIX ||
+        (nut >= 41 && nut <= 44) || (nut >= 48 && nut <= 55)) {
+        if (sc->frame_start_found && !layer_id) {
+            sc->frame_start_found = 0;
+            return 1;
+        }
+    } else if (nut <= NAL_RASL_R ||
+               (nut >= NAL_BLA_W_LP && nut <= NAL_CRA_NUT)) {
+        int first_slice_segment_in_pic_flag = buf[i] >> 7;
+        //mpp_log("nut = %d first_slice_segment_in_pic_flag %d layer_id = %d \n",nut,
+        //    first_slice_segment_in_pic_flag,
+        //     layer_id);
+        if (first_slice_segment_in_pic_flag && !layer_id) {
+            if (!sc->frame_start_found) {
+                sc->frame_start_found = 1;
+            } else { // First slice of next frame found
+                sc->frame_start_found = 0;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * The frame end check needs the start code and three following bytes. The
+ * first bytes of the buffer are checked one by one against the history in
+ * state64 and the rest is searched for start codes in bulk.
+ */
+#define FRAME_END_CHECK_BYTES   6
+
 static RK_S32 hevc_find_frame_end(SplitContext_t *sc, const RK_U8 *buf,
                                   int buf_size)
 {
     RK_S32 i;
+    RK_S32 last = 0;
 
-    for (i = 0; i < buf_size; i++) {
-        int nut, layer_id;
-
+    for (i = 0; i < buf_size && i < FRAME_END_CHECK_BYTES - 1; i++) {
         sc->state64 = (sc->state64 << 8) | buf[i];
+        if (hevc_check_frame_end(sc, buf, i))
+            return i - 5;
+    }
+    last = i;
 
-        if (((sc->state64 >> 3 * 8) & 0xFFFFFF) != START_CODE)
-            continue;
-        nut = (sc->state64 >> (2 * 8 + 1)) & 0x3F;
-        layer_id  =  (((sc->state64 >> 2 * 8) & 0x01) << 5) + (((sc->state64 >> 1 * 8) & 0xF8) >> 3);
-        //mpp_log("nut = %d layer_id = %d\n",nut,layer_id);
-        // Beginning of access unit
-        if ((nut >= NAL_VPS && nut <= NAL_AUD) || nut == NAL_SEI_PREFIX ||
-            (nut >= 41 && nut <= 44) || (nut >= 48 && nut <= 55)) {
-            if (sc->frame_start_found && !layer_id) {
-                sc->frame_start_found = 0;
-                return i - 5;
-            }
-        } else if (nut <= NAL_RASL_R ||
-                   (nut >= NAL_BLA_W_LP && nut <= NAL_CRA_NUT)) {
-            int first_slice_segment_in_pic_flag = buf[i] >> 7;
-            //mpp_log("nut = %d first_slice_segment_in_pic_flag %d layer_id = %d \n",nut,
-            //    first_slice_segment_in_pic_flag,
-            //     layer_id);
-            if (first_slice_segment_in_pic_flag && !layer_id) {
-                if (!sc->frame_start_found) {
-                    sc->frame_start_found = 1;
-                } else { // First slice of next frame found
-                    sc->frame_start_found = 0;
-                    return i - 5;
-                }
-            }
-        }
+    while (i < buf_size) {
+        /* start code at j is checked when byte j + 5 is reached */
+        RK_S32 start = i - (FRAME_END_CHECK_BYTES - 1);
+        RK_S32 found = mpp_find_startcode(buf + start, buf_size - 3 - start);
+
+        if (found < 0)
+            break;
+
+        i = start + found + FRAME_END_CHECK_BYTES - 1;
+        sc->state64 = mpp_startcode_state(sc->state64, buf + last, i + 1 - last);
+        last = i + 1;
+        if (hevc_check_frame_end(sc, buf, i))
+            return i - 5;
+        i++;
     }
+
+    sc->state64 = mpp_startcode_state(sc->state64, buf + last, buf_size - last);
     return END_NOT_FOUND;
 }
 
@@ -1180,6 +1214,34 @@ static RK_S32 mpp_hevc_output_frame(void *ctx, int flush)
     return 0;
 }
 
+/*
+ * Pictures dropped by skip mode are never referenced by the kept pictures.
+ * Sub-layer non-reference picture can only be referenced by higher sub-layer
+ * so it is dropped on the highest sub-layer only. RASL pictures are only
+ * referenced by RASL pictures.
+ */
+static RK_U32 hevc_skip_picture(HEVCContext *s)
+{
+    RK_S32 nut = s->nal_unit_type;
+
+    switch (s->h265dctx->skip_mode) {
+    case MPP_DEC_SKIP_NON_REF : {
+        if (nut == NAL_RASL_N || nut == NAL_RASL_R)
+            return 1;
+
+        return (nut < NAL_BLA_W_LP && !(nut & 1) &&
+                s->temporal_id == s->sps->max_sub_layers - 1);
+    } break;
+    case MPP_DEC_SKIP_NON_KEY : {
+        return !IS_IRAP(s);
+    } break;
+    default : {
+    } break;
+    }
+
+    return 0;
+}
+
 static RK_S32 hevc_frame_start(HEVCContext *s)
 {
     int ret;
@@ -1264,6 +1326,9 @@ static RK_S32 parser_nal_unit(HEVCContext *s, const RK_U8 *nal, int length)
     s->nuh_layer_id = ret;
     h265d_dbg(H265D_DBG_GLOBAL, "s->nal_unit_type = %d,len = %d \n", s->nal_unit_type, length);
 
+    s->ps_nal = nal;
+    s->ps_nal_size = length;
+
     switch (s->nal_unit_type) {
     case NAL_VPS:
         ret = mpp_hevc_decode_nal_vps(s);
@@ -1345,6 +1410,12 @@ static RK_S32 parser_nal_unit(HEVCContext *s, const RK_U8 *nal, int length)
                 s->max_ra = INT_MIN;
         }
 
+        /* slice header is still parsed for poc and parameter set update */
+        if (hevc_skip_picture(s)) {
+            s->is_decoded = 0;
+            break;
+        }
+
         if (s->sh.first_slice_in_pic_flag) {
             ret = hevc_frame_start(s);
             if (ret < 0) {
@@ -1450,6 +1521,18 @@ RK_S32 mpp_hevc_extract_rbsp(HEVCContext *s, const RK_U8 *src, int length,
     }
 #endif
 
+    /*
+     * Slice nal is only referenced in the source buffer here. It is copied
+     * to stream buffer by h265d_syntax_fill_slice once and the slice header
+     * is parsed from there. Parameter set and sei are parsed after the source
+     * packet is released so they are still copied.
+     */
+    if (length > 0 && ((src[0] >> 1) & 0x3f) < NAL_VPS) {
+        nal->data = src;
+        nal->size = length;
+        return length;
+    }
+
     if (length + MPP_INPUT_BUFFER_PADDING_SIZE > nal->rbsp_buffer_size) {
         RK_S32 min_size = length + MPP_INPUT_BUFFER_PADDING_SIZE;
         mpp_free(nal->rbsp_buffer);
@@ -1785,6 +1868,15 @@ MPP_RET h265d_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
             task->input_packet = s->input_packet;
         }
     }
+
+    /*
+     * Slice nals still point into the caller packet until fill_slice has
+     * copied them. mpp_dec skips h265d_parse on an invalid task, but drop
+     * the nal list anyway so a stale caller pointer can never be parsed.
+     */
+    if (!task->valid)
+        s->nb_nals = 0;
+
     return ret;
 
 }
@@ -1867,6 +1959,13 @@ MPP_RET h265d_deinit(void *ctx)
     for (i = 0; i < MAX_PPS_COUNT; i++)
         mpp_hevc_pps_free(s->pps_list[i]);
 
+    if (s->vps_cache)
+        mpp_ps_cache_deinit(s->vps_cache);
+    if (s->sps_cache)
+        mpp_ps_cache_deinit(s->sps_cache);
+    if (s->pps_cache)
+        mpp_ps_cache_deinit(s->pps_cache);
+
     mpp_free(s->HEVClc);
 
     s->HEVClc = NULL;
@@ -1910,6 +2009,11 @@ static RK_S32 hevc_init_context(H265dContext_t *h265dctx)
     if (!s->HEVClc)
         goto fail;
 
+    if (mpp_ps_cache_init(&s->vps_cache, MAX_VPS_COUNT) ||
+        mpp_ps_cache_init(&s->sps_cache, MAX_SPS_COUNT) ||
+        mpp_ps_cache_init(&s->pps_cache, MAX_PPS_COUNT))
+        goto fail;
+
     for (i = 0; i < MPP_ARRAY_ELEMS(s->DPB); i++) {
         s->DPB[i].slot_index = 0xff;
         s->DPB[i].poc = INT_MAX;
@@ -2033,7 +2137,18 @@ MPP_RET h265d_control(void *ctx, MpiCmd cmd, void *param)
     switch (cmd) {
     case MPP_DEC_SET_DISABLE_ERROR: {
         h265dctx->disable_error = *((RK_U32 *)param);
-    }
+    } break;
+    case MPP_DEC_SET_SKIP_MODE: {
+        h265dctx->skip_mode = *((RK_U32 *)param);
+    } break;
+    case MPP_GET_STATS: {
+        HEVCContext *s = (HEVCContext *)h265dctx->priv_data;
+        MppStats *stats = (MppStats *)param;
+
+        mpp_ps_cache_stats(s->vps_cache, &stats->ps_cache_hit, &stats->ps_cache_miss);
+        mpp_ps_cache_stats(s->sps_cache, &stats->ps_cache_hit, &stats->ps_cache_miss);
+        mpp_ps_cache_stats(s->pps_cache, &stats->ps_cache_hit, &stats->ps_cache_miss);
+    } break;
     default : {
     } break;
     }
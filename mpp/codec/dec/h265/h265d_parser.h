@@ -35,6 +35,7 @@
 #include "mpp_mem.h"
 #include "mpp_bitread.h"
 #include "mpp_buf_slot.h"
+#include "mpp_ps_cache.h"
 
 #include "hal_task.h"
 #include "h265d_codec.h"
@@ -489,6 +490,12 @@ typedef struct HEVCContext {
     RK_U8 *vps_list[MAX_VPS_COUNT];
     RK_U8 *sps_list[MAX_SPS_COUNT];
     RK_U8 *pps_list[MAX_PPS_COUNT];
+    /* raw bytes of the parameter sets in the lists for resend detection */
+    MppPsCache vps_cache;
+    MppPsCache sps_cache;
+    MppPsCache pps_cache;
+    const RK_U8 *ps_nal;
+    RK_S32 ps_nal_size;
 
     SliceHeader sh;
 
@@ -324,6 +324,11 @@ RK_S32 h265d_syntax_fill_slice(void *ctx, RK_S32 input_index)
     if (-1 != input_index) {
         mpp_buf_slot_get_prop(h->packet_slots, input_index, SLOT_BUFFER, &streambuf);
         current = ptr = (RK_U8 *)mpp_buffer_get_ptr(streambuf);
+        /*
+         * NOTE: early return leaves nals[].data pointing into the caller
+         * packet. h265d_prepare drops the nal list on failure so that
+         * h265d_parse never reads the caller memory.
+         */
         if (current == NULL) {
             return MPP_ERR_NULL_PTR;
         }
@@ -367,6 +372,8 @@ RK_S32 h265d_syntax_fill_slice(void *ctx, RK_S32 input_index)
         current += start_code_size;
         position += start_code_size;
         memcpy(current, h->nals[i].data, h->nals[i].size);
+        /* the source packet may be released before slice header parsing */
+        h->nals[i].data = current;
         // mpp_log("h->nals[%d].size = %d", i, h->nals[i].size);
         fill_slice_short(&ctx_pic->slice_short[count], position, h->nals[i].size);
         init_slice_cut_param(&ctx_pic->slice_cut_param[count]);
@@ -387,5 +394,6 @@ RK_S32 h265d_syntax_fill_slice(void *ctx, RK_S32 input_index)
     }
     return MPP_OK;
 __BITREAD_ERR:
+    /* NOTE: nals after i are not rebased, see the note above */
     return  MPP_ERR_STREAM;
 }
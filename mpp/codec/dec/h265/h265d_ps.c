@@ -1027,9 +1027,14 @@ int mpp_hevc_decode_nal_vps(HEVCContext *s)
     BitReadCtx_t *gb = &s->HEVClc->gb;
     RK_S32 vps_id = 0;
     HEVCVPS *vps = NULL;
-    RK_U8 *vps_buf = mpp_calloc(RK_U8, sizeof(HEVCVPS));
+    RK_U8 *vps_buf = NULL;
     RK_S32 value = 0;
 
+    /* resend of the vps already in list */
+    if (mpp_ps_cache_lookup(s->vps_cache, s->ps_nal, s->ps_nal_size) >= 0)
+        return 0;
+
+    vps_buf = mpp_calloc(RK_U8, sizeof(HEVCVPS));
     if (!vps_buf)
         return MPP_ERR_NOMEM;
     vps = (HEVCVPS*)vps_buf;
@@ -1150,6 +1155,7 @@ int mpp_hevc_decode_nal_vps(HEVCContext *s)
         }
         s->vps_list[vps_id] = vps_buf;
     }
+    mpp_ps_cache_update(s->vps_cache, vps_id, s->ps_nal, s->ps_nal_size);
 
     return 0;
 __BITREAD_ERR:
@@ -1398,8 +1404,17 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
     RK_S32 value = 0;
 
     HEVCSPS *sps;
-    RK_U8 *sps_buf = mpp_calloc(RK_U8, sizeof(*sps));
+    RK_U8 *sps_buf = NULL;
+
+    /* resend of the sps already in list, keep it and its ppses */
+    sps_id = mpp_ps_cache_lookup(s->sps_cache, s->ps_nal, s->ps_nal_size);
+    if (sps_id >= 0) {
+        s->sps_list_of_updated[sps_id] = 1;
+        return 0;
+    }
+    sps_id = 0;
 
+    sps_buf = mpp_calloc(RK_U8, sizeof(*sps));
     if (!sps_buf)
         return MPP_ERR_NOMEM;
     sps = (HEVCSPS*)sps_buf;
@@ -1821,12 +1836,14 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
             if (s->pps_list[i] && ((HEVCPPS*)s->pps_list[i])->sps_id == sps_id) {
                 mpp_hevc_pps_free(s->pps_list[i]);
                 s->pps_list[i] = NULL;
+                mpp_ps_cache_remove(s->pps_cache, i);
             }
         }
         if (s->sps_list[sps_id] != NULL)
             mpp_free(s->sps_list[sps_id]);
         s->sps_list[sps_id] = sps_buf;
     }
+    mpp_ps_cache_update(s->sps_cache, sps_id, s->ps_nal, s->ps_nal_size);
 
     if (s->sps_list[sps_id])
         s->sps_list_of_updated[sps_id] = 1;
@@ -1859,6 +1876,15 @@ int mpp_hevc_decode_nal_pps(HEVCContext *s)
 
     HEVCPPS *pps = NULL;
     RK_U8 *pps_buf;
+
+    /* resend of the pps already in list, its sps is not changed after it */
+    pps_id = mpp_ps_cache_lookup(s->pps_cache, s->ps_nal, s->ps_nal_size);
+    if (pps_id >= 0) {
+        s->pps_list_of_updated[pps_id] = 1;
+        return 0;
+    }
+    pps_id = 0;
+
     pps_buf = mpp_calloc(RK_U8, sizeof(*pps));
 
     if (!pps_buf)
@@ -2112,6 +2138,7 @@ int mpp_hevc_decode_nal_pps(HEVCContext *s)
         s->pps_list[pps_id] = NULL;
     }
     s->pps_list[pps_id] = pps_buf;
+    mpp_ps_cache_update(s->pps_cache, pps_id, s->ps_nal, s->ps_nal_size);
 
     if (s->pps_list[pps_id])
         s->pps_list_of_updated[pps_id] = 1;
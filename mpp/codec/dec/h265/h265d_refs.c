@@ -255,6 +255,10 @@ RK_S32 mpp_hevc_frame_rps(HEVCContext *s)
         else
             list = ST_CURR_AFT;
 
+        /* picture dropped by skip mode can only be left in foll list */
+        if (list == ST_FOLL && s->h265dctx->skip_mode && !find_ref_idx(s, poc))
+            continue;
+
         ret = add_candidate_ref(s, &rps[list], poc, HEVC_FRAME_FLAG_SHORT_REF);
         if (ret < 0)
             return ret;
@@ -265,6 +269,9 @@ RK_S32 mpp_hevc_frame_rps(HEVCContext *s)
         int poc  = long_rps->poc[i];
         int list = long_rps->used[i] ? LT_CURR : LT_FOLL;
 
+        if (list == LT_FOLL && s->h265dctx->skip_mode && !find_ref_idx(s, poc))
+            continue;
+
         ret = add_candidate_ref(s, &rps[list], poc, HEVC_FRAME_FLAG_LONG_REF);
         if (ret < 0)
             return ret;
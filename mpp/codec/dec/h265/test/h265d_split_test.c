@@ -0,0 +1,387 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h265d_split_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_err.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "h265d_api.h"
+#include "h265d_codec.h"
+#include "h265d_parser.h"
+#include "h265d_syntax.h"
+
+/*
+ * 4096x4096 picture with 16x16 ctb gives a 16 bit slice address. The second
+ * slice starts at ctb 0x8000 so its header holds a long zero run which needs
+ * an emulation prevention byte inside the parsed part of the slice header.
+ */
+#define SPLIT_TEST_WIDTH        4096
+#define SPLIT_TEST_HEIGHT       4096
+#define SPLIT_TEST_PPS_ID       3
+#define SPLIT_TEST_EXTRA_BITS   7
+#define SPLIT_TEST_SLICE1_ADDR  0x8000
+#define SPLIT_TEST_SLICE1_QP_D  (-3)
+#define SPLIT_TEST_BUF_SIZE     1024
+
+typedef struct SplitTestBits_t {
+    RK_U8   buf[128];
+    RK_S32  bits;
+} SplitTestBits;
+
+typedef struct SplitTestStream_t {
+    RK_U8   *data;
+    RK_S32  len;
+    /* expected stream buffer content: start code + slice nals only */
+    RK_U8   expect[SPLIT_TEST_BUF_SIZE];
+    RK_S32  expect_len;
+} SplitTestStream;
+
+/* slice data with zero runs which must be escaped in the nal */
+static const RK_U8 slice_payload[] = {
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x02, 0x55, 0x80,
+};
+
+static void put_bits(SplitTestBits *w, RK_S32 n, RK_U32 val)
+{
+    RK_S32 i;
+
+    for (i = n - 1; i >= 0; i--) {
+        if ((val >> i) & 1)
+            w->buf[w->bits >> 3] |= 0x80 >> (w->bits & 7);
+        w->bits++;
+    }
+}
+
+static void put_ue(SplitTestBits *w, RK_U32 val)
+{
+    RK_U32 code = val + 1;
+    RK_S32 len = 0;
+
+    while (code >> len)
+        len++;
+
+    put_bits(w, len - 1, 0);
+    put_bits(w, len, code);
+}
+
+static void put_se(SplitTestBits *w, RK_S32 val)
+{
+    put_ue(w, val > 0 ? 2 * val - 1 : -2 * val);
+}
+
+static void put_trailing(SplitTestBits *w)
+{
+    put_bits(w, 1, 1);
+    while (w->bits & 7)
+        put_bits(w, 1, 0);
+}
+
+static void put_bytes(SplitTestBits *w, const RK_U8 *src, RK_S32 size)
+{
+    memcpy(w->buf + (w->bits >> 3), src, size);
+    w->bits += size * 8;
+}
+
+/* main profile, level 5.1, no sub-layer */
+static void put_ptl(SplitTestBits *w)
+{
+    put_bits(w, 2, 0);
+    put_bits(w, 1, 0);
+    put_bits(w, 5, 1);
+    put_bits(w, 32, 0x60000000);
+    put_bits(w, 4, 0x9);
+    /* 44 reserved zero bits */
+    put_bits(w, 16, 0);
+    put_bits(w, 16, 0);
+    put_bits(w, 12, 0);
+    put_bits(w, 8, 153);
+}
+
+static void put_nal(SplitTestStream *st, RK_S32 type, SplitTestBits *w)
+{
+    RK_U8 *dst = st->data + st->len;
+    RK_U8 *nal = NULL;
+    RK_S32 size = w->bits >> 3;
+    RK_S32 zeros = 0;
+    RK_S32 pos = 0;
+    RK_S32 i;
+
+    dst[pos++] = 0;
+    dst[pos++] = 0;
+    dst[pos++] = 1;
+    nal = dst + pos;
+    dst[pos++] = type << 1;
+    dst[pos++] = 1;
+
+    for (i = 0; i < size; i++) {
+        RK_U8 b = w->buf[i];
+
+        if (zeros >= 2 && b <= 3) {
+            dst[pos++] = 3;
+            zeros = 0;
+        }
+        dst[pos++] = b;
+        zeros = b ? 0 : zeros + 1;
+    }
+
+    if (type < NAL_VPS) {
+        RK_S32 nal_size = (RK_S32)(dst + pos - nal);
+
+        memcpy(st->expect + st->expect_len, dst, 3);
+        memcpy(st->expect + st->expect_len + 3, nal, nal_size);
+        st->expect_len += 3 + nal_size;
+    }
+
+    st->len += pos;
+    memset(w, 0, sizeof(*w));
+}
+
+static void build_stream(SplitTestStream *st)
+{
+    SplitTestBits w;
+
+    memset(&w, 0, sizeof(w));
+
+    /* vps */
+    put_bits(&w, 4, 0);
+    put_bits(&w, 2, 3);
+    put_bits(&w, 6, 0);
+    put_bits(&w, 3, 0);
+    put_bits(&w, 1, 1);
+    put_bits(&w, 16, 0xffff);
+    put_ptl(&w);
+    put_bits(&w, 1, 1);
+    put_ue(&w, 4);
+    put_ue(&w, 0);
+    put_ue(&w, 0);
+    put_bits(&w, 6, 0);
+    put_ue(&w, 0);
+    put_bits(&w, 1, 0);
+    put_bits(&w, 1, 0);
+    put_trailing(&w);
+    put_nal(st, NAL_VPS, &w);
+
+    /* sps */
+    put_bits(&w, 4, 0);
+    put_bits(&w, 3, 0);
+    put_bits(&w, 1, 1);
+    put_ptl(&w);
+    put_ue(&w, 0);
+    put_ue(&w, 1);
+    put_ue(&w, SPLIT_TEST_WIDTH);
+    put_ue(&w, SPLIT_TEST_HEIGHT);
+    put_bits(&w, 1, 0);
+    put_ue(&w, 0);
+    put_ue(&w, 0);
+    put_ue(&w, 4);
+    put_bits(&w, 1, 1);
+    put_ue(&w, 4);
+    put_ue(&w, 0);
+    put_ue(&w, 0);
+    /* 8x8 min cb, 16x16 ctb, 4x4 to 16x16 tb */
+    put_ue(&w, 0);
+    put_ue(&w, 1);
+    put_ue(&w, 0);
+    put_ue(&w, 2);
+    put_ue(&w, 0);
+    put_ue(&w, 0);
+    /* scaling list, amp, sao, pcm */
+    put_bits(&w, 4, 0);
+    put_ue(&w, 0);
+    /* long term ref, temporal mvp, strong intra smoothing, vui, extension */
+    put_bits(&w, 5, 0);
+    put_trailing(&w);
+    put_nal(st, NAL_SPS, &w);
+
+    /* pps */
+    put_ue(&w, SPLIT_TEST_PPS_ID);
+    put_ue(&w, 0);
+    put_bits(&w, 2, 0);
+    put_bits(&w, 3, SPLIT_TEST_EXTRA_BITS);
+    put_bits(&w, 2, 0);
+    put_ue(&w, 0);
+    put_ue(&w, 0);
+    put_se(&w, 0);
+    put_bits(&w, 3, 0);
+    put_se(&w, 0);
+    put_se(&w, 0);
+    /* slice chroma qp offsets to deblocking filter control */
+    put_bits(&w, 8, 0);
+    /* scaling list, lists modification */
+    put_bits(&w, 2, 0);
+    put_ue(&w, 0);
+    put_bits(&w, 2, 0);
+    put_trailing(&w);
+    put_nal(st, NAL_PPS, &w);
+
+    /* slice 0 */
+    put_bits(&w, 1, 1);
+    put_bits(&w, 1, 0);
+    put_ue(&w, SPLIT_TEST_PPS_ID);
+    put_bits(&w, SPLIT_TEST_EXTRA_BITS, 0);
+    put_ue(&w, I_SLICE);
+    put_se(&w, 0);
+    put_trailing(&w);
+    put_bytes(&w, slice_payload, sizeof(slice_payload));
+    put_nal(st, NAL_IDR_W_RADL, &w);
+
+    /* slice 1 */
+    put_bits(&w, 1, 0);
+    put_bits(&w, 1, 0);
+    put_ue(&w, SPLIT_TEST_PPS_ID);
+    put_bits(&w, 16, SPLIT_TEST_SLICE1_ADDR);
+    put_bits(&w, SPLIT_TEST_EXTRA_BITS, 0);
+    put_ue(&w, I_SLICE);
+    put_se(&w, SPLIT_TEST_SLICE1_QP_D);
+    put_trailing(&w);
+    put_bytes(&w, slice_payload, sizeof(slice_payload));
+    put_nal(st, NAL_IDR_W_RADL, &w);
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufSlots frame_slots = NULL;
+    MppBufSlots packet_slots = NULL;
+    MppPacket packet = NULL;
+    SplitTestStream *st = NULL;
+    H265dContext_t *ctx = NULL;
+    HEVCContext *s = NULL;
+    h265d_dxva2_picture_context_t *ctx_pic = NULL;
+    ParserCfg cfg;
+    HalDecTask task;
+    RK_S32 index = -1;
+    RK_S32 i;
+
+    mpp_log("h265d split test start\n");
+
+    st = mpp_calloc(SplitTestStream, 1);
+    ctx = mpp_calloc_size(H265dContext_t, api_h265d_parser.ctx_size);
+    if (!st || !ctx) {
+        mpp_err("failed to malloc test context\n");
+        goto DONE;
+    }
+
+    /* the caller owned packet memory */
+    st->data = mpp_calloc(RK_U8, SPLIT_TEST_BUF_SIZE);
+    if (!st->data) {
+        mpp_err("failed to malloc stream\n");
+        goto DONE;
+    }
+    build_stream(st);
+
+    mpp_buf_slot_init(&frame_slots);
+    mpp_buf_slot_init(&packet_slots);
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.coding = MPP_VIDEO_CodingHEVC;
+    cfg.frame_slots = frame_slots;
+    cfg.packet_slots = packet_slots;
+    cfg.need_split = 1;
+
+    ret = api_h265d_parser.init(ctx, &cfg);
+    if (ret) {
+        mpp_err("parser init failed ret %d\n", ret);
+        goto DEINIT;
+    }
+    s = (HEVCContext *)ctx->priv_data;
+    ctx_pic = (h265d_dxva2_picture_context_t *)s->hal_pic_private;
+
+    mpp_packet_init(&packet, st->data, st->len);
+    mpp_packet_set_eos(packet);
+
+    memset(&task, 0, sizeof(task));
+    task.input = -1;
+
+    ret = api_h265d_parser.prepare(ctx, packet, &task);
+    if (ret || !task.valid) {
+        mpp_err("prepare failed ret %d valid %d\n", ret, task.valid);
+        ret = MPP_NOK;
+        goto DEINIT;
+    }
+
+    ret = MPP_NOK;
+    if (ctx_pic->slice_count != 2) {
+        mpp_err("slice count %d expect 2\n", ctx_pic->slice_count);
+        goto DEINIT;
+    }
+
+    if ((RK_S32)ctx_pic->bitstream_size != st->expect_len ||
+        memcmp(mpp_packet_get_data(task.input_packet), st->expect, st->expect_len)) {
+        mpp_err("stream size %d expect %d or content mismatch\n",
+                ctx_pic->bitstream_size, st->expect_len);
+        goto DEINIT;
+    }
+
+    for (i = 0; i < s->nb_nals; i++) {
+        RK_U8 *data = (RK_U8 *)s->nals[i].data;
+
+        if (data >= st->data && data < st->data + st->len) {
+            mpp_err("nal %d still points to caller packet\n", i);
+            goto DEINIT;
+        }
+    }
+
+    /* slice header must be parsed from the stream buffer copy only */
+    memset(st->data, 0xff, st->len);
+
+    ret = api_h265d_parser.parse(ctx, &task);
+    if (ret || task.flags.parse_err || !task.valid) {
+        mpp_err("parse failed ret %d err %d valid %d\n",
+                ret, task.flags.parse_err, task.valid);
+        ret = MPP_NOK;
+        goto DEINIT;
+    }
+
+    /* release the output frame as hal and mpp_dec output would do */
+    mpp_buf_slot_clr_flag(frame_slots, task.output, SLOT_HAL_OUTPUT);
+    while (MPP_OK == mpp_buf_slot_dequeue(frame_slots, &index, QUEUE_DISPLAY))
+        mpp_buf_slot_clr_flag(frame_slots, index, SLOT_QUEUE_USE);
+
+    ret = MPP_NOK;
+    if (s->sh.slice_segment_addr != SPLIT_TEST_SLICE1_ADDR ||
+        s->sh.slice_type != I_SLICE ||
+        s->sh.slice_qp != 26 + SPLIT_TEST_SLICE1_QP_D) {
+        mpp_err("slice addr %d type %d qp %d mismatch\n",
+                s->sh.slice_segment_addr, s->sh.slice_type, s->sh.slice_qp);
+        goto DEINIT;
+    }
+
+    ret = MPP_OK;
+
+DEINIT:
+    api_h265d_parser.deinit(ctx);
+    if (packet)
+        mpp_packet_deinit(&packet);
+    if (frame_slots)
+        mpp_buf_slot_deinit(frame_slots);
+    if (packet_slots)
+        mpp_buf_slot_deinit(packet_slots);
+DONE:
+    if (st)
+        MPP_FREE(st->data);
+    MPP_FREE(st);
+    MPP_FREE(ctx);
+
+    mpp_log("h265d split test %s\n", ret ? "failed" : "success");
+    return ret;
+}
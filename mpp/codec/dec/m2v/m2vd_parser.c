@@ -20,6 +20,7 @@
 
 #include "mpp_env.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 
 #include "m2vd_parser.h"
 #include "m2vd_codec.h"
@@ -373,10 +374,18 @@ MPP_RET m2vd_parser_flush(void *ctx)
 MPP_RET m2vd_parser_control(void *ctx, MpiCmd cmd_type, void *param)
 {
     MPP_RET ret = MPP_OK;
+    M2VDContext *c = (M2VDContext *)ctx;
+    M2VDParserContext *p = (M2VDParserContext *)c->parse_ctx;
     m2vd_dbg_func("FUN_I");
-    (void)ctx;
-    (void)cmd_type;
-    (void)param;
+
+    switch (cmd_type) {
+    case MPP_DEC_SET_SKIP_MODE: {
+        p->skip_mode = *((RK_U32 *)param);
+    } break;
+    default : {
+    } break;
+    }
+
     m2vd_dbg_func("FUN_O");
     return ret;
 }
@@ -408,8 +417,12 @@ MPP_RET mpp_m2vd_parser_split(M2VDParserContext *ctx, MppPacket dst, MppPacket s
         }
 
         while (src_pos < src_len) {
-            p->state = (p->state << 8) | src_buf[src_pos];
-            dst_buf[dst_len++] = src_buf[src_pos++];
+            RK_U32 len = mpp_startcode_skip(p->state, src_buf + src_pos, src_len - src_pos);
+
+            memcpy(dst_buf + dst_len, src_buf + src_pos, len);
+            p->state = (RK_U32)mpp_startcode_state(p->state, src_buf + src_pos, len);
+            dst_len += len;
+            src_pos += len;
 
             /*
              * 0x1b3 : sequence header
@@ -426,8 +439,12 @@ MPP_RET mpp_m2vd_parser_split(M2VDParserContext *ctx, MppPacket dst, MppPacket s
 
     if (p->vop_header_found) {
         while (src_pos < src_len) {
-            p->state = (p->state << 8) | src_buf[src_pos];
-            dst_buf[dst_len++] = src_buf[src_pos++];
+            RK_U32 len = mpp_startcode_skip(p->state, src_buf + src_pos, src_len - src_pos);
+
+            memcpy(dst_buf + dst_len, src_buf + src_pos, len);
+            p->state = (RK_U32)mpp_startcode_state(p->state, src_buf + src_pos, len);
+            dst_len += len;
+            src_pos += len;
 
             if (((p->state & 0x00FFFFFF) == 0x000001) && (src_pos < src_len) &&
                 (src_buf[src_pos] == (SEQUENCE_HEADER_CODE & 0xFF) ||
@@ -1066,6 +1083,30 @@ static MPP_RET m2vd_decode_head(M2VDParserContext *ctx)
     return ret;
 }
 
+/*
+ * B picture is never referenced. The second field follows the decision of
+ * the first field because I frame may have a P second field.
+ */
+static RK_U32 m2vd_skip_picture(M2VDParserContext *ctx)
+{
+    M2VDHeadPicCodeExt *ext = &ctx->pic_code_ext_head;
+    RK_S32 type = ctx->pic_head.picture_coding_type;
+
+    if (!ctx->skip_mode)
+        return 0;
+
+    if ((ext->picture_structure == M2VD_PIC_STRUCT_FRAME) ||
+        ((ext->picture_structure == M2VD_PIC_STRUCT_TOP_FIELD) && ext->top_field_first) ||
+        ((ext->picture_structure == M2VD_PIC_STRUCT_BOTTOM_FIELD) && !ext->top_field_first)) {
+        if (ctx->skip_mode == MPP_DEC_SKIP_NON_KEY)
+            ctx->skip_frame = (type != M2VD_CODING_TYPE_I);
+        else
+            ctx->skip_frame = (type == M2VD_CODING_TYPE_B);
+    }
+
+    return ctx->skip_frame;
+}
+
 static MPP_RET m2vd_alloc_frame(M2VDParserContext *ctx)
 {
     RK_U64 pts = ctx->pts;
@@ -1420,6 +1461,11 @@ MPP_RET m2vd_parser_parse(void *ctx, HalDecTask *in_task)
     }
 
     if (rev == M2VD_DEC_PICHEAD_OK) {
+        if (m2vd_skip_picture(p)) {
+            if (M2VD_DBG_SEC_HEADER & m2vd_debug)
+                mpp_log("[m2v]: skip picture type %d", p->pic_head.picture_coding_type);
+            goto __FAILED;
+        }
         if (MPP_OK != m2vd_alloc_frame(p)) {
             mpp_err("m2vd_alloc_frame not OK");
             goto __FAILED;
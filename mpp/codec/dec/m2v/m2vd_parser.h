@@ -253,6 +253,8 @@ typedef struct M2VDParserContext_t {
     M2VDHeadPicDispExt  pic_disp_ext_head;
 
     RK_S32             resetFlag;
+    RK_U32             skip_mode;
+    RK_U32             skip_frame;
 
     RK_U64          PreGetFrameTime;
     RK_S64          Group_start_Time;
@@ -167,8 +167,17 @@ static MPP_RET mpg4d_control(void *dec, MpiCmd cmd_type, void *param)
         mpp_err_f("found NULL intput\n");
         return MPP_ERR_NULL_PTR;
     }
-    (void)cmd_type;
-    (void)param;
+
+    switch (cmd_type) {
+    case MPP_DEC_SET_SKIP_MODE : {
+        Mpg4dCtx *p = (Mpg4dCtx *)dec;
+
+        mpp_mpg4_parser_set_skip_mode(p->parser, *((RK_U32 *)param));
+    } break;
+    default : {
+    } break;
+    }
+
     return MPP_OK;
 }
 
@@ -287,6 +296,9 @@ static MPP_RET mpg4d_parse(void *dec, HalDecTask *task)
         task->valid  = 0;
         task->output = -1;
         mpp_packet_set_length(task->input_packet, 0);
+        // dropped last frame still need to flush the frames in dpb
+        if (p->got_eos)
+            mpg4d_flush(dec);
 
         return MPP_NOK;
     }
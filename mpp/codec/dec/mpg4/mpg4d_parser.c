@@ -19,10 +19,13 @@
 
 #include <string.h>
 
+#include "rk_mpi_cmd.h"
+
 #include "mpp_env.h"
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_bitread.h"
+#include "mpp_startcode.h"
 
 #include "mpg4d_parser.h"
 #include "mpg4d_syntax.h"
@@ -159,6 +162,7 @@ typedef struct {
     RK_U32          found_vol;
     RK_U32          found_vop;
     RK_U32          found_i_vop;
+    RK_U32          skip_mode;
 
     // frame size parameter
     RK_S32          width;
@@ -1184,8 +1188,12 @@ MPP_RET mpp_mpg4_parser_split(Mpg4dParser ctx, MppPacket dst, MppPacket src)
             dst_len = 3;
         }
         while (src_pos < src_len) {
-            p->state = (p->state << 8) | src_buf[src_pos];
-            dst_buf[dst_len++] = src_buf[src_pos++];
+            RK_U32 len = mpp_startcode_skip(p->state, src_buf + src_pos, src_len - src_pos);
+
+            memcpy(dst_buf + dst_len, src_buf + src_pos, len);
+            p->state = (RK_U32)mpp_startcode_state(p->state, src_buf + src_pos, len);
+            dst_len += len;
+            src_pos += len;
             if (p->state == MPG4_VOP_STARTCODE) {
                 p->vop_header_found = 1;
                 mpp_packet_set_pts(dst, src_pts);
@@ -1196,8 +1204,12 @@ MPP_RET mpp_mpg4_parser_split(Mpg4dParser ctx, MppPacket dst, MppPacket src)
     // find the end of the vop
     if (p->vop_header_found) {
         while (src_pos < src_len) {
-            p->state = (p->state << 8) | src_buf[src_pos];
-            dst_buf[dst_len++] = src_buf[src_pos++];
+            RK_U32 len = mpp_startcode_skip(p->state, src_buf + src_pos, src_len - src_pos);
+
+            memcpy(dst_buf + dst_len, src_buf + src_pos, len);
+            p->state = (RK_U32)mpp_startcode_state(p->state, src_buf + src_pos, len);
+            dst_len += len;
+            src_pos += len;
             if ((p->state & 0x00FFFFFF) == 0x000001) {
                 dst_len -= 3;
                 p->vop_header_found = 0;
@@ -1327,6 +1339,14 @@ MPP_RET mpp_mpg4_parser_decode(Mpg4dParser ctx, MppPacket pkt)
                     continue;
                 }
 
+                /* vop time is already updated so B-VOP after skip gets right time_bp */
+                if ((p->skip_mode == MPP_DEC_SKIP_NON_REF && coding_type == MPEG4_B_VOP) ||
+                    (p->skip_mode == MPP_DEC_SKIP_NON_KEY && coding_type != MPEG4_I_VOP)) {
+                    mpg4d_dbg_result("skip vop coding_type %d\n", coding_type);
+                    mpp_align_get_bits(gb);
+                    continue;
+                }
+
                 p->found_vop = p->found_i_vop;
             }
         }
@@ -1368,6 +1388,14 @@ __BITREAD_ERR:
     return ret;
 }
 
+MPP_RET mpp_mpg4_parser_set_skip_mode(Mpg4dParser ctx, RK_U32 mode)
+{
+    Mpg4dParserImpl *p = (Mpg4dParserImpl *)ctx;
+
+    p->skip_mode = mode;
+    return MPP_OK;
+}
+
 MPP_RET mpp_mpg4_parser_setup_syntax(Mpg4dParser ctx, MppSyntax *syntax)
 {
     Mpg4dParserImpl *p = (Mpg4dParserImpl *)ctx;
@@ -41,6 +41,7 @@ MPP_RET mpp_mpg4_parser_reset(Mpg4dParser ctx);
 
 MPP_RET mpp_mpg4_parser_split(Mpg4dParser ctx, MppPacket dst, MppPacket src);
 MPP_RET mpp_mpg4_parser_decode(Mpg4dParser ctx, MppPacket pkt);
+MPP_RET mpp_mpg4_parser_set_skip_mode(Mpg4dParser ctx, RK_U32 mode);
 MPP_RET mpp_mpg4_parser_setup_syntax(Mpg4dParser ctx, MppSyntax *syntax);
 MPP_RET mpp_mpg4_parser_setup_hal_output(Mpg4dParser ctx, RK_S32 *output);
 MPP_RET mpp_mpg4_parser_setup_refer(Mpg4dParser ctx, RK_S32 *refer, RK_S32 max_ref);
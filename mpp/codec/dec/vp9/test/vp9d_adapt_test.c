@@ -0,0 +1,209 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "vp9d_adapt_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_err.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "vp9d_adapt.h"
+
+#define ADAPT_TEST_ROUNDS       2000
+#define ADAPT_TEST_BENCH_LOOPS  20000
+
+#define FASTDIV(a,b) ((RK_U32)((((RK_U64)a) * vpx_inverse[b]) >> 32))
+
+extern const RK_U32 vpx_inverse[257];
+
+/* scalar reference copied from adapt_prob / adapt_probs in vp9d_parser.c */
+static void ref_adapt_prob(RK_U8 *p, RK_U32 ct0, RK_U32 ct1,
+                           RK_S32 max_count, RK_S32 update_factor)
+{
+    RK_U32 ct = ct0 + ct1, p2, p1;
+
+    if (!ct)
+        return;
+
+    p1 = *p;
+    p2 = ((ct0 << 8) + (ct >> 1)) / ct;
+    p2 = mpp_clip(p2, 1, 255);
+    ct = MPP_MIN(ct, (RK_U32)max_count);
+    update_factor = FASTDIV(update_factor * ct, max_count);
+
+    *p = p1 + (((p2 - p1) * update_factor + 128) >> 8);
+}
+
+static void ref_adapt_coef_probs(RK_U8 *prob, const RK_U32 *coef,
+                                 const RK_U32 *eob, RK_S32 uf)
+{
+    RK_S32 i, l, m;
+
+    for (i = 0; i < 4 * 2 * 2; i++)
+        for (l = 0; l < 6; l++)
+            for (m = 0; m < 6; m++) {
+                RK_S32 idx = (i * 6 + l) * 6 + m;
+                RK_U8 *pp = prob + idx * 3;
+                const RK_U32 *e = eob + idx * 2;
+                const RK_U32 *c = coef + idx * 3;
+
+                if (l == 0 && m >= 3)
+                    break;
+
+                ref_adapt_prob(&pp[0], e[0], e[1], 24, uf);
+                ref_adapt_prob(&pp[1], c[0], c[1] + c[2], 24, uf);
+                ref_adapt_prob(&pp[2], c[1], c[2], 24, uf);
+            }
+}
+
+typedef enum AdaptTestCase_e {
+    ADAPT_TEST_SMALL,       /* around the saturation count */
+    ADAPT_TEST_MEDIUM,      /* typical 1080p frame */
+    ADAPT_TEST_LARGE,       /* 4K frame with skewed statistic */
+    ADAPT_TEST_SPARSE,      /* mostly unused context */
+    ADAPT_TEST_OVERFLOW,    /* full 32 bit range with wrap around */
+    ADAPT_TEST_BUTT,
+} AdaptTestCase;
+
+static const char *case_names[ADAPT_TEST_BUTT] = {
+    "small",
+    "medium",
+    "large",
+    "sparse",
+    "overflow",
+};
+
+static RK_U32 rand_u32(void)
+{
+    return ((RK_U32)rand() << 16) ^ (RK_U32)rand();
+}
+
+static RK_U32 rand_count(AdaptTestCase type)
+{
+    switch (type) {
+    case ADAPT_TEST_SMALL :
+        return rand_u32() % 40;
+    case ADAPT_TEST_MEDIUM :
+        return rand_u32() % 4096;
+    case ADAPT_TEST_LARGE :
+        return rand_u32() >> (8 + rand_u32() % 24);
+    case ADAPT_TEST_SPARSE :
+        return (rand_u32() % 8) ? 0 : rand_u32() % 64;
+    default :
+        return rand_u32();
+    }
+}
+
+static void fill_test_data(RK_U8 *prob, RK_U32 *coef, RK_U32 *eob,
+                           AdaptTestCase type)
+{
+    RK_S32 i;
+
+    for (i = 0; i < VP9D_COEF_PROB_NUM; i++) {
+        prob[i] = (RK_U8)rand_u32();
+        coef[i] = rand_count(type);
+    }
+
+    for (i = 0; i < VP9D_COEF_CTX_NUM * 2; i++)
+        eob[i] = rand_count(type);
+}
+
+static MPP_RET adapt_test_exact(AdaptTestCase type)
+{
+    RK_U8 prob[VP9D_COEF_PROB_NUM];
+    RK_U8 prob_ref[VP9D_COEF_PROB_NUM];
+    RK_U32 coef[VP9D_COEF_PROB_NUM];
+    RK_U32 eob[VP9D_COEF_CTX_NUM * 2];
+    RK_S32 i, j;
+
+    for (i = 0; i < ADAPT_TEST_ROUNDS; i++) {
+        RK_S32 uf = (i & 1) ? 112 : 128;
+
+        fill_test_data(prob, coef, eob, type);
+        memcpy(prob_ref, prob, sizeof(prob));
+
+        ref_adapt_coef_probs(prob_ref, coef, eob, uf);
+        vp9d_adapt_coef_probs(prob, coef, eob, uf);
+
+        if (!memcmp(prob, prob_ref, sizeof(prob)))
+            continue;
+
+        for (j = 0; j < VP9D_COEF_PROB_NUM; j++) {
+            if (prob[j] != prob_ref[j]) {
+                mpp_err("%s round %d prob %d mismatch %d vs ref %d\n",
+                        case_names[type], i, j, prob[j], prob_ref[j]);
+                break;
+            }
+        }
+        return MPP_NOK;
+    }
+
+    mpp_log("%-8s %d rounds bit-exact\n", case_names[type], ADAPT_TEST_ROUNDS);
+    return MPP_OK;
+}
+
+static void adapt_test_bench(void)
+{
+    RK_U8 prob[VP9D_COEF_PROB_NUM];
+    RK_U8 init[VP9D_COEF_PROB_NUM];
+    RK_U32 coef[VP9D_COEF_PROB_NUM];
+    RK_U32 eob[VP9D_COEF_CTX_NUM * 2];
+    RK_S64 time_ref;
+    RK_S64 time_new;
+    RK_S32 i;
+
+    fill_test_data(init, coef, eob, ADAPT_TEST_LARGE);
+
+    memcpy(prob, init, sizeof(prob));
+    time_ref = mpp_time();
+    for (i = 0; i < ADAPT_TEST_BENCH_LOOPS; i++)
+        ref_adapt_coef_probs(prob, coef, eob, 128);
+    time_ref = mpp_time() - time_ref;
+
+    memcpy(prob, init, sizeof(prob));
+    time_new = mpp_time();
+    for (i = 0; i < ADAPT_TEST_BENCH_LOOPS; i++)
+        vp9d_adapt_coef_probs(prob, coef, eob, 128);
+    time_new = mpp_time() - time_new;
+
+    mpp_log("coef adaptation per frame: scalar %.2f us batch %.2f us\n",
+            (double)time_ref / ADAPT_TEST_BENCH_LOOPS,
+            (double)time_new / ADAPT_TEST_BENCH_LOOPS);
+}
+
+int main()
+{
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
+
+    mpp_log("vp9d_adapt_test start\n");
+
+    srand(0x9d);
+
+    for (i = 0; i < ADAPT_TEST_BUTT && !ret; i++)
+        ret = adapt_test_exact((AdaptTestCase)i);
+
+    if (!ret)
+        adapt_test_bench();
+
+    mpp_log("vp9d_adapt_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
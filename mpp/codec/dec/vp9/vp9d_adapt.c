@@ -0,0 +1,114 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "vp9d_adapt"
+
+#include "mpp_common.h"
+
+#include "vp9d_adapt.h"
+
+/*
+ * ceil(65536 / 24): (x * inv) >> 16 == x / 24 for all 0 <= x <= 3072 which
+ * covers update factor 128 times saturated count 24
+ */
+#define VP9D_COEF_COUNT_INV     2731
+
+/* signed int conversion has vector instruction on all targets */
+#define U32_TO_DOUBLE(x)        ((double)(RK_S32)((x) ^ 0x80000000) + 2147483648.0)
+
+/*
+ * Each coefficient context has three binary probabilities:
+ * more coef    - eob[0] : eob[1]
+ * zero token   - coef[0] : coef[1] + coef[2]
+ * one token    - coef[1] : coef[2]
+ *
+ * The dc band (band 0) only has 3 contexts. The other 3 contexts are left
+ * with zero count so the batch loop keeps their probabilities unchanged.
+ */
+static void gather_coef_counts(RK_U32 *ct0, RK_U32 *ct1, const RK_U32 *coef,
+                               const RK_U32 *eob)
+{
+    RK_S32 i;
+
+    for (i = 0; i < VP9D_COEF_CTX_NUM; i++) {
+        const RK_U32 *c = coef + i * 3;
+        const RK_U32 *e = eob + i * 2;
+        RK_U32 *a = ct0 + i * 3;
+        RK_U32 *b = ct1 + i * 3;
+
+        /* index i is [tx][plane][ref][band][ctx] with 6 ctx and 6 band */
+        if ((i / 6) % 6 == 0 && i % 6 >= 3) {
+            a[0] = a[1] = a[2] = 0;
+            b[0] = b[1] = b[2] = 0;
+            continue;
+        }
+
+        a[0] = e[0];
+        b[0] = e[1];
+        a[1] = c[0];
+        b[1] = c[1] + c[2];
+        a[2] = c[1];
+        b[2] = c[2];
+    }
+}
+
+/*
+ * Branch free version of adapt_prob over flat arrays so the compiler can
+ * vectorize it.
+ *
+ * The integer division ((ct0 << 8) + (ct >> 1)) / ct has unbounded divisor
+ * so it is done in double instead. Both operands are below 2^32 and exact in
+ * double. When the quotient is not an integer it is at least 1 / ct away
+ * from the next integer, which is far above the rounding error of a quotient
+ * below 256, so truncation gives the same value as the integer division. A
+ * quotient of 256 or more is clipped to 255 on both paths.
+ *
+ * The update factor division by the saturated count uses a reciprocal.
+ */
+static void adapt_coef_batch(RK_U8 *prob, const RK_U32 *ct0, const RK_U32 *ct1,
+                             RK_U32 update_factor)
+{
+    RK_U32 factor = update_factor * VP9D_COEF_COUNT_INV;
+    RK_S32 i;
+
+    for (i = 0; i < VP9D_COEF_PROB_NUM; i++) {
+        RK_U32 ct = ct0[i] + ct1[i];
+        RK_U32 num = (ct0[i] << 8) + (ct >> 1);
+        RK_U32 den = ct ? ct : 1;
+        RK_U32 sat = MPP_MIN(ct, VP9D_COEF_COUNT_SAT);
+        RK_U32 uf = (sat * factor) >> 16;
+        RK_U32 p1 = prob[i];
+        RK_U32 p2;
+        double q = U32_TO_DOUBLE(num) / U32_TO_DOUBLE(den);
+
+        q = MPP_MIN(q, 255.0);
+        q = MPP_MAX(q, 1.0);
+        p2 = (RK_U32)(RK_S32)q;
+
+        /* zero count gives zero update factor and keeps p1 */
+        prob[i] = (RK_U8)(p1 + (((p2 - p1) * uf + 128) >> 8));
+    }
+}
+
+void vp9d_adapt_coef_probs(RK_U8 *prob, const RK_U32 *coef, const RK_U32 *eob,
+                           RK_S32 update_factor)
+{
+    RK_U32 ct0[VP9D_COEF_PROB_NUM];
+    RK_U32 ct1[VP9D_COEF_PROB_NUM];
+
+    gather_coef_counts(ct0, ct1, coef, eob);
+    adapt_coef_batch(prob, ct0, ct1, (RK_U32)update_factor);
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __VP9D_ADAPT_H__
+#define __VP9D_ADAPT_H__
+
+#include "rk_type.h"
+
+/* coefficient probability context count: tx size / plane / ref / band / ctx */
+#define VP9D_COEF_CTX_NUM       (4 * 2 * 2 * 6 * 6)
+#define VP9D_COEF_PROB_NUM      (VP9D_COEF_CTX_NUM * 3)
+#define VP9D_COEF_COUNT_SAT     24
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Backward adaptation of all coefficient probabilities in one pass.
+ *
+ * prob is RK_U8 [4][2][2][6][6][3], coef is RK_U32 [4][2][2][6][6][3] and
+ * eob is RK_U32 [4][2][2][6][6][2] as in VP9Context. The result is bit-exact
+ * to adapt_prob on each probability with max count 24.
+ */
+void vp9d_adapt_coef_probs(RK_U8 *prob, const RK_U32 *coef, const RK_U32 *eob,
+                           RK_S32 update_factor);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __VP9D_ADAPT_H__ */
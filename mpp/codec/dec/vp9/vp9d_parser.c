@@ -26,6 +26,7 @@
 #include "mpp_packet_impl.h"
 
 #include "vp9data.h"
+#include "vp9d_adapt.h"
 #include "vp9d_codec.h"
 #include "vp9d_parser.h"
 
@@ -1276,34 +1277,14 @@ static void adapt_prob(RK_U8 *p, RK_U32 ct0, RK_U32 ct1,
 
 static void adapt_probs(VP9Context *s)
 {
-    RK_S32 i, j, k, l, m;
+    RK_S32 i, j;
     prob_context *p = &s->prob_ctx[s->framectxid].p;
     RK_S32 uf = (s->keyframe || s->intraonly || !s->last_keyframe) ? 112 : 128;
 
     // coefficients
-    for (i = 0; i < 4; i++)
-        for (j = 0; j < 2; j++)
-            for (k = 0; k < 2; k++)
-                for (l = 0; l < 6; l++)
-                    for (m = 0; m < 6; m++) {
-                        RK_U8 *pp = s->prob_ctx[s->framectxid].coef[i][j][k][l][m];
-                        RK_U32 *e = s->counts.eob[i][j][k][l][m];
-                        RK_U32 *c = s->counts.coef[i][j][k][l][m];
-
-                        if (l == 0 && m >= 3) // dc only has 3 pt
-                            break;
-                        /*  if(i == 0 && j == 0 && k== 1 && l == 0){
-                             mpp_log("e[0] = 0x%x e[1] = 0x%x c[0] = 0x%x c[1] = 0x%x c[2] = 0x%x \n",
-                             e[0],e[1],c[0],c[1],c[2]);
-                             mpp_log("pp[0] = 0x%x pp[1] = 0x%x pp[2] = 0x%x",pp[0],pp[1],pp[2]);
-                          }*/
-                        adapt_prob(&pp[0], e[0], e[1], 24, uf);
-                        adapt_prob(&pp[1], c[0], c[1] + c[2], 24, uf);
-                        adapt_prob(&pp[2], c[1], c[2], 24, uf);
-                        /* if(i == 0 && j == 0 && k== 1 && l == 0){
-                            mpp_log("after pp[0] = 0x%x pp[1] = 0x%x pp[2] = 0x%x",pp[0],pp[1],pp[2]);
-                         }*/
-                    }
+    vp9d_adapt_coef_probs(&s->prob_ctx[s->framectxid].coef[0][0][0][0][0][0],
+                          &s->counts.coef[0][0][0][0][0][0],
+                          &s->counts.eob[0][0][0][0][0][0], uf);
 #ifdef dump
     fwrite(&s->counts, 1, sizeof(s->counts), vp9_p_fp);
     fflush(vp9_p_fp);
@@ -1671,12 +1652,16 @@ MPP_RET vp9d_paser_reset(Vp9CodecContext *ctx)
     }
     return MPP_OK;
 }
+/* hardware mode count index of each syntax intra mode */
+static const RK_U8 vp9_hw_mode_idx[10] = {
+    2, 0, 1, 3, 4, 5, 6, 8, 7, 9,
+};
+
 static void inv_count_data(VP9Context *s)
 {
     RK_U32 partition_probs[4][4][4];
     RK_U32 count_uv[10][10];
     RK_U32 count_y_mode[4][10];
-    RK_U32 *dst_uv = NULL;
     RK_S32 i, j;
 
     /*
@@ -1695,28 +1680,9 @@ static void inv_count_data(VP9Context *s)
     }
     if (!(s->keyframe || s->intraonly)) {
         memcpy(count_y_mode, s->counts.y_mode, sizeof(s->counts.y_mode));
-        for (i = 0; i < 4; i++) {
-            RK_U32 value = 0;
-            for (j = 0; j < 10; j++) {
-                value = count_y_mode[i][j];
-                if (j == 0)
-                    s->counts.y_mode[i][2] = value;
-                else if (j == 1)
-                    s->counts.y_mode[i][0] = value;
-                else if (j == 2)
-                    s->counts.y_mode[i][1] = value;
-                else if (j == 7)
-                    s->counts.y_mode[i][8] = value;
-                else if (j == 8)
-                    s->counts.y_mode[i][7] = value;
-                else
-                    s->counts.y_mode[i][j] = value;
-
-            }
-        }
-
-
-        memcpy(count_uv, s->counts.uv_mode, sizeof(s->counts.uv_mode));
+        for (i = 0; i < 4; i++)
+            for (j = 0; j < 10; j++)
+                s->counts.y_mode[i][vp9_hw_mode_idx[j]] = count_y_mode[i][j];
 
         /*change uv_mode to hardware need style*/
         /*
@@ -1732,38 +1698,12 @@ static void inv_count_data(VP9Context *s)
          *+++++ d207 ++++*    *++++ d63 ++++*
          *+++++ tm  ++++*     *++++ tm  ++++*
         */
+        memcpy(count_uv, s->counts.uv_mode, sizeof(s->counts.uv_mode));
         for (i = 0; i < 10; i++) {
-            RK_U32 *src_uv = (RK_U32 *)(count_uv[i]);
-            RK_U32 value = 0;
-            if (i == 0) {
-                dst_uv = s->counts.uv_mode[2]; //dc
-            } else if ( i == 1) {
-                dst_uv = s->counts.uv_mode[0]; //h
-            }  else if ( i == 2) {
-                dst_uv = s->counts.uv_mode[1]; //h
-            }  else if ( i == 7) {
-                dst_uv = s->counts.uv_mode[8]; //d207
-            } else if (i == 8) {
-                dst_uv = s->counts.uv_mode[7]; //d63
-            } else {
-                dst_uv = s->counts.uv_mode[i];
-            }
-            for (j = 0; j < 10; j++) {
-                value = src_uv[j];
-                if (j == 0)
-                    dst_uv[2] = value;
-                else if (j == 1)
-                    dst_uv[0] = value;
-                else if (j == 2)
-                    dst_uv[1] = value;
-                else if (j == 7)
-                    dst_uv[8] = value;
-                else if (j == 8)
-                    dst_uv[7] = value;
-                else
-                    dst_uv[j] = value;
-            }
+            RK_U32 *dst_uv = s->counts.uv_mode[vp9_hw_mode_idx[i]];
 
+            for (j = 0; j < 10; j++)
+                dst_uv[vp9_hw_mode_idx[j]] = count_uv[i][j];
         }
     }
 }
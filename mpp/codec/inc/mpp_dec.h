@@ -26,6 +26,7 @@ typedef void* MppDec;
 typedef struct {
     MppCodingType       coding;
     RK_U32              fast_mode;
+    RK_U32              batch_depth;
     RK_U32              need_split;
     RK_U32              internal_pts;
     RK_U32              immedaite_out;
@@ -45,6 +46,7 @@ MPP_RET mpp_dec_stop(MppDec ctx);
 MPP_RET mpp_dec_reset(MppDec ctx);
 MPP_RET mpp_dec_flush(MppDec ctx);
 MPP_RET mpp_dec_control(MppDec ctx, MpiCmd cmd, void *param);
+MPP_RET mpp_dec_get_stats(MppDec ctx, MppStats *stats);
 MPP_RET mpp_dec_notify(MppDec ctx, RK_U32 flag);
 
 #ifdef __cplusplus
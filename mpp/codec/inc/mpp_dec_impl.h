@@ -40,6 +40,61 @@ typedef enum MppDecTimingType_e {
     DEC_TIMING_BUTT,
 } MppDecTimingType;
 
+typedef union PaserTaskWait_u {
+    RK_U32          val;
+    struct {
+        RK_U32      dec_pkt_in      : 1;   // 0x0001 MPP_DEC_NOTIFY_PACKET_ENQUEUE
+        RK_U32      dis_que_full    : 1;   // 0x0002 MPP_DEC_NOTIFY_FRAME_DEQUEUE
+        RK_U32      reserv0004      : 1;   // 0x0004
+        RK_U32      reserv0008      : 1;   // 0x0008
+
+        RK_U32      ext_buf_grp     : 1;   // 0x0010 MPP_DEC_NOTIFY_EXT_BUF_GRP_READY
+        RK_U32      info_change     : 1;   // 0x0020 MPP_DEC_NOTIFY_INFO_CHG_DONE
+        RK_U32      dec_pic_unusd   : 1;   // 0x0040 MPP_DEC_NOTIFY_BUFFER_VALID
+        RK_U32      dec_all_done    : 1;   // 0x0080 MPP_DEC_NOTIFY_TASK_ALL_DONE
+
+        RK_U32      task_hnd        : 1;   // 0x0100 MPP_DEC_NOTIFY_TASK_HND_VALID
+        RK_U32      prev_task       : 1;   // 0x0200 MPP_DEC_NOTIFY_TASK_PREV_DONE
+        RK_U32      dec_pic_match   : 1;   // 0x0400 MPP_DEC_NOTIFY_BUFFER_MATCH
+        RK_U32      reserv0800      : 1;   // 0x0800
+
+        RK_U32      dec_pkt_idx     : 1;   // 0x1000
+        RK_U32      dec_pkt_buf     : 1;   // 0x2000
+        RK_U32      dec_slot_idx    : 1;   // 0x4000
+    };
+} PaserTaskWait;
+
+typedef union DecTaskStatus_u {
+    RK_U32          val;
+    struct {
+        RK_U32      task_hnd_rdy      : 1;
+        RK_U32      mpp_pkt_in_rdy    : 1;
+        RK_U32      dec_pkt_idx_rdy   : 1;
+        RK_U32      dec_pkt_buf_rdy   : 1;
+        RK_U32      task_valid_rdy    : 1;
+        RK_U32      dec_pkt_copy_rdy  : 1;
+        RK_U32      prev_task_rdy     : 1;
+        RK_U32      info_task_gen_rdy : 1;
+        RK_U32      curr_task_rdy     : 1;
+        RK_U32      task_parsed_rdy   : 1;
+    };
+} DecTaskStatus;
+
+typedef struct DecTask_t {
+    HalTaskHnd      hnd;
+
+    DecTaskStatus   status;
+    PaserTaskWait   wait;
+
+    RK_S32          hal_pkt_idx_in;
+    RK_S32          hal_frm_idx_out;
+
+    MppBuffer       hal_pkt_buf_in;
+    MppBuffer       hal_frm_buf_out;
+
+    HalTaskInfo     info;
+} DecTask;
+
 typedef struct MppDecImpl_t {
     MppCodingType       coding;
 
@@ -89,6 +144,9 @@ typedef struct MppDecImpl_t {
 
     // dec parser thread runtime resource context
     MppPacket           mpp_pkt_in;
+    DecTask             parser_task;
+    // dec hal thread runtime resource context
+    HalTaskHnd          hal_task;
     void                *mpp;
     void                *vproc;
 
@@ -177,6 +177,7 @@ MPP_RET mpp_enc_start_v2(MppEnc ctx);
 MPP_RET mpp_enc_stop_v2(MppEnc ctx);
 
 MPP_RET mpp_enc_control_v2(MppEnc ctx, MpiCmd cmd, void *param);
+MPP_RET mpp_enc_get_stats_v2(MppEnc ctx, MppStats *stats);
 MPP_RET mpp_enc_notify_v2(MppEnc ctx, RK_U32 flag);
 MPP_RET mpp_enc_reset_v2(MppEnc ctx);
 
@@ -22,6 +22,8 @@
 #include "mpp_mem.h"
 #include "mpp_log.h"
 #include "mpp_time.h"
+#include "mpp_sched.h"
+#include "mpp_trace.h"
 
 #include "mpp.h"
 #include "mpp_dec_impl.h"
@@ -49,61 +51,6 @@ static RK_U32 mpp_dec_debug = 0;
 #define dec_dbg_reset(fmt, ...)         mpp_dec_dbg(MPP_DEC_DBG_RESET, fmt, ## __VA_ARGS__)
 #define dec_dbg_notify(fmt, ...)        mpp_dec_dbg_f(MPP_DEC_DBG_NOTIFY, fmt, ## __VA_ARGS__)
 
-typedef union PaserTaskWait_u {
-    RK_U32          val;
-    struct {
-        RK_U32      dec_pkt_in      : 1;   // 0x0001 MPP_DEC_NOTIFY_PACKET_ENQUEUE
-        RK_U32      dis_que_full    : 1;   // 0x0002 MPP_DEC_NOTIFY_FRAME_DEQUEUE
-        RK_U32      reserv0004      : 1;   // 0x0004
-        RK_U32      reserv0008      : 1;   // 0x0008
-
-        RK_U32      ext_buf_grp     : 1;   // 0x0010 MPP_DEC_NOTIFY_EXT_BUF_GRP_READY
-        RK_U32      info_change     : 1;   // 0x0020 MPP_DEC_NOTIFY_INFO_CHG_DONE
-        RK_U32      dec_pic_unusd   : 1;   // 0x0040 MPP_DEC_NOTIFY_BUFFER_VALID
-        RK_U32      dec_all_done    : 1;   // 0x0080 MPP_DEC_NOTIFY_TASK_ALL_DONE
-
-        RK_U32      task_hnd        : 1;   // 0x0100 MPP_DEC_NOTIFY_TASK_HND_VALID
-        RK_U32      prev_task       : 1;   // 0x0200 MPP_DEC_NOTIFY_TASK_PREV_DONE
-        RK_U32      dec_pic_match   : 1;   // 0x0400 MPP_DEC_NOTIFY_BUFFER_MATCH
-        RK_U32      reserv0800      : 1;   // 0x0800
-
-        RK_U32      dec_pkt_idx     : 1;   // 0x1000
-        RK_U32      dec_pkt_buf     : 1;   // 0x2000
-        RK_U32      dec_slot_idx    : 1;   // 0x4000
-    };
-} PaserTaskWait;
-
-typedef union DecTaskStatus_u {
-    RK_U32          val;
-    struct {
-        RK_U32      task_hnd_rdy      : 1;
-        RK_U32      mpp_pkt_in_rdy    : 1;
-        RK_U32      dec_pkt_idx_rdy   : 1;
-        RK_U32      dec_pkt_buf_rdy   : 1;
-        RK_U32      task_valid_rdy    : 1;
-        RK_U32      dec_pkt_copy_rdy  : 1;
-        RK_U32      prev_task_rdy     : 1;
-        RK_U32      info_task_gen_rdy : 1;
-        RK_U32      curr_task_rdy     : 1;
-        RK_U32      task_parsed_rdy   : 1;
-    };
-} DecTaskStatus;
-
-typedef struct DecTask_t {
-    HalTaskHnd      hnd;
-
-    DecTaskStatus   status;
-    PaserTaskWait   wait;
-
-    RK_S32          hal_pkt_idx_in;
-    RK_S32          hal_frm_idx_out;
-
-    MppBuffer       hal_pkt_buf_in;
-    MppBuffer       hal_frm_buf_out;
-
-    HalTaskInfo     info;
-} DecTask;
-
 static void dec_task_init(DecTask *task)
 {
     task->hnd = NULL;
@@ -176,7 +123,7 @@ static RK_U32 reset_parser_thread(Mpp *mpp, DecTask *task)
     hal->signal();
     hal->unlock();
 
-    sem_wait(&dec->hal_reset);
+    mpp_sched_sem_wait(&dec->hal_reset);
 
     dec_dbg_reset("reset: parser check hal proc task empty start\n");
 
@@ -384,7 +331,7 @@ static void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
         dec_vproc_signal(dec->vproc);
     } else {
         // direct output -> copy a new MppFrame and output
-        mpp_list *list = mpp->mFrames;
+        MppSpscQueue *frames = mpp->mFrames;
         MppFrame out = NULL;
 
         mpp_frame_init(&out);
@@ -393,11 +340,11 @@ static void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
         if (mpp_debug & MPP_DBG_PTS)
             mpp_log("output frame pts %lld\n", mpp_frame_get_pts(out));
 
-        list->lock();
-        list->add_at_tail(&out, sizeof(out));
+        /* queue room is far beyond display queue limit, just in case */
+        while (frames->push(out))
+            msleep(1);
+        mpp_trace_mark("dec_frame_out", mpp, mpp->mFramePutCount, index, 0);
         mpp->mFramePutCount++;
-        list->signal();
-        list->unlock();
 
         if (fake_frame)
             mpp_frame_deinit(&frame);
@@ -507,16 +454,12 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
      * 2. get packet for parser preparing
      */
     if (!dec->mpp_pkt_in && !task->status.curr_task_rdy) {
-        mpp_list *packets = mpp->mPackets;
-        AutoMutex autolock(packets->mutex());
-
-        if (!packets->list_size()) {
+        if (mpp->mPackets->pop(&dec->mpp_pkt_in)) {
             task->wait.dec_pkt_in = 1;
             return MPP_NOK;
         }
 
         task->wait.dec_pkt_in = 0;
-        packets->del_at_head(&dec->mpp_pkt_in, sizeof(dec->mpp_pkt_in));
         mpp->mPacketGetCount++;
 
         if (dec->use_preset_time_order) {
@@ -528,7 +471,15 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
             if (pkt_in) {
                 mpp_packet_set_pts(pkt_in, mpp_packet_get_pts(dec->mpp_pkt_in));
                 mpp_packet_set_dts(pkt_in, mpp_packet_get_dts(dec->mpp_pkt_in));
-                ts->add_at_tail(&pkt_in, sizeof(pkt_in));
+                /* drop the oldest timestamp never matched by output frame */
+                if (ts->add_at_tail(&pkt_in, sizeof(pkt_in))) {
+                    MppPacket pkt_old = NULL;
+
+                    mpp_err_f("timestamp queue full drop the oldest one\n");
+                    ts->del_at_head(&pkt_old, sizeof(pkt_old));
+                    mpp_packet_deinit(&pkt_old);
+                    ts->add_at_tail(&pkt_in, sizeof(pkt_in));
+                }
             }
         }
     }
@@ -563,9 +514,15 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
             mpp_log("input packet pts %lld\n",
                     mpp_packet_get_pts(dec->mpp_pkt_in));
 
+        RK_S64 trace_ts = mpp_trace_ts();
+        RK_S32 length = (RK_S32)mpp_packet_get_length(dec->mpp_pkt_in);
+
         mpp_clock_start(dec->clocks[DEC_PRS_PREPARE]);
         mpp_parser_prepare(dec->parser, dec->mpp_pkt_in, task_dec);
         mpp_clock_pause(dec->clocks[DEC_PRS_PREPARE]);
+        mpp_trace_span("dec_prepare", mpp, mpp->mPacketGetCount, -1,
+                       length - (RK_S32)mpp_packet_get_length(dec->mpp_pkt_in),
+                       trace_ts);
 
         if (0 == mpp_packet_get_length(dec->mpp_pkt_in)) {
             mpp_packet_deinit(&dec->mpp_pkt_in);
@@ -666,7 +623,7 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
 
     /* too many frame delay in dispaly queue */
     if (mpp->mFrames) {
-        task->wait.dis_que_full = (mpp->mFrames->list_size() > 4) ? 1 : 0;
+        task->wait.dis_que_full = (mpp->mFrames->size() > (RK_S32)mpp->mOutputQueueDepth) ? 1 : 0;
         if (task->wait.dis_que_full)
             return MPP_ERR_DISPLAY_FULL;
     }
@@ -692,9 +649,13 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
      *    4. detect whether output index has MppBuffer and task valid
      */
     if (!task->status.task_parsed_rdy) {
+        RK_S64 trace_ts = mpp_trace_ts();
+
         mpp_clock_start(dec->clocks[DEC_PRS_PARSE]);
         mpp_parser_parse(dec->parser, task_dec);
         mpp_clock_pause(dec->clocks[DEC_PRS_PARSE]);
+        mpp_trace_span("dec_parse", mpp, mpp->mTaskPutCount, task_dec->output,
+                       0, trace_ts);
         task->status.task_parsed_rdy = 1;
     }
 
@@ -757,6 +718,7 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     if (NULL == mpp->mFrameGroup) {
         mpp_log("mpp_dec use internal frame buffer group\n");
         mpp_buffer_group_get_internal(&mpp->mFrameGroup, MPP_BUFFER_TYPE_ION);
+        mpp_buffer_group_env_placement((MppBufferGroupImpl *)mpp->mFrameGroup);
     }
 
     /* 10.1 look for a unused hardware buffer for output */
@@ -800,14 +762,19 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
         return MPP_NOK;
 
     /* generating registers table */
+    RK_S64 trace_ts = mpp_trace_ts();
+
     mpp_clock_start(dec->clocks[DEC_HAL_GEN_REG]);
     mpp_hal_reg_gen(dec->hal, &task->info);
     mpp_clock_pause(dec->clocks[DEC_HAL_GEN_REG]);
+    mpp_trace_span("dec_gen_reg", mpp, mpp->mTaskPutCount, output, 0, trace_ts);
 
     /* send current register set to hardware */
+    trace_ts = mpp_trace_ts();
     mpp_clock_start(dec->clocks[DEC_HW_START]);
     mpp_hal_hw_start(dec->hal, &task->info);
     mpp_clock_pause(dec->clocks[DEC_HW_START]);
+    mpp_trace_span("dec_hw_start", mpp, mpp->mTaskPutCount, output, 0, trace_ts);
 
     /*
      * 12. send dxva output information and buffer information to hal thread
@@ -829,204 +796,174 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     return MPP_OK;
 }
 
-void *mpp_dec_parser_thread(void *data)
+/*
+ * parser thread need to wait at cases below:
+ * 1. no task slot for output
+ * 2. no packet for parsing
+ * 3. info change on progress
+ * 3. no buffer on analyzing output task
+ */
+static RK_S32 mpp_dec_parser_check(void *data)
 {
     Mpp *mpp = (Mpp*)data;
     MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
-    MppThread *parser = dec->thread_parser;
-    MppBufSlots packet_slots = dec->packet_slots;
 
-    DecTask task;
-    HalDecTask  *task_dec = &task.info.dec;
+    if (check_task_wait(dec, &dec->parser_task)) {
+        mpp_clock_start(dec->clocks[DEC_PRS_WAIT]);
+        return MPP_NOK;
+    }
+
+    mpp_clock_pause(dec->clocks[DEC_PRS_WAIT]);
+    return MPP_OK;
+}
 
-    dec_task_init(&task);
+static void mpp_dec_parser_work(void *data)
+{
+    Mpp *mpp = (Mpp*)data;
+    MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
+    MppThread *parser = dec->thread_parser;
 
-    mpp_clock_start(dec->clocks[DEC_PRS_TOTAL]);
+    if (dec->reset_flag) {
+        reset_parser_thread(mpp, &dec->parser_task);
 
-    while (1) {
-        {
-            AutoMutex autolock(parser->mutex());
-            if (MPP_THREAD_RUNNING != parser->get_status())
-                break;
+        AutoMutex autolock(parser->mutex(THREAD_CONTROL));
+        dec->reset_flag = 0;
+        sem_post(&dec->parser_reset);
+        return;
+    }
 
-            /*
-             * parser thread need to wait at cases below:
-             * 1. no task slot for output
-             * 2. no packet for parsing
-             * 3. info change on progress
-             * 3. no buffer on analyzing output task
-             */
-            if (check_task_wait(dec, &task)) {
-                mpp_clock_start(dec->clocks[DEC_PRS_WAIT]);
-                parser->wait();
-                mpp_clock_pause(dec->clocks[DEC_PRS_WAIT]);
-            }
-        }
+    // NOTE: ignore return value here is to fast response to reset.
+    // Otherwise we can loop all dec task until it is failed.
+    mpp_clock_start(dec->clocks[DEC_PRS_PROC]);
+    try_proc_dec_task(mpp, &dec->parser_task);
+    mpp_clock_pause(dec->clocks[DEC_PRS_PROC]);
+}
 
-        if (dec->reset_flag) {
-            reset_parser_thread(mpp, &task);
+/* hal thread wait for dxva interface intput first */
+static RK_S32 mpp_dec_hal_check(void *data)
+{
+    Mpp *mpp = (Mpp*)data;
+    MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
 
-            AutoMutex autolock(parser->mutex(THREAD_CONTROL));
-            dec->reset_flag = 0;
-            sem_post(&dec->parser_reset);
+    while (hal_task_get_hnd(dec->tasks, TASK_PROCESSING, &dec->hal_task)) {
+        // process all task then do reset process
+        if (dec->hal_reset_post != dec->hal_reset_done) {
+            dec_dbg_reset("reset: hal reset start\n");
+            reset_hal_thread(mpp);
+            dec_dbg_reset("reset: hal reset done\n");
+            dec->hal_reset_done++;
+            sem_post(&dec->hal_reset);
             continue;
         }
 
-        // NOTE: ignore return value here is to fast response to reset.
-        // Otherwise we can loop all dec task until it is failed.
-        mpp_clock_start(dec->clocks[DEC_PRS_PROC]);
-        try_proc_dec_task(mpp, &task);
-        mpp_clock_pause(dec->clocks[DEC_PRS_PROC]);
+        mpp_dec_notify(dec, MPP_DEC_NOTIFY_TASK_ALL_DONE);
+        mpp_clock_start(dec->clocks[DEC_HAL_WAIT]);
+        return MPP_NOK;
     }
 
-    mpp_clock_pause(dec->clocks[DEC_PRS_TOTAL]);
-
-    mpp_dbg(MPP_DBG_INFO, "mpp_dec_parser_thread is going to exit\n");
-    if (task.hnd && task_dec->valid) {
-        mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
-        mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
-        mpp_buf_slot_clr_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
-    }
-    mpp_buffer_group_clear(mpp->mPacketGroup);
-    mpp_dbg(MPP_DBG_INFO, "mpp_dec_parser_thread exited\n");
-    return NULL;
+    mpp_clock_pause(dec->clocks[DEC_HAL_WAIT]);
+    return MPP_OK;
 }
 
-void *mpp_dec_hal_thread(void *data)
+static void mpp_dec_hal_work(void *data)
 {
     Mpp *mpp = (Mpp*)data;
     MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
-    MppThread *hal = dec->thread_hal;
-    HalTaskGroup tasks = dec->tasks;
     MppBufSlots frame_slots = dec->frame_slots;
     MppBufSlots packet_slots = dec->packet_slots;
-
-    HalTaskHnd  task = NULL;
+    HalTaskHnd  task = dec->hal_task;
     HalTaskInfo task_info;
     HalDecTask  *task_dec = &task_info.dec;
+    RK_U32 notify_flag = MPP_DEC_NOTIFY_TASK_HND_VALID;
 
-    mpp_clock_start(dec->clocks[DEC_HAL_TOTAL]);
+    if (NULL == task)
+        return;
 
-    while (1) {
-        /* hal thread wait for dxva interface intput first */
-        {
-            AutoMutex work_lock(hal->mutex());
-            if (MPP_THREAD_RUNNING != hal->get_status())
-                break;
-
-            if (hal_task_get_hnd(tasks, TASK_PROCESSING, &task)) {
-                // process all task then do reset process
-                if (dec->hal_reset_post != dec->hal_reset_done) {
-                    dec_dbg_reset("reset: hal reset start\n");
-                    reset_hal_thread(mpp);
-                    dec_dbg_reset("reset: hal reset done\n");
-                    dec->hal_reset_done++;
-                    sem_post(&dec->hal_reset);
-                    continue;
-                }
+    dec->hal_task = NULL;
 
-                mpp_dec_notify(dec, MPP_DEC_NOTIFY_TASK_ALL_DONE);
-                mpp_clock_start(dec->clocks[DEC_HAL_WAIT]);
-                hal->wait();
-                mpp_clock_pause(dec->clocks[DEC_HAL_WAIT]);
-                continue;
-            }
-        }
+    mpp_clock_start(dec->clocks[DEC_HAL_PROC]);
+    mpp->mTaskGetCount++;
 
-        if (task) {
-            RK_U32 notify_flag = MPP_DEC_NOTIFY_TASK_HND_VALID;
+    hal_task_hnd_get_info(task, &task_info);
 
-            mpp_clock_start(dec->clocks[DEC_HAL_PROC]);
-            mpp->mTaskGetCount++;
-
-            hal_task_hnd_get_info(task, &task_info);
-
-            /*
-             * check info change flag
-             * if this is a frame with that flag, only output an empty
-             * MppFrame without any image data for info change.
-             */
-            if (task_dec->flags.info_change) {
-                mpp_dec_flush(dec);
-                mpp_dec_push_display(mpp, task_dec->flags);
-                mpp_dec_put_frame(mpp, task_dec->output, task_dec->flags);
-
-                hal_task_hnd_set_status(task, TASK_IDLE);
-                task = NULL;
-                mpp_dec_notify(dec, notify_flag);
-                mpp_clock_pause(dec->clocks[DEC_HAL_PROC]);
-                continue;
-            }
-            /*
-             * check eos task
-             * if this task is invalid while eos flag is set, we will
-             * flush display queue then push the eos frame to info that
-             * all frames have decoded.
-             */
-            if (task_dec->flags.eos &&
-                (!task_dec->valid || task_dec->output < 0)) {
-                mpp_dec_push_display(mpp, task_dec->flags);
-                /*
-                 * Use -1 as invalid buffer slot index.
-                 * Reason: the last task maybe is a empty task with eos flag
-                 * only but this task may go through vproc process also. We need
-                 * create a buffer slot index for it.
-                 */
-                mpp_dec_put_frame(mpp, -1, task_dec->flags);
-
-                hal_task_hnd_set_status(task, TASK_IDLE);
-                task = NULL;
-                mpp_dec_notify(dec, notify_flag);
-                mpp_clock_pause(dec->clocks[DEC_HAL_PROC]);
-                continue;
-            }
+    /*
+     * check info change flag
+     * if this is a frame with that flag, only output an empty
+     * MppFrame without any image data for info change.
+     */
+    if (task_dec->flags.info_change) {
+        mpp_dec_flush(dec);
+        mpp_dec_push_display(mpp, task_dec->flags);
+        mpp_dec_put_frame(mpp, task_dec->output, task_dec->flags);
+
+        hal_task_hnd_set_status(task, TASK_IDLE);
+        mpp_dec_notify(dec, notify_flag);
+        mpp_clock_pause(dec->clocks[DEC_HAL_PROC]);
+        return;
+    }
+    /*
+     * check eos task
+     * if this task is invalid while eos flag is set, we will
+     * flush display queue then push the eos frame to info that
+     * all frames have decoded.
+     */
+    if (task_dec->flags.eos &&
+        (!task_dec->valid || task_dec->output < 0)) {
+        mpp_dec_push_display(mpp, task_dec->flags);
+        /*
+         * Use -1 as invalid buffer slot index.
+         * Reason: the last task maybe is a empty task with eos flag
+         * only but this task may go through vproc process also. We need
+         * create a buffer slot index for it.
+         */
+        mpp_dec_put_frame(mpp, -1, task_dec->flags);
 
-            mpp_clock_start(dec->clocks[DEC_HW_WAIT]);
-            mpp_hal_hw_wait(dec->hal, &task_info);
-            mpp_clock_pause(dec->clocks[DEC_HW_WAIT]);
+        hal_task_hnd_set_status(task, TASK_IDLE);
+        mpp_dec_notify(dec, notify_flag);
+        mpp_clock_pause(dec->clocks[DEC_HAL_PROC]);
+        return;
+    }
 
-            /*
-             * when hardware decoding is done:
-             * 1. clear decoding flag (mark buffer is ready)
-             * 2. use get_display to get a new frame with buffer
-             * 3. add frame to output list
-             * repeat 2 and 3 until not frame can be output
-             */
-            mpp_buf_slot_clr_flag(packet_slots, task_dec->input,
-                                  SLOT_HAL_INPUT);
+    RK_S64 trace_ts = mpp_trace_ts();
 
-            hal_task_hnd_set_status(task, (dec->parser_fast_mode) ?
-                                    (TASK_IDLE) : (TASK_PROC_DONE));
+    mpp_clock_start(dec->clocks[DEC_HW_WAIT]);
+    mpp_hal_hw_wait(dec->hal, &task_info);
+    mpp_clock_pause(dec->clocks[DEC_HW_WAIT]);
+    mpp_trace_span("dec_hw_wait", mpp, mpp->mTaskGetCount - 1,
+                   task_dec->output, 0, trace_ts);
 
-            if (dec->parser_fast_mode)
-                notify_flag |= MPP_DEC_NOTIFY_TASK_HND_VALID;
-            else
-                notify_flag |= MPP_DEC_NOTIFY_TASK_PREV_DONE;
+    /*
+     * when hardware decoding is done:
+     * 1. clear decoding flag (mark buffer is ready)
+     * 2. use get_display to get a new frame with buffer
+     * 3. add frame to output list
+     * repeat 2 and 3 until not frame can be output
+     */
+    mpp_buf_slot_clr_flag(packet_slots, task_dec->input,
+                          SLOT_HAL_INPUT);
 
-            task = NULL;
+    hal_task_hnd_set_status(task, (dec->parser_fast_mode) ?
+                            (TASK_IDLE) : (TASK_PROC_DONE));
 
-            if (task_dec->output >= 0)
-                mpp_buf_slot_clr_flag(frame_slots, task_dec->output, SLOT_HAL_OUTPUT);
+    if (dec->parser_fast_mode)
+        notify_flag |= MPP_DEC_NOTIFY_TASK_HND_VALID;
+    else
+        notify_flag |= MPP_DEC_NOTIFY_TASK_PREV_DONE;
 
-            for (RK_U32 i = 0; i < MPP_ARRAY_ELEMS(task_dec->refer); i++) {
-                RK_S32 index = task_dec->refer[i];
-                if (index >= 0)
-                    mpp_buf_slot_clr_flag(frame_slots, index, SLOT_HAL_INPUT);
-            }
-            if (task_dec->flags.eos)
-                mpp_dec_flush(dec);
-            mpp_dec_push_display(mpp, task_dec->flags);
+    if (task_dec->output >= 0)
+        mpp_buf_slot_clr_flag(frame_slots, task_dec->output, SLOT_HAL_OUTPUT);
 
-            mpp_dec_notify(dec, notify_flag);
-            mpp_clock_pause(dec->clocks[DEC_HAL_PROC]);
-        }
+    for (RK_U32 i = 0; i < MPP_ARRAY_ELEMS(task_dec->refer); i++) {
+        RK_S32 index = task_dec->refer[i];
+        if (index >= 0)
+            mpp_buf_slot_clr_flag(frame_slots, index, SLOT_HAL_INPUT);
     }
+    if (task_dec->flags.eos)
+        mpp_dec_flush(dec);
+    mpp_dec_push_display(mpp, task_dec->flags);
 
-    mpp_clock_pause(dec->clocks[DEC_HAL_TOTAL]);
-
-    mpp_assert(mpp->mTaskPutCount == mpp->mTaskGetCount);
-    mpp_dbg(MPP_DBG_INFO, "mpp_dec_hal_thread exited\n");
-    return NULL;
+    mpp_dec_notify(dec, notify_flag);
+    mpp_clock_pause(dec->clocks[DEC_HAL_PROC]);
 }
 
 static MPP_RET dec_release_task_in_port(MppPort port)
@@ -1235,17 +1172,17 @@ void *mpp_dec_advanced_thread(void *data)
 
 static const char *timing_str[DEC_TIMING_BUTT] = {
     "prs thread",
-    "prs wait  ",
-    "prs proc  ",
-    "prepare   ",
-    "parse     ",
-    "gen reg   ",
-    "hw start  ",
+    "prs wait",
+    "prs proc",
+    "prepare",
+    "parse",
+    "gen reg",
+    "hw start",
 
     "hal thread",
-    "hal wait  ",
-    "hal proc  ",
-    "hw wait   ",
+    "hal wait",
+    "hal proc",
+    "hw wait",
 };
 
 MPP_RET mpp_dec_init(MppDec *dec, MppDecCfg *cfg)
@@ -1278,7 +1215,12 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecCfg *cfg)
     }
 
     coding = cfg->coding;
-    hal_task_count = (cfg->fast_mode) ? (3) : (2);
+    /*
+     * fast mode lets parser run ahead of hardware by hal_task_count - 1 tasks
+     * and batch depth deepens the task queue for small and high fps stream
+     */
+    hal_task_count = (cfg->fast_mode) ?
+                     MPP_CLIP3(3, MPP_HAL_DEC_TASK_MAX, (RK_S32)cfg->batch_depth) : (2);
 
     do {
         ret = mpp_buf_slot_init(&frame_slots);
@@ -1348,10 +1290,11 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecCfg *cfg)
 
         p->statistics_en        = (mpp_dec_debug & MPP_DEC_DBG_TIMING) ? 1 : 0;
 
+        /* clocks are always on for MPP_GET_STATS, statistics_en only logs them */
         for (i = 0; i < DEC_TIMING_BUTT; i++) {
             p->clocks[i] = mpp_clock_get(timing_str[i]);
             mpp_assert(p->clocks[i]);
-            mpp_clock_enable(p->clocks[i], p->statistics_en);
+            mpp_clock_enable(p->clocks[i], 1);
         }
 
         sem_init(&p->parser_reset, 0, 0);
@@ -1390,9 +1333,10 @@ MPP_RET mpp_dec_deinit(MppDec ctx)
             if (!time || !total)
                 continue;
 
-            mpp_log("%p %s - %6.2f %-12lld avg %-12lld\n", dec,
-                    mpp_clock_get_name(timer), time * 100.0 / total, time,
-                    time / mpp_clock_get_count(timer));
+            mpp_log("%p %-10s - %6.2f %-12lld avg %-8lld p99 %-8lld max %lld\n",
+                    dec, mpp_clock_get_name(timer), time * 100.0 / total, time,
+                    time / mpp_clock_get_count(timer),
+                    mpp_clock_get_percentile(timer, 99), mpp_clock_get_max(timer));
         }
     }
 
@@ -1442,11 +1386,22 @@ MPP_RET mpp_dec_start(MppDec ctx)
     dec_dbg_func("%p in\n", dec);
 
     if (dec->coding != MPP_VIDEO_CodingMJPEG) {
-        dec->thread_parser = new MppThread(mpp_dec_parser_thread,
+        dec_task_init(&dec->parser_task);
+        dec->hal_task = NULL;
+
+        dec->thread_parser = new MppThread(mpp_dec_parser_check,
+                                           mpp_dec_parser_work,
                                            dec->mpp, "mpp_dec_parser");
-        dec->thread_hal = new MppThread(mpp_dec_hal_thread,
+        dec->thread_hal = new MppThread(mpp_dec_hal_check,
+                                        mpp_dec_hal_work,
                                         dec->mpp, "mpp_dec_hal");
 
+        /* wait clock is paused on the first check */
+        mpp_clock_start(dec->clocks[DEC_PRS_TOTAL]);
+        mpp_clock_start(dec->clocks[DEC_PRS_WAIT]);
+        mpp_clock_start(dec->clocks[DEC_HAL_TOTAL]);
+        mpp_clock_start(dec->clocks[DEC_HAL_WAIT]);
+
         dec->thread_parser->start();
         dec->thread_hal->start();
     } else {
@@ -1472,6 +1427,25 @@ MPP_RET mpp_dec_stop(MppDec ctx)
     if (dec->thread_hal)
         dec->thread_hal->stop();
 
+    if (dec->coding != MPP_VIDEO_CodingMJPEG && dec->thread_parser) {
+        Mpp *mpp = (Mpp *)dec->mpp;
+        DecTask *task = &dec->parser_task;
+        HalDecTask *task_dec = &task->info.dec;
+        MppBufSlots packet_slots = dec->packet_slots;
+
+        mpp_clock_pause(dec->clocks[DEC_PRS_TOTAL]);
+        mpp_clock_pause(dec->clocks[DEC_HAL_TOTAL]);
+
+        if (task->hnd && task_dec->valid) {
+            mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
+            mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
+            mpp_buf_slot_clr_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
+        }
+        mpp_buffer_group_clear(mpp->mPacketGroup);
+
+        mpp_assert(mpp->mTaskPutCount == mpp->mTaskGetCount);
+    }
+
     if (dec->thread_parser) {
         delete dec->thread_parser;
         dec->thread_parser = NULL;
@@ -1552,6 +1526,86 @@ MPP_RET mpp_dec_notify(MppDec ctx, RK_U32 flag)
     return MPP_OK;
 }
 
+MPP_RET mpp_dec_get_stats(MppDec ctx, MppStats *stats)
+{
+    MppDecImpl *dec = (MppDecImpl *)ctx;
+    RK_S32 i;
+
+    if (NULL == dec || NULL == stats) {
+        mpp_err_f("found NULL input dec %p stats %p\n", dec, stats);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    for (i = 0; i < DEC_TIMING_BUTT; i++) {
+        MppClock timer = dec->clocks[i];
+        MppStageStat *stage = NULL;
+        RK_S64 count;
+
+        /* thread total clocks are wall time totals without per call samples */
+        if (i == DEC_PRS_TOTAL || i == DEC_HAL_TOTAL)
+            continue;
+
+        if (stats->stage_count >= MPP_STATS_STAGE_MAX)
+            break;
+
+        stage = &stats->stages[stats->stage_count++];
+        count = mpp_clock_get_count(timer);
+
+        snprintf(stage->name, sizeof(stage->name), "dec %s", mpp_clock_get_name(timer));
+        stage->count = count;
+        stage->avg = count ? mpp_clock_get_sum(timer) / count : 0;
+        stage->p50 = mpp_clock_get_percentile(timer, 50);
+        stage->p90 = mpp_clock_get_percentile(timer, 90);
+        stage->p99 = mpp_clock_get_percentile(timer, 99);
+        stage->max = mpp_clock_get_max(timer);
+    }
+
+    if (dec->parser)
+        mpp_parser_control(dec->parser, MPP_GET_STATS, stats);
+
+    return MPP_OK;
+}
+
+static MPP_RET mpp_dec_pre_alloc_buff(MppDecImpl *dec, MppDecPreAlloc *cfg)
+{
+    Mpp *mpp = (Mpp *)dec->mpp;
+    MppFrame frame = NULL;
+    size_t size = 0;
+    MPP_RET ret = MPP_OK;
+
+    if (NULL == cfg || cfg->width <= 0 || cfg->height <= 0 || cfg->count <= 0) {
+        mpp_err_f("invalid pre alloc config %p\n", cfg);
+        return MPP_ERR_VALUE;
+    }
+
+    /* same as the parser thread on first frame buffer request */
+    if (NULL == mpp->mFrameGroup) {
+        mpp_log("mpp_dec use internal frame buffer group\n");
+        mpp_buffer_group_get_internal(&mpp->mFrameGroup, MPP_BUFFER_TYPE_ION);
+        if (NULL == mpp->mFrameGroup)
+            return MPP_ERR_MALLOC;
+
+        mpp_buffer_group_env_placement((MppBufferGroupImpl *)mpp->mFrameGroup);
+    }
+
+    ret = mpp_frame_init(&frame);
+    if (ret)
+        return ret;
+
+    mpp_frame_set_width(frame, cfg->width);
+    mpp_frame_set_height(frame, cfg->height);
+    mpp_frame_set_fmt(frame, (MppFrameFormat)cfg->format);
+    size = mpp_buf_slot_calc_size(dec->frame_slots, frame);
+    mpp_frame_deinit(&frame);
+
+    ret = mpp_buffer_group_prealloc(mpp->mFrameGroup, size, cfg->count);
+
+    mpp_log("pre alloc %d frame buffers w %d h %d fmt %x size %d ret %d\n",
+            cfg->count, cfg->width, cfg->height, cfg->format, size, ret);
+
+    return ret;
+}
+
 MPP_RET mpp_dec_control(MppDec ctx, MpiCmd cmd, void *param)
 {
     MPP_RET ret = MPP_OK;
@@ -1598,6 +1652,9 @@ MPP_RET mpp_dec_control(MppDec ctx, MpiCmd cmd, void *param)
         dec->enable_deinterlace = (param) ? (*((RK_U32 *)param)) : (1);
         dec_dbg_func("enable deinterlace %d\n", dec->enable_deinterlace);
     } break;
+    case MPP_DEC_SET_PRE_ALLOC_BUFF: {
+        ret = mpp_dec_pre_alloc_buff(dec, (MppDecPreAlloc *)param);
+    } break;
     default : {
     } break;
     }
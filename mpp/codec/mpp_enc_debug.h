@@ -26,6 +26,7 @@
 #define MPP_ENC_DBG_RESET               (0x00000040)
 #define MPP_ENC_DBG_NOTIFY              (0x00000080)
 #define MPP_ENC_DBG_REENC               (0x00000100)
+#define MPP_ENC_DBG_TIMING              (0x00000200)
 
 #define MPP_ENC_DBG_FRM_STATUS          (0x00010000)
 
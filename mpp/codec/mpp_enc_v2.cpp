@@ -23,6 +23,7 @@
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_info.h"
+#include "mpp_trace.h"
 #include "mpp_common.h"
 
 #include "mpp_packet_impl.h"
@@ -56,65 +57,6 @@ typedef struct RcApiStatus_t {
     RK_U32              rc_api_user_cfg : 1;
 } RcApiStatus;
 
-typedef struct MppEncImpl_t {
-    MppCodingType       coding;
-    EncImpl             impl;
-    MppEncHal           enc_hal;
-
-    /* cpb parameters */
-    MppEncRefs          refs;
-    MppEncRefFrmUsrCfg  frm_cfg;
-
-    /*
-     * Rate control plugin parameters
-     */
-    RcApiStatus         rc_status;
-    RK_S32              rc_api_updated;
-    RK_S32              rc_cfg_updated;
-    RcApiBrief          rc_brief;
-    RcCtx               rc_ctx;
-    EncRcTask           rc_task;
-
-    MppThread           *thread_enc;
-    void                *mpp;
-
-    // internal status and protection
-    Mutex               lock;
-    RK_U32              reset_flag;
-    sem_t               enc_reset;
-
-    RK_U32              wait_count;
-    RK_U32              work_count;
-    RK_U32              status_flag;
-    RK_U32              notify_flag;
-
-    /* Encoder configure set */
-    MppEncCfgSet        cfg;
-
-    /* control process */
-    RK_U32              cmd_send;
-    RK_U32              cmd_recv;
-    MpiCmd              cmd;
-    void                *param;
-    MPP_RET             *cmd_ret;
-    sem_t               enc_ctrl;
-
-    // legacy support for MPP_ENC_GET_EXTRA_INFO
-    MppPacket           hdr_pkt;
-    void                *hdr_buf;
-    RK_U32              hdr_len;
-    MppEncHeaderStatus  hdr_status;
-    MppEncHeaderMode    hdr_mode;
-
-    /* information for debug prefix */
-    const char          *version_info;
-    RK_S32              version_length;
-    char                *rc_cfg_info;
-    RK_S32              rc_cfg_pos;
-    RK_S32              rc_cfg_length;
-    RK_S32              rc_cfg_size;
-} MppEncImpl;
-
 typedef union EncTaskWait_u {
     RK_U32          val;
     struct {
@@ -167,6 +109,24 @@ typedef union EncTaskStatus_u {
     };
 } EncTaskStatus;
 
+// for timing record
+typedef enum MppEncTimingType_e {
+    ENC_FRAME,
+    ENC_PROC_HAL,
+    ENC_HAL_GEN_REG,
+    ENC_HW_START,
+    ENC_HW_WAIT,
+    ENC_TIMING_BUTT,
+} MppEncTimingType;
+
+static const char *timing_str[ENC_TIMING_BUTT] = {
+    "frame",
+    "proc hal",
+    "gen reg",
+    "hw start",
+    "hw wait",
+};
+
 typedef struct EncTask_t {
     RK_S32          seq_idx;
     EncTaskStatus   status;
@@ -175,6 +135,70 @@ typedef struct EncTask_t {
     HalTaskInfo     info;
 } EncTask;
 
+typedef struct MppEncImpl_t {
+    MppCodingType       coding;
+    EncImpl             impl;
+    MppEncHal           enc_hal;
+
+    /* cpb parameters */
+    MppEncRefs          refs;
+    MppEncRefFrmUsrCfg  frm_cfg;
+
+    /*
+     * Rate control plugin parameters
+     */
+    RcApiStatus         rc_status;
+    RK_S32              rc_api_updated;
+    RK_S32              rc_cfg_updated;
+    RcApiBrief          rc_brief;
+    RcCtx               rc_ctx;
+    EncRcTask           rc_task;
+
+    MppThread           *thread_enc;
+    void                *mpp;
+    EncTask             task;
+
+    // internal status and protection
+    Mutex               lock;
+    RK_U32              reset_flag;
+    sem_t               enc_reset;
+
+    RK_U32              wait_count;
+    RK_U32              work_count;
+    RK_U32              status_flag;
+    RK_U32              notify_flag;
+
+    /* timing statistic */
+    RK_U32              statistics_en;
+    MppClock            clocks[ENC_TIMING_BUTT];
+
+    /* Encoder configure set */
+    MppEncCfgSet        cfg;
+
+    /* control process */
+    RK_U32              cmd_send;
+    RK_U32              cmd_recv;
+    MpiCmd              cmd;
+    void                *param;
+    MPP_RET             *cmd_ret;
+    sem_t               enc_ctrl;
+
+    // legacy support for MPP_ENC_GET_EXTRA_INFO
+    MppPacket           hdr_pkt;
+    void                *hdr_buf;
+    RK_U32              hdr_len;
+    MppEncHeaderStatus  hdr_status;
+    MppEncHeaderMode    hdr_mode;
+
+    /* information for debug prefix */
+    const char          *version_info;
+    RK_S32              version_length;
+    char                *rc_cfg_info;
+    RK_S32              rc_cfg_pos;
+    RK_S32              rc_cfg_length;
+    RK_S32              rc_cfg_size;
+} MppEncImpl;
+
 static RK_U8 uuid_version[16] = {
     0x3d, 0x07, 0x6d, 0x45, 0x73, 0x0f, 0x41, 0xa8,
     0xb1, 0xc4, 0x25, 0xd7, 0x97, 0x6b, 0xf1, 0xac,
@@ -732,7 +756,15 @@ static void set_rc_cfg(RcCfg *cfg, MppEncCfgSet *cfg_set)
             cfg->igop, cfg->vgop);
 }
 
-void *mpp_enc_thread(void *data)
+static RK_S32 mpp_enc_check(void *data)
+{
+    Mpp *mpp = (Mpp*)data;
+    MppEncImpl *enc = (MppEncImpl *)mpp->mEnc;
+
+    return check_enc_task_wait(enc, &enc->task);
+}
+
+static void mpp_enc_work(void *data)
 {
     Mpp *mpp = (Mpp*)data;
     MppEncImpl *enc = (MppEncImpl *)mpp->mEnc;
@@ -746,7 +778,7 @@ void *mpp_enc_thread(void *data)
     EncCpbStatus *cpb = &rc_task->cpb;
     EncFrmStatus *frm = &rc_task->frm;
     MppEncRefFrmUsrCfg *frm_cfg = &enc->frm_cfg;
-    EncTask task;
+    EncTask &task = enc->task;
     HalTaskInfo *task_info = &task.info;
     HalEncTask *hal_task = &task_info->enc;
     MppPort input  = mpp_task_queue_get_port(mpp->mInputTaskQueue,  MPP_PORT_OUTPUT);
@@ -756,424 +788,423 @@ void *mpp_enc_thread(void *data)
     MPP_RET ret = MPP_OK;
     MppFrame frame = NULL;
     MppPacket packet = NULL;
+    RK_S64 trace_frm = 0;
+    RK_S64 trace_ts = 0;
+
+    // 1. process user control
+    if (enc->cmd_send != enc->cmd_recv) {
+        enc_dbg_detail("ctrl proc %d cmd %08x\n", enc->cmd_recv, enc->cmd);
+        mpp_enc_proc_cfg(enc);
+        sem_post(&enc->enc_ctrl);
+        enc->cmd_recv++;
+        enc_dbg_detail("ctrl proc %d done send %d\n", enc->cmd_recv,
+                       enc->cmd_send);
+        return;
+    }
 
-    memset(&task, 0, sizeof(task));
-
-    while (1) {
+    // 2. process reset
+    if (enc->reset_flag) {
+        enc_dbg_detail("thread reset start\n");
         {
             AutoMutex autolock(thd_enc->mutex());
-            if (MPP_THREAD_RUNNING != thd_enc->get_status())
-                break;
-
-            if (check_enc_task_wait(enc, &task))
-                thd_enc->wait();
-        }
-
-        // 1. process user control
-        if (enc->cmd_send != enc->cmd_recv) {
-            enc_dbg_detail("ctrl proc %d cmd %08x\n", enc->cmd_recv, enc->cmd);
-            mpp_enc_proc_cfg(enc);
-            sem_post(&enc->enc_ctrl);
-            enc->cmd_recv++;
-            enc_dbg_detail("ctrl proc %d done send %d\n", enc->cmd_recv,
-                           enc->cmd_send);
-            continue;
+            enc->status_flag = 0;
         }
 
-        // 2. process reset
-        if (enc->reset_flag) {
-            enc_dbg_detail("thread reset start\n");
-            {
-                AutoMutex autolock(thd_enc->mutex());
-                enc->status_flag = 0;
-            }
-
-            AutoMutex autolock(thd_enc->mutex(THREAD_CONTROL));
-            enc->reset_flag = 0;
-            sem_post(&enc->enc_reset);
-            enc_dbg_detail("thread reset done\n");
-            continue;
-        }
-
-        // 3. check and update rate control api
-        if (!enc->rc_status.rc_api_inited || enc->rc_status.rc_api_updated) {
-            RcApiBrief *brief = &enc->rc_brief;
-
-            if (enc->rc_ctx) {
-                enc_dbg_detail("rc deinit %p\n", enc->rc_ctx);
-                rc_deinit(enc->rc_ctx);
-                enc->rc_ctx = NULL;
-            }
-
-            /* NOTE: default name is NULL */
-            ret = rc_init(&enc->rc_ctx, enc->coding, &brief->name);
-            if (ret)
-                mpp_err("enc %p fail to init rc %s\n", enc, brief->name);
-            else
-                enc->rc_status.rc_api_inited = 1;
+        AutoMutex autolock(thd_enc->mutex(THREAD_CONTROL));
+        enc->reset_flag = 0;
+        sem_post(&enc->enc_reset);
+        enc_dbg_detail("thread reset done\n");
+        return;
+    }
 
-            enc_dbg_detail("rc init %p name %s ret %d\n", enc->rc_ctx, brief->name, ret);
-            enc->rc_status.rc_api_updated = 0;
+    // 3. check and update rate control api
+    if (!enc->rc_status.rc_api_inited || enc->rc_status.rc_api_updated) {
+        RcApiBrief *brief = &enc->rc_brief;
 
-            enc->rc_cfg_length = 0;
-            update_rc_cfg_log(enc, "%s:", brief->name);
-            enc->rc_cfg_pos = enc->rc_cfg_length;
+        if (enc->rc_ctx) {
+            enc_dbg_detail("rc deinit %p\n", enc->rc_ctx);
+            rc_deinit(enc->rc_ctx);
+            enc->rc_ctx = NULL;
         }
 
-        // 4. check input task
-        if (!task.status.task_in_rdy) {
-            ret = mpp_port_poll(input, MPP_POLL_NON_BLOCK);
-            if (ret) {
-                task.wait.enc_frm_in = 1;
-                continue;
-            }
+        /* NOTE: default name is NULL */
+        ret = rc_init(&enc->rc_ctx, enc->coding, &brief->name);
+        if (ret)
+            mpp_err("enc %p fail to init rc %s\n", enc, brief->name);
+        else
+            enc->rc_status.rc_api_inited = 1;
 
-            task.status.task_in_rdy = 1;
-            task.wait.enc_frm_in = 0;
-            enc_dbg_detail("task in ready\n");
-        }
+        enc_dbg_detail("rc init %p name %s ret %d\n", enc->rc_ctx, brief->name, ret);
+        enc->rc_status.rc_api_updated = 0;
 
-        // 5. check output task
-        if (!task.status.task_out_rdy) {
-            ret = mpp_port_poll(output, MPP_POLL_NON_BLOCK);
-            if (ret) {
-                task.wait.enc_pkt_out = 1;
-                continue;
-            }
+        enc->rc_cfg_length = 0;
+        update_rc_cfg_log(enc, "%s:", brief->name);
+        enc->rc_cfg_pos = enc->rc_cfg_length;
+    }
 
-            task.status.task_out_rdy = 1;
-            task.wait.enc_pkt_out = 0;
-            enc_dbg_detail("task out ready\n");
+    // 4. check input task
+    if (!task.status.task_in_rdy) {
+        ret = mpp_port_poll(input, MPP_POLL_NON_BLOCK);
+        if (ret) {
+            task.wait.enc_frm_in = 1;
+            return;
         }
 
-        // get tasks from both input and output
-        ret = mpp_port_dequeue(input, &task_in);
-        mpp_assert(task_in);
-
-        ret = mpp_port_dequeue(output, &task_out);
-        mpp_assert(task_out);
-
-        /*
-         * frame will be return to input.
-         * packet will be sent to output.
-         */
-        mpp_task_meta_get_frame (task_in, KEY_INPUT_FRAME,  &frame);
-        mpp_task_meta_get_packet(task_in, KEY_OUTPUT_PACKET, &packet);
-
-        enc_dbg_detail("task dequeue done frm %p pkt %p\n", frame, packet);
+        task.status.task_in_rdy = 1;
+        task.wait.enc_frm_in = 0;
+        enc_dbg_detail("task in ready\n");
+    }
 
-        /*
-         * 6. check empty task for signaling
-         * If there is no input frame just return empty packet task
-         */
-        if (NULL == frame)
-            goto TASK_RETURN;
-
-        if (NULL == mpp_frame_get_buffer(frame))
-            goto TASK_RETURN;
-
-        // 7. check and update rate control config
-        if (enc->rc_status.rc_api_user_cfg) {
-            RcCfg usr_cfg;
-
-            enc_dbg_detail("rc update cfg start\n");
-
-            memset(&usr_cfg, 0 , sizeof(usr_cfg));
-            set_rc_cfg(&usr_cfg, cfg);
-            ret = rc_update_usr_cfg(enc->rc_ctx, &usr_cfg);
-            rc_cfg->change = 0;
-            prep_cfg->change = 0;
-
-            enc_dbg_detail("rc update cfg done\n");
-            enc->rc_status.rc_api_user_cfg = 0;
-
-            enc->rc_cfg_length = enc->rc_cfg_pos;
-            update_rc_cfg_log(enc, "%s-b:%d[%d:%d]-g:%d-q:%d:[%d:%d]:[%d:%d]:%d\n",
-                              name_of_rc_mode[usr_cfg.mode],
-                              usr_cfg.bps_target,
-                              usr_cfg.bps_min, usr_cfg.bps_max, usr_cfg.igop,
-                              usr_cfg.init_quality,
-                              usr_cfg.min_quality, usr_cfg.max_quality,
-                              usr_cfg.min_i_quality, usr_cfg.max_i_quality,
-                              usr_cfg.i_quality_delta);
+    // 5. check output task
+    if (!task.status.task_out_rdy) {
+        ret = mpp_port_poll(output, MPP_POLL_NON_BLOCK);
+        if (ret) {
+            task.wait.enc_pkt_out = 1;
+            return;
         }
 
-        // 8. all task ready start encoding one frame
-        reset_hal_enc_task(hal_task);
-        reset_enc_rc_task(rc_task);
-        hal_task->rc_task = rc_task;
-        hal_task->frm_cfg = frm_cfg;
-        frm->seq_idx = task.seq_idx++;
-        rc_task->frame = frame;
+        task.status.task_out_rdy = 1;
+        task.wait.enc_pkt_out = 0;
+        enc_dbg_detail("task out ready\n");
+    }
 
-        enc_dbg_detail("task seq idx %d start\n", frm->seq_idx);
+    // get tasks from both input and output
+    ret = mpp_port_dequeue(input, &task_in);
+    mpp_assert(task_in);
 
-        /*
-         * 9. check and create packet for output
-         * if there is available buffer in the input frame do encoding
-         */
-        if (NULL == packet) {
-            /* NOTE: set buffer w * h * 1.5 to avoid buffer overflow */
-            RK_U32 width  = enc->cfg.prep.width;
-            RK_U32 height = enc->cfg.prep.height;
-            RK_U32 size = MPP_ALIGN(width, 16) * MPP_ALIGN(height, 16) * 3 / 2;
-            MppBuffer buffer = NULL;
-
-            mpp_assert(size);
-            mpp_buffer_get(mpp->mPacketGroup, &buffer, size);
-            mpp_packet_init_with_buffer(&packet, buffer);
-            /* NOTE: clear length for output */
-            mpp_packet_set_length(packet, 0);
-            mpp_buffer_put(buffer);
-
-            enc_dbg_detail("create output pkt %p buf %p\n", packet, buffer);
-        }
+    ret = mpp_port_dequeue(output, &task_out);
+    mpp_assert(task_out);
 
-        mpp_assert(packet);
+    /*
+     * frame will be return to input.
+     * packet will be sent to output.
+     */
+    mpp_task_meta_get_frame (task_in, KEY_INPUT_FRAME,  &frame);
+    mpp_task_meta_get_packet(task_in, KEY_OUTPUT_PACKET, &packet);
 
-        // 10. bypass pts to output
-        {
-            RK_S64 pts = mpp_frame_get_pts(frame);
-            mpp_packet_set_pts(packet, pts);
-            enc_dbg_detail("task %d pts %lld\n", frm->seq_idx, pts);
-        }
+    enc_dbg_detail("task dequeue done frm %p pkt %p\n", frame, packet);
 
-        // 11. check frame drop by frame rate conversion
-        RUN_ENC_RC_FUNC(rc_frm_check_drop, enc->rc_ctx, rc_task, mpp, ret);
-        task.status.rc_check_frm_drop = 1;
-        enc_dbg_detail("task %d drop %d\n", frm->seq_idx, frm->drop);
+    /*
+     * 6. check empty task for signaling
+     * If there is no input frame just return empty packet task
+     */
+    if (NULL == frame)
+        goto TASK_RETURN;
+
+    if (NULL == mpp_frame_get_buffer(frame))
+        goto TASK_RETURN;
+
+    // 7. check and update rate control config
+    if (enc->rc_status.rc_api_user_cfg) {
+        RcCfg usr_cfg;
+
+        enc_dbg_detail("rc update cfg start\n");
+
+        memset(&usr_cfg, 0 , sizeof(usr_cfg));
+        set_rc_cfg(&usr_cfg, cfg);
+        ret = rc_update_usr_cfg(enc->rc_ctx, &usr_cfg);
+        rc_cfg->change = 0;
+        prep_cfg->change = 0;
+
+        enc_dbg_detail("rc update cfg done\n");
+        enc->rc_status.rc_api_user_cfg = 0;
+
+        enc->rc_cfg_length = enc->rc_cfg_pos;
+        update_rc_cfg_log(enc, "%s-b:%d[%d:%d]-g:%d-q:%d:[%d:%d]:[%d:%d]:%d\n",
+                          name_of_rc_mode[usr_cfg.mode],
+                          usr_cfg.bps_target,
+                          usr_cfg.bps_min, usr_cfg.bps_max, usr_cfg.igop,
+                          usr_cfg.init_quality,
+                          usr_cfg.min_quality, usr_cfg.max_quality,
+                          usr_cfg.min_i_quality, usr_cfg.max_i_quality,
+                          usr_cfg.i_quality_delta);
+    }
 
-        // when the frame should be dropped just return empty packet
-        if (frm->drop) {
-            hal_task->valid = 0;
-            hal_task->length = 0;
-            goto TASK_DONE;
-        }
+    // 8. all task ready start encoding one frame
+    reset_hal_enc_task(hal_task);
+    reset_enc_rc_task(rc_task);
+    hal_task->rc_task = rc_task;
+    hal_task->frm_cfg = frm_cfg;
+    frm->seq_idx = task.seq_idx++;
+    rc_task->frame = frame;
+    trace_frm = mpp_trace_ts();
+    mpp_clock_start(enc->clocks[ENC_FRAME]);
 
-        // start encoder task process here
-        hal_task->valid = 1;
+    enc_dbg_detail("task seq idx %d start\n", frm->seq_idx);
 
-        // 12. generate header before hardware stream
-        if (!enc->hdr_status.ready) {
-            /* config cpb before generating header */
-            enc_impl_gen_hdr(impl, enc->hdr_pkt);
-            enc->hdr_len = mpp_packet_get_length(enc->hdr_pkt);
-            enc->hdr_status.ready = 1;
+    /*
+     * 9. check and create packet for output
+     * if there is available buffer in the input frame do encoding
+     */
+    if (NULL == packet) {
+        /* NOTE: set buffer w * h * 1.5 to avoid buffer overflow */
+        RK_U32 width  = enc->cfg.prep.width;
+        RK_U32 height = enc->cfg.prep.height;
+        RK_U32 size = MPP_ALIGN(width, 16) * MPP_ALIGN(height, 16) * 3 / 2;
+        MppBuffer buffer = NULL;
+
+        mpp_assert(size);
+        mpp_buffer_get(mpp->mPacketGroup, &buffer, size);
+        mpp_packet_init_with_buffer(&packet, buffer);
+        /* NOTE: clear length for output */
+        mpp_packet_set_length(packet, 0);
+        mpp_buffer_put(buffer);
+
+        enc_dbg_detail("create output pkt %p buf %p\n", packet, buffer);
+    }
 
-            enc_dbg_detail("task %d update header length %d\n",
-                           frm->seq_idx, enc->hdr_len);
+    mpp_assert(packet);
 
-            mpp_packet_append(packet, enc->hdr_pkt);
-            hal_task->header_length = enc->hdr_len;
-            hal_task->length += enc->hdr_len;
-            enc->hdr_status.added_by_change = 1;
-        }
+    // 10. bypass pts to output
+    {
+        RK_S64 pts = mpp_frame_get_pts(frame);
+        mpp_packet_set_pts(packet, pts);
+        enc_dbg_detail("task %d pts %lld\n", frm->seq_idx, pts);
+    }
 
-        mpp_assert(hal_task->length == mpp_packet_get_length(packet));
+    // 11. check frame drop by frame rate conversion
+    RUN_ENC_RC_FUNC(rc_frm_check_drop, enc->rc_ctx, rc_task, mpp, ret);
+    task.status.rc_check_frm_drop = 1;
+    enc_dbg_detail("task %d drop %d\n", frm->seq_idx, frm->drop);
 
-        // 13. setup input frame and output packet
-        hal_task->frame  = frame;
-        hal_task->input  = mpp_frame_get_buffer(frame);
-        hal_task->packet = packet;
-        hal_task->output = mpp_packet_get_buffer(packet);
-        hal_task->length = mpp_packet_get_length(packet);
-        mpp_task_meta_get_buffer(task_in, KEY_MOTION_INFO, &hal_task->mv_info);
+    // when the frame should be dropped just return empty packet
+    if (frm->drop) {
+        hal_task->valid = 0;
+        hal_task->length = 0;
+        goto TASK_DONE;
+    }
 
-        /* 14. check frm_meta data force key in input frame and start one frame */
-        enc_dbg_detail("task %d enc start\n", frm->seq_idx);
-        RUN_ENC_IMPL_FUNC(enc_impl_start, impl, hal_task, mpp, ret);
+    // start encoder task process here
+    hal_task->valid = 1;
 
-        // 14. setup user_cfg to dpb
-        if (frm_cfg->force_flag) {
-            mpp_enc_refs_set_usr_cfg(enc->refs, frm_cfg);
-            frm_cfg->force_flag = 0;
-        }
-
-        // 15. backup dpb
-        mpp_enc_refs_stash(enc->refs);
-        task.status.enc_backup = 1;
-
-    TASK_REENCODE:
-        // 15. restore and process dpb
-        if (!frm->reencode) {
-            if (!frm->re_dpb_proc) {
-                enc_dbg_detail("task %d enc proc dpb\n", frm->seq_idx);
-                mpp_enc_refs_get_cpb(enc->refs, cpb);
-
-                enc_dbg_frm_status("frm %d start ***********************************\n", cpb->curr.seq_idx);
-                RUN_ENC_IMPL_FUNC(enc_impl_proc_dpb, impl, hal_task, mpp, ret);
-
-                enc_dbg_frm_status("frm %d compare\n", cpb->curr.seq_idx);
-                enc_dbg_frm_status("seq_idx      %d vs %d\n", frm->seq_idx, cpb->curr.seq_idx);
-                enc_dbg_frm_status("is_idr       %d vs %d\n", frm->is_idr, cpb->curr.is_idr);
-                enc_dbg_frm_status("is_intra     %d vs %d\n", frm->is_intra, cpb->curr.is_intra);
-                enc_dbg_frm_status("is_non_ref   %d vs %d\n", frm->is_non_ref, cpb->curr.is_non_ref);
-                enc_dbg_frm_status("is_lt_ref    %d vs %d\n", frm->is_lt_ref, cpb->curr.is_lt_ref);
-                enc_dbg_frm_status("lt_idx       %d vs %d\n", frm->lt_idx, cpb->curr.lt_idx);
-                enc_dbg_frm_status("temporal_id  %d vs %d\n", frm->temporal_id, cpb->curr.temporal_id);
-                enc_dbg_frm_status("frm %d done  ***********************************\n", cpb->curr.seq_idx);
-            }
+    // 12. generate header before hardware stream
+    if (!enc->hdr_status.ready) {
+        /* config cpb before generating header */
+        enc_impl_gen_hdr(impl, enc->hdr_pkt);
+        enc->hdr_len = mpp_packet_get_length(enc->hdr_pkt);
+        enc->hdr_status.ready = 1;
 
-            enc_dbg_detail("task %d rc frame start\n", frm->seq_idx);
-            RUN_ENC_RC_FUNC(rc_frm_start, enc->rc_ctx, rc_task, mpp, ret);
-            task.status.enc_proc_dpb = 1;
-            if (frm->re_dpb_proc)
-                goto TASK_REENCODE;
-
-            // 16. generate header before hardware stream
-            if (enc->hdr_mode == MPP_ENC_HEADER_MODE_EACH_IDR &&
-                frm->is_intra &&
-                !enc->hdr_status.added_by_change &&
-                !enc->hdr_status.added_by_ctrl &&
-                !enc->hdr_status.added_by_mode) {
-                enc_dbg_detail("task %d IDR header length %d\n",
-                               frm->seq_idx, enc->hdr_len);
-
-                mpp_packet_append(packet, enc->hdr_pkt);
-
-                hal_task->header_length = enc->hdr_len;
-                hal_task->length += enc->hdr_len;
-                enc->hdr_status.added_by_mode = 1;
-            }
-        }
-        frm->reencode = 0;
+        enc_dbg_detail("task %d update header length %d\n",
+                       frm->seq_idx, enc->hdr_len);
 
-        // check for header adding
-        if (hal_task->length != mpp_packet_get_length(packet)) {
-            mpp_err_f("header adding check failed: task length is not match to packet length %d vs %d\n",
-                      hal_task->length, mpp_packet_get_length(packet));
-        }
+        mpp_packet_append(packet, enc->hdr_pkt);
+        hal_task->header_length = enc->hdr_len;
+        hal_task->length += enc->hdr_len;
+        enc->hdr_status.added_by_change = 1;
+    }
 
-        /* 17. Add all prefix info before encoding */
-        if (frm->is_idr) {
-            RK_S32 length = 0;
+    mpp_assert(hal_task->length == mpp_packet_get_length(packet));
 
-            enc_impl_add_prefix(impl, packet, &length, uuid_version,
-                                enc->version_info, enc->version_length);
+    // 13. setup input frame and output packet
+    hal_task->frame  = frame;
+    hal_task->input  = mpp_frame_get_buffer(frame);
+    hal_task->packet = packet;
+    hal_task->output = mpp_packet_get_buffer(packet);
+    hal_task->length = mpp_packet_get_length(packet);
+    mpp_task_meta_get_buffer(task_in, KEY_MOTION_INFO, &hal_task->mv_info);
 
-            hal_task->sei_length += length;
-            hal_task->length += length;
+    /* 14. check frm_meta data force key in input frame and start one frame */
+    enc_dbg_detail("task %d enc start\n", frm->seq_idx);
+    RUN_ENC_IMPL_FUNC(enc_impl_start, impl, hal_task, mpp, ret);
 
-            length = 0;
-            enc_impl_add_prefix(impl, packet, &length, uuid_rc_cfg,
-                                enc->rc_cfg_info, enc->rc_cfg_length);
+    // 14. setup user_cfg to dpb
+    if (frm_cfg->force_flag) {
+        mpp_enc_refs_set_usr_cfg(enc->refs, frm_cfg);
+        frm_cfg->force_flag = 0;
+    }
 
-            hal_task->sei_length += length;
-            hal_task->length += length;
+    // 15. backup dpb
+    mpp_enc_refs_stash(enc->refs);
+    task.status.enc_backup = 1;
+
+TASK_REENCODE:
+    // 15. restore and process dpb
+    if (!frm->reencode) {
+        if (!frm->re_dpb_proc) {
+            enc_dbg_detail("task %d enc proc dpb\n", frm->seq_idx);
+            mpp_enc_refs_get_cpb(enc->refs, cpb);
+
+            enc_dbg_frm_status("frm %d start ***********************************\n", cpb->curr.seq_idx);
+            RUN_ENC_IMPL_FUNC(enc_impl_proc_dpb, impl, hal_task, mpp, ret);
+
+            enc_dbg_frm_status("frm %d compare\n", cpb->curr.seq_idx);
+            enc_dbg_frm_status("seq_idx      %d vs %d\n", frm->seq_idx, cpb->curr.seq_idx);
+            enc_dbg_frm_status("is_idr       %d vs %d\n", frm->is_idr, cpb->curr.is_idr);
+            enc_dbg_frm_status("is_intra     %d vs %d\n", frm->is_intra, cpb->curr.is_intra);
+            enc_dbg_frm_status("is_non_ref   %d vs %d\n", frm->is_non_ref, cpb->curr.is_non_ref);
+            enc_dbg_frm_status("is_lt_ref    %d vs %d\n", frm->is_lt_ref, cpb->curr.is_lt_ref);
+            enc_dbg_frm_status("lt_idx       %d vs %d\n", frm->lt_idx, cpb->curr.lt_idx);
+            enc_dbg_frm_status("temporal_id  %d vs %d\n", frm->temporal_id, cpb->curr.temporal_id);
+            enc_dbg_frm_status("frm %d done  ***********************************\n", cpb->curr.seq_idx);
         }
 
-        if (mpp_frame_has_meta(frame)) {
-            MppMeta frm_meta = mpp_frame_get_meta(frame);
-            MppEncUserData *user_data = NULL;
-
-            mpp_meta_get_ptr(frm_meta, KEY_USER_DATA, (void**)&user_data);
+        enc_dbg_detail("task %d rc frame start\n", frm->seq_idx);
+        RUN_ENC_RC_FUNC(rc_frm_start, enc->rc_ctx, rc_task, mpp, ret);
+        task.status.enc_proc_dpb = 1;
+        if (frm->re_dpb_proc)
+            goto TASK_REENCODE;
 
-            if (user_data) {
-                if (user_data->pdata && user_data->len) {
-                    RK_S32 length = 0;
+        // 16. generate header before hardware stream
+        if (enc->hdr_mode == MPP_ENC_HEADER_MODE_EACH_IDR &&
+            frm->is_intra &&
+            !enc->hdr_status.added_by_change &&
+            !enc->hdr_status.added_by_ctrl &&
+            !enc->hdr_status.added_by_mode) {
+            enc_dbg_detail("task %d IDR header length %d\n",
+                           frm->seq_idx, enc->hdr_len);
 
-                    enc_impl_add_prefix(impl, packet, &length, uuid_usr_data,
-                                        user_data->pdata, user_data->len);
+            mpp_packet_append(packet, enc->hdr_pkt);
 
-                    hal_task->sei_length += length;
-                    hal_task->length += length;
-                } else
-                    mpp_err_f("failed to insert user data %p len %d\n",
-                              user_data->pdata, user_data->len);
-            }
+            hal_task->header_length = enc->hdr_len;
+            hal_task->length += enc->hdr_len;
+            enc->hdr_status.added_by_mode = 1;
         }
+    }
+    frm->reencode = 0;
 
-        // check for user data adding
-        if (hal_task->length != mpp_packet_get_length(packet)) {
-            mpp_err_f("user data adding check failed: task length is not match to packet length %d vs %d\n",
-                      hal_task->length, mpp_packet_get_length(packet));
-        }
+    // check for header adding
+    if (hal_task->length != mpp_packet_get_length(packet)) {
+        mpp_err_f("header adding check failed: task length is not match to packet length %d vs %d\n",
+                  hal_task->length, mpp_packet_get_length(packet));
+    }
 
-        enc_dbg_detail("task %d enc proc hal\n", frm->seq_idx);
-        RUN_ENC_IMPL_FUNC(enc_impl_proc_hal, impl, hal_task, mpp, ret);
+    /* 17. Add all prefix info before encoding */
+    if (frm->is_idr) {
+        RK_S32 length = 0;
 
-        enc_dbg_detail("task %d hal get task\n", frm->seq_idx);
-        RUN_ENC_HAL_FUNC(mpp_enc_hal_get_task, hal, hal_task, mpp, ret);
+        enc_impl_add_prefix(impl, packet, &length, uuid_version,
+                            enc->version_info, enc->version_length);
 
-        enc_dbg_detail("task %d rc hal start\n", frm->seq_idx);
-        RUN_ENC_RC_FUNC(rc_hal_start, enc->rc_ctx, rc_task, mpp, ret);
+        hal_task->sei_length += length;
+        hal_task->length += length;
 
-        enc_dbg_detail("task %d hal generate reg\n", frm->seq_idx);
-        RUN_ENC_HAL_FUNC(mpp_enc_hal_gen_regs, hal, hal_task, mpp, ret);
+        length = 0;
+        enc_impl_add_prefix(impl, packet, &length, uuid_rc_cfg,
+                            enc->rc_cfg_info, enc->rc_cfg_length);
 
-        enc_dbg_detail("task %d hal start\n", frm->seq_idx);
-        RUN_ENC_HAL_FUNC(mpp_enc_hal_start, hal, hal_task, mpp, ret);
+        hal_task->sei_length += length;
+        hal_task->length += length;
+    }
 
-        enc_dbg_detail("task %d hal wait\n", frm->seq_idx);
-        RUN_ENC_HAL_FUNC(mpp_enc_hal_wait,  hal, hal_task, mpp, ret);
+    if (mpp_frame_has_meta(frame)) {
+        MppMeta frm_meta = mpp_frame_get_meta(frame);
+        MppEncUserData *user_data = NULL;
 
-        enc_dbg_detail("task %d rc hal end\n", frm->seq_idx);
-        RUN_ENC_RC_FUNC(rc_hal_end, enc->rc_ctx, rc_task, mpp, ret);
+        mpp_meta_get_ptr(frm_meta, KEY_USER_DATA, (void**)&user_data);
 
-        enc_dbg_detail("task %d hal ret task\n", frm->seq_idx);
-        RUN_ENC_HAL_FUNC(mpp_enc_hal_ret_task, hal, hal_task, mpp, ret);
+        if (user_data) {
+            if (user_data->pdata && user_data->len) {
+                RK_S32 length = 0;
 
-        enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
-        RUN_ENC_RC_FUNC(rc_frm_end, enc->rc_ctx, rc_task, mpp, ret);
+                enc_impl_add_prefix(impl, packet, &length, uuid_usr_data,
+                                    user_data->pdata, user_data->len);
 
-        if (frm->reencode_times < rc_cfg->max_reenc_times && frm->reencode) {
-            mpp_enc_refs_rollback(enc->refs);
-            enc_dbg_reenc("reencode time %d\n", frm->reencode_times);
-            hal_task->length -= hal_task->hw_length;
-            hal_task->hw_length = 0;
-            goto TASK_REENCODE;
-        } else {
-            frm->reencode = 0;
-            frm->reencode_times = 0;
+                hal_task->sei_length += length;
+                hal_task->length += length;
+            } else
+                mpp_err_f("failed to insert user data %p len %d\n",
+                          user_data->pdata, user_data->len);
         }
-    TASK_DONE:
-        /* setup output packet and meta data */
-        mpp_packet_set_length(packet, hal_task->length);
-
-        {
-            MppMeta meta = mpp_packet_get_meta(packet);
+    }
 
-            if (hal_task->mv_info)
-                mpp_meta_set_buffer(meta, KEY_MOTION_INFO, hal_task->mv_info);
+    // check for user data adding
+    if (hal_task->length != mpp_packet_get_length(packet)) {
+        mpp_err_f("user data adding check failed: task length is not match to packet length %d vs %d\n",
+                  hal_task->length, mpp_packet_get_length(packet));
+    }
 
-            mpp_meta_set_s32(meta, KEY_OUTPUT_INTRA, frm->is_intra);
-        }
+    enc_dbg_detail("task %d enc proc hal\n", frm->seq_idx);
+    trace_ts = mpp_trace_ts();
+    mpp_clock_start(enc->clocks[ENC_PROC_HAL]);
+    RUN_ENC_IMPL_FUNC(enc_impl_proc_hal, impl, hal_task, mpp, ret);
+    mpp_clock_pause(enc->clocks[ENC_PROC_HAL]);
+    mpp_trace_span("enc_proc_hal", mpp, frm->seq_idx, -1, 0, trace_ts);
+
+    enc_dbg_detail("task %d hal get task\n", frm->seq_idx);
+    RUN_ENC_HAL_FUNC(mpp_enc_hal_get_task, hal, hal_task, mpp, ret);
+
+    enc_dbg_detail("task %d rc hal start\n", frm->seq_idx);
+    RUN_ENC_RC_FUNC(rc_hal_start, enc->rc_ctx, rc_task, mpp, ret);
+
+    enc_dbg_detail("task %d hal generate reg\n", frm->seq_idx);
+    trace_ts = mpp_trace_ts();
+    mpp_clock_start(enc->clocks[ENC_HAL_GEN_REG]);
+    RUN_ENC_HAL_FUNC(mpp_enc_hal_gen_regs, hal, hal_task, mpp, ret);
+    mpp_clock_pause(enc->clocks[ENC_HAL_GEN_REG]);
+    mpp_trace_span("enc_gen_reg", mpp, frm->seq_idx, -1, 0, trace_ts);
+
+    enc_dbg_detail("task %d hal start\n", frm->seq_idx);
+    trace_ts = mpp_trace_ts();
+    mpp_clock_start(enc->clocks[ENC_HW_START]);
+    RUN_ENC_HAL_FUNC(mpp_enc_hal_start, hal, hal_task, mpp, ret);
+    mpp_clock_pause(enc->clocks[ENC_HW_START]);
+    mpp_trace_span("enc_hw_start", mpp, frm->seq_idx, -1, 0, trace_ts);
+
+    enc_dbg_detail("task %d hal wait\n", frm->seq_idx);
+    trace_ts = mpp_trace_ts();
+    mpp_clock_start(enc->clocks[ENC_HW_WAIT]);
+    RUN_ENC_HAL_FUNC(mpp_enc_hal_wait,  hal, hal_task, mpp, ret);
+    mpp_clock_pause(enc->clocks[ENC_HW_WAIT]);
+    mpp_trace_span("enc_hw_wait", mpp, frm->seq_idx, -1, 0, trace_ts);
+
+    enc_dbg_detail("task %d rc hal end\n", frm->seq_idx);
+    RUN_ENC_RC_FUNC(rc_hal_end, enc->rc_ctx, rc_task, mpp, ret);
+
+    enc_dbg_detail("task %d hal ret task\n", frm->seq_idx);
+    RUN_ENC_HAL_FUNC(mpp_enc_hal_ret_task, hal, hal_task, mpp, ret);
+
+    enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
+    RUN_ENC_RC_FUNC(rc_frm_end, enc->rc_ctx, rc_task, mpp, ret);
+
+    if (frm->reencode_times < rc_cfg->max_reenc_times && frm->reencode) {
+        mpp_enc_refs_rollback(enc->refs);
+        enc_dbg_reenc("reencode time %d\n", frm->reencode_times);
+        hal_task->length -= hal_task->hw_length;
+        hal_task->hw_length = 0;
+        goto TASK_REENCODE;
+    } else {
+        frm->reencode = 0;
+        frm->reencode_times = 0;
+    }
+TASK_DONE:
+    /* setup output packet and meta data */
+    mpp_packet_set_length(packet, hal_task->length);
+    mpp_clock_pause(enc->clocks[ENC_FRAME]);
+    mpp_trace_span("enc_frame", mpp, frm->seq_idx, -1, hal_task->length,
+                   trace_frm);
 
-    TASK_RETURN:
-        /*
-         * First return output packet.
-         * Then enqueue task back to input port.
-         * Final user will release the mpp_frame they had input.
-         */
-        if (NULL == packet)
-            mpp_packet_new(&packet);
+    {
+        MppMeta meta = mpp_packet_get_meta(packet);
 
-        if (frame && mpp_frame_get_eos(frame))
-            mpp_packet_set_eos(packet);
-        else
-            mpp_packet_clr_eos(packet);
+        if (hal_task->mv_info)
+            mpp_meta_set_buffer(meta, KEY_MOTION_INFO, hal_task->mv_info);
 
-        mpp_task_meta_set_packet(task_out, KEY_OUTPUT_PACKET, packet);
-        mpp_port_enqueue(output, task_out);
+        mpp_meta_set_s32(meta, KEY_OUTPUT_INTRA, frm->is_intra);
+    }
 
-        mpp_task_meta_set_frame(task_in, KEY_INPUT_FRAME, frame);
-        mpp_port_enqueue(input, task_in);
+TASK_RETURN:
+    /*
+     * First return output packet.
+     * Then enqueue task back to input port.
+     * Final user will release the mpp_frame they had input.
+     */
+    if (NULL == packet)
+        mpp_packet_new(&packet);
 
-        task_in = NULL;
-        task_out = NULL;
-        packet = NULL;
-        frame = NULL;
+    if (frame && mpp_frame_get_eos(frame))
+        mpp_packet_set_eos(packet);
+    else
+        mpp_packet_clr_eos(packet);
 
-        task.status.val = 0;
-        enc->hdr_status.val = 0;
-        enc->hdr_status.ready = 1;
-    }
+    mpp_task_meta_set_packet(task_out, KEY_OUTPUT_PACKET, packet);
+    mpp_port_enqueue(output, task_out);
 
-    // clear remain task in output port
-    release_task_in_port(input);
-    release_task_in_port(mpp->mOutputPort);
+    mpp_task_meta_set_frame(task_in, KEY_INPUT_FRAME, frame);
+    mpp_port_enqueue(input, task_in);
 
-    return NULL;
+    task.status.val = 0;
+    enc->hdr_status.val = 0;
+    enc->hdr_status.ready = 1;
 }
 
 MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
@@ -1185,6 +1216,7 @@ MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
     MppEncHal enc_hal = NULL;
     MppEncHalCfg enc_hal_cfg;
     EncImplCfg ctrl_cfg;
+    RK_S32 i;
 
     mpp_env_get_u32("mpp_enc_debug", &mpp_enc_debug, 0);
 
@@ -1246,6 +1278,14 @@ MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
     p->rc_cfg_size = SZ_1K;
     p->rc_cfg_info = mpp_calloc_size(char, p->rc_cfg_size);
 
+    /* clocks are always on for MPP_GET_STATS, statistics_en only logs them */
+    p->statistics_en = (mpp_enc_debug & MPP_ENC_DBG_TIMING) ? 1 : 0;
+    for (i = 0; i < ENC_TIMING_BUTT; i++) {
+        p->clocks[i] = mpp_clock_get(timing_str[i]);
+        mpp_assert(p->clocks[i]);
+        mpp_clock_enable(p->clocks[i], 1);
+    }
+
     {
         // create header packet storage
         size_t size = SZ_1K;
@@ -1275,12 +1315,31 @@ ERR_RET:
 MPP_RET mpp_enc_deinit_v2(MppEnc ctx)
 {
     MppEncImpl *enc = (MppEncImpl *)ctx;
+    RK_S32 i;
 
     if (NULL == enc) {
         mpp_err_f("found NULL input\n");
         return MPP_ERR_NULL_PTR;
     }
 
+    for (i = 0; i < ENC_TIMING_BUTT; i++) {
+        MppClock timer = enc->clocks[i];
+        RK_S64 count;
+
+        if (NULL == timer)
+            continue;
+
+        count = mpp_clock_get_count(timer);
+        if (enc->statistics_en && count)
+            mpp_log("%p %-10s - %-8lld avg %-8lld p99 %-8lld max %lld\n",
+                    enc, mpp_clock_get_name(timer), count,
+                    mpp_clock_get_sum(timer) / count,
+                    mpp_clock_get_percentile(timer, 99), mpp_clock_get_max(timer));
+
+        mpp_clock_put(timer);
+        enc->clocks[i] = NULL;
+    }
+
     if (enc->impl) {
         enc_impl_deinit(enc->impl);
         enc->impl = NULL;
@@ -1322,13 +1381,47 @@ MPP_RET mpp_enc_deinit_v2(MppEnc ctx)
     return MPP_OK;
 }
 
+MPP_RET mpp_enc_get_stats_v2(MppEnc ctx, MppStats *stats)
+{
+    MppEncImpl *enc = (MppEncImpl *)ctx;
+    RK_S32 i;
+
+    if (NULL == enc || NULL == stats) {
+        mpp_err_f("found NULL input enc %p stats %p\n", enc, stats);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    for (i = 0; i < ENC_TIMING_BUTT; i++) {
+        MppClock timer = enc->clocks[i];
+        MppStageStat *stage = NULL;
+        RK_S64 count;
+
+        if (stats->stage_count >= MPP_STATS_STAGE_MAX)
+            break;
+
+        stage = &stats->stages[stats->stage_count++];
+        count = mpp_clock_get_count(timer);
+
+        snprintf(stage->name, sizeof(stage->name), "enc %s", mpp_clock_get_name(timer));
+        stage->count = count;
+        stage->avg = count ? mpp_clock_get_sum(timer) / count : 0;
+        stage->p50 = mpp_clock_get_percentile(timer, 50);
+        stage->p90 = mpp_clock_get_percentile(timer, 90);
+        stage->p99 = mpp_clock_get_percentile(timer, 99);
+        stage->max = mpp_clock_get_max(timer);
+    }
+
+    return MPP_OK;
+}
+
 MPP_RET mpp_enc_start_v2(MppEnc ctx)
 {
     MppEncImpl *enc = (MppEncImpl *)ctx;
 
     enc_dbg_func("%p in\n", enc);
 
-    enc->thread_enc = new MppThread(mpp_enc_thread,
+    memset(&enc->task, 0, sizeof(enc->task));
+    enc->thread_enc = new MppThread(mpp_enc_check, mpp_enc_work,
                                     enc->mpp, "mpp_enc");
     enc->thread_enc->start();
 
@@ -1345,9 +1438,16 @@ MPP_RET mpp_enc_stop_v2(MppEnc ctx)
     enc_dbg_func("%p in\n", enc);
 
     if (enc->thread_enc) {
+        Mpp *mpp = (Mpp *)enc->mpp;
+
         enc->thread_enc->stop();
         delete enc->thread_enc;
         enc->thread_enc = NULL;
+
+        // clear remain task in output port
+        release_task_in_port(mpp_task_queue_get_port(mpp->mInputTaskQueue,
+                                                     MPP_PORT_OUTPUT));
+        release_task_in_port(mpp->mOutputPort);
     }
 
     enc_dbg_func("%p out\n", enc);
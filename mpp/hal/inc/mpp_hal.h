@@ -42,6 +42,12 @@ typedef enum vpu_hard_mode_e {
 
 typedef void*   MppHalCtx;
 
+/*
+ * Max task count of decoder fast mode. Each task in flight on fast mode owns
+ * one register set in hal so the hal register set array is sized by it.
+ */
+#define MPP_HAL_DEC_TASK_MAX    8
+
 typedef struct MppHalCfg_t {
     // input
     MppCtxType      type;
@@ -95,6 +95,8 @@ MPP_RET hal_h264d_init(void *hal, MppHalCfg *cfg)
     p_hal->frame_slots  = cfg->frame_slots;
     p_hal->packet_slots = cfg->packet_slots;
     p_hal->fast_mode = cfg->fast_mode;
+    /* one register set for each task in flight */
+    p_hal->reg_count = MPP_MIN(cfg->task_count, MPP_HAL_DEC_TASK_MAX);
     //!< choose hard mode
     {
         RK_U32 mode = 0;
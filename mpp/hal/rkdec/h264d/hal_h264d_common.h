@@ -246,7 +246,7 @@ typedef struct h264d_refs_list_t {
 } H264dRefsList_t;
 
 typedef struct h264d_vdpu_reg_ctx_t {
-    H264dVdpuBuf_t reg_buf[3];
+    H264dVdpuBuf_t reg_buf[MPP_HAL_DEC_TASK_MAX];
 
     MppBuffer buf;
     void *cabac_ptr;
@@ -127,6 +127,7 @@ typedef struct h264d_hal_ctx_t {
     MppDevCtx                dev_ctx;
     void                     *reg_ctx;
     RK_U32                   fast_mode;
+    RK_U32                   reg_count;
 } H264dHalCtx_t;
 
 
@@ -56,7 +56,7 @@ typedef struct h264d_rkv_reg_ctx_t {
 
     MppBuffer cabac_buf;
     MppBuffer errinfo_buf;
-    H264dRkvBuf_t reg_buf[3];
+    H264dRkvBuf_t reg_buf[MPP_HAL_DEC_TASK_MAX];
 
     MppBuffer spspps_buf;
     MppBuffer rps_buf;
@@ -554,7 +554,7 @@ MPP_RET rkv_h264d_init(void *hal, MppHalCfg *cfg)
                                    &reg_ctx->errinfo_buf, RKV_ERROR_INFO_SIZE));
     // malloc buffers
     RK_U32 i = 0;
-    RK_U32 loop = p_hal->fast_mode ? MPP_ARRAY_ELEMS(reg_ctx->reg_buf) : 1;
+    RK_U32 loop = p_hal->fast_mode ? p_hal->reg_count : 1;
     for (i = 0; i < loop; i++) {
         reg_ctx->reg_buf[i].regs = mpp_calloc(H264dRkvRegs_t, 1);
         FUN_CHECK(ret = mpp_buffer_get(p_hal->buf_group,
@@ -601,7 +601,7 @@ MPP_RET rkv_h264d_deinit(void *hal)
     H264dRkvRegCtx_t *reg_ctx = (H264dRkvRegCtx_t *)p_hal->reg_ctx;
 
     RK_U32 i = 0;
-    RK_U32 loop = p_hal->fast_mode ? MPP_ARRAY_ELEMS(reg_ctx->reg_buf) : 1;
+    RK_U32 loop = p_hal->fast_mode ? p_hal->reg_count : 1;
     for (i = 0; i < loop; i++) {
         MPP_FREE(reg_ctx->reg_buf[i].regs);
         mpp_buffer_put(reg_ctx->reg_buf[i].spspps);
@@ -635,7 +635,7 @@ MPP_RET rkv_h264d_gen_regs(void *hal, HalTaskInfo *task)
     H264dRkvRegCtx_t *reg_ctx = (H264dRkvRegCtx_t *)p_hal->reg_ctx;
     if (p_hal->fast_mode) {
         RK_U32 i = 0;
-        for (i = 0; i <  MPP_ARRAY_ELEMS(reg_ctx->reg_buf); i++) {
+        for (i = 0; i < p_hal->reg_count; i++) {
             if (!reg_ctx->reg_buf[i].valid) {
                 task->dec.reg_index = i;
                 reg_ctx->spspps_buf = reg_ctx->reg_buf[i].spspps;
@@ -690,7 +690,7 @@ MPP_RET vdpu2_h264d_init(void *hal, MppHalCfg *cfg)
     //!< malloc buffers
     {
         RK_U32 i = 0;
-        RK_U32 loop = p_hal->fast_mode ? MPP_ARRAY_ELEMS(reg_ctx->reg_buf) : 1;
+        RK_U32 loop = p_hal->fast_mode ? p_hal->reg_count : 1;
 
         RK_U32 buf_size = VDPU_CABAC_TAB_SIZE +  VDPU_POC_BUF_SIZE + VDPU_SCALING_LIST_SIZE;
         for (i = 0; i < loop; i++) {
@@ -737,7 +737,7 @@ MPP_RET vdpu2_h264d_deinit(void *hal)
     H264dVdpuRegCtx_t *reg_ctx = (H264dVdpuRegCtx_t *)p_hal->reg_ctx;
 
     RK_U32 i = 0;
-    RK_U32 loop = p_hal->fast_mode ? MPP_ARRAY_ELEMS(reg_ctx->reg_buf) : 1;
+    RK_U32 loop = p_hal->fast_mode ? p_hal->reg_count : 1;
     for (i = 0; i < loop; i++) {
         MPP_FREE(reg_ctx->reg_buf[i].regs);
         mpp_buffer_put(reg_ctx->reg_buf[i].buf);
@@ -774,7 +774,7 @@ MPP_RET vdpu2_h264d_gen_regs(void *hal, HalTaskInfo *task)
     H264dVdpuRegCtx_t *reg_ctx = (H264dVdpuRegCtx_t *)p_hal->reg_ctx;
     if (p_hal->fast_mode) {
         RK_U32 i = 0;
-        for (i = 0; i <  MPP_ARRAY_ELEMS(reg_ctx->reg_buf); i++) {
+        for (i = 0; i < p_hal->reg_count; i++) {
             if (!reg_ctx->reg_buf[i].valid) {
                 task->dec.reg_index = i;
                 reg_ctx->buf = reg_ctx->reg_buf[i].buf;
@@ -47,7 +47,7 @@
 static FILE *fp = NULL;
 #endif
 #define HW_RPS
-#define MAX_GEN_REG 3
+#define MAX_GEN_REG MPP_HAL_DEC_TASK_MAX
 RK_U32 h265h_debug = 0;
 typedef struct h265d_reg_buf {
     RK_S32    use_flag;
@@ -66,6 +66,7 @@ typedef struct h265d_reg_context {
     MppBuffer       rps_data;
     void*           hw_regs;
     h265d_reg_buf_t g_buf[MAX_GEN_REG];
+    RK_S32          reg_count;
     RK_U32          fast_mode;
     IOInterruptCB   int_cb;
     MppDevCtx       dev_ctx;
@@ -284,7 +285,7 @@ static MPP_RET hal_h265d_alloc_res(void *hal)
     RK_S32 ret = 0;
     h265d_reg_context_t *reg_cxt = (h265d_reg_context_t *)hal;
     if (reg_cxt->fast_mode) {
-        for (i = 0; i < MAX_GEN_REG; i++) {
+        for (i = 0; i < reg_cxt->reg_count; i++) {
             reg_cxt->g_buf[i].hw_regs =
                 mpp_calloc_size(void, sizeof(H265d_REGS_t));
             ret = mpp_buffer_get(reg_cxt->group,
@@ -417,6 +418,8 @@ MPP_RET hal_h265d_init(void *hal, MppHalCfg *cfg)
     reg_cxt->slots = cfg->frame_slots;
     reg_cxt->int_cb = cfg->hal_int_cb;
     reg_cxt->fast_mode = cfg->fast_mode;
+    /* one register set for each task in flight */
+    reg_cxt->reg_count = MPP_MIN(cfg->task_count, MAX_GEN_REG);
 
     mpp_slots_set_prop(reg_cxt->slots, SLOTS_HOR_ALIGN, hevc_hor_align);
     mpp_slots_set_prop(reg_cxt->slots, SLOTS_VER_ALIGN, hevc_ver_align);
@@ -1693,7 +1696,7 @@ MPP_RET hal_h265d_gen_regs(void *hal,  HalTaskInfo *syn)
 
     void *rps_ptr = NULL;
     if (reg_cxt ->fast_mode) {
-        for (i = 0; i < MAX_GEN_REG; i++) {
+        for (i = 0; i < reg_cxt->reg_count; i++) {
             if (!reg_cxt->g_buf[i].use_flag) {
                 syn->dec.reg_index = i;
                 reg_cxt->rps_data = reg_cxt->g_buf[i].rps_data;
@@ -1705,7 +1708,7 @@ MPP_RET hal_h265d_gen_regs(void *hal,  HalTaskInfo *syn)
                 break;
             }
         }
-        if (i == MAX_GEN_REG) {
+        if (i == reg_cxt->reg_count) {
             mpp_err("hevc rps buf all used");
             return MPP_ERR_NOMEM;
         }
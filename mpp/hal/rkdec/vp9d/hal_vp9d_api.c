@@ -70,7 +70,7 @@ typedef struct vp9_dec_last_info {
     UCHAR feature_mask[8];
 } vp9_dec_last_info_t;
 
-#define MAX_GEN_REG 3
+#define MAX_GEN_REG MPP_HAL_DEC_TASK_MAX
 typedef struct vp9d_reg_buf {
     RK_S32    use_flag;
     MppBuffer probe_base;
@@ -86,6 +86,7 @@ typedef struct hal_vp9_context {
     MppDevCtx       dev_ctx;
     MppBufferGroup group;
     vp9d_reg_buf_t g_buf[MAX_GEN_REG];
+    RK_S32 reg_count;
     MppBuffer probe_base;
     MppBuffer count_base;
     MppBuffer segid_cur_base;
@@ -119,7 +120,7 @@ static MPP_RET hal_vp9d_alloc_res(hal_vp9_context_t *reg_cxt)
     RK_S32 ret = 0;
 
     if (reg_cxt->fast_mode) {
-        for (i = 0; i < MAX_GEN_REG; i++) {
+        for (i = 0; i < reg_cxt->reg_count; i++) {
             reg_cxt->g_buf[i].hw_regs = mpp_calloc_size(void, sizeof(VP9_REGS));
             ret = mpp_buffer_get(reg_cxt->group,
                                  &reg_cxt->g_buf[i].probe_base, PROBE_SIZE);
@@ -271,6 +272,8 @@ MPP_RET hal_vp9d_init(void *hal, MppHalCfg *cfg)
     reg_cxt->mv_base_addr = -1;
     reg_cxt->pre_mv_base_addr = -1;
     reg_cxt->fast_mode = cfg->fast_mode;
+    /* one register set for each task in flight */
+    reg_cxt->reg_count = MPP_MIN(cfg->task_count, MAX_GEN_REG);
     mpp_slots_set_prop(reg_cxt->slots, SLOTS_HOR_ALIGN, vp9_hor_align);
     mpp_slots_set_prop(reg_cxt->slots, SLOTS_VER_ALIGN, vp9_ver_align);
     reg_cxt->packet_slots = cfg->packet_slots;
@@ -708,7 +711,7 @@ MPP_RET hal_vp9d_gen_regs(void *hal, HalTaskInfo *task)
     DXVA_PicParams_VP9 *pic_param = (DXVA_PicParams_VP9*)task->dec.syntax.data;
 
     if (reg_cxt ->fast_mode) {
-        for (i = 0; i < MAX_GEN_REG; i++) {
+        for (i = 0; i < reg_cxt->reg_count; i++) {
             if (!reg_cxt->g_buf[i].use_flag) {
                 task->dec.reg_index = i;
                 reg_cxt->probe_base = reg_cxt->g_buf[i].probe_base;
@@ -720,7 +723,7 @@ MPP_RET hal_vp9d_gen_regs(void *hal, HalTaskInfo *task)
                 break;
             }
         }
-        if (i == MAX_GEN_REG) {
+        if (i == reg_cxt->reg_count) {
             mpp_err("vp9 fast mode buf all used\n");
             return MPP_ERR_NOMEM;
         }
@@ -18,6 +18,7 @@
 #define __MPP_H__
 
 #include "mpp_queue.h"
+#include "mpp_spsc_queue.h"
 #include "mpp_task_impl.h"
 
 #include "mpp_dec.h"
@@ -114,9 +115,18 @@ public:
     MPP_RET notify(RK_U32 flag);
     MPP_RET notify(MppBufferGroup group);
 
-    mpp_list        *mPackets;
-    mpp_list        *mFrames;
+    /*
+     * decoder input packet / output frame queue
+     * single producer lock-free queue, only wait on empty takes the lock
+     */
+    MppSpscQueue    *mPackets;
+    MppSpscQueue    *mFrames;
     mpp_list        *mTimeStamps;
+    /* packet / frame count allowed in queue, configurable before init */
+    RK_U32          mInputQueueDepth;
+    RK_U32          mOutputQueueDepth;
+    /* put_packet takes user payload without copy when release is set */
+    MppPacketRefCfg mPacketRef;
     /* counters for debug */
     RK_U32          mPacketPutCount;
     RK_U32          mPacketGetCount;
@@ -167,6 +177,7 @@ private:
 
     /* decoder paramter before init */
     RK_U32          mParserFastMode;
+    RK_U32          mParserBatchDepth;
     RK_U32          mParserNeedSplit;
     RK_U32          mParserInternalPts;     /* for MPEG2/MPEG4 */
     RK_U32          mImmediateOut;
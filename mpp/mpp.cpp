@@ -17,6 +17,7 @@
 #define  MODULE_TAG "mpp"
 
 #include <errno.h>
+#include <string.h>
 
 #include "rk_mpi.h"
 
@@ -25,6 +26,7 @@
 #include "mpp_env.h"
 #include "mpp_time.h"
 #include "mpp_impl.h"
+#include "mpp_trace.h"
 
 #include "mpp.h"
 #include "mpp_hal.h"
@@ -44,6 +46,18 @@ static void mpp_notify_by_buffer_group(void *arg, void *group)
     mpp->notify((MppBufferGroup) group);
 }
 
+/*
+ * Extra room in the queues besides the configured depth
+ * Packet queue always accepts eos packet and the restored extra data packet.
+ * Frame queue is not throttled when decoder flushes all the frames in dpb.
+ */
+#define MPP_PACKET_QUEUE_EXTRA      4
+#define MPP_FRAME_QUEUE_EXTRA       64
+/* timestamps of the frames held in dpb and hal besides the frame queue */
+#define MPP_TIMESTAMP_QUEUE_EXTRA   32
+/* max depth of input / output queue set by user */
+#define MPP_QUEUE_DEPTH_MAX         64
+
 static void *list_wraper_packet(void *arg)
 {
     mpp_packet_deinit((MppPacket *)arg);
@@ -60,6 +74,8 @@ Mpp::Mpp()
     : mPackets(NULL),
       mFrames(NULL),
       mTimeStamps(NULL),
+      mInputQueueDepth(4),
+      mOutputQueueDepth(4),
       mPacketPutCount(0),
       mPacketGetCount(0),
       mFramePutCount(0),
@@ -85,19 +101,29 @@ Mpp::Mpp()
       mMultiFrame(0),
       mStatus(0),
       mParserFastMode(0),
+      mParserBatchDepth(0),
       mParserNeedSplit(0),
       mParserInternalPts(0),
       mImmediateOut(0),
       mExtraPacket(NULL),
       mDump(NULL)
 {
+    mPacketRef.release = NULL;
+    mPacketRef.ctx = NULL;
+
     mpp_env_get_u32("mpp_debug", &mpp_debug, 0);
     mpp_dump_init(&mDump);
 }
 
 MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
 {
-    if (mpp_check_support_format(type, coding)) {
+    RK_U32 dummy = 0;
+
+    /* dummy decoder runs the whole pipeline without hardware for test */
+    if (type == MPP_CTX_DEC && coding == MPP_VIDEO_CodingUnused)
+        mpp_env_get_u32("mpp_dec_dummy", &dummy, 0);
+
+    if (!dummy && mpp_check_support_format(type, coding)) {
         mpp_err("unable to create unsupported type %d coding %d\n", type, coding);
         return MPP_NOK;
     }
@@ -112,9 +138,13 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
 
     switch (mType) {
     case MPP_CTX_DEC : {
-        mPackets    = new mpp_list(list_wraper_packet);
-        mFrames     = new mpp_list(list_wraper_frame);
-        mTimeStamps = new mpp_list(list_wraper_packet);
+        mPackets    = new MppSpscQueue(mInputQueueDepth + MPP_PACKET_QUEUE_EXTRA,
+                                       list_wraper_packet);
+        mFrames     = new MppSpscQueue(mOutputQueueDepth + MPP_FRAME_QUEUE_EXTRA,
+                                       list_wraper_frame);
+        mTimeStamps = new mpp_list(sizeof(MppPacket),
+                                   mOutputQueueDepth + MPP_FRAME_QUEUE_EXTRA +
+                                   MPP_TIMESTAMP_QUEUE_EXTRA, list_wraper_packet);
 
         if (mInputTimeout == MPP_POLL_BUTT)
             mInputTimeout = MPP_POLL_NON_BLOCK;
@@ -139,6 +169,7 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         MppDecCfg cfg = {
             coding,
             mParserFastMode,
+            mParserBatchDepth,
             mParserNeedSplit,
             mParserInternalPts,
             mImmediateOut,
@@ -151,8 +182,8 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         mInitDone = 1;
     } break;
     case MPP_CTX_ENC : {
-        mFrames     = new mpp_list(NULL);
-        mPackets    = new mpp_list(list_wraper_packet);
+        mFrames     = new MppSpscQueue(mOutputQueueDepth, NULL);
+        mPackets    = new MppSpscQueue(mInputQueueDepth, list_wraper_packet);
 
         if (mInputTimeout == MPP_POLL_BUTT)
             mInputTimeout = MPP_POLL_BLOCK;
@@ -285,20 +316,31 @@ MPP_RET Mpp::put_packet(MppPacket packet)
     if (!mInitDone)
         return MPP_ERR_INIT;
 
-    AutoMutex autoLock(mPackets->mutex());
     if (mExtraPacket) {
-        mPackets->add_at_tail(&mExtraPacket, sizeof(mExtraPacket));
-        mExtraPacket = NULL;
-        mPacketPutCount++;
+        if (MPP_OK == mPackets->push(mExtraPacket)) {
+            mExtraPacket = NULL;
+            mPacketPutCount++;
+        }
     }
 
     RK_U32 eos = mpp_packet_get_eos(packet);
-    if (mPackets->list_size() < 4 || eos) {
+    if (mPackets->size() < (RK_S32)mInputQueueDepth || eos) {
         MppPacket pkt;
-        if (MPP_OK != mpp_packet_copy_init(&pkt, packet))
+        MPP_RET ret = (mPacketRef.release) ?
+                      mpp_packet_ref_init(&pkt, packet, mPacketRef.release, mPacketRef.ctx) :
+                      mpp_packet_copy_init(&pkt, packet);
+
+        if (MPP_OK != ret)
             return MPP_NOK;
 
-        mPackets->add_at_tail(&pkt, sizeof(pkt));
+        if (MPP_OK != mPackets->push(pkt)) {
+            /* payload is still owned by user on failure */
+            ((MppPacketImpl *)pkt)->release = NULL;
+            mpp_packet_deinit(&pkt);
+            return MPP_ERR_BUFFER_FULL;
+        }
+        mpp_trace_mark("put_packet", this, mPacketPutCount, -1,
+                       (RK_S32)mpp_packet_get_length(packet));
         mPacketPutCount++;
         // dump input packet
         mpp_ops_dec_put_pkt(mDump, packet);
@@ -318,39 +360,36 @@ MPP_RET Mpp::get_frame(MppFrame *frame)
     if (!mInitDone)
         return MPP_ERR_INIT;
 
-    AutoMutex autoFrameLock(mFrames->mutex());
     MppFrame first = NULL;
 
-    if (0 == mFrames->list_size()) {
+    if (0 == mFrames->size()) {
         if (mOutputTimeout) {
-            if (mOutputTimeout < 0) {
-                /* block wait */
-                mFrames->wait();
-            } else {
-                RK_S32 ret = mFrames->wait(mOutputTimeout);
-                if (ret) {
-                    if (ret == ETIMEDOUT)
-                        return MPP_ERR_TIMEOUT;
-                    else
-                        return MPP_NOK;
-                }
+            /* negative timeout is block wait */
+            RK_S32 ret = mFrames->wait(mOutputTimeout);
+            if (ret) {
+                if (ret == ETIMEDOUT)
+                    return MPP_ERR_TIMEOUT;
+                else
+                    return MPP_NOK;
             }
         } else {
-            /* NOTE: in non-block mode the sleep is to avoid user's dead loop */
-            msleep(1);
+            /*
+             * NOTE: in non-block mode the wait is to avoid user's dead loop
+             * but it returns as soon as a frame is ready
+             */
+            mFrames->wait(1);
         }
     }
 
-    if (mFrames->list_size()) {
-        mFrames->del_at_head(&first, sizeof(frame));
+    if (MPP_OK == mFrames->pop(&first)) {
+        mpp_trace_mark("get_frame", this, mFrameGetCount, -1, 0);
         mFrameGetCount++;
         notify(MPP_OUTPUT_DEQUEUE);
 
         if (mMultiFrame) {
             MppFrame prev = first;
             MppFrame next = NULL;
-            while (mFrames->list_size()) {
-                mFrames->del_at_head(&next, sizeof(frame));
+            while (MPP_OK == mFrames->pop(&next)) {
                 mFrameGetCount++;
                 notify(MPP_OUTPUT_DEQUEUE);
                 mpp_frame_set_next(prev, next);
@@ -364,8 +403,7 @@ MPP_RET Mpp::get_frame(MppFrame *frame)
         // There is no way to wake up parser thread to continue decoding.
         // The put_packet only signal sem on may be it better to use sem on info
         // change too.
-        AutoMutex autoPacketLock(mPackets->mutex());
-        if (mPackets->list_size())
+        if (mPackets->size())
             notify(MPP_INPUT_ENQUEUE);
     }
 
@@ -642,10 +680,9 @@ MPP_RET Mpp::reset()
          * To avoid this case happen we need to save it on reset beginning
          * then restore it on reset end.
          */
-        mPackets->lock();
-        while (mPackets->list_size()) {
-            MppPacket pkt = NULL;
-            mPackets->del_at_head(&pkt, sizeof(pkt));
+        MppPacket pkt = NULL;
+
+        while (MPP_OK == mPackets->pop(&pkt)) {
             mPacketGetCount++;
 
             RK_U32 flags = mpp_packet_get_flag(pkt);
@@ -659,17 +696,12 @@ MPP_RET Mpp::reset()
             }
         }
         mPackets->flush();
-        mPackets->unlock();
 
         mpp_dec_reset(mDec);
 
-        mFrames->lock();
         mFrames->flush();
-        mFrames->unlock();
     } else {
-        mFrames->lock();
         mFrames->flush();
-        mFrames->unlock();
 
         if (mEncVersion) {
             mpp_enc_reset_v2(mEnc);
@@ -677,9 +709,7 @@ MPP_RET Mpp::reset()
             mpp_enc_reset(mEnc);
         }
 
-        mPackets->lock();
         mPackets->flush();
-        mPackets->unlock();
     }
 
     return MPP_OK;
@@ -727,6 +757,56 @@ MPP_RET Mpp::control_mpp(MpiCmd cmd, MppParam param)
             mOutputTimeout = timeout;
     } break;
 
+    case MPP_SET_INPUT_QUEUE_DEPTH:
+    case MPP_SET_OUTPUT_QUEUE_DEPTH: {
+        RK_U32 depth = (param) ? *((RK_U32 *)param) : 0;
+
+        if (mInitDone) {
+            mpp_err("queue depth should be set before init\n");
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+
+        if (!depth || depth > MPP_QUEUE_DEPTH_MAX) {
+            mpp_err("invalid queue depth %d should be in range [1, %d]\n",
+                    depth, MPP_QUEUE_DEPTH_MAX);
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+
+        if (cmd == MPP_SET_INPUT_QUEUE_DEPTH)
+            mInputQueueDepth = depth;
+        else
+            mOutputQueueDepth = depth;
+    } break;
+    case MPP_SET_INPUT_PACKET_REF: {
+        if (param) {
+            mPacketRef = *((MppPacketRefCfg *)param);
+        } else {
+            mPacketRef.release = NULL;
+            mPacketRef.ctx = NULL;
+        }
+    } break;
+    case MPP_GET_STATS: {
+        MppStats *stats = (MppStats *)param;
+
+        if (NULL == stats) {
+            ret = MPP_ERR_NULL_PTR;
+            break;
+        }
+
+        memset(stats, 0, sizeof(*stats));
+        stats->packet_put = mPacketPutCount;
+        stats->packet_get = mPacketGetCount;
+        stats->frame_put = mFramePutCount;
+        stats->frame_get = mFrameGetCount;
+
+        if (mDec)
+            ret = mpp_dec_get_stats(mDec, stats);
+        else if (mEnc && mEncVersion)
+            ret = mpp_enc_get_stats_v2(mEnc, stats);
+    } break;
+
     default : {
         ret = MPP_NOK;
     } break;
@@ -741,8 +821,17 @@ MPP_RET Mpp::control_osal(MpiCmd cmd, MppParam param)
     mpp_assert(cmd > MPP_OSAL_CMD_BASE);
     mpp_assert(cmd < MPP_OSAL_CMD_END);
 
-    (void)cmd;
-    (void)param;
+    switch (cmd) {
+    case MPP_OSAL_DUMP_MEM_STAT : {
+        ret = mpp_show_mem_stat();
+    } break;
+    case MPP_OSAL_DUMP_TRACE : {
+        ret = mpp_trace_dump((const char *)param);
+    } break;
+    default : {
+    } break;
+    }
+
     return ret;
 }
 
@@ -810,9 +899,24 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
         mParserFastMode = flag;
         ret = MPP_OK;
     } break;
+    case MPP_DEC_SET_PARSER_BATCH_DEPTH: {
+        RK_U32 depth = *((RK_U32 *)param);
+
+        if (depth > MPP_HAL_DEC_TASK_MAX) {
+            mpp_err("invalid batch depth %d should be in range [0, %d]\n",
+                    depth, MPP_HAL_DEC_TASK_MAX);
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+
+        /* batch parsing relies on fast mode task flow */
+        mParserBatchDepth = depth;
+        if (depth)
+            mParserFastMode = 1;
+        ret = MPP_OK;
+    } break;
     case MPP_DEC_GET_STREAM_COUNT: {
-        AutoMutex autoLock(mPackets->mutex());
-        *((RK_S32 *)param) = mPackets->list_size();
+        *((RK_S32 *)param) = mPackets->size();
         ret = MPP_OK;
     } break;
     case MPP_DEC_SET_IMMEDIATE_OUT: {
@@ -821,6 +925,25 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
         if (mDec)
             ret = mpp_dec_control(mDec, cmd, param);
     } break;
+    case MPP_DEC_SET_PRE_ALLOC_BUFF: {
+        if (!mInitDone) {
+            mpp_err("pre alloc buffer should be called after mpp_init\n");
+            ret = MPP_ERR_INIT;
+        } else
+            ret = mpp_dec_control(mDec, cmd, param);
+    } break;
+    case MPP_DEC_SET_SKIP_MODE: {
+        RK_U32 mode = *((RK_U32 *)param);
+
+        if (mode >= MPP_DEC_SKIP_BUTT) {
+            mpp_err("invalid skip mode %d\n", mode);
+            ret = MPP_ERR_VALUE;
+        } else if (!mInitDone) {
+            mpp_err("skip mode should be set after mpp_init\n");
+            ret = MPP_ERR_INIT;
+        } else
+            ret = mpp_dec_control(mDec, cmd, param);
+    } break;
     case MPP_DEC_GET_VPUMEM_USED_COUNT:
     case MPP_DEC_SET_OUTPUT_FORMAT:
     case MPP_DEC_SET_DISABLE_ERROR:
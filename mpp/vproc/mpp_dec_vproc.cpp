@@ -20,6 +20,7 @@
 
 #include "mpp_env.h"
 #include "mpp_mem.h"
+#include "mpp_time.h"
 #include "mpp_common.h"
 
 #include "mpp_dec_impl.h"
@@ -74,7 +75,7 @@ typedef struct MppDecVprocCtxImpl_t {
 
 static void dec_vproc_put_frame(Mpp *mpp, MppFrame frame, MppBuffer buf, RK_S64 pts)
 {
-    mpp_list *list = mpp->mFrames;
+    MppSpscQueue *frames = mpp->mFrames;
     MppFrame out = NULL;
     MppFrameImpl *impl = NULL;
 
@@ -86,15 +87,13 @@ static void dec_vproc_put_frame(Mpp *mpp, MppFrame frame, MppBuffer buf, RK_S64
     if (buf)
         impl->buffer = buf;
 
-    list->lock();
-    list->add_at_tail(&out, sizeof(out));
-
     if (mpp_debug & MPP_DBG_PTS)
         mpp_log("output frame pts %lld\n", mpp_frame_get_pts(out));
 
+    /* queue room is far beyond display queue limit, just in case */
+    while (frames->push(out))
+        msleep(1);
     mpp->mFramePutCount++;
-    list->signal();
-    list->unlock();
 }
 
 static void dec_vproc_clr_prev(MppDecVprocCtxImpl *ctx)
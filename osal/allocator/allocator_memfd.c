@@ -0,0 +1,288 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "allocator_memfd"
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_common.h"
+
+#include "allocator_memfd.h"
+#include "allocator_page.h"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC             0x0001U
+#endif
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB             0x0004U
+#endif
+
+#define MEMFD_DBG_FUNC          (0x00000001)
+
+#define memfd_dbg(flag, fmt, ...)   _mpp_dbg_f(memfd_debug, flag, fmt, ## __VA_ARGS__)
+#define memfd_dbg_func(fmt, ...)    memfd_dbg(MEMFD_DBG_FUNC, fmt, ## __VA_ARGS__)
+
+static RK_U32 memfd_debug = 0;
+
+/*
+ * env mpp_memfd_hugetlb - create memfd with MFD_HUGETLB, fall back to normal
+ *                         page when no huge page is available
+ * env mpp_memfd_path    - create unlinked file in the directory instead of
+ *                         memfd, eg. a hugetlbfs or tmpfs mount point
+ */
+typedef struct {
+    size_t          alignment;
+    RK_U32          hugetlb;
+    const char      *path;
+    MppBufferPage   page;
+    RK_S32          numa_node;
+} allocator_ctx;
+
+static int memfd_create_fd(allocator_ctx *p, RK_U32 hugetlb)
+{
+    int fd = -1;
+
+    if (p->path) {
+        char name[256];
+
+        snprintf(name, sizeof(name), "%s/mpp_buffer_XXXXXX", p->path);
+        fd = mkstemp(name);
+        if (fd >= 0) {
+            unlink(name);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        return fd;
+    }
+
+#ifdef SYS_memfd_create
+    fd = syscall(SYS_memfd_create, "mpp_buffer",
+                 MFD_CLOEXEC | (hugetlb ? MFD_HUGETLB : 0));
+#else
+    (void)hugetlb;
+    errno = ENOSYS;
+#endif
+
+    return fd;
+}
+
+/* hugetlb file size and mapping length must be huge page aligned */
+static size_t memfd_map_size(int fd, size_t size)
+{
+    struct stat st;
+
+    if (fstat(fd, &st) || st.st_blksize <= 0)
+        return size;
+
+    return MPP_ALIGN(size, (size_t)st.st_blksize);
+}
+
+static MPP_RET memfd_map(MppBufferInfo *info)
+{
+    size_t map_size = memfd_map_size(info->fd, info->size);
+    void *ptr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     info->fd, 0);
+
+    if (ptr == MAP_FAILED)
+        return MPP_NOK;
+
+    info->ptr = ptr;
+    /* hnd keeps the mapping length for munmap */
+    info->hnd = (void *)(intptr_t)map_size;
+    return MPP_OK;
+}
+
+static void memfd_unmap(MppBufferInfo *info)
+{
+    if (info->ptr) {
+        munmap(info->ptr, (size_t)(intptr_t)info->hnd);
+        info->ptr = NULL;
+    }
+    info->hnd = NULL;
+}
+
+static MPP_RET allocator_memfd_open(void **ctx, MppAllocatorCfg *cfg)
+{
+    allocator_ctx *p = NULL;
+
+    if (NULL == ctx) {
+        mpp_err_f("do not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_env_get_u32("memfd_debug", &memfd_debug, 0);
+
+    p = mpp_calloc(allocator_ctx, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to allocate context\n");
+        *ctx = NULL;
+        return MPP_ERR_MALLOC;
+    }
+
+    p->alignment = cfg->alignment;
+    p->page = cfg->page;
+    p->numa_node = cfg->numa_node;
+    mpp_env_get_u32("mpp_memfd_hugetlb", &p->hugetlb, 0);
+    mpp_env_get_str("mpp_memfd_path", &p->path, NULL);
+
+    *ctx = p;
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_alloc(void *ctx, MppBufferInfo *info)
+{
+    allocator_ctx *p = (allocator_ctx *)ctx;
+    RK_U32 hugetlb;
+
+    if (NULL == p) {
+        mpp_err_f("found NULL context input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    hugetlb = p->hugetlb || p->page == MPP_BUFFER_PAGE_HUGETLB;
+
+    /* huge page pool may be exhausted, retry with normal page */
+    for (; ; hugetlb = 0) {
+        int fd = memfd_create_fd(p, hugetlb);
+
+        if (fd >= 0) {
+            info->fd = fd;
+            if (!ftruncate(fd, memfd_map_size(fd, info->size)) &&
+                !memfd_map(info)) {
+                memfd_dbg_func("fd %d size %d map %p hugetlb %d\n", fd,
+                               info->size, info->ptr, hugetlb);
+                /* thp advice is only for normal page mapping */
+                allocator_page_apply(info->ptr, (size_t)(intptr_t)info->hnd,
+                                     hugetlb ? MPP_BUFFER_PAGE_DEFAULT : p->page,
+                                     p->numa_node);
+                return MPP_OK;
+            }
+
+            close(fd);
+            info->fd = -1;
+        }
+
+        if (!hugetlb || p->path)
+            break;
+
+        mpp_log_f("hugetlb size %d failed %s retry normal page\n",
+                  info->size, strerror(errno));
+    }
+
+    mpp_err_f("failed to alloc size %d %s\n", info->size, strerror(errno));
+    return MPP_ERR_MALLOC;
+}
+
+static MPP_RET allocator_memfd_free(void *ctx, MppBufferInfo *info)
+{
+    (void)ctx;
+
+    memfd_dbg_func("fd %d size %d ptr %p\n", info->fd, info->size, info->ptr);
+
+    memfd_unmap(info);
+    if (info->fd >= 0)
+        close(info->fd);
+    info->fd = -1;
+
+    return MPP_OK;
+}
+
+/*
+ * Import fd from other process or other group. The fd is duplicated so the
+ * buffer owns its fd and the mapping is created on mmap. The input ptr is
+ * ignored as it may belong to the other process.
+ */
+static MPP_RET allocator_memfd_import(void *ctx, MppBufferInfo *info)
+{
+    int fd;
+
+    mpp_assert(ctx);
+    mpp_assert(info->size);
+
+    if (info->fd < 0) {
+        mpp_err_f("invalid fd %d\n", info->fd);
+        return MPP_ERR_VALUE;
+    }
+
+    fd = fcntl(info->fd, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0) {
+        mpp_err_f("failed to dup fd %d %s\n", info->fd, strerror(errno));
+        return MPP_NOK;
+    }
+
+    info->fd = fd;
+    info->ptr = NULL;
+    info->hnd = NULL;
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_mmap(void *ctx, MppBufferInfo *info)
+{
+    mpp_assert(ctx);
+    mpp_assert(info->size);
+    mpp_assert(info->fd >= 0);
+
+    if (info->ptr)
+        return MPP_OK;
+
+    if (memfd_map(info)) {
+        mpp_err_f("failed to mmap fd %d size %d %s\n", info->fd, info->size,
+                  strerror(errno));
+        return MPP_ERR_NULL_PTR;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_config(void *ctx, MppAllocatorCfg *cfg)
+{
+    allocator_ctx *p = (allocator_ctx *)ctx;
+
+    p->page = cfg->page;
+    p->numa_node = cfg->numa_node;
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_close(void *ctx)
+{
+    if (ctx) {
+        mpp_free(ctx);
+        return MPP_OK;
+    }
+
+    mpp_err_f("found NULL context input\n");
+    return MPP_NOK;
+}
+
+os_allocator allocator_memfd = {
+    .open = allocator_memfd_open,
+    .close = allocator_memfd_close,
+    .alloc = allocator_memfd_alloc,
+    .free = allocator_memfd_free,
+    .import = allocator_memfd_import,
+    .release = allocator_memfd_free,
+    .mmap = allocator_memfd_mmap,
+    .config = allocator_memfd_config,
+};
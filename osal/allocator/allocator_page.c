@@ -0,0 +1,127 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "allocator_page"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "mpp_log.h"
+#include "mpp_common.h"
+
+#include "allocator_page.h"
+
+/* avoid libnuma dependency, values from linux/mempolicy.h */
+#define PAGE_MPOL_BIND          2
+#define PAGE_MPOL_MF_MOVE       (1 << 1)
+
+void *allocator_page_map(size_t size, MppBufferPage page, size_t *map_size)
+{
+    size_t huge = ALLOCATOR_HUGE_PAGE_SIZE;
+    size_t len = 0;
+    RK_U8 *ptr = NULL;
+    RK_U8 *start = NULL;
+
+    /* numa only placement keeps normal page granularity */
+    if (page != MPP_BUFFER_PAGE_THP && page != MPP_BUFFER_PAGE_HUGETLB) {
+        len = MPP_ALIGN(size, (size_t)sysconf(_SC_PAGESIZE));
+        ptr = (RK_U8 *)mmap(NULL, len, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+            return NULL;
+
+        *map_size = len;
+        return ptr;
+    }
+
+    len = MPP_ALIGN(size, huge);
+
+#ifdef MAP_HUGETLB
+    if (page == MPP_BUFFER_PAGE_HUGETLB) {
+        ptr = (RK_U8 *)mmap(NULL, len, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED) {
+            *map_size = len;
+            return ptr;
+        }
+
+        mpp_log_f("hugetlb size %d failed %s retry normal page\n",
+                  size, strerror(errno));
+    }
+#endif
+
+    /* over map one huge page then trim to huge page aligned range for thp */
+    ptr = (RK_U8 *)mmap(NULL, len + huge, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+    start = (RK_U8 *)MPP_ALIGN((intptr_t)ptr, huge);
+    if (start > ptr)
+        munmap(ptr, start - ptr);
+    if (start + len < ptr + len + huge)
+        munmap(start + len, ptr + len + huge - (start + len));
+
+    *map_size = len;
+    return start;
+}
+
+void allocator_page_unmap(void *ptr, size_t map_size)
+{
+    if (ptr && map_size)
+        munmap(ptr, map_size);
+}
+
+MPP_RET allocator_page_apply(void *ptr, size_t size, MppBufferPage page,
+                             RK_S32 numa_node)
+{
+    MPP_RET ret = MPP_OK;
+
+#ifdef MADV_HUGEPAGE
+    if (page == MPP_BUFFER_PAGE_THP && madvise(ptr, size, MADV_HUGEPAGE)) {
+        mpp_err_f("madvise thp %p size %d failed %s\n", ptr, size,
+                  strerror(errno));
+        ret = MPP_NOK;
+    }
+#endif
+
+    if (numa_node >= 0) {
+#ifdef SYS_mbind
+        unsigned long mask = 0;
+
+        if (numa_node >= (RK_S32)(sizeof(mask) * 8)) {
+            mpp_err_f("numa node %d is not supported\n", numa_node);
+            return MPP_NOK;
+        }
+
+        mask = 1UL << numa_node;
+        if (syscall(SYS_mbind, ptr, size, PAGE_MPOL_BIND, &mask,
+                    sizeof(mask) * 8 + 1, PAGE_MPOL_MF_MOVE)) {
+            mpp_err_f("bind %p size %d to node %d failed %s\n", ptr, size,
+                      numa_node, strerror(errno));
+            ret = MPP_NOK;
+        }
+#else
+        mpp_err_f("numa binding is not supported\n");
+        ret = MPP_NOK;
+#endif
+    }
+
+    return ret;
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ALLOCATOR_PAGE_H__
+#define __ALLOCATOR_PAGE_H__
+
+#include "mpp_allocator.h"
+
+#define ALLOCATOR_HUGE_PAGE_SIZE    (SZ_1M * 2)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Page placement helper for allocator with mapping of its own
+ *
+ * allocator_page_map   - anonymous private mapping with the page policy,
+ *                        return NULL on failure, map_size is for unmap
+ * allocator_page_apply - apply thp advice and numa binding on mapping before
+ *                        the pages are touched
+ */
+void *allocator_page_map(size_t size, MppBufferPage page, size_t *map_size);
+void allocator_page_unmap(void *ptr, size_t map_size);
+MPP_RET allocator_page_apply(void *ptr, size_t size, MppBufferPage page,
+                             RK_S32 numa_node);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__ALLOCATOR_PAGE_H__*/
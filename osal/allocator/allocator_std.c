@@ -15,16 +15,20 @@
  */
 
 #include <stdio.h>
+#include <stdint.h>
 
 #include "os_mem.h"
 #include "mpp_mem.h"
 #include "mpp_log.h"
 
 #include "allocator_std.h"
+#include "allocator_page.h"
 
 typedef struct {
     size_t alignment;
     RK_S32 fd_count;
+    MppBufferPage page;
+    RK_S32 numa_node;
 } allocator_ctx;
 
 static MPP_RET allocator_std_open(void **ctx, MppAllocatorCfg *cfg)
@@ -41,10 +45,12 @@ static MPP_RET allocator_std_open(void **ctx, MppAllocatorCfg *cfg)
     if (NULL == p) {
         mpp_err_f("failed to allocate context\n");
         ret = MPP_ERR_MALLOC;
-    } else
+    } else {
         p->alignment = cfg->alignment;
-
-    p->fd_count = 0;
+        p->fd_count = 0;
+        p->page = cfg->page;
+        p->numa_node = cfg->numa_node;
+    }
 
     *ctx = p;
     return ret;
@@ -61,14 +67,35 @@ static MPP_RET allocator_std_alloc(void *ctx, MppBufferInfo *info)
 
     p = (allocator_ctx *)ctx;
     info->fd = p->fd_count++;
-    return (MPP_RET)os_malloc(&info->ptr, p->alignment, info->size);
+    info->hnd = NULL;
+
+    if (p->page == MPP_BUFFER_PAGE_DEFAULT && p->numa_node < 0)
+        return (MPP_RET)os_malloc(&info->ptr, p->alignment, info->size);
+
+    /* placement needs a mapping of its own, hnd keeps the mapping length */
+    {
+        size_t map_size = 0;
+
+        info->ptr = allocator_page_map(info->size, p->page, &map_size);
+        if (NULL == info->ptr)
+            return MPP_ERR_MALLOC;
+
+        info->hnd = (void *)(intptr_t)map_size;
+        allocator_page_apply(info->ptr, map_size, p->page, p->numa_node);
+    }
+
+    return MPP_OK;
 }
 
 static MPP_RET allocator_std_free(void *ctx, MppBufferInfo *info)
 {
     (void) ctx;
-    if (info->ptr)
-        os_free(info->ptr);
+    if (info->ptr) {
+        if (info->hnd)
+            allocator_page_unmap(info->ptr, (size_t)(intptr_t)info->hnd);
+        else
+            os_free(info->ptr);
+    }
     return MPP_OK;
 }
 
@@ -103,6 +130,15 @@ static MPP_RET allocator_std_mmap(void *ctx, MppBufferInfo *info)
     return MPP_OK;
 }
 
+static MPP_RET allocator_std_config(void *ctx, MppAllocatorCfg *cfg)
+{
+    allocator_ctx *p = (allocator_ctx *)ctx;
+
+    p->page = cfg->page;
+    p->numa_node = cfg->numa_node;
+    return MPP_OK;
+}
+
 static MPP_RET allocator_std_close(void *ctx)
 {
     if (ctx) {
@@ -121,5 +157,6 @@ os_allocator allocator_std = {
     .import = allocator_std_import,
     .release = allocator_std_release,
     .mmap = allocator_std_mmap,
+    .config = allocator_std_config,
 };
 
@@ -26,6 +26,9 @@ typedef struct MppAllocatorCfg_t {
     // input
     size_t          alignment;
     RK_U32          flags;
+    // placement of the allocated memory
+    MppBufferPage   page;
+    RK_S32          numa_node;
 } MppAllocatorCfg;
 
 typedef struct MppAllocatorApi_t {
@@ -37,6 +40,8 @@ typedef struct MppAllocatorApi_t {
     MPP_RET (*import)(MppAllocator allocator, MppBufferInfo *data);
     MPP_RET (*release)(MppAllocator allocator, MppBufferInfo *data);
     MPP_RET (*mmap)(MppAllocator allocator, MppBufferInfo *data);
+    /* version 2: placement of later allocation, only page / numa_node is used */
+    MPP_RET (*config)(MppAllocator allocator, MppAllocatorCfg *cfg);
 } MppAllocatorApi;
 
 #ifdef __cplusplus
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_ATOMIC_H__
+#define __MPP_ATOMIC_H__
+
+/*
+ * atomic operation on gcc / clang builtin
+ *
+ * MPP_FETCH_XXX / MPP_XXX_FETCH / MPP_BOOL_CAS / MPP_VAL_CAS are full barrier
+ * MPP_LOAD_XXX / MPP_STORE_XXX are for lock-free index handoff between
+ * producer and consumer
+ */
+#define MPP_FETCH_ADD                   __sync_fetch_and_add
+#define MPP_FETCH_SUB                   __sync_fetch_and_sub
+#define MPP_FETCH_OR                    __sync_fetch_and_or
+#define MPP_FETCH_AND                   __sync_fetch_and_and
+
+#define MPP_ADD_FETCH                   __sync_add_and_fetch
+#define MPP_SUB_FETCH                   __sync_sub_and_fetch
+#define MPP_OR_FETCH                    __sync_or_and_fetch
+#define MPP_AND_FETCH                   __sync_and_and_fetch
+
+#define MPP_BOOL_CAS                    __sync_bool_compare_and_swap
+#define MPP_VAL_CAS                     __sync_val_compare_and_swap
+
+#define MPP_SYNC()                      __sync_synchronize()
+
+#define MPP_LOAD_RELAXED(ptr)           __atomic_load_n(ptr, __ATOMIC_RELAXED)
+#define MPP_LOAD_ACQUIRE(ptr)           __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define MPP_STORE_RELAXED(ptr, val)     __atomic_store_n(ptr, val, __ATOMIC_RELAXED)
+#define MPP_STORE_RELEASE(ptr, val)     __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+
+#endif /*__MPP_ATOMIC_H__*/
@@ -35,6 +35,13 @@ class mpp_list
 {
 public:
     mpp_list(node_destructor func = NULL);
+    /*
+     * ring buffer mode: element storage is preallocated on create so adding
+     * and deleting only copy the element without any malloc / free.
+     * Every element has the same size as elem_size. Adding to a full list
+     * returns -ENOMEM. Key functions are not supported.
+     */
+    mpp_list(RK_S32 elem_size, RK_S32 capacity, node_destructor func = NULL);
     ~mpp_list();
 
     // for FIFO or FILO implement
@@ -82,6 +89,13 @@ private:
     node_destructor         destroy;
     struct mpp_list_node    *head;
     RK_S32                  count;
+
+    // ring buffer mode storage
+    RK_U8                   *ring;
+    RK_S32                  ring_size;
+    RK_S32                  ring_max;
+    RK_S32                  ring_pos;
+
     static RK_U32           keys;
     static RK_U32           get_key();
 
@@ -27,6 +27,14 @@
  * mpp_err is for error status message, it will print for sure.
  * mpp_log is for important message like open/close/reset/flush, it will print too.
  * mpp_dbg is for all optional message. it can be controlled by debug and flag.
+ *
+ * env mpp_log_async - queue depth of async log, zero for sync log
+ *                     mpp_log / mpp_dbg are formatted on the caller and
+ *                     written by a log thread. Message on full queue is
+ *                     dropped and counted instead of blocking the caller.
+ *                     mpp_err is always written synchronously.
+ * env mpp_log_rate  - max mpp_log / mpp_dbg messages per second of a tag,
+ *                     zero for no limit
  */
 
 #define mpp_log(fmt, ...)   _mpp_log(MODULE_TAG, fmt, NULL, ## __VA_ARGS__)
@@ -56,6 +56,11 @@ void *mpp_osal_realloc(const char *caller, void *ptr, size_t size);
 void mpp_osal_free(const char *caller, void *ptr);
 
 void mpp_show_mem_status();
+/*
+ * dump per-caller live count / live size / peak size / allocation rate since
+ * last call, return MPP_NOK when env mpp_mem_debug is not enabled
+ */
+MPP_RET mpp_show_mem_stat();
 
 /*
  * mpp memory usage snapshot tool
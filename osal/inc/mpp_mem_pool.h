@@ -0,0 +1,58 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_MEM_POOL_H__
+#define __MPP_MEM_POOL_H__
+
+#include <stddef.h>
+
+#include "rk_type.h"
+
+/*
+ * Fixed size memory pool with per-thread free list cache
+ *
+ * Released memory is kept on the cache of the releasing thread. When the
+ * cache is full half of it is moved to a shared list of the pool and a
+ * thread with empty cache refills from there, so memory allocated on one
+ * thread and released on another thread is still reused.
+ *
+ * When mpp_mem_debug is enabled the pool is bypassed and every get / put
+ * goes to mpp_malloc / mpp_free for leak tracking.
+ *
+ * Memory from mpp_mem_pool_get is NOT cleared. It is allocated by
+ * mpp_malloc so releasing it by mpp_free is also valid.
+ * Pool is expected to live until process exit. On deinit memory cached by
+ * other threads is not released.
+ */
+typedef void* MppMemPool;
+
+#define mpp_mem_pool_init(size) mpp_mem_pool_init_f(__FUNCTION__, size)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MppMemPool mpp_mem_pool_init_f(const char *caller, size_t size);
+void mpp_mem_pool_deinit(MppMemPool pool);
+
+void *mpp_mem_pool_get(MppMemPool pool);
+void mpp_mem_pool_put(MppMemPool pool, void *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_MEM_POOL_H__*/
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_SCHED_H__
+#define __MPP_SCHED_H__
+
+#include "mpp_thread.h"
+
+/*
+ * Process-wide work-stealing scheduler
+ *
+ * When env mpp_sched_workers is set to non-zero a fixed number of worker
+ * threads is shared by all the MppThread created with check / work callback.
+ * Each such MppThread becomes a job which runs its loop until the check
+ * callback asks to wait, then it is resubmitted by the next signal.
+ *
+ * Job submitted from a worker goes to the queue of the worker itself, job
+ * submitted from other threads is spread by round robin. Idle worker steals
+ * job from other workers.
+ *
+ * Job MUST NOT block on the other job. mpp_sched_sem_wait runs the pending
+ * jobs on the current worker while waiting for the semaphore.
+ *
+ * Default worker count is zero which means every MppThread has its own
+ * thread as before.
+ */
+typedef void (*MppSchedFunc)(void *ctx);
+
+typedef struct MppSchedJob_t {
+    struct MppSchedJob_t    *next;
+    MppSchedFunc            func;
+    void                    *ctx;
+} MppSchedJob;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* worker count, zero for scheduler disabled */
+RK_S32 mpp_sched_get_workers(void);
+
+void mpp_sched_job_init(MppSchedJob *job, MppSchedFunc func, void *ctx);
+void mpp_sched_submit(MppSchedJob *job);
+
+/* return 1 when the caller is a scheduler worker */
+RK_S32 mpp_sched_is_worker(void);
+/* run one pending job on the worker, return 1 when a job is done */
+RK_S32 mpp_sched_help(void);
+void mpp_sched_sem_wait(sem_t *sem);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_SCHED_H__*/
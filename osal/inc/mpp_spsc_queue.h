@@ -0,0 +1,77 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_SPSC_QUEUE_H__
+#define __MPP_SPSC_QUEUE_H__
+
+#include "mpp_list.h"
+
+#ifdef __cplusplus
+
+/*
+ * Bounded lock-free queue of pointers for one producer thread.
+ *
+ * push / pop do not take any lock. Pop is also safe when another thread
+ * drains the queue on reset. The lock is only taken when the consumer has
+ * to sleep in wait() and by the producer to wake it up.
+ */
+class MppSpscQueue
+{
+public:
+    MppSpscQueue(RK_S32 capacity, node_destructor func = NULL);
+    ~MppSpscQueue();
+
+    // producer side, return MPP_NOK when queue is full
+    RK_S32 push(void *data);
+    // consumer side, return MPP_NOK when queue is empty
+    RK_S32 pop(void **data);
+
+    RK_S32 size();
+    RK_S32 capacity();
+
+    // pop all elements and release them by node destructor
+    RK_S32 flush();
+
+    /*
+     * wait until queue is not empty
+     * timeout: negative - block, zero - non block, positive - in millisecond
+     * return zero when queue is not empty otherwise ETIMEDOUT
+     */
+    RK_S32 wait(RK_S64 timeout);
+
+private:
+    void                    **mSlots;
+    RK_U32                  mMask;
+    RK_U32                  mCapacity;
+
+    // only producer writes mTail and only consumer moves mHead
+    RK_U32                  mHead;
+    RK_U32                  mTail;
+
+    // consumer count sleeping on mCondition
+    RK_U32                  mWaiters;
+    Mutex                   mMutex;
+    Condition               mCondition;
+
+    node_destructor         destroy;
+
+    MppSpscQueue(const MppSpscQueue &);
+    MppSpscQueue &operator=(const MppSpscQueue &);
+};
+
+#endif
+
+#endif /*__MPP_SPSC_QUEUE_H__*/
@@ -55,6 +55,12 @@ int pthread_setname_np(pthread_t thread, const char *name);
 #define THREAD_NAME_LEN 16
 
 typedef void *(*MppThreadFunc)(void *);
+/*
+ * loop callback: check is called with THREAD_WORK lock held and returns zero
+ * for work and non-zero for wait. work is called without lock.
+ */
+typedef RK_S32 (*MppThreadCheck)(void *);
+typedef void (*MppThreadWork)(void *);
 
 typedef enum {
     MPP_THREAD_UNINITED,
@@ -217,11 +223,22 @@ typedef enum MppThreadSignal_e {
 #define THREAD_NORMAL       0
 #define THRE       0
 
+struct MppSchedJob_t;
+
 class MppThread
 {
 public:
     MppThread(MppThreadFunc func, void *ctx, const char *name = NULL);
-    ~MppThread() {};
+    /*
+     * Loop mode thread. The loop is run on the shared scheduler when it is
+     * enabled otherwise on its own thread:
+     * 1. exit when status is not running
+     * 2. wait for signal when check returns non-zero
+     * 3. call work and goto 1
+     */
+    MppThread(MppThreadCheck check, MppThreadWork work, void *ctx,
+              const char *name = NULL);
+    ~MppThread();
 
     MppThreadStatus get_status(MppThreadSignal id = THREAD_WORK);
     void set_status(MppThreadStatus status, MppThreadSignal id = THREAD_WORK);
@@ -254,7 +271,10 @@ public:
 
     void signal(MppThreadSignal id = THREAD_WORK) {
         mpp_assert(id < THREAD_SIGNAL_BUTT);
-        mMutexCond[id].signal();
+        if (mJob && id == THREAD_WORK)
+            resume();
+        else
+            mMutexCond[id].signal();
     }
 
     Mutex *mutex(MppThreadSignal id = THREAD_WORK) {
@@ -263,6 +283,11 @@ public:
     }
 
 private:
+    static void *loop(void *ctx);
+    static void run_job(void *ctx);
+    void init(const char *name);
+    void resume();
+
     pthread_t       mThread;
     MppMutexCond    mMutexCond[THREAD_SIGNAL_BUTT];
     MppThreadStatus mStatus[THREAD_SIGNAL_BUTT];
@@ -271,6 +296,12 @@ private:
     char            mName[THREAD_NAME_LEN];
     void            *mContext;
 
+    // loop mode callback and scheduler job
+    MppThreadCheck  mCheck;
+    MppThreadWork   mWork;
+    struct MppSchedJob_t *mJob;
+    RK_S32          mJobStatus;
+
     MppThread();
     MppThread(const MppThread &);
     MppThread &operator=(const MppThread &);
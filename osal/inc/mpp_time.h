@@ -69,6 +69,16 @@ RK_S64 mpp_clock_get_sum(MppClock clock);
 RK_S64 mpp_clock_get_count(MppClock clock);
 const char *mpp_clock_get_name(MppClock clock);
 
+/*
+ * Each start to first pause duration is also recorded in a log-linear
+ * histogram with 1/8 resolution on each power of two:
+ * mpp_clock_get_max        - Return the longest duration
+ * mpp_clock_get_percentile - Return the duration at percent (0 ~ 100) which
+ *                            is the upper bound of its histogram bucket
+ */
+RK_S64 mpp_clock_get_max(MppClock clock);
+RK_S64 mpp_clock_get_percentile(MppClock clock, RK_U32 percent);
+
 /*
  * MppTimer is for timer with callback function
  * It will provide the ability to repeat doing something until it is
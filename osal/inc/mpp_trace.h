@@ -0,0 +1,75 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_TRACE_H__
+#define __MPP_TRACE_H__
+
+#include "mpp_err.h"
+#include "mpp_time.h"
+
+/*
+ * Binary trace of the pipeline stages
+ *
+ * Each thread records fixed size events into its own ring buffer without
+ * lock and without formatting. The rings are exported as Chrome trace /
+ * Perfetto json by mpp_trace_dump.
+ *
+ * env mpp_trace_depth  - events kept per thread, zero for trace disabled
+ * env mpp_trace_file   - json file written on process exit
+ *
+ * Stage is recorded as one complete event on stage end:
+ *
+ *     RK_S64 ts = mpp_trace_ts();
+ *     do_stage();
+ *     mpp_trace_span("stage", ctx, task, slot, size, ts);
+ *
+ * name MUST be a static string. task / slot / size are free integers, the
+ * convention is task sequence number, buffer slot index and data size.
+ * When trace is disabled every macro is one load and one branch.
+ */
+extern RK_U32 mpp_trace_en;
+
+#define mpp_trace_ts()  (mpp_trace_en ? mpp_time() : 0)
+
+#define mpp_trace_span(name, ctx, task, slot, size, start) \
+    do { \
+        if (mpp_trace_en) \
+            mpp_trace_emit(name, ctx, task, slot, size, start, mpp_time()); \
+    } while (0)
+
+#define mpp_trace_mark(name, ctx, task, slot, size) \
+    do { \
+        if (mpp_trace_en) \
+            mpp_trace_emit(name, ctx, task, slot, size, mpp_time(), -1); \
+    } while (0)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* end is -1 for instant event */
+void mpp_trace_emit(const char *name, void *ctx, RK_S32 task, RK_S32 slot,
+                    RK_S32 size, RK_S64 start, RK_S64 end);
+
+/* runtime enable with events per thread, zero for disable */
+void mpp_trace_enable(RK_U32 depth);
+MPP_RET mpp_trace_dump(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_TRACE_H__*/
@@ -22,6 +22,7 @@
 #include "allocator_ext_dma.h"
 #include "allocator_ion.h"
 #include "allocator_std.h"
+#include "allocator_memfd.h"
 
 /*
  * Linux only support MPP_BUFFER_TYPE_NORMAL so far
@@ -45,6 +46,9 @@ MPP_RET os_allocator_get(os_allocator *api, MppBufferType type)
     case MPP_BUFFER_TYPE_EXT_DMA: {
         *api = allocator_ext_dma;
     } break;
+    case MPP_BUFFER_TYPE_MEMFD : {
+        *api = allocator_memfd;
+    } break;
     case MPP_BUFFER_TYPE_DRM : {
 #if HAVE_DRM
         *api = (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_DRM)) ? allocator_drm :
@@ -108,14 +108,33 @@ static MPP_RET mpp_allocator_mmap(MppAllocator allocator, MppBufferInfo *info)
     return mpp_allocator_api_wrapper(allocator, info, ALLOC_API_MMAP);
 }
 
+static MPP_RET mpp_allocator_config(MppAllocator allocator, MppAllocatorCfg *cfg)
+{
+    MppAllocatorImpl *p = (MppAllocatorImpl *)allocator;
+    MPP_RET ret = MPP_NOK;
+
+    if (NULL == p || NULL == cfg) {
+        mpp_err_f("invalid input: allocator %p cfg %p\n", allocator, cfg);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MPP_ALLOCATOR_LOCK(p);
+    if (p->os_api.config && p->ctx)
+        ret = p->os_api.config(p->ctx, cfg);
+    MPP_ALLOCATOR_UNLOCK(p);
+
+    return ret;
+}
+
 static MppAllocatorApi mpp_allocator_api = {
     .size = sizeof(mpp_allocator_api),
-    .version = 1,
+    .version = 2,
     .alloc = mpp_allocator_alloc,
     .free = mpp_allocator_free,
     .import = mpp_allocator_import,
     .release =  mpp_allocator_release,
     .mmap  = mpp_allocator_mmap,
+    .config = mpp_allocator_config,
 };
 
 MPP_RET mpp_allocator_get(MppAllocator *allocator,
@@ -146,6 +165,8 @@ MPP_RET mpp_allocator_get(MppAllocator *allocator,
         MppAllocatorCfg cfg = {
             .alignment = SZ_4K,
             .flags = flags,
+            .page = MPP_BUFFER_PAGE_DEFAULT,
+            .numa_node = -1,
         };
         ret = p->os_api.open(&p->ctx, &cfg);
     }
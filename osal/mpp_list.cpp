@@ -80,10 +80,35 @@ static inline void mpp_list_add_tail(mpp_list_node *_new, mpp_list_node *head)
     _mpp_list_add(_new, head->prev, head);
 }
 
+static inline RK_S32 ring_index(RK_S32 pos, RK_S32 max)
+{
+    return (pos >= max) ? (pos - max) : (pos);
+}
+
+static void ring_read(void *src, RK_S32 elem_size, void *data, RK_S32 size)
+{
+    if (size != elem_size) {
+        LIST_ERROR("node size check failed when ring read");
+        size = (size < elem_size) ? (size) : (elem_size);
+    }
+    if (data)
+        memcpy(data, src, size);
+}
+
 RK_S32 mpp_list::add_at_head(void *data, RK_S32 size)
 {
     RK_S32 ret = -EINVAL;
-    if (head) {
+    if (ring) {
+        if (size != ring_size)
+            return -EINVAL;
+        if (count >= ring_max)
+            return -ENOMEM;
+
+        ring_pos = ring_index(ring_pos + ring_max - 1, ring_max);
+        memcpy(ring + ring_pos * ring_size, data, size);
+        count++;
+        ret = 0;
+    } else if (head) {
         mpp_list_node *node = create_list(data, size, 0);
         if (node) {
             mpp_list_add(node, head);
@@ -99,7 +124,16 @@ RK_S32 mpp_list::add_at_head(void *data, RK_S32 size)
 RK_S32 mpp_list::add_at_tail(void *data, RK_S32 size)
 {
     RK_S32 ret = -EINVAL;
-    if (head) {
+    if (ring) {
+        if (size != ring_size)
+            return -EINVAL;
+        if (count >= ring_max)
+            return -ENOMEM;
+
+        memcpy(ring + ring_index(ring_pos + count, ring_max) * ring_size, data, size);
+        count++;
+        ret = 0;
+    } else if (head) {
         mpp_list_node *node = create_list(data, size, 0);
         if (node) {
             mpp_list_add_tail(node, head);
@@ -148,7 +182,14 @@ static inline void _list_del_node_no_lock(mpp_list_node *node, void *data, RK_S3
 RK_S32 mpp_list::del_at_head(void *data, RK_S32 size)
 {
     RK_S32 ret = -EINVAL;
-    if (head && count) {
+    if (ring) {
+        if (count) {
+            ring_read(ring + ring_pos * ring_size, ring_size, data, size);
+            ring_pos = ring_index(ring_pos + 1, ring_max);
+            count--;
+            ret = 0;
+        }
+    } else if (head && count) {
         _list_del_node_no_lock(head->next, data, size);
         count--;
         ret = 0;
@@ -159,7 +200,15 @@ RK_S32 mpp_list::del_at_head(void *data, RK_S32 size)
 RK_S32 mpp_list::del_at_tail(void *data, RK_S32 size)
 {
     RK_S32 ret = -EINVAL;
-    if (head && count) {
+    if (ring) {
+        if (count) {
+            RK_S32 idx = ring_index(ring_pos + count - 1, ring_max);
+
+            ring_read(ring + idx * ring_size, ring_size, data, size);
+            count--;
+            ret = 0;
+        }
+    } else if (head && count) {
         _list_del_node_no_lock(head->prev, data, size);
         count--;
         ret = 0;
@@ -185,7 +234,9 @@ static mpp_list_node* create_list_with_size(void *data, RK_S32 size, RK_U32 key)
 RK_S32 mpp_list::fifo_wr(void *data, RK_S32 size)
 {
     RK_S32 ret = -EINVAL;
-    if (head) {
+    if (ring) {
+        ret = add_at_tail(data, size);
+    } else if (head) {
         mpp_list_node *node = create_list_with_size(data, size, 0);
         if (node) {
             mpp_list_add_tail(node, head);
@@ -214,7 +265,11 @@ static void release_list_with_size(mpp_list_node* node, void *data, RK_S32 *size
 RK_S32 mpp_list::fifo_rd(void *data, RK_S32 *size)
 {
     RK_S32 ret = -EINVAL;
-    if (head && count) {
+    if (ring) {
+        ret = del_at_head(data, ring_size);
+        if (!ret)
+            *size = ring_size;
+    } else if (head && count) {
         mpp_list_node *node = head->next;
 
         mpp_list_del_init(node);
@@ -240,7 +295,10 @@ RK_S32 mpp_list::list_size()
 RK_S32 mpp_list::add_by_key(void *data, RK_S32 size, RK_U32 *key)
 {
     RK_S32 ret = 0;
-    if (head) {
+    if (ring) {
+        LIST_ERROR("key function is not supported in ring mode");
+        ret = -EINVAL;
+    } else if (head) {
         RK_U32 list_key = get_key();
         *key = list_key;
         mpp_list_node *node = create_list(data, size, list_key);
@@ -258,7 +316,9 @@ RK_S32 mpp_list::add_by_key(void *data, RK_S32 size, RK_U32 *key)
 RK_S32 mpp_list::del_by_key(void *data, RK_S32 size, RK_U32 key)
 {
     RK_S32 ret = 0;
-    if (head && count) {
+    if (ring) {
+        ret = -EINVAL;
+    } else if (head && count) {
         struct mpp_list_node *tmp = head->next;
         ret = -EINVAL;
         while (tmp->next != head) {
@@ -283,7 +343,15 @@ RK_S32 mpp_list::show_by_key(void *data, RK_U32 key)
 
 RK_S32 mpp_list::flush()
 {
-    if (head) {
+    if (ring) {
+        while (count) {
+            if (destroy)
+                destroy((void*)(ring + ring_pos * ring_size));
+
+            ring_pos = ring_index(ring_pos + 1, ring_max);
+            count--;
+        }
+    } else if (head) {
         while (count) {
             mpp_list_node* node = head->next;
             mpp_list_del_init(node);
@@ -341,7 +409,11 @@ void mpp_list::signal()
 mpp_list::mpp_list(node_destructor func)
     : destroy(NULL),
       head(NULL),
-      count(0)
+      count(0),
+      ring(NULL),
+      ring_size(0),
+      ring_max(0),
+      ring_pos(0)
 {
     destroy = func;
     head = (mpp_list_node*)malloc(sizeof(mpp_list_node));
@@ -352,11 +424,32 @@ mpp_list::mpp_list(node_destructor func)
     }
 }
 
+mpp_list::mpp_list(RK_S32 elem_size, RK_S32 capacity, node_destructor func)
+    : destroy(func),
+      head(NULL),
+      count(0),
+      ring(NULL),
+      ring_size(elem_size),
+      ring_max(capacity),
+      ring_pos(0)
+{
+    if (elem_size <= 0 || capacity <= 0) {
+        LIST_ERROR("invalid ring size %d capacity %d", elem_size, capacity);
+        return;
+    }
+
+    ring = (RK_U8 *)malloc(elem_size * capacity);
+    if (NULL == ring)
+        LIST_ERROR("failed to allocate list ring");
+}
+
 mpp_list::~mpp_list()
 {
     flush();
     if (head) free(head);
+    if (ring) free(ring);
     head = NULL;
+    ring = NULL;
     destroy = NULL;
 }
 
@@ -16,20 +16,59 @@
 
 #define MODULE_TAG "mpp_log"
 
+#include <sched.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
 
+#include "mpp_env.h"
 #include "mpp_log.h"
 #include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_atomic.h"
 #include "mpp_common.h"
+#include "mpp_thread.h"
 
 #include "os_log.h"
+#include "os_mem.h"
 
 #define MPP_LOG_MAX_LEN     256
+#define MPP_LOG_ASYNC_LEN   512
+#define MPP_LOG_ASYNC_MAX   (1 << 16)
+#define MPP_LOG_RATE_BITS   6
+#define MPP_LOG_RATE_SLOTS  (1 << MPP_LOG_RATE_BITS)
 
 typedef void (*mpp_log_callback)(const char*, const char*, va_list);
 
+/*
+ * Async log record slot in bounded multi-producer ring. seq equals to the
+ * position when the slot is free for producer and position + 1 when the
+ * message is ready for the log thread.
+ */
+typedef struct MppLogRecord_t {
+    RK_U32          seq;
+    const char      *tag;
+    char            msg[MPP_LOG_ASYNC_LEN];
+} MppLogRecord;
+
+typedef struct MppLogAsync_t {
+    MppLogRecord    *ring;
+    RK_U32          mask;
+    RK_U32          head;
+    RK_U32          tail;
+    RK_U32          drop;
+    RK_U32          running;
+    sem_t           sem;
+    pthread_t       thd;
+} MppLogAsync;
+
+/* per second message budget of the tags hashed to the same slot */
+typedef struct MppLogRate_t {
+    RK_U32          sec;
+    RK_U32          count;
+    RK_U32          drop;
+} MppLogRate;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,6 +81,172 @@ static RK_U32 mpp_log_flag = 0;
 static const char *msg_log_warning = "log message is long\n";
 static const char *msg_log_nothing = "\n";
 
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static RK_U32 log_async_en = 0;
+static RK_U32 log_rate = 0;
+static MppLogAsync log_async;
+static MppLogRate log_rates[MPP_LOG_RATE_SLOTS];
+
+static void log_output(mpp_log_callback func, const char *tag, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    func(tag, fmt, args);
+    va_end(args);
+}
+
+static void *log_async_loop(void *arg)
+{
+    MppLogAsync *p = (MppLogAsync *)arg;
+
+    while (1) {
+        MppLogRecord *rec = NULL;
+        RK_U32 drop;
+
+        sem_wait(&p->sem);
+
+        if (MPP_LOAD_ACQUIRE(&p->tail) == p->head) {
+            if (!MPP_LOAD_ACQUIRE(&p->running))
+                break;
+            continue;
+        }
+
+        /* slot is claimed by producer but may still be under formatting */
+        rec = &p->ring[p->head & p->mask];
+        while (MPP_LOAD_ACQUIRE(&rec->seq) != p->head + 1)
+            sched_yield();
+
+        log_output(os_log, rec->tag, "%s", rec->msg);
+
+        MPP_STORE_RELEASE(&rec->seq, p->head + p->mask + 1);
+        p->head++;
+
+        drop = MPP_FETCH_AND(&p->drop, 0);
+        if (drop)
+            log_output(os_log, MODULE_TAG, "%u messages dropped on full queue\n", drop);
+    }
+
+    return NULL;
+}
+
+static void log_async_put(const char *tag, const char *fmt, va_list args)
+{
+    MppLogAsync *p = &log_async;
+    MppLogRecord *rec = NULL;
+    RK_U32 pos = MPP_LOAD_RELAXED(&p->tail);
+
+    while (1) {
+        RK_S32 diff;
+
+        rec = &p->ring[pos & p->mask];
+        diff = (RK_S32)(MPP_LOAD_ACQUIRE(&rec->seq) - pos);
+
+        if (!diff) {
+            if (MPP_BOOL_CAS(&p->tail, pos, pos + 1))
+                break;
+            pos = MPP_LOAD_RELAXED(&p->tail);
+        } else if (diff < 0) {
+            /* never block the caller on a slow log thread */
+            MPP_FETCH_ADD(&p->drop, 1);
+            return;
+        } else
+            pos = MPP_LOAD_RELAXED(&p->tail);
+    }
+
+    rec->tag = tag;
+    vsnprintf(rec->msg, sizeof(rec->msg), fmt, args);
+
+    MPP_STORE_RELEASE(&rec->seq, pos + 1);
+    sem_post(&p->sem);
+}
+
+static void log_async_stop(void)
+{
+    MppLogAsync *p = &log_async;
+
+    /* messages after stop fall back to sync output */
+    MPP_STORE_RELEASE(&log_async_en, 0);
+    MPP_STORE_RELEASE(&p->running, 0);
+    sem_post(&p->sem);
+    pthread_join(p->thd, NULL);
+}
+
+static void log_init(void)
+{
+    MppLogAsync *p = &log_async;
+    RK_U32 depth = 0;
+    RK_U32 size = 1;
+    RK_U32 i;
+
+    mpp_env_get_u32("mpp_log_rate", &log_rate, 0);
+    mpp_env_get_u32("mpp_log_async", &depth, 0);
+
+    if (!depth)
+        return;
+
+    if (depth > MPP_LOG_ASYNC_MAX)
+        depth = MPP_LOG_ASYNC_MAX;
+
+    while (size < depth)
+        size <<= 1;
+
+    os_malloc((void **)&p->ring, sizeof(RK_S64), sizeof(MppLogRecord) * size);
+    if (NULL == p->ring)
+        return;
+
+    for (i = 0; i < size; i++)
+        p->ring[i].seq = i;
+
+    p->mask = size - 1;
+    p->running = 1;
+    sem_init(&p->sem, 0, 0);
+
+    if (pthread_create(&p->thd, NULL, log_async_loop, p)) {
+        sem_destroy(&p->sem);
+        os_free(p->ring);
+        p->ring = NULL;
+        return;
+    }
+
+#ifndef ARMLINUX
+    pthread_setname_np(p->thd, "mpp_log");
+#endif
+
+    /* registered on first log after static init so it runs before closelog */
+    atexit(log_async_stop);
+    MPP_STORE_RELEASE(&log_async_en, 1);
+}
+
+static RK_S32 log_rate_drop(const char *tag)
+{
+    MppLogRate *r = NULL;
+    RK_U32 sec;
+    RK_U32 old;
+
+    if (!log_rate)
+        return 0;
+
+    r = &log_rates[((RK_U32)(intptr_t)tag * 0x9E3779B1) >> (32 - MPP_LOG_RATE_BITS)];
+    sec = (RK_U32)(mpp_time() / 1000000);
+    old = MPP_LOAD_RELAXED(&r->sec);
+
+    /* the first message of a new second reports the drop in the last one */
+    if (old != sec && MPP_BOOL_CAS(&r->sec, old, sec)) {
+        RK_U32 drop = MPP_FETCH_AND(&r->drop, 0);
+
+        MPP_STORE_RELAXED(&r->count, 0);
+        if (drop)
+            log_output(log_async_en ? log_async_put : os_log, tag,
+                       "%u messages dropped by rate limit %u/s\n", drop, log_rate);
+    }
+
+    if (MPP_FETCH_ADD(&r->count, 1) < log_rate)
+        return 0;
+
+    MPP_FETCH_ADD(&r->drop, 1);
+    return 1;
+}
+
 static void __mpp_log(mpp_log_callback func, const char *tag, const char *fmt,
                       const char *fname, va_list args)
 {
@@ -82,8 +287,15 @@ static void __mpp_log(mpp_log_callback func, const char *tag, const char *fmt,
 void _mpp_log(const char *tag, const char *fmt, const char *fname, ...)
 {
     va_list args;
+
+    pthread_once(&log_once, log_init);
+
+    if (log_rate_drop(tag))
+        return;
+
     va_start(args, fname);
-    __mpp_log(os_log, tag, fmt, fname, args);
+    __mpp_log(MPP_LOAD_ACQUIRE(&log_async_en) ? log_async_put : os_log,
+              tag, fmt, fname, args);
     va_end(args);
 }
 
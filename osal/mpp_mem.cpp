@@ -25,6 +25,7 @@
 #include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_list.h"
+#include "mpp_time.h"
 #include "mpp_common.h"
 
 #include "os_mem.h"
@@ -45,6 +46,8 @@
 #define MEM_HEAD_ROOM(debug)    ((debug & MEM_EXT_ROOM) ? (MEM_ALIGN) : (0))
 #define MEM_NODE_MAX            (1024)
 #define MEM_FREE_MAX            (512)
+#define MEM_CALLER_BITS         (9)
+#define MEM_CALLER_MAX          (1 << MEM_CALLER_BITS)
 #define MEM_LOG_MAX             (1024)
 #define MEM_CHECK_MARK          (0xdd)
 #define MEM_HEAD_MASK           (0xab)
@@ -82,6 +85,21 @@ typedef struct MppMemNode_s {
     const char  *caller;
 } MppMemNode;
 
+/*
+ * Per-caller statistic keyed by the caller string pointer.
+ * Entry is never removed so the caller table only grows until it is full,
+ * then all the new callers are accounted to one shared entry.
+ */
+typedef struct MppMemCaller_s {
+    const char  *caller;
+    RK_S32      count;          // live allocation count
+    size_t      size;           // live allocation size
+    size_t      peak;           // peak of live allocation size
+    RK_U64      alloc_count;    // total allocation count
+    RK_U64      alloc_size;     // total allocation size
+    RK_U64      alloc_last;     // allocation count at last statistic dump
+} MppMemCaller;
+
 typedef struct MppMemLog_s {
     RK_U32      index;
     MppMemOps   ops;
@@ -101,14 +119,6 @@ public:
     ~MppMemService();
 
     void    add_node(const char *caller, void *ptr, size_t size);
-    /*
-     * try delete node will return index in nodes
-     * return 1 for need os_free call to real free
-     * return 0 for reserve memory for check
-     */
-    RK_S32  find_node(const char *caller, void *ptr, size_t *size, RK_S32 *idx);
-    /*
-     */
     void    del_node(const char *caller, void *ptr, size_t *size);
     void*   delay_del_node(const char *caller, void *ptr, size_t *size);
     void    reset_node(const char *caller, void *ptr, void *ret, size_t size);
@@ -121,15 +131,33 @@ public:
                     size_t size_0, size_t size_1);
 
     void    dump(const char *caller);
+    void    dump_stat(const char *caller);
 
     Mutex       lock;
     RK_U32      debug;
 
 private:
+    /*
+     * nodes is an open addressing hash table keyed by pointer with linear
+     * probing. Node with negative index is an empty slot. Node removal shifts
+     * the following nodes in the same probe sequence backward so no tombstone
+     * is left and lookup stops on the first empty slot.
+     */
+    MppMemNode *get_node(void *ptr);
+    MppMemNode *get_slot(void *ptr);
+    void        put_slot(MppMemNode *node);
+    void        grow_node();
+
+    MppMemCaller *get_caller(const char *caller);
+    void    stat_add(const char *caller, size_t size);
+    void    stat_del(const char *caller, size_t size);
+
     // data for node record and delay free check
     RK_S32      nodes_max;
     RK_S32      nodes_idx;
     RK_S32      nodes_cnt;
+    RK_S32      nodes_size;
+    RK_U32      nodes_bits;
     RK_S32      frees_max;
     RK_S32      frees_idx;
     RK_S32      frees_cnt;
@@ -137,6 +165,12 @@ private:
     MppMemNode  *nodes;
     MppMemNode  *frees;
 
+    // data for per-caller statistic
+    RK_S32      callers_cnt;
+    MppMemCaller *callers;
+    MppMemCaller caller_other;
+    RK_S64      stat_time;
+
     // data for log record
     RK_U32      log_index;
     RK_S32      log_max;
@@ -193,16 +227,26 @@ static void set_mem_ext_room(void *p, size_t size)
     memset((RK_U8 *)p + size,      MEM_TAIL_MASK, MEM_ALIGN);
 }
 
+static inline RK_U32 mem_hash(const void *ptr, RK_U32 bits)
+{
+    return (RK_U32)(((RK_U64)(intptr_t)ptr * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
 MppMemService::MppMemService()
     : debug(0),
       nodes_max(MEM_NODE_MAX),
       nodes_idx(0),
       nodes_cnt(0),
+      nodes_size(0),
+      nodes_bits(0),
       frees_max(MEM_FREE_MAX),
       frees_idx(0),
       frees_cnt(0),
       nodes(NULL),
       frees(NULL),
+      callers_cnt(0),
+      callers(NULL),
+      stat_time(0),
       log_index(0),
       log_max(MEM_LOG_MAX),
       log_idx(0),
@@ -218,15 +262,34 @@ MppMemService::MppMemService()
 
     if (debug & MEM_DEBUG_EN) {
         mpp_env_get_u32("mpp_mem_node_max", (RK_U32 *)&nodes_max, MEM_NODE_MAX);
+        if (nodes_max < 16)
+            nodes_max = 16;
+
+        // keep hash table load factor under 1/2
+        nodes_bits = 1;
+        while ((1 << nodes_bits) < nodes_max * 2)
+            nodes_bits++;
+        nodes_size = 1 << nodes_bits;
+        nodes_max = nodes_size / 2;
 
         mpp_log_f("mpp_mem_debug enabled %x max node %d\n",
                   debug, nodes_max);
 
-        size_t size = nodes_max * sizeof(MppMemNode);
+        memset(&caller_other, 0, sizeof(caller_other));
+        caller_other.caller = "others";
+        stat_time = mpp_time();
+
+        size_t size = MEM_CALLER_MAX * sizeof(MppMemCaller);
+        os_malloc((void **)&callers, MEM_ALIGN, size);
+        mpp_assert(callers);
+        memset(callers, 0, size);
+
+        size = nodes_size * sizeof(MppMemNode);
         os_malloc((void **)&nodes, MEM_ALIGN, size);
         mpp_assert(nodes);
         memset(nodes, 0xff, size);
         add_node(__FUNCTION__, nodes, size);
+        add_node(__FUNCTION__, callers, MEM_CALLER_MAX * sizeof(MppMemCaller));
 
         size = frees_max * sizeof(MppMemNode);
         os_malloc((void **)&frees, MEM_ALIGN, size);
@@ -256,15 +319,16 @@ MppMemService::~MppMemService()
 
         del_node(__FUNCTION__, this,  &size);
         del_node(__FUNCTION__, nodes, &size);
+        del_node(__FUNCTION__, callers, &size);
         del_node(__FUNCTION__, frees, &size);
         del_node(__FUNCTION__, logs,  &size);
 
         // then check leak memory
         if (nodes_cnt) {
-            for (i = 0; i < nodes_max; i++, node++) {
+            for (i = 0; i < nodes_size; i++, node++) {
                 if (node->index >= 0) {
-                    mpp_log("found idx %8d mem %10p size %d leaked\n",
-                            node->index, node->ptr, node->size);
+                    mpp_log("found idx %8d mem %10p size %d leaked at %s\n",
+                            node->index, node->ptr, node->size, node->caller);
                     nodes_cnt--;
                     add_log(MEM_FREE, __FUNCTION__, node->ptr, NULL,
                             node->size, 0);
@@ -292,96 +356,204 @@ MppMemService::~MppMemService()
         }
 
         os_free(nodes);
+        os_free(callers);
         os_free(frees);
         os_free(logs);
     }
 }
 
-void MppMemService::add_node(const char *caller, void *ptr, size_t size)
+MppMemNode *MppMemService::get_node(void *ptr)
 {
-    RK_S32 i = 0;
+    RK_U32 mask = nodes_size - 1;
+    RK_U32 i = mem_hash(ptr, nodes_bits);
 
-    if (debug & MEM_NODE_LOG)
-        mpp_log("mem cnt: %5d total %8d inc size %8d at %s\n",
-                nodes_cnt, total_size, size, caller);
+    while (nodes[i].index >= 0) {
+        if (nodes[i].ptr == ptr)
+            return &nodes[i];
 
-    if (nodes_cnt >= nodes_max) {
-        mpp_err("******************************************************\n");
-        mpp_err("* Reach max limit of mpp_mem counter %5d           *\n", nodes_max);
-        mpp_err("* Increase limit by setup env mpp_mem_node_max or    *\n");
-        mpp_err("* recompile mpp with larger macro MEM_NODE_MAX value *\n");
-        mpp_err("******************************************************\n");
-        mpp_abort();
+        i = (i + 1) & mask;
     }
 
-    MppMemNode *node = nodes;
-    for (i = 0; i < nodes_max; i++, node++) {
-        if (node->index < 0) {
-            node->index = nodes_idx++;
-            node->size  = size;
-            node->ptr   = ptr;
-            node->caller = caller;
-
-            // NOTE: reset node index on revert
-            if (nodes_idx < 0)
-                nodes_idx = 0;
-
-            nodes_cnt++;
-            total_size += size;
+    return NULL;
+}
+
+MppMemNode *MppMemService::get_slot(void *ptr)
+{
+    RK_U32 mask = nodes_size - 1;
+    RK_U32 i = mem_hash(ptr, nodes_bits);
+
+    while (nodes[i].index >= 0)
+        i = (i + 1) & mask;
+
+    return &nodes[i];
+}
+
+void MppMemService::put_slot(MppMemNode *node)
+{
+    RK_U32 mask = nodes_size - 1;
+    RK_U32 i = node - nodes;
+    RK_U32 j = i;
+
+    while (1) {
+        j = (j + 1) & mask;
+        if (nodes[j].index < 0)
             break;
+
+        // move node j to the hole i when i is in the probe path of node j
+        RK_U32 k = mem_hash(nodes[j].ptr, nodes_bits);
+
+        if (((j - k) & mask) >= ((j - i) & mask)) {
+            nodes[i] = nodes[j];
+            i = j;
         }
     }
+
+    nodes[i].index = -1;
 }
 
-RK_S32 MppMemService::find_node(const char *caller, void *ptr, size_t *size, RK_S32 *idx)
+void MppMemService::grow_node()
 {
-    RK_S32 i = 0;
-    MppMemNode *node = nodes;
+    MppMemNode *old = nodes;
+    RK_S32 old_size = nodes_size;
+    size_t size = nodes_size * 2 * sizeof(MppMemNode);
+    MppMemNode *node = NULL;
+    RK_S32 i;
 
-    MPP_MEM_ASSERT(nodes_cnt <= nodes_max);
-    for (i = 0; i < nodes_max; i++, node++) {
-        if (node->index >= 0 && node->ptr == ptr) {
-            *size = node->size;
-            *idx  = i;
-            return 1;
-        }
+    os_malloc((void **)&nodes, MEM_ALIGN, size);
+    if (NULL == nodes) {
+        mpp_err("mpp_mem failed to grow node table to %d\n", nodes_size * 2);
+        nodes = old;
+        dump(__FUNCTION__);
+        mpp_abort();
+        return;
+    }
+
+    memset(nodes, 0xff, size);
+    nodes_size *= 2;
+    nodes_max *= 2;
+    nodes_bits++;
+
+    for (i = 0; i < old_size; i++) {
+        if (old[i].index >= 0)
+            *get_slot(old[i].ptr) = old[i];
+    }
+
+    // update the node of the table itself
+    node = get_node(old);
+    if (node) {
+        MppMemNode tmp = *node;
+
+        stat_del(tmp.caller, tmp.size);
+        total_size -= tmp.size;
+        put_slot(node);
+
+        tmp.ptr = nodes;
+        tmp.size = size;
+        *get_slot(nodes) = tmp;
+        stat_add(tmp.caller, size);
+        total_size += size;
     }
 
-    mpp_err("%s can NOT found node with ptr %p\n", caller, ptr);
-    mpp_abort();
-    return 0;
+    os_free(old);
+
+    if (debug & MEM_NODE_LOG)
+        mpp_log("mem node table grow to %d\n", nodes_size);
+}
+
+MppMemCaller *MppMemService::get_caller(const char *caller)
+{
+    RK_U32 mask = MEM_CALLER_MAX - 1;
+    RK_U32 i = mem_hash(caller, MEM_CALLER_BITS);
+
+    while (callers[i].caller) {
+        if (callers[i].caller == caller)
+            return &callers[i];
+
+        i = (i + 1) & mask;
+    }
+
+    // keep load factor under 3/4
+    if (callers_cnt >= MEM_CALLER_MAX * 3 / 4)
+        return &caller_other;
+
+    callers[i].caller = caller;
+    callers_cnt++;
+    return &callers[i];
+}
+
+void MppMemService::stat_add(const char *caller, size_t size)
+{
+    MppMemCaller *stat = get_caller(caller);
+
+    stat->count++;
+    stat->size += size;
+    stat->alloc_count++;
+    stat->alloc_size += size;
+    if (stat->size > stat->peak)
+        stat->peak = stat->size;
+}
+
+void MppMemService::stat_del(const char *caller, size_t size)
+{
+    MppMemCaller *stat = get_caller(caller);
+
+    stat->count--;
+    stat->size -= size;
+}
+
+void MppMemService::add_node(const char *caller, void *ptr, size_t size)
+{
+    if (debug & MEM_NODE_LOG)
+        mpp_log("mem cnt: %5d total %8d inc size %8d at %s\n",
+                nodes_cnt, total_size, size, caller);
+
+    if (nodes_cnt >= nodes_max)
+        grow_node();
+
+    MppMemNode *node = get_slot(ptr);
+
+    node->index = nodes_idx++;
+    node->size  = size;
+    node->ptr   = ptr;
+    node->caller = caller;
+
+    // NOTE: reset node index on revert
+    if (nodes_idx < 0)
+        nodes_idx = 0;
+
+    nodes_cnt++;
+    total_size += size;
+    stat_add(caller, size);
 }
 
 void MppMemService::del_node(const char *caller, void *ptr, size_t *size)
 {
-    RK_S32 i = 0;
-    MppMemNode *node = nodes;
+    MppMemNode *node = get_node(ptr);
 
     MPP_MEM_ASSERT(nodes_cnt <= nodes_max);
 
-    for (i = 0; i < nodes_max; i++, node++) {
-        if (node->index >= 0 && node->ptr == ptr) {
-            *size = node->size;
-            node->index = ~node->index;
-            nodes_cnt--;
-            total_size -= node->size;
-
-            if (debug & MEM_NODE_LOG)
-                mpp_log("mem cnt: %5d total %8d dec size %8d at %s\n",
-                        nodes_cnt, total_size, node->size, caller);
-            return ;
-        }
+    if (NULL == node) {
+        mpp_err("%s fail to find node with ptr %p\n", caller, ptr);
+        mpp_abort();
+        return ;
     }
 
-    mpp_err("%s fail to find node with ptr %p\n", caller, ptr);
-    mpp_abort();
-    return ;
+    *size = node->size;
+    nodes_cnt--;
+    total_size -= node->size;
+    stat_del(node->caller, node->size);
+
+    if (debug & MEM_NODE_LOG)
+        mpp_log("mem cnt: %5d total %8d dec size %8d at %s\n",
+                nodes_cnt, total_size, node->size, caller);
+
+    put_slot(node);
 }
 
 void *MppMemService::delay_del_node(const char *caller, void *ptr, size_t *size)
 {
     RK_S32 i = 0;
-    MppMemNode *node = nodes;
+    MppMemNode *node = get_node(ptr);
 
     // clear output first
     void *ret = NULL;
@@ -389,14 +561,9 @@ void *MppMemService::delay_del_node(const char *caller, void *ptr, size_t *size)
 
     // find the node to save
     MPP_MEM_ASSERT(nodes_cnt <= nodes_max);
-    for (i = 0; i < nodes_max; i++, node++) {
-        if (node->index >= 0 && node->ptr == ptr) {
-            chk_node(caller, node);
-            break;
-        }
-    }
+    MPP_MEM_ASSERT(node);
+    chk_node(caller, node);
 
-    MPP_MEM_ASSERT(i < nodes_max);
     if (debug & MEM_NODE_LOG)
         mpp_log("mem cnt: %5d total %8d dec size %8d at %s\n",
                 nodes_cnt, total_size, node->size, caller);
@@ -447,14 +614,15 @@ void *MppMemService::delay_del_node(const char *caller, void *ptr, size_t *size)
 
     MPP_MEM_ASSERT(frees_cnt <= frees_max);
 
-    memcpy(&frees[frees_idx], node, sizeof(*node));
+    memcpy(free_node, node, sizeof(*node));
 
     if ((debug & MEM_POISON) && (node->size < 1024))
         memset(node->ptr, MEM_CHECK_MARK, node->size);
 
-    node->index = ~node->index;
     total_size -= node->size;
     nodes_cnt--;
+    stat_del(node->caller, node->size);
+    put_slot(node);
 
     return ret;
 }
@@ -530,8 +698,7 @@ RK_S32 MppMemService::chk_poison(MppMemNode *node)
 
 void MppMemService::reset_node(const char *caller, void *ptr, void *ret, size_t size)
 {
-    RK_S32 i = 0;
-    MppMemNode *node = nodes;
+    MppMemNode *node = get_node(ptr);
 
     if (debug & MEM_NODE_LOG)
         mpp_log("mem cnt: %5d total %8d equ size %8d at %s\n",
@@ -539,20 +706,31 @@ void MppMemService::reset_node(const char *caller, void *ptr, void *ret, size_t
 
     MPP_MEM_ASSERT(nodes_cnt <= nodes_max);
 
-    for (i = 0; i < nodes_max; i++, node++) {
-        if (node->index >= 0 && node->ptr == ptr) {
-            total_size  += size;
-            total_size  -= node->size;
+    if (NULL == node) {
+        mpp_err("%s fail to find node with ptr %p\n", caller, ptr);
+        return;
+    }
 
-            node->ptr   = ret;
-            node->size  = size;
-            node->caller = caller;
+    MppMemNode tmp = *node;
 
-            if (debug & MEM_EXT_ROOM)
-                set_mem_ext_room(ret, size);
-            break;
-        }
+    total_size  += size;
+    total_size  -= tmp.size;
+    stat_del(tmp.caller, tmp.size);
+    stat_add(caller, size);
+
+    // pointer is the key so the node is moved when realloc changes it
+    if (ret != ptr) {
+        put_slot(node);
+        node = get_slot(ret);
+        node->index = tmp.index;
     }
+
+    node->ptr   = ret;
+    node->size  = size;
+    node->caller = caller;
+
+    if (debug & MEM_EXT_ROOM)
+        set_mem_ext_room(ret, size);
 }
 
 void MppMemService::add_log(MppMemOps ops, const char *caller,
@@ -590,7 +768,7 @@ void MppMemService::dump(const char *caller)
 
     mpp_log("mpp_mem node count %d:\n", nodes_cnt);
     if (nodes_cnt) {
-        for (i = 0; i < nodes_max; i++, node++) {
+        for (i = 0; i < nodes_size; i++, node++) {
             if (node->index < 0)
                 continue;
 
@@ -634,28 +812,63 @@ void MppMemService::dump(const char *caller)
     }
 }
 
+void MppMemService::dump_stat(const char *caller)
+{
+    RK_S64 now = mpp_time();
+    RK_S64 time = now - stat_time;
+    RK_S32 i;
+
+    if (time <= 0)
+        time = 1;
+
+    mpp_log("mpp_mem caller statistic from %s: total %d node %u size %.2f s\n",
+            caller, nodes_cnt, total_size, time / 1000000.0);
+    mpp_log("%-32s %8s %10s %10s %10s %10s\n", "caller", "live",
+            "size", "peak", "alloc", "alloc/s");
+
+    for (i = 0; i <= MEM_CALLER_MAX; i++) {
+        MppMemCaller *stat = (i < MEM_CALLER_MAX) ? &callers[i] : &caller_other;
+
+        if (!stat->alloc_count)
+            continue;
+
+        mpp_log("%-32s %8d %10u %10u %10llu %10.1f\n",
+                stat->caller, stat->count, (RK_U32)stat->size,
+                (RK_U32)stat->peak, stat->alloc_count,
+                (double)(stat->alloc_count - stat->alloc_last) * 1000000 / time);
+
+        stat->alloc_last = stat->alloc_count;
+    }
+
+    stat_time = now;
+}
+
 void *mpp_osal_malloc(const char *caller, size_t size)
 {
-    AutoMutex auto_lock(&service.lock);
     RK_U32 debug = service.debug;
     size_t size_align = MEM_ALIGNED(size);
     size_t size_real = (debug & MEM_EXT_ROOM) ? (size_align + 2 * MEM_ALIGN) :
                        (size_align);
     void *ptr;
 
-    os_malloc(&ptr, MEM_ALIGN, size_real);
+    // debug is fixed on init so only the tracker needs the lock
+    if (!debug) {
+        os_malloc(&ptr, MEM_ALIGN, size_real);
+        return ptr;
+    }
 
-    if (debug) {
-        service.add_log(MEM_MALLOC, caller, NULL, ptr, size, size_real);
+    AutoMutex auto_lock(&service.lock);
 
-        if (ptr) {
-            if (debug & MEM_EXT_ROOM) {
-                ptr = (RK_U8 *)ptr + MEM_ALIGN;
-                set_mem_ext_room(ptr, size);
-            }
+    os_malloc(&ptr, MEM_ALIGN, size_real);
+    service.add_log(MEM_MALLOC, caller, NULL, ptr, size, size_real);
 
-            service.add_node(caller, ptr, size);
+    if (ptr) {
+        if (debug & MEM_EXT_ROOM) {
+            ptr = (RK_U8 *)ptr + MEM_ALIGN;
+            set_mem_ext_room(ptr, size);
         }
+
+        service.add_node(caller, ptr, size);
     }
 
     return ptr;
@@ -671,7 +884,6 @@ void *mpp_osal_calloc(const char *caller, size_t size)
 
 void *mpp_osal_realloc(const char *caller, void *ptr, size_t size)
 {
-    AutoMutex auto_lock(&service.lock);
     RK_U32 debug = service.debug;
     void *ret;
 
@@ -683,12 +895,14 @@ void *mpp_osal_realloc(const char *caller, void *ptr, size_t size)
         return NULL;
     }
 
+    AutoMutex auto_lock(&service.lock);
+
     size_t size_align = MEM_ALIGNED(size);
     size_t size_real = (debug & MEM_EXT_ROOM) ? (size_align + 2 * MEM_ALIGN) :
                        (size_align);
     void *ptr_real = (RK_U8 *)ptr - MEM_HEAD_ROOM(debug);
 
-    os_realloc(ptr_real, &ret, MEM_ALIGN, size_align);
+    os_realloc(ptr_real, &ret, MEM_ALIGN, size_real);
 
     if (NULL == ret) {
         // if realloc fail the original buffer will be kept the same.
@@ -710,7 +924,6 @@ void *mpp_osal_realloc(const char *caller, void *ptr, size_t size)
 
 void mpp_osal_free(const char *caller, void *ptr)
 {
-    AutoMutex auto_lock(&service.lock);
     RK_U32 debug = service.debug;
     if (NULL == ptr)
         return;
@@ -720,6 +933,8 @@ void mpp_osal_free(const char *caller, void *ptr)
         return ;
     }
 
+    AutoMutex auto_lock(&service.lock);
+
     size_t size = 0;
 
     if (debug & MEM_POISON) {
@@ -746,3 +961,13 @@ void mpp_show_mem_status()
     if (service.debug & MEM_DEBUG_EN)
         service.dump(__FUNCTION__);
 }
+
+MPP_RET mpp_show_mem_stat()
+{
+    AutoMutex auto_lock(&service.lock);
+    if (!(service.debug & MEM_DEBUG_EN))
+        return MPP_NOK;
+
+    service.dump_stat(__FUNCTION__);
+    return MPP_OK;
+}
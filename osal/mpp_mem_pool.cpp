@@ -0,0 +1,219 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_mem_pool"
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_atomic.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+#include "mpp_mem_pool.h"
+
+// memory cached by one thread on one pool
+#define MEM_POOL_CACHE_SIZE     (256 * 1024)
+#define MEM_POOL_CACHE_MIN      4
+#define MEM_POOL_CACHE_MAX      64
+// shared list can hold caches from this many threads
+#define MEM_POOL_SHARED_RATIO   4
+
+typedef struct MppMemPoolNode_t {
+    struct MppMemPoolNode_t *next;
+} MppMemPoolNode;
+
+typedef struct MppMemPoolCache_t {
+    MppMemPoolNode      *head;
+    RK_S32              count;
+} MppMemPoolCache;
+
+typedef struct MppMemPoolImpl_t {
+    const char          *caller;
+    size_t              size;
+    RK_S32              cache_max;
+    RK_U32              bypass;
+
+    pthread_key_t       key;
+
+    // shared list for memory moved out of thread caches
+    pthread_mutex_t     lock;
+    MppMemPoolNode      *head;
+    RK_S32              count;
+} MppMemPoolImpl;
+
+static void mem_pool_free_list(const char *caller, MppMemPoolNode *node)
+{
+    while (node) {
+        MppMemPoolNode *next = node->next;
+
+        mpp_osal_free(caller, node);
+        node = next;
+    }
+}
+
+static void mem_pool_cache_release(void *ctx)
+{
+    MppMemPoolCache *cache = (MppMemPoolCache *)ctx;
+
+    if (NULL == cache)
+        return;
+
+    mem_pool_free_list(MODULE_TAG, cache->head);
+    mpp_free(cache);
+}
+
+static MppMemPoolCache *mem_pool_get_cache(MppMemPoolImpl *impl)
+{
+    MppMemPoolCache *cache = (MppMemPoolCache *)pthread_getspecific(impl->key);
+
+    if (NULL == cache) {
+        cache = mpp_calloc(MppMemPoolCache, 1);
+        if (cache && pthread_setspecific(impl->key, cache))
+            MPP_FREE(cache);
+    }
+
+    return cache;
+}
+
+MppMemPool mpp_mem_pool_init_f(const char *caller, size_t size)
+{
+    MppMemPoolImpl *impl = mpp_calloc(MppMemPoolImpl, 1);
+    RK_U32 mem_debug = 0;
+
+    if (NULL == impl) {
+        mpp_err_f("failed to malloc pool for %s\n", caller);
+        return NULL;
+    }
+
+    impl->caller = caller;
+    impl->size = MPP_MAX(size, sizeof(MppMemPoolNode));
+    impl->cache_max = MPP_CLIP3(MEM_POOL_CACHE_MIN, MEM_POOL_CACHE_MAX,
+                                (RK_S32)(MEM_POOL_CACHE_SIZE / impl->size));
+
+    /* keep every allocation visible to the memory tracker on debug */
+    mpp_env_get_u32("mpp_mem_debug", &mem_debug, 0);
+    impl->bypass = mem_debug ? 1 : 0;
+
+    if (!impl->bypass && pthread_key_create(&impl->key, mem_pool_cache_release))
+        impl->bypass = 1;
+
+    pthread_mutex_init(&impl->lock, NULL);
+
+    return impl;
+}
+
+void mpp_mem_pool_deinit(MppMemPool pool)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+
+    if (NULL == impl)
+        return;
+
+    if (!impl->bypass) {
+        mem_pool_cache_release(pthread_getspecific(impl->key));
+        pthread_setspecific(impl->key, NULL);
+        pthread_key_delete(impl->key);
+    }
+
+    mem_pool_free_list(impl->caller, impl->head);
+    pthread_mutex_destroy(&impl->lock);
+    mpp_free(impl);
+}
+
+void *mpp_mem_pool_get(MppMemPool pool)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    MppMemPoolCache *cache = NULL;
+    MppMemPoolNode *node = NULL;
+
+    if (!impl->bypass)
+        cache = mem_pool_get_cache(impl);
+
+    if (NULL == cache)
+        return mpp_osal_malloc(impl->caller, impl->size);
+
+    /* refill from shared list by half cache, count is changed under lock */
+    if (NULL == cache->head && MPP_LOAD_ACQUIRE(&impl->count)) {
+        pthread_mutex_lock(&impl->lock);
+        while (impl->head && cache->count < impl->cache_max / 2) {
+            node = impl->head;
+            impl->head = node->next;
+            impl->count--;
+
+            node->next = cache->head;
+            cache->head = node;
+            cache->count++;
+        }
+        pthread_mutex_unlock(&impl->lock);
+    }
+
+    node = cache->head;
+    if (NULL == node)
+        return mpp_osal_malloc(impl->caller, impl->size);
+
+    cache->head = node->next;
+    cache->count--;
+
+    return node;
+}
+
+void mpp_mem_pool_put(MppMemPool pool, void *p)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    MppMemPoolNode *node = (MppMemPoolNode *)p;
+    MppMemPoolCache *cache = NULL;
+
+    if (NULL == p)
+        return;
+
+    if (!impl->bypass)
+        cache = mem_pool_get_cache(impl);
+
+    if (NULL == cache) {
+        mpp_osal_free(impl->caller, p);
+        return;
+    }
+
+    /* flush half cache to shared list and release the overflow */
+    if (cache->count >= impl->cache_max) {
+        RK_S32 shared_max = impl->cache_max * MEM_POOL_SHARED_RATIO;
+        MppMemPoolNode *overflow = NULL;
+
+        pthread_mutex_lock(&impl->lock);
+        while (cache->count > impl->cache_max / 2) {
+            MppMemPoolNode *tmp = cache->head;
+
+            cache->head = tmp->next;
+            cache->count--;
+
+            if (impl->count < shared_max) {
+                tmp->next = impl->head;
+                impl->head = tmp;
+                impl->count++;
+            } else {
+                tmp->next = overflow;
+                overflow = tmp;
+            }
+        }
+        pthread_mutex_unlock(&impl->lock);
+
+        mem_pool_free_list(impl->caller, overflow);
+    }
+
+    node->next = cache->head;
+    cache->head = node;
+    cache->count++;
+}
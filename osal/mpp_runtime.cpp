@@ -77,6 +77,11 @@ RK_U32 MppRuntimeService::get_allocator_valid(MppBufferType type)
 MppRuntimeService::MppRuntimeService()
 {
     allocator_valid[MPP_BUFFER_TYPE_NORMAL] = 1;
+#if defined(__gnu_linux__)
+    allocator_valid[MPP_BUFFER_TYPE_MEMFD] = 1;
+#else
+    allocator_valid[MPP_BUFFER_TYPE_MEMFD] = 0;
+#endif
 
     if (access("/dev/ion", F_OK | R_OK | W_OK)) {
         allocator_valid[MPP_BUFFER_TYPE_ION] = 0;
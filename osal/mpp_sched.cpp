@@ -0,0 +1,364 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_sched"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_atomic.h"
+#include "mpp_common.h"
+#include "mpp_sched.h"
+
+#define MPP_SCHED_WORKER_MAX        64
+
+#define MPP_SCHED_DBG_FUNCTION      (0x00000001)
+#define MPP_SCHED_DBG_JOB           (0x00000002)
+
+#define sched_dbg(flag, fmt, ...)   _mpp_dbg(mpp_sched_debug, flag, fmt, ## __VA_ARGS__)
+#define sched_dbg_func(fmt, ...)    sched_dbg(MPP_SCHED_DBG_FUNCTION, fmt, ## __VA_ARGS__)
+#define sched_dbg_job(fmt, ...)     sched_dbg(MPP_SCHED_DBG_JOB, fmt, ## __VA_ARGS__)
+
+static RK_U32 mpp_sched_debug = 0;
+
+class MppSchedService;
+
+typedef struct MppSchedWorker_t {
+    MppSchedService     *sched;
+    RK_S32              id;
+    pthread_t           thd;
+
+    // job fifo of this worker
+    pthread_mutex_t     lock;
+    MppSchedJob         *head;
+    MppSchedJob         *tail;
+
+    // statistic
+    RK_U32              run_count;
+    RK_U32              steal_count;
+} MppSchedWorker;
+
+class MppSchedService
+{
+private:
+    // avoid any unwanted function
+    MppSchedService();
+    ~MppSchedService();
+    MppSchedService(const MppSchedService &);
+    MppSchedService &operator=(const MppSchedService &);
+
+    static void *worker_loop(void *arg);
+    MppSchedJob *pop(MppSchedWorker *worker);
+    MppSchedJob *steal(MppSchedWorker *worker);
+
+    RK_S32              mCount;
+    MppSchedWorker      *mWorkers;
+    pthread_key_t       mKey;
+    RK_U32              mNext;
+    RK_S32              mRunning;
+
+    // idle worker sleep on this condition
+    pthread_mutex_t     mLock;
+    pthread_cond_t      mCond;
+    volatile RK_S32     mPending;
+    volatile RK_S32     mIdle;
+
+public:
+    static MppSchedService *get_instance() {
+        static MppSchedService instance;
+        return &instance;
+    }
+
+    RK_S32 get_workers() { return mCount; };
+    MppSchedWorker *get_worker();
+    void submit(MppSchedJob *job);
+    RK_S32 help();
+};
+
+MppSchedService::MppSchedService()
+    : mCount(0),
+      mWorkers(NULL),
+      mNext(0),
+      mRunning(0),
+      mPending(0),
+      mIdle(0)
+{
+    RK_U32 count = 0;
+    RK_S32 i;
+
+    mpp_env_get_u32("mpp_sched_debug", &mpp_sched_debug, 0);
+    mpp_env_get_u32("mpp_sched_workers", &count, 0);
+
+    if (!count)
+        return;
+
+    if (count > MPP_SCHED_WORKER_MAX)
+        count = MPP_SCHED_WORKER_MAX;
+
+    if (pthread_key_create(&mKey, NULL)) {
+        mpp_err_f("failed to create worker key\n");
+        return;
+    }
+
+    mWorkers = mpp_calloc(MppSchedWorker, count);
+    if (NULL == mWorkers) {
+        mpp_err_f("failed to malloc %d workers\n", count);
+        pthread_key_delete(mKey);
+        return;
+    }
+
+    pthread_mutex_init(&mLock, NULL);
+    pthread_cond_init(&mCond, NULL);
+    mRunning = 1;
+
+    for (i = 0; i < (RK_S32)count; i++) {
+        MppSchedWorker *worker = &mWorkers[i];
+        /* room for "mpp_sched_" and any RK_S32 index */
+        char name[32];
+
+        worker->sched = this;
+        worker->id = i;
+        pthread_mutex_init(&worker->lock, NULL);
+
+        if (pthread_create(&worker->thd, NULL, worker_loop, worker)) {
+            mpp_err_f("failed to create worker %d\n", i);
+            pthread_mutex_destroy(&worker->lock);
+            break;
+        }
+
+        snprintf(name, sizeof(name), "mpp_sched_%d", i);
+#ifndef ARMLINUX
+        pthread_setname_np(worker->thd, name);
+#endif
+        mCount++;
+    }
+
+    mpp_log("scheduler start with %d workers\n", mCount);
+}
+
+MppSchedService::~MppSchedService()
+{
+    RK_S32 i;
+
+    if (NULL == mWorkers)
+        return;
+
+    pthread_mutex_lock(&mLock);
+    mRunning = 0;
+    pthread_cond_broadcast(&mCond);
+    pthread_mutex_unlock(&mLock);
+
+    for (i = 0; i < mCount; i++) {
+        MppSchedWorker *worker = &mWorkers[i];
+
+        pthread_join(worker->thd, NULL);
+        if (worker->head)
+            mpp_err_f("worker %d quit with pending job\n", i);
+
+        sched_dbg_func("worker %d run %d steal %d\n", i,
+                       worker->run_count, worker->steal_count);
+        pthread_mutex_destroy(&worker->lock);
+    }
+
+    pthread_cond_destroy(&mCond);
+    pthread_mutex_destroy(&mLock);
+    pthread_key_delete(mKey);
+    MPP_FREE(mWorkers);
+}
+
+MppSchedWorker *MppSchedService::get_worker()
+{
+    if (!mCount)
+        return NULL;
+
+    return (MppSchedWorker *)pthread_getspecific(mKey);
+}
+
+MppSchedJob *MppSchedService::pop(MppSchedWorker *worker)
+{
+    MppSchedJob *job = NULL;
+
+    pthread_mutex_lock(&worker->lock);
+    job = worker->head;
+    if (job) {
+        worker->head = job->next;
+        if (NULL == worker->head)
+            worker->tail = NULL;
+        job->next = NULL;
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    if (job)
+        MPP_FETCH_SUB(&mPending, 1);
+
+    return job;
+}
+
+MppSchedJob *MppSchedService::steal(MppSchedWorker *worker)
+{
+    MppSchedJob *job = NULL;
+    RK_S32 i;
+
+    for (i = 1; i < mCount && NULL == job; i++) {
+        MppSchedWorker *victim = &mWorkers[(worker->id + i) % mCount];
+
+        if (MPP_LOAD_RELAXED(&victim->head))
+            job = pop(victim);
+    }
+
+    if (job)
+        worker->steal_count++;
+
+    return job;
+}
+
+void *MppSchedService::worker_loop(void *arg)
+{
+    MppSchedWorker *worker = (MppSchedWorker *)arg;
+    MppSchedService *sched = worker->sched;
+
+    pthread_setspecific(sched->mKey, worker);
+
+    while (1) {
+        MppSchedJob *job = sched->pop(worker);
+
+        if (NULL == job)
+            job = sched->steal(worker);
+
+        if (job) {
+            sched_dbg_job("worker %d run job %p\n", worker->id, job);
+            worker->run_count++;
+            /* NOTE: job may be released by itself, do not touch it after run */
+            job->func(job->ctx);
+            continue;
+        }
+
+        pthread_mutex_lock(&sched->mLock);
+        if (!sched->mRunning) {
+            pthread_mutex_unlock(&sched->mLock);
+            break;
+        }
+
+        /* pair with mPending increase and mIdle check in submit */
+        MPP_FETCH_ADD(&sched->mIdle, 1);
+        if (MPP_LOAD_ACQUIRE(&sched->mPending) <= 0)
+            pthread_cond_wait(&sched->mCond, &sched->mLock);
+        MPP_FETCH_SUB(&sched->mIdle, 1);
+        pthread_mutex_unlock(&sched->mLock);
+    }
+
+    return NULL;
+}
+
+void MppSchedService::submit(MppSchedJob *job)
+{
+    MppSchedWorker *worker = get_worker();
+
+    if (NULL == worker)
+        worker = &mWorkers[MPP_FETCH_ADD(&mNext, 1) % mCount];
+
+    sched_dbg_job("submit job %p to worker %d\n", job, worker->id);
+
+    job->next = NULL;
+    pthread_mutex_lock(&worker->lock);
+    if (worker->tail)
+        worker->tail->next = job;
+    else
+        worker->head = job;
+    worker->tail = job;
+    pthread_mutex_unlock(&worker->lock);
+
+    MPP_FETCH_ADD(&mPending, 1);
+    if (MPP_LOAD_ACQUIRE(&mIdle)) {
+        pthread_mutex_lock(&mLock);
+        pthread_cond_signal(&mCond);
+        pthread_mutex_unlock(&mLock);
+    }
+}
+
+RK_S32 MppSchedService::help()
+{
+    MppSchedWorker *worker = get_worker();
+    MppSchedJob *job = NULL;
+
+    if (NULL == worker)
+        return 0;
+
+    job = pop(worker);
+    if (NULL == job)
+        job = steal(worker);
+
+    if (NULL == job)
+        return 0;
+
+    sched_dbg_job("worker %d help job %p\n", worker->id, job);
+    worker->run_count++;
+    job->func(job->ctx);
+    return 1;
+}
+
+RK_S32 mpp_sched_get_workers(void)
+{
+    return MppSchedService::get_instance()->get_workers();
+}
+
+void mpp_sched_job_init(MppSchedJob *job, MppSchedFunc func, void *ctx)
+{
+    job->next = NULL;
+    job->func = func;
+    job->ctx = ctx;
+}
+
+void mpp_sched_submit(MppSchedJob *job)
+{
+    MppSchedService *sched = MppSchedService::get_instance();
+
+    if (!sched->get_workers()) {
+        mpp_err_f("submit job %p without worker\n", job);
+        return;
+    }
+
+    sched->submit(job);
+}
+
+RK_S32 mpp_sched_is_worker(void)
+{
+    return MppSchedService::get_instance()->get_worker() ? 1 : 0;
+}
+
+RK_S32 mpp_sched_help(void)
+{
+    return MppSchedService::get_instance()->help();
+}
+
+void mpp_sched_sem_wait(sem_t *sem)
+{
+    MppSchedService *sched = MppSchedService::get_instance();
+
+    if (NULL == sched->get_worker()) {
+        sem_wait(sem);
+        return;
+    }
+
+    /* the job to post the semaphore may be queued behind current job */
+    while (sem_trywait(sem)) {
+        if (!sched->help())
+            msleep(1);
+    }
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_spsc_queue"
+
+#include <errno.h>
+
+#include "mpp_err.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_atomic.h"
+#include "mpp_spsc_queue.h"
+
+MppSpscQueue::MppSpscQueue(RK_S32 capacity, node_destructor func)
+    : mSlots(NULL),
+      mMask(0),
+      mCapacity(0),
+      mHead(0),
+      mTail(0),
+      mWaiters(0),
+      destroy(func)
+{
+    RK_U32 count = 1;
+
+    if (capacity <= 0)
+        capacity = 1;
+
+    while (count < (RK_U32)capacity)
+        count <<= 1;
+
+    mSlots = mpp_calloc(void *, count);
+    if (NULL == mSlots) {
+        mpp_err_f("failed to malloc %d slots\n", count);
+        return;
+    }
+
+    mMask = count - 1;
+    mCapacity = capacity;
+}
+
+MppSpscQueue::~MppSpscQueue()
+{
+    flush();
+    MPP_FREE(mSlots);
+}
+
+RK_S32 MppSpscQueue::push(void *data)
+{
+    RK_U32 tail = MPP_LOAD_RELAXED(&mTail);
+    RK_U32 head = MPP_LOAD_ACQUIRE(&mHead);
+
+    if (tail - head >= mCapacity)
+        return MPP_NOK;
+
+    MPP_STORE_RELAXED(&mSlots[tail & mMask], data);
+    MPP_STORE_RELEASE(&mTail, tail + 1);
+
+    /* pairs with the waiter count increase in wait() */
+    MPP_SYNC();
+    if (MPP_LOAD_RELAXED(&mWaiters)) {
+        AutoMutex autoLock(&mMutex);
+        mCondition.signal();
+    }
+
+    return MPP_OK;
+}
+
+RK_S32 MppSpscQueue::pop(void **data)
+{
+    RK_U32 head;
+    void *val;
+
+    /*
+     * The slot is read before the head is moved so the producer can not
+     * overwrite it. Head is moved by cas for the reset thread drain.
+     */
+    do {
+        head = MPP_LOAD_ACQUIRE(&mHead);
+        if (head == MPP_LOAD_ACQUIRE(&mTail))
+            return MPP_NOK;
+
+        val = MPP_LOAD_RELAXED(&mSlots[head & mMask]);
+    } while (!MPP_BOOL_CAS(&mHead, head, head + 1));
+
+    if (data)
+        *data = val;
+
+    return MPP_OK;
+}
+
+RK_S32 MppSpscQueue::size()
+{
+    RK_U32 head = MPP_LOAD_ACQUIRE(&mHead);
+    RK_U32 tail = MPP_LOAD_ACQUIRE(&mTail);
+
+    return (RK_S32)(tail - head);
+}
+
+RK_S32 MppSpscQueue::capacity()
+{
+    return mCapacity;
+}
+
+RK_S32 MppSpscQueue::flush()
+{
+    void *val = NULL;
+
+    while (!pop(&val)) {
+        if (destroy)
+            destroy(&val);
+    }
+
+    return MPP_OK;
+}
+
+RK_S32 MppSpscQueue::wait(RK_S64 timeout)
+{
+    RK_S64 end = 0;
+    RK_S32 ret = 0;
+
+    if (size())
+        return 0;
+
+    if (!timeout)
+        return ETIMEDOUT;
+
+    if (timeout > 0)
+        end = mpp_time() + timeout * 1000;
+
+    AutoMutex autoLock(&mMutex);
+
+    MPP_ADD_FETCH(&mWaiters, 1);
+
+    while (!size()) {
+        if (timeout < 0) {
+            mCondition.wait(&mMutex);
+        } else {
+            RK_S64 left = end - mpp_time();
+
+            if (left <= 0) {
+                ret = ETIMEDOUT;
+                break;
+            }
+
+            mCondition.timedwait(&mMutex, (left + 999) / 1000);
+        }
+    }
+
+    MPP_SUB_FETCH(&mWaiters, 1);
+
+    return ret;
+}
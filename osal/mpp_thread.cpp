@@ -19,28 +19,135 @@
 #include <string.h>
 
 #include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_sched.h"
 #include "mpp_common.h"
 #include "mpp_thread.h"
 
 #define MPP_THREAD_DBG_FUNCTION     (0x00000001)
 
+// loop count before a job yields its worker to other jobs
+#define MPP_THREAD_JOB_BUDGET       8
+
+typedef enum MppThreadJobStatus_e {
+    THREAD_JOB_IDLE,            // waiting for signal
+    THREAD_JOB_QUEUED,          // queued or running on scheduler
+    THREAD_JOB_DONE,            // loop quit on stop
+} MppThreadJobStatus;
+
 static RK_U32 thread_debug = 0;
 
 #define thread_dbg(flag, fmt, ...)  _mpp_dbg(thread_debug, flag, fmt, ## __VA_ARGS__)
 
 MppThread::MppThread(MppThreadFunc func, void *ctx, const char *name)
     : mFunction(func),
-      mContext(ctx)
+      mContext(ctx),
+      mCheck(NULL),
+      mWork(NULL),
+      mJob(NULL),
+      mJobStatus(THREAD_JOB_IDLE)
+{
+    init(name);
+}
+
+MppThread::MppThread(MppThreadCheck check, MppThreadWork work, void *ctx,
+                     const char *name)
+    : mFunction(loop),
+      mContext(ctx),
+      mCheck(check),
+      mWork(work),
+      mJob(NULL),
+      mJobStatus(THREAD_JOB_IDLE)
+{
+    init(name);
+
+    if (mpp_sched_get_workers()) {
+        mJob = mpp_calloc(MppSchedJob, 1);
+        if (mJob)
+            mpp_sched_job_init(mJob, run_job, this);
+    }
+}
+
+MppThread::~MppThread()
+{
+    MPP_FREE(mJob);
+}
+
+void MppThread::init(const char *name)
 {
     mStatus[THREAD_WORK]    = MPP_THREAD_UNINITED;
     mStatus[THREAD_INPUT]   = MPP_THREAD_RUNNING;
     mStatus[THREAD_OUTPUT]  = MPP_THREAD_RUNNING;
     mStatus[THREAD_CONTROL] = MPP_THREAD_RUNNING;
 
-    if (name)
-        strncpy(mName, name, sizeof(mName));
-    else
-        snprintf(mName, sizeof(mName), "mpp_thread");
+    snprintf(mName, sizeof(mName), "%s", name ? name : "mpp_thread");
+}
+
+void *MppThread::loop(void *ctx)
+{
+    MppThread *thd = (MppThread *)ctx;
+
+    while (1) {
+        {
+            AutoMutex autolock(thd->mutex());
+            if (MPP_THREAD_RUNNING != thd->get_status())
+                break;
+
+            if (thd->mCheck(thd->mContext)) {
+                thd->wait();
+                continue;
+            }
+        }
+
+        thd->mWork(thd->mContext);
+    }
+
+    return NULL;
+}
+
+void MppThread::run_job(void *ctx)
+{
+    MppThread *thd = (MppThread *)ctx;
+    RK_S32 count = 0;
+
+    while (1) {
+        thd->lock();
+        if (MPP_THREAD_RUNNING != thd->get_status()) {
+            thd->mJobStatus = THREAD_JOB_DONE;
+            thd->mMutexCond[THREAD_WORK].signal();
+            /* NOTE: thread may be deleted by stop after unlock */
+            thd->unlock();
+            return;
+        }
+
+        if (count >= MPP_THREAD_JOB_BUDGET) {
+            /* requeue to tail for fairness and keep QUEUED status */
+            mpp_sched_submit(thd->mJob);
+            thd->unlock();
+            return;
+        }
+
+        if (thd->mCheck(thd->mContext)) {
+            thd->mJobStatus = THREAD_JOB_IDLE;
+            thd->unlock();
+            return;
+        }
+        thd->unlock();
+
+        thd->mWork(thd->mContext);
+        count++;
+    }
+}
+
+void MppThread::resume()
+{
+    /* called with THREAD_WORK lock held */
+    if (THREAD_JOB_IDLE == mJobStatus &&
+        MPP_THREAD_UNINITED != mStatus[THREAD_WORK]) {
+        mJobStatus = THREAD_JOB_QUEUED;
+        mpp_sched_submit(mJob);
+    }
 }
 
 MppThreadStatus MppThread::get_status(MppThreadSignal id)
@@ -66,10 +173,21 @@ void MppThread::start()
     pthread_attr_init(&attr);
     pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
 
-    if (MPP_THREAD_UNINITED == get_status()) {
+    if (mJob && MPP_THREAD_UNINITED == get_status()) {
+        AutoMutex autolock(mutex());
+
+        set_status(MPP_THREAD_RUNNING);
+        mJobStatus = THREAD_JOB_IDLE;
+        resume();
+        thread_dbg(MPP_THREAD_DBG_FUNCTION, "thread %s context %p start on scheduler\n",
+                   mName, mContext);
+    } else if (MPP_THREAD_UNINITED == get_status()) {
         // NOTE: set status here first to avoid unexpected loop quit racing condition
         set_status(MPP_THREAD_RUNNING);
-        if (0 == pthread_create(&mThread, &attr, mFunction, mContext)) {
+        // loop mode thread function takes the thread itself
+        void *arg = (mCheck) ? (void *)this : mContext;
+
+        if (0 == pthread_create(&mThread, &attr, mFunction, arg)) {
 #ifndef ARMLINUX
             RK_S32 ret = pthread_setname_np(mThread, mName);
             if (ret)
@@ -86,7 +204,25 @@ void MppThread::start()
 
 void MppThread::stop()
 {
-    if (MPP_THREAD_UNINITED != get_status()) {
+    if (mJob && MPP_THREAD_UNINITED != get_status()) {
+        lock();
+        set_status(MPP_THREAD_STOPPING);
+        resume();
+        while (THREAD_JOB_DONE != mJobStatus) {
+            if (mpp_sched_is_worker()) {
+                unlock();
+                if (!mpp_sched_help())
+                    msleep(1);
+                lock();
+            } else
+                mMutexCond[THREAD_WORK].wait();
+        }
+        set_status(MPP_THREAD_UNINITED);
+        unlock();
+
+        thread_dbg(MPP_THREAD_DBG_FUNCTION, "thread %s context %p stop on scheduler\n",
+                   mName, mContext);
+    } else if (MPP_THREAD_UNINITED != get_status()) {
         lock();
         set_status(MPP_THREAD_STOPPING);
         thread_dbg(MPP_THREAD_DBG_FUNCTION,
@@ -57,6 +57,17 @@ void mpp_time_diff(RK_S64 start, RK_S64 end, RK_S64 limit, const char *fmt)
         mpp_dbg(MPP_DBG_TIMING, "%s timing %lld us\n", fmt, diff);
 }
 
+/*
+ * Log-linear latency histogram in microsecond
+ * Value below 8 has its own bucket. Each power of two above is split into 8
+ * buckets so the bucket width is at most 1/8 of its value.
+ */
+#define CLOCK_HIST_SUB_BITS     3
+#define CLOCK_HIST_SUB          (1 << CLOCK_HIST_SUB_BITS)
+#define CLOCK_HIST_VAL_MAX      (0x7fffffff)
+/* mpp_log2(CLOCK_HIST_VAL_MAX) is 30 */
+#define CLOCK_HIST_SIZE         ((30 - CLOCK_HIST_SUB_BITS + 2) * CLOCK_HIST_SUB)
+
 typedef struct MppClockImpl_t {
     const char *check;
     char    name[16];
@@ -65,10 +76,37 @@ typedef struct MppClockImpl_t {
     RK_S64  time;
     RK_S64  sum;
     RK_S64  count;
+    RK_S64  max;
+    RK_U32  hist[CLOCK_HIST_SIZE];
 } MppClockImpl;
 
 static const char *clock_name = "mpp_clock";
 
+static RK_U32 clock_hist_idx(RK_S64 val)
+{
+    RK_U32 v = (val > CLOCK_HIST_VAL_MAX) ? (CLOCK_HIST_VAL_MAX) :
+               (val < 0) ? (0) : ((RK_U32)val);
+    RK_S32 shift;
+
+    if (v < CLOCK_HIST_SUB)
+        return v;
+
+    shift = mpp_log2(v) - CLOCK_HIST_SUB_BITS;
+    return (shift + 1) * CLOCK_HIST_SUB + ((v >> shift) & (CLOCK_HIST_SUB - 1));
+}
+
+/* the largest value falls into the bucket */
+static RK_S64 clock_hist_val(RK_U32 idx)
+{
+    RK_S32 shift;
+
+    if (idx < CLOCK_HIST_SUB)
+        return idx;
+
+    shift = idx / CLOCK_HIST_SUB - 1;
+    return ((RK_S64)(CLOCK_HIST_SUB + idx % CLOCK_HIST_SUB + 1) << shift) - 1;
+}
+
 MPP_RET check_is_mpp_clock(void *clock)
 {
     if (clock && ((MppClockImpl*)clock)->check == clock_name)
@@ -144,8 +182,13 @@ RK_S64 mpp_clock_pause(MppClock clock)
 
     if (!p->time) {
         // first pause after start
-        p->sum += time - p->base;
+        RK_S64 diff = time - p->base;
+
+        p->sum += diff;
         p->count++;
+        p->hist[clock_hist_idx(diff)]++;
+        if (diff > p->max)
+            p->max = diff;
     }
     p->time = time;
     return p->time - p->base;
@@ -162,6 +205,8 @@ RK_S64 mpp_clock_reset(MppClock clock)
         p->time = 0;
         p->sum = 0;
         p->count = 0;
+        p->max = 0;
+        memset(p->hist, 0, sizeof(p->hist));
     }
 
     return 0;
@@ -189,6 +234,56 @@ RK_S64 mpp_clock_get_count(MppClock clock)
     return (p->enable) ? (p->count) : (0);
 }
 
+RK_S64 mpp_clock_get_max(MppClock clock)
+{
+    if (NULL == clock || check_is_mpp_clock(clock)) {
+        mpp_err_f("invalid clock %p\n", clock);
+        return 0;
+    }
+
+    MppClockImpl *p = (MppClockImpl *)clock;
+    return (p->enable) ? (p->max) : (0);
+}
+
+RK_S64 mpp_clock_get_percentile(MppClock clock, RK_U32 percent)
+{
+    if (NULL == clock || check_is_mpp_clock(clock)) {
+        mpp_err_f("invalid clock %p\n", clock);
+        return 0;
+    }
+
+    MppClockImpl *p = (MppClockImpl *)clock;
+    RK_U64 total = 0;
+    RK_U64 target;
+    RK_U64 acc = 0;
+    RK_U32 i;
+
+    if (!p->enable)
+        return 0;
+
+    /* count may run ahead of histogram when sampled on the other thread */
+    for (i = 0; i < CLOCK_HIST_SIZE; i++)
+        total += p->hist[i];
+
+    if (!total)
+        return 0;
+
+    if (percent > 100)
+        percent = 100;
+
+    target = (total * percent + 99) / 100;
+    if (!target)
+        target = 1;
+
+    for (i = 0; i < CLOCK_HIST_SIZE; i++) {
+        acc += p->hist[i];
+        if (acc >= target)
+            break;
+    }
+
+    return MPP_MIN(clock_hist_val(i), p->max);
+}
+
 const char *mpp_clock_get_name(MppClock clock)
 {
     if (NULL == clock || check_is_mpp_clock(clock)) {
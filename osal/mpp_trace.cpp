@@ -0,0 +1,278 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_trace"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_trace.h"
+#include "mpp_atomic.h"
+#include "mpp_thread.h"
+
+#include "os_mem.h"
+
+#define MPP_TRACE_DEPTH_MAX     (1 << 20)
+
+RK_U32 mpp_trace_en = 0;
+
+typedef struct MppTraceEvent_t {
+    RK_S64          time;
+    const char      *name;
+    void            *ctx;
+    RK_S32          tid;
+    RK_S32          dur;            // negative for instant event
+    RK_S32          task;
+    RK_S32          slot;
+    RK_S32          size;
+    RK_S32          reserve;
+} MppTraceEvent;
+
+/*
+ * Ring is only written by its owner thread. When the owner exits the ring
+ * is handed to the next new thread with a new tid so the events recorded
+ * before are still exported with the old tid.
+ */
+typedef struct MppTraceRing_t {
+    struct MppTraceRing_t   *next;
+    RK_S32                  tid;
+    RK_S32                  idle;
+    char                    name[THREAD_NAME_LEN];
+
+    RK_U32                  mask;
+    RK_U32                  pos;
+    MppTraceEvent           *events;
+} MppTraceRing;
+
+class MppTraceService
+{
+public:
+    MppTraceService();
+    ~MppTraceService();
+
+    MppTraceRing *get_ring();
+    void    enable(RK_U32 depth);
+    MPP_RET dump(const char *path);
+
+    pthread_key_t   key;
+
+private:
+    static void put_ring(void *ring);
+
+    Mutex           lock;
+    MppTraceRing    *rings;
+    RK_U32          depth;
+    RK_S32          tid;
+    RK_S32          key_valid;
+    const char      *file;
+
+    MppTraceService(const MppTraceService &);
+    MppTraceService &operator=(const MppTraceService &);
+};
+
+static MppTraceService service;
+
+MppTraceService::MppTraceService()
+    : rings(NULL),
+      depth(0),
+      tid(0),
+      key_valid(0),
+      file(NULL)
+{
+    RK_U32 env_depth = 0;
+
+    key_valid = !pthread_key_create(&key, put_ring);
+
+    mpp_env_get_u32("mpp_trace_depth", &env_depth, 0);
+    mpp_env_get_str("mpp_trace_file", &file, NULL);
+
+    if (env_depth)
+        enable(env_depth);
+}
+
+MppTraceService::~MppTraceService()
+{
+    AutoMutex auto_lock(&lock);
+
+    mpp_trace_en = 0;
+
+    if (file && rings)
+        dump(file);
+
+    /*
+     * NOTE: rings and thread key are left to process exit. Threads which are
+     * still running may be writing to their ring in mpp_trace_emit without
+     * any lock while static destruction runs.
+     */
+}
+
+void MppTraceService::put_ring(void *ring)
+{
+    AutoMutex auto_lock(&service.lock);
+
+    ((MppTraceRing *)ring)->idle = 1;
+}
+
+MppTraceRing *MppTraceService::get_ring()
+{
+    AutoMutex auto_lock(&lock);
+    MppTraceRing *ring = NULL;
+
+    if (!key_valid || !depth)
+        return NULL;
+
+    for (ring = rings; ring; ring = ring->next) {
+        if (ring->idle && ring->mask + 1 == depth)
+            break;
+    }
+
+    if (NULL == ring) {
+        os_malloc((void **)&ring, sizeof(RK_S64), sizeof(MppTraceRing));
+        if (NULL == ring)
+            return NULL;
+
+        os_malloc((void **)&ring->events, sizeof(RK_S64),
+                  sizeof(MppTraceEvent) * depth);
+        if (NULL == ring->events) {
+            os_free(ring);
+            return NULL;
+        }
+
+        ring->mask = depth - 1;
+        ring->pos = 0;
+        ring->next = rings;
+        rings = ring;
+    }
+
+    ring->tid = ++tid;
+    ring->idle = 0;
+    ring->name[0] = '\0';
+#if !defined(ARMLINUX) && !defined(_WIN32)
+    pthread_getname_np(pthread_self(), ring->name, sizeof(ring->name));
+#endif
+
+    pthread_setspecific(key, ring);
+
+    return ring;
+}
+
+void MppTraceService::enable(RK_U32 size)
+{
+    AutoMutex auto_lock(&lock);
+
+    if (size) {
+        if (size > MPP_TRACE_DEPTH_MAX)
+            size = MPP_TRACE_DEPTH_MAX;
+
+        depth = 1;
+        while (depth < size)
+            depth <<= 1;
+    }
+
+    MPP_STORE_RELEASE(&mpp_trace_en, size ? 1 : 0);
+}
+
+MPP_RET MppTraceService::dump(const char *path)
+{
+    AutoMutex auto_lock(&lock);
+    MppTraceRing *ring = NULL;
+    RK_S32 pid = (RK_S32)getpid();
+    RK_S32 first = 1;
+    FILE *fp = fopen(path, "w");
+
+    if (NULL == fp) {
+        mpp_err_f("failed to open %s\n", path);
+        return MPP_NOK;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (ring = rings; ring; ring = ring->next) {
+        RK_U32 end = MPP_LOAD_ACQUIRE(&ring->pos);
+        RK_U32 start = (end > ring->mask + 1) ? (end - ring->mask - 1) : (0);
+        RK_U32 i;
+
+        if (ring->name[0]) {
+            fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+                    "\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", pid, ring->tid, ring->name);
+            first = 0;
+        }
+
+        for (i = start; i != end; i++) {
+            MppTraceEvent *ev = &ring->events[i & ring->mask];
+
+            fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":%d,\"tid\":%d,"
+                    "\"ts\":%lld", first ? "" : ",\n", ev->name,
+                    (ev->dur < 0) ? "i" : "X", pid, ev->tid, ev->time);
+            if (ev->dur >= 0)
+                fprintf(fp, ",\"dur\":%d", ev->dur);
+            else
+                fprintf(fp, ",\"s\":\"t\"");
+
+            fprintf(fp, ",\"args\":{\"ctx\":\"%p\",\"task\":%d,\"slot\":%d,"
+                    "\"size\":%d}}", ev->ctx, ev->task, ev->slot, ev->size);
+            first = 0;
+        }
+    }
+
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+
+    return MPP_OK;
+}
+
+void mpp_trace_emit(const char *name, void *ctx, RK_S32 task, RK_S32 slot,
+                    RK_S32 size, RK_S64 start, RK_S64 end)
+{
+    MppTraceRing *ring = (MppTraceRing *)pthread_getspecific(service.key);
+    MppTraceEvent *ev = NULL;
+    RK_U32 pos;
+
+    if (NULL == ring) {
+        ring = service.get_ring();
+        if (NULL == ring)
+            return;
+    }
+
+    pos = ring->pos;
+    ev = &ring->events[pos & ring->mask];
+    ev->time = start;
+    ev->name = name;
+    ev->ctx = ctx;
+    ev->tid = ring->tid;
+    ev->dur = (end < 0) ? (-1) : (RK_S32)(end - start);
+    ev->task = task;
+    ev->slot = slot;
+    ev->size = size;
+
+    /* pair with the acquire load in dump */
+    MPP_STORE_RELEASE(&ring->pos, pos + 1);
+}
+
+void mpp_trace_enable(RK_U32 depth)
+{
+    service.enable(depth);
+}
+
+MPP_RET mpp_trace_dump(const char *path)
+{
+    if (NULL == path)
+        return MPP_ERR_NULL_PTR;
+
+    return service.dump(path);
+}
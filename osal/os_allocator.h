@@ -30,6 +30,8 @@ typedef struct os_allocator_t {
     OsAllocatorFunc import;
     OsAllocatorFunc release;
     OsAllocatorFunc mmap;
+    /* optional */
+    MPP_RET (*config)(void *ctx, MppAllocatorCfg *cfg);
 } os_allocator;
 
 #ifdef __cplusplus
@@ -16,13 +16,41 @@
 
 #define MODULE_TAG "mpp_log_test"
 
+#include "mpp_env.h"
 #include "mpp_log.h"
+#include "mpp_time.h"
 
-int main()
+#define LOG_TEST_THREADS    4
+#define LOG_TEST_COUNT      10000
+
+static void *log_test_thread(void *arg)
+{
+    RK_S32 id = *(RK_S32 *)arg;
+    RK_S32 i;
+
+    for (i = 0; i < LOG_TEST_COUNT; i++)
+        mpp_log("thread %d message %d\n", id, i);
+
+    return NULL;
+}
+
+/*
+ * usage: mpp_log_test [async depth] [rate]
+ * default runs async log with depth 1024 and 100 messages per second
+ */
+int main(int argc, char **argv)
 {
     RK_U32 flag_dbg = 0x02;
     RK_U32 flag_set = 0xffff;
     RK_U32 flag_get = 0;
+    pthread_t thds[LOG_TEST_THREADS];
+    RK_S32 ids[LOG_TEST_THREADS];
+    RK_S64 time;
+    RK_S32 i;
+
+    /* must be setup before the first log */
+    mpp_env_set_u32("mpp_log_async", (argc > 1) ? atoi(argv[1]) : 1024);
+    mpp_env_set_u32("mpp_log_rate", (argc > 2) ? atoi(argv[2]) : 100);
 
     mpp_err("mpp log test start\n");
 
@@ -48,6 +76,20 @@ int main()
     mpp_log("try _mpp_dbg test 0 debug %x, flag %x", flag_get, flag_dbg);
     _mpp_dbg(flag_get, flag_dbg, "mpp_dbg printing debug %x, flag %x", flag_get, flag_dbg);
 
+    time = mpp_time();
+    for (i = 0; i < LOG_TEST_THREADS; i++) {
+        ids[i] = i;
+        pthread_create(&thds[i], NULL, log_test_thread, &ids[i]);
+    }
+
+    for (i = 0; i < LOG_TEST_THREADS; i++)
+        pthread_join(thds[i], NULL);
+    time = mpp_time() - time;
+
+    mpp_err("%d threads log %d messages %.1f ns per message\n",
+            LOG_TEST_THREADS, LOG_TEST_COUNT,
+            (double)time * 1000 / (LOG_TEST_THREADS * LOG_TEST_COUNT));
+
     mpp_err("mpp log log test done\n");
 
     return 0;
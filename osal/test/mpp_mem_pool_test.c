@@ -0,0 +1,157 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_mem_pool_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
+#include "mpp_mem_pool.h"
+
+#define POOL_TEST_SIZE      512
+#define POOL_TEST_BATCH     32
+#define POOL_TEST_ROUND     20000
+
+/*
+ * packet flow between threads: producer gets a batch of memory and the
+ * consumer releases the whole batch on another thread
+ */
+typedef struct PoolTestCtx_t {
+    MppMemPool      pool;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    void            *batch[POOL_TEST_BATCH];
+    RK_S32          ready;
+    RK_S32          error;
+} PoolTestCtx;
+
+static void *pool_test_alloc(PoolTestCtx *ctx)
+{
+    return (ctx->pool) ? mpp_mem_pool_get(ctx->pool) :
+           mpp_malloc_size(void, POOL_TEST_SIZE);
+}
+
+static void pool_test_free(PoolTestCtx *ctx, void *p)
+{
+    if (ctx->pool)
+        mpp_mem_pool_put(ctx->pool, p);
+    else
+        mpp_free(p);
+}
+
+static void *pool_test_consumer(void *arg)
+{
+    PoolTestCtx *ctx = (PoolTestCtx *)arg;
+    RK_S32 i, j;
+
+    for (i = 0; i < POOL_TEST_ROUND; i++) {
+        pthread_mutex_lock(&ctx->lock);
+        while (!ctx->ready)
+            pthread_cond_wait(&ctx->cond, &ctx->lock);
+
+        for (j = 0; j < POOL_TEST_BATCH; j++) {
+            RK_U8 *p = (RK_U8 *)ctx->batch[j];
+
+            if (p[0] != (RK_U8)j || p[POOL_TEST_SIZE - 1] != (RK_U8)j)
+                ctx->error = 1;
+
+            pool_test_free(ctx, p);
+        }
+
+        ctx->ready = 0;
+        pthread_cond_signal(&ctx->cond);
+        pthread_mutex_unlock(&ctx->lock);
+    }
+
+    return NULL;
+}
+
+static RK_S64 pool_test_cross_thread(PoolTestCtx *ctx)
+{
+    pthread_t thd;
+    RK_S64 time = mpp_time();
+    RK_S32 i, j;
+
+    pthread_create(&thd, NULL, pool_test_consumer, ctx);
+
+    for (i = 0; i < POOL_TEST_ROUND; i++) {
+        pthread_mutex_lock(&ctx->lock);
+        while (ctx->ready)
+            pthread_cond_wait(&ctx->cond, &ctx->lock);
+
+        for (j = 0; j < POOL_TEST_BATCH; j++) {
+            RK_U8 *p = (RK_U8 *)pool_test_alloc(ctx);
+
+            memset(p, j, POOL_TEST_SIZE);
+            ctx->batch[j] = p;
+        }
+
+        ctx->ready = 1;
+        pthread_cond_signal(&ctx->cond);
+        pthread_mutex_unlock(&ctx->lock);
+    }
+
+    pthread_join(thd, NULL);
+
+    return mpp_time() - time;
+}
+
+int main()
+{
+    PoolTestCtx ctx;
+    MppMemPool pool = mpp_mem_pool_init(POOL_TEST_SIZE);
+    void *p0 = NULL;
+    void *p1 = NULL;
+    RK_S64 time_pool;
+    RK_S64 time_malloc;
+    RK_S32 ret = 0;
+
+    mpp_log("mpp_mem_pool_test start\n");
+
+    /* same thread get after put should reuse the memory */
+    p0 = mpp_mem_pool_get(pool);
+    mpp_mem_pool_put(pool, p0);
+    p1 = mpp_mem_pool_get(pool);
+    mpp_mem_pool_put(pool, p1);
+    mpp_log("reuse check get %p -> %p\n", p0, p1);
+
+    memset(&ctx, 0, sizeof(ctx));
+    pthread_mutex_init(&ctx.lock, NULL);
+    pthread_cond_init(&ctx.cond, NULL);
+
+    ctx.pool = pool;
+    time_pool = pool_test_cross_thread(&ctx);
+    ret |= ctx.error;
+
+    ctx.pool = NULL;
+    time_malloc = pool_test_cross_thread(&ctx);
+    ret |= ctx.error;
+
+    mpp_log("cross thread %d x %d get / put: pool %.2f ms malloc %.2f ms\n",
+            POOL_TEST_ROUND, POOL_TEST_BATCH, time_pool / 1000.0,
+            time_malloc / 1000.0);
+
+    pthread_cond_destroy(&ctx.cond);
+    pthread_mutex_destroy(&ctx.lock);
+    mpp_mem_pool_deinit(pool);
+
+    mpp_log("mpp_mem_pool_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
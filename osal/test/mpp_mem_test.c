@@ -16,15 +16,79 @@
 
 #define MODULE_TAG "mpp_mem_test"
 
+#include <string.h>
+
 #include "mpp_log.h"
 #include "mpp_env.h"
 #include "mpp_mem.h"
+#include "mpp_time.h"
+
+#define MEM_TEST_LIVE       4096
+#define MEM_TEST_ROUND      1000000
+
+// TODO: need to add parameter scan case
+
+/*
+ * pressure case: keep MEM_TEST_LIVE allocation alive and replace a random one
+ * on each round. Run with and without env mpp_mem_debug=1 to compare the
+ * tracker overhead.
+ */
+static RK_S32 mem_test_pressure(void)
+{
+    void **live = mpp_calloc(void *, MEM_TEST_LIVE);
+    RK_U32 seed = 1;
+    RK_S64 time;
+    RK_S32 ret = 0;
+    RK_S32 i;
+
+    if (NULL == live)
+        return -1;
+
+    time = mpp_time();
+
+    for (i = 0; i < MEM_TEST_ROUND; i++) {
+        RK_U32 idx;
+        size_t size;
+
+        seed = seed * 1103515245 + 12345;
+        idx = (seed >> 8) % MEM_TEST_LIVE;
+        size = 16 + ((seed >> 20) & 0x3ff);
+
+        if (live[idx]) {
+            if (*(RK_U32 *)live[idx] != idx)
+                ret = -1;
+            mpp_free(live[idx]);
+        }
+
+        live[idx] = mpp_malloc_size(void, size);
+        if (NULL == live[idx]) {
+            ret = -1;
+            break;
+        }
+        *(RK_U32 *)live[idx] = idx;
+    }
+
+    time = mpp_time() - time;
+
+    mpp_log("pressure %d malloc / free with %d live: %.2f ms %.1f ns per round\n",
+            MEM_TEST_ROUND, MEM_TEST_LIVE, time / 1000.0,
+            (double)time * 1000 / MEM_TEST_ROUND);
 
-// TODO: need to add pressure test case and parameter scan case
+    if (MPP_OK == mpp_show_mem_stat())
+        mpp_log("caller statistic dumped\n");
+
+    for (i = 0; i < MEM_TEST_LIVE; i++)
+        MPP_FREE(live[i]);
+
+    mpp_free(live);
+
+    return ret;
+}
 
 int main()
 {
     void *tmp = NULL;
+    RK_S32 ret = 0;
 
     tmp = mpp_calloc(int, 100);
     if (tmp) {
@@ -41,7 +105,10 @@ int main()
         }
     }
     mpp_free(tmp);
-    mpp_log("mpp_mem_test done\n");
 
-    return 0;
+    ret = mem_test_pressure();
+
+    mpp_log("mpp_mem_test %s\n", ret ? "failed" : "success");
+
+    return ret;
 }
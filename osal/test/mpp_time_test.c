@@ -67,6 +67,24 @@ int main()
 
     mpp_log("mpp_time cost %.3f ms\n",
             mpp_clock_get_sum(clock) / mpp_clock_get_count(clock) / 1000.0);
+    mpp_log("mpp_time cost p50 %lld p90 %lld p99 %lld max %lld us\n",
+            mpp_clock_get_percentile(clock, 50), mpp_clock_get_percentile(clock, 90),
+            mpp_clock_get_percentile(clock, 99), mpp_clock_get_max(clock));
+
+    mpp_clock_reset(clock);
+
+    /* 90 short and 10 long sleep for percentile check */
+    for (i = 0; i < 100; i++) {
+        mpp_clock_start(clock);
+        msleep((i % 10) ? 1 : 10);
+        mpp_clock_pause(clock);
+    }
+
+    mpp_log("sleep 1ms x 90 10ms x 10 p50 %.3f p90 %.3f p99 %.3f max %.3f ms\n",
+            mpp_clock_get_percentile(clock, 50) / 1000.0,
+            mpp_clock_get_percentile(clock, 90) / 1000.0,
+            mpp_clock_get_percentile(clock, 99) / 1000.0,
+            mpp_clock_get_max(clock) / 1000.0);
 
     mpp_clock_reset(clock);
     mpp_clock_start(clock);
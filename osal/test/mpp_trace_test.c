@@ -0,0 +1,95 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_trace_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_trace.h"
+#include "mpp_thread.h"
+
+#define TRACE_TEST_THREADS      4
+#define TRACE_TEST_EVENTS       100000
+#define TRACE_TEST_DEPTH        1024
+
+static void *trace_test_thread(void *arg)
+{
+    RK_S32 i;
+
+    for (i = 0; i < TRACE_TEST_EVENTS; i++) {
+        RK_S64 ts = mpp_trace_ts();
+
+        mpp_trace_span("test_span", arg, i, i & 0xf, i * 2, ts);
+        if (!(i & 0xff))
+            mpp_trace_mark("test_mark", arg, i, -1, 0);
+    }
+
+    return NULL;
+}
+
+static RK_S64 trace_test_run(void)
+{
+    pthread_t thds[TRACE_TEST_THREADS];
+    RK_S32 ids[TRACE_TEST_THREADS];
+    RK_S64 time = mpp_time();
+    RK_S32 i;
+
+    for (i = 0; i < TRACE_TEST_THREADS; i++) {
+        ids[i] = i;
+        pthread_create(&thds[i], NULL, trace_test_thread, &ids[i]);
+    }
+
+    for (i = 0; i < TRACE_TEST_THREADS; i++)
+        pthread_join(thds[i], NULL);
+
+    return mpp_time() - time;
+}
+
+/*
+ * usage: mpp_trace_test [json file]
+ * open the json file by chrome://tracing or ui.perfetto.dev
+ */
+int main(int argc, char **argv)
+{
+    const char *path = (argc > 1) ? argv[1] : "mpp_trace_test.json";
+    RK_S32 count = TRACE_TEST_THREADS * TRACE_TEST_EVENTS;
+    RK_S64 time_off;
+    RK_S64 time_on;
+    MPP_RET ret;
+
+    mpp_log("mpp_trace_test start\n");
+
+    mpp_trace_enable(0);
+    time_off = trace_test_run();
+
+    mpp_trace_enable(TRACE_TEST_DEPTH);
+    time_on = trace_test_run();
+
+    mpp_log("%d events: disabled %.1f ns enabled %.1f ns per event\n", count,
+            (double)time_off * 1000 / count, (double)time_on * 1000 / count);
+
+    ret = mpp_trace_dump(path);
+    if (!ret)
+        mpp_log("last %d events per thread dumped to %s\n",
+                TRACE_TEST_DEPTH, path);
+
+    mpp_trace_enable(0);
+
+    mpp_log("mpp_trace_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
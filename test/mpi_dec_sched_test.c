@@ -0,0 +1,297 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpi_dec_sched_test"
+
+#include <string.h>
+#include <sys/resource.h>
+
+#include "rk_mpi.h"
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_env.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+
+#define SCHED_TEST_SESSIONS         16
+#define SCHED_TEST_FRAMES           1000
+#define SCHED_TEST_STREAM_SIZE      64
+#define SCHED_TEST_BUF_COUNT        4
+#define SCHED_TEST_TIMEOUT          10
+
+/*
+ * Multi-instance decoder benchmark on dummy decoder and dummy hal.
+ *
+ * usage: mpi_dec_sched_test [sessions] [frames] [workers] [prealloc] [batch]
+ *
+ * workers 0 runs each decoder on its own parser / hal thread and workers N
+ * runs all decoders on N shared scheduler workers.
+ * prealloc 1 allocates the frame buffers for the max size before decoding
+ * by MPP_DEC_SET_PRE_ALLOC_BUFF and keeps them over info change.
+ * batch N lets parser run N tasks ahead of hal by MPP_DEC_SET_PARSER_BATCH_DEPTH.
+ */
+typedef struct SchedTestSession_t {
+    MppCtx          ctx;
+    MppApi          *mpi;
+    MppBufferGroup  frm_grp;
+    pthread_t       thd;
+
+    RK_S32          frames;
+    RK_S32          prealloc;
+    RK_S32          put_count;
+    RK_S32          get_count;
+    RK_S32          error;
+    RK_S64          latency_max;
+    RK_S64          first_frame;
+} SchedTestSession;
+
+static RK_S32 sched_test_thread_count(void)
+{
+    RK_S32 count = 0;
+    char line[128];
+    FILE *fp = fopen("/proc/self/status", "r");
+
+    if (NULL == fp)
+        return 0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (!strncmp(line, "Threads:", 8)) {
+            count = atoi(line + 8);
+            break;
+        }
+    }
+    fclose(fp);
+
+    return count;
+}
+
+static MPP_RET sched_test_prealloc(SchedTestSession *s)
+{
+    MppDecPreAlloc cfg;
+    MPP_RET ret = MPP_OK;
+
+    cfg.width = 1920;
+    cfg.height = 1088;
+    cfg.format = MPP_FMT_YUV420SP;
+    cfg.count = SCHED_TEST_BUF_COUNT;
+
+    ret = mpp_buffer_group_get_internal(&s->frm_grp, MPP_BUFFER_TYPE_ION);
+    if (!ret)
+        ret = s->mpi->control(s->ctx, MPP_DEC_SET_EXT_BUF_GROUP, s->frm_grp);
+    if (!ret)
+        ret = s->mpi->control(s->ctx, MPP_DEC_SET_PRE_ALLOC_BUFF, &cfg);
+
+    return ret;
+}
+
+static MPP_RET sched_test_info_change(SchedTestSession *s, MppFrame frame)
+{
+    MPP_RET ret = MPP_OK;
+
+    if (s->prealloc) {
+        /* keep the pre-allocated buffers in group */
+        ret = mpp_buffer_group_limit_config(s->frm_grp, 0, SCHED_TEST_BUF_COUNT);
+    } else if (NULL == s->frm_grp) {
+        ret = mpp_buffer_group_get_internal(&s->frm_grp, MPP_BUFFER_TYPE_ION);
+        if (ret)
+            return ret;
+
+        ret = s->mpi->control(s->ctx, MPP_DEC_SET_EXT_BUF_GROUP, s->frm_grp);
+    } else
+        ret = mpp_buffer_group_clear(s->frm_grp);
+
+    if (!ret)
+        ret = mpp_buffer_group_limit_config(s->frm_grp, mpp_frame_get_buf_size(frame),
+                                            SCHED_TEST_BUF_COUNT);
+    if (!ret)
+        ret = s->mpi->control(s->ctx, MPP_DEC_SET_INFO_CHANGE_READY, NULL);
+
+    return ret;
+}
+
+static void *sched_test_session(void *arg)
+{
+    SchedTestSession *s = (SchedTestSession *)arg;
+    MppPacket packet = NULL;
+    RK_U8 stream[SCHED_TEST_STREAM_SIZE];
+    RK_S64 start = mpp_time();
+    RK_U32 eos = 0;
+
+    memset(stream, 0, sizeof(stream));
+    mpp_packet_init(&packet, stream, sizeof(stream));
+
+    while (!eos && !s->error) {
+        MppFrame frame = NULL;
+
+        if (s->put_count < s->frames) {
+            mpp_packet_set_pos(packet, stream);
+            mpp_packet_set_length(packet, sizeof(stream));
+            mpp_packet_set_pts(packet, mpp_time());
+            if (s->put_count == s->frames - 1)
+                mpp_packet_set_eos(packet);
+
+            /* fill input queue first then wait on output */
+            if (MPP_OK == s->mpi->decode_put_packet(s->ctx, packet)) {
+                s->put_count++;
+                continue;
+            }
+        }
+
+        if (s->mpi->decode_get_frame(s->ctx, &frame) || NULL == frame)
+            continue;
+
+        if (mpp_frame_get_info_change(frame)) {
+            if (sched_test_info_change(s, frame))
+                s->error = 1;
+        } else if (!mpp_frame_get_eos(frame) || mpp_frame_get_buffer(frame)) {
+            RK_S64 latency = mpp_time() - mpp_frame_get_pts(frame);
+
+            if (latency > s->latency_max)
+                s->latency_max = latency;
+            if (!s->get_count)
+                s->first_frame = mpp_time() - start;
+            s->get_count++;
+        }
+
+        eos = mpp_frame_get_eos(frame);
+        mpp_frame_deinit(&frame);
+    }
+
+    mpp_packet_deinit(&packet);
+
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    RK_S32 sessions = (argc > 1) ? atoi(argv[1]) : SCHED_TEST_SESSIONS;
+    RK_S32 frames = (argc > 2) ? atoi(argv[2]) : SCHED_TEST_FRAMES;
+    RK_S32 workers = (argc > 3) ? atoi(argv[3]) : 0;
+    RK_S32 prealloc = (argc > 4) ? atoi(argv[4]) : 0;
+    RK_U32 batch = (argc > 5) ? atoi(argv[5]) : 0;
+    SchedTestSession *list = NULL;
+    MppPollType timeout = SCHED_TEST_TIMEOUT;
+    struct rusage usage_start;
+    struct rusage usage_end;
+    RK_S32 thread_count = 0;
+    RK_S64 latency_max = 0;
+    RK_S64 first_frame = 0;
+    RK_S64 total = 0;
+    RK_S64 time;
+    RK_S32 ret = 0;
+    RK_S32 i;
+
+    mpp_log("mpi_dec_sched_test sessions %d frames %d workers %d prealloc %d batch %d\n",
+            sessions, frames, workers, prealloc, batch);
+
+    /* must be setup before first decoder is created */
+    mpp_env_set_u32("mpp_sched_workers", workers);
+    mpp_env_set_u32("mpp_dec_dummy", 1);
+
+    list = mpp_calloc(SchedTestSession, sessions);
+    if (NULL == list) {
+        mpp_err("failed to malloc %d sessions\n", sessions);
+        return -1;
+    }
+
+    for (i = 0; i < sessions; i++) {
+        SchedTestSession *s = &list[i];
+
+        s->frames = frames;
+        s->prealloc = prealloc;
+        if (mpp_create(&s->ctx, &s->mpi) ||
+            s->mpi->control(s->ctx, MPP_SET_OUTPUT_TIMEOUT, &timeout) ||
+            (batch && s->mpi->control(s->ctx, MPP_DEC_SET_PARSER_BATCH_DEPTH, &batch)) ||
+            mpp_init(s->ctx, MPP_CTX_DEC, MPP_VIDEO_CodingUnused) ||
+            (prealloc && sched_test_prealloc(s))) {
+            mpp_err("failed to create session %d\n", i);
+            ret = -1;
+            sessions = i + 1;
+            goto DONE;
+        }
+    }
+
+    /* decoder threads or scheduler workers plus main thread */
+    thread_count = sched_test_thread_count();
+
+    getrusage(RUSAGE_SELF, &usage_start);
+    time = mpp_time();
+
+    for (i = 0; i < sessions; i++)
+        pthread_create(&list[i].thd, NULL, sched_test_session, &list[i]);
+
+    for (i = 0; i < sessions; i++)
+        pthread_join(list[i].thd, NULL);
+
+    time = mpp_time() - time;
+    getrusage(RUSAGE_SELF, &usage_end);
+
+    for (i = 0; i < sessions; i++) {
+        SchedTestSession *s = &list[i];
+
+        if (s->error || s->get_count != s->frames) {
+            mpp_err("session %d error %d get %d frames\n", i, s->error,
+                    s->get_count);
+            ret = -1;
+        }
+        total += s->get_count;
+        latency_max = MPP_MAX(latency_max, s->latency_max);
+        first_frame = MPP_MAX(first_frame, s->first_frame);
+    }
+
+    mpp_log("%lld frames in %.2f ms %.2f frames/s max latency %.2f ms\n",
+            total, time / 1000.0, (double)total * 1000000 / MPP_MAX(time, 1),
+            latency_max / 1000.0);
+    mpp_log("max first frame latency %.2f ms\n", first_frame / 1000.0);
+    mpp_log("threads %d context switch voluntary %ld involuntary %ld\n",
+            thread_count, usage_end.ru_nvcsw - usage_start.ru_nvcsw,
+            usage_end.ru_nivcsw - usage_start.ru_nivcsw);
+
+    {
+        MppStats stats;
+
+        if (!list[0].mpi->control(list[0].ctx, MPP_GET_STATS, &stats)) {
+            mpp_log("session 0 packet %d frame %d stage timing in us:\n",
+                    stats.packet_put, stats.frame_get);
+            for (i = 0; i < stats.stage_count; i++) {
+                MppStageStat *stage = &stats.stages[i];
+
+                mpp_log("%-16s count %-6lld avg %-6lld p50 %-6lld p90 %-6lld p99 %-6lld max %lld\n",
+                        stage->name, stage->count, stage->avg, stage->p50,
+                        stage->p90, stage->p99, stage->max);
+            }
+        }
+    }
+
+DONE:
+    for (i = 0; i < sessions; i++) {
+        SchedTestSession *s = &list[i];
+
+        if (s->ctx) {
+            s->mpi->reset(s->ctx);
+            mpp_destroy(s->ctx);
+        }
+        if (s->frm_grp)
+            mpp_buffer_group_put(s->frm_grp);
+    }
+    mpp_free(list);
+
+    mpp_log("mpi_dec_sched_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}